@@ -0,0 +1,128 @@
+'use strict';
+
+// Streams a file-backed Blob, as returned by fs.openAsBlob(), through an HTTP
+// response and reports the throughput in MiB/s. `method` selects how the
+// response body is produced:
+//   - stream: pipes blob.stream() into the response.
+//   - arrayBuffer: materializes the whole Blob with blob.arrayBuffer().
+//   - writeToFd: writes the Blob straight to the socket's descriptor on the
+//     threadpool with the internal writeToFd(), after the response head.
+//   - readStream: fs.createReadStream() on the same file, as the baseline.
+
+const common = require('../common.js');
+const fs = require('fs');
+const http = require('http');
+const path = require('path');
+const { Readable } = require('stream');
+const tmpdir = require('../../test/common/tmpdir');
+
+const bench = common.createBenchmark(main, {
+  method: ['stream', 'arrayBuffer', 'writeToFd', 'readStream'],
+  size: [64 * 1024 * 1024, 2 * 1024 * 1024 * 1024],
+  n: [4],
+}, {
+  flags: ['--expose-internals'],
+  combinationFilter({ method, size }) {
+    // A 2 GiB ArrayBuffer is slow enough to dominate the whole run.
+    return method !== 'arrayBuffer' || size < 2 * 1024 * 1024 * 1024;
+  },
+});
+
+function createFile(filename, size) {
+  const chunk = Buffer.alloc(16 * 1024 * 1024, 'x');
+  const fd = fs.openSync(filename, 'w');
+  for (let written = 0; written < size; written += chunk.length)
+    fs.writeSync(fd, chunk, 0, Math.min(chunk.length, size - written));
+  fs.closeSync(fd);
+}
+
+// Writes all of `blob` to `fd`. writeToFd() gives up with UV_EAGAIN when a
+// non-blocking descriptor stays full, and the rest is written from a slice.
+function writeToFd(blob, fd) {
+  const { kHandle } = require('internal/blob');
+  const { internalBinding } = require('internal/test/binding');
+  const { UV_EAGAIN } = internalBinding('uv');
+  return new Promise((resolve, reject) => {
+    (function write(blob) {
+      const started = blob[kHandle].writeToFd(fd, (status, written) => {
+        if (status === UV_EAGAIN)
+          return setImmediate(write, blob.slice(written));
+        if (status < 0)
+          return reject(new Error(`writeToFd() failed with ${status}`));
+        resolve();
+      });
+      if (!started)
+        reject(new Error('The Blob has no extents'));
+    })(blob);
+  });
+}
+
+async function respond(method, filename, res) {
+  if (method === 'writeToFd') {
+    // The body bypasses the response, so the socket is taken over after the
+    // head has been written.
+    const blob = await fs.openAsBlob(filename);
+    const { socket } = res;
+    const head = 'HTTP/1.1 200 OK\r\n' +
+                 'Content-Type: application/octet-stream\r\n' +
+                 `Content-Length: ${blob.size}\r\n` +
+                 'Connection: close\r\n\r\n';
+    await new Promise((resolve) => socket.write(head, resolve));
+    await writeToFd(blob, socket._handle.fd);
+    socket.end();
+    return;
+  }
+
+  res.writeHead(200, { 'Content-Type': 'application/octet-stream' });
+  switch (method) {
+    case 'stream': {
+      const blob = await fs.openAsBlob(filename);
+      Readable.fromWeb(blob.stream()).pipe(res);
+      break;
+    }
+    case 'arrayBuffer': {
+      const blob = await fs.openAsBlob(filename);
+      res.end(Buffer.from(await blob.arrayBuffer()));
+      break;
+    }
+    case 'readStream':
+      fs.createReadStream(filename).pipe(res);
+      break;
+  }
+}
+
+function main({ method, size, n }) {
+  tmpdir.refresh();
+  const filename = path.join(tmpdir.path, 'blob-http-response.bin');
+  createFile(filename, size);
+
+  const server = http.createServer((req, res) => {
+    respond(method, filename, res).catch((err) => {
+      res.destroy(err);
+    });
+  });
+
+  server.listen(0, () => {
+    const { port } = server.address();
+    let remaining = n;
+    let received = 0;
+
+    function request() {
+      http.get({ port, agent: false }, (res) => {
+        res.on('data', (chunk) => {
+          received += chunk.length;
+        });
+        res.on('end', () => {
+          if (--remaining > 0)
+            return request();
+          bench.end(received / (1024 * 1024));
+          server.close();
+          tmpdir.refresh();
+        });
+      });
+    }
+
+    bench.start();
+    request();
+  });
+}
@@ -0,0 +1,61 @@
+'use strict';
+
+// Reads a file-backed Blob, as returned by fs.openAsBlob(), and reports the
+// throughput in MiB/s. The file is read once before the timed runs, so this
+// measures the reader with a warm page cache rather than the disk.
+//   - stream: reads blob.stream() to the end.
+//   - arrayBuffer: materializes the whole Blob with blob.arrayBuffer().
+//   - readFile: fs.promises.readFile() on the same file, as the baseline.
+
+const common = require('../common.js');
+const fs = require('fs');
+const path = require('path');
+const tmpdir = require('../../test/common/tmpdir');
+
+const bench = common.createBenchmark(main, {
+  method: ['stream', 'arrayBuffer', 'readFile'],
+  size: [1024 * 1024, 64 * 1024 * 1024],
+  n: [16],
+});
+
+function createFile(filename, size) {
+  const chunk = Buffer.alloc(16 * 1024 * 1024, 'x');
+  const fd = fs.openSync(filename, 'w');
+  for (let written = 0; written < size; written += chunk.length)
+    fs.writeSync(fd, chunk, 0, Math.min(chunk.length, size - written));
+  fs.closeSync(fd);
+}
+
+async function read(method, filename) {
+  switch (method) {
+    case 'stream': {
+      const blob = await fs.openAsBlob(filename);
+      let length = 0;
+      for await (const chunk of blob.stream())
+        length += chunk.length;
+      return length;
+    }
+    case 'arrayBuffer': {
+      const blob = await fs.openAsBlob(filename);
+      return (await blob.arrayBuffer()).byteLength;
+    }
+    case 'readFile':
+      return (await fs.promises.readFile(filename)).length;
+    default:
+      throw new Error(`Unsupported method ${method}`);
+  }
+}
+
+async function main({ method, size, n }) {
+  tmpdir.refresh();
+  const filename = path.join(tmpdir.path, 'blob-file-read.bin');
+  createFile(filename, size);
+  await read(method, filename);
+
+  let received = 0;
+  bench.start();
+  for (let i = 0; i < n; i++)
+    received += await read(method, filename);
+  bench.end(received / (1024 * 1024));
+  tmpdir.refresh();
+}
@@ -0,0 +1,78 @@
+'use strict';
+
+// Measures the per-call overhead of the Buffer methods backed by the
+// `buffer` binding on small inputs, where the JS <-> C++ transition rather
+// than the actual work dominates. Run with --no-opt or against a build
+// without fast API calls to get the baseline numbers.
+
+const common = require('../common.js');
+
+const bench = common.createBenchmark(main, {
+  method: [
+    'compare',
+    'compareOffset',
+    'copy',
+    'fill',
+    'indexOfBuffer',
+    'indexOfNumber',
+    'swap16',
+    'swap32',
+    'swap64',
+    'isUtf8',
+    'isAscii',
+  ],
+  size: [16, 256],
+  n: [1e7],
+});
+
+function main({ method, size, n }) {
+  const { isUtf8, isAscii } = require('buffer');
+  const a = Buffer.alloc(size, 'a');
+  const b = Buffer.alloc(size, 'a');
+  b[size - 1] = 0x62;
+  const needle = b.subarray(size - 4);
+  let fn;
+
+  switch (method) {
+    case 'compare':
+      fn = () => a.compare(b);
+      break;
+    case 'compareOffset':
+      fn = () => a.compare(b, 1, size - 1, 1, size - 1);
+      break;
+    case 'copy':
+      fn = () => a.copy(b, 0, 0, size);
+      break;
+    case 'fill':
+      fn = () => a.fill(0x61, 0, size);
+      break;
+    case 'indexOfBuffer':
+      fn = () => b.indexOf(needle);
+      break;
+    case 'indexOfNumber':
+      fn = () => b.indexOf(0x62);
+      break;
+    case 'swap16':
+      fn = () => a.swap16();
+      break;
+    case 'swap32':
+      fn = () => a.swap32();
+      break;
+    case 'swap64':
+      fn = () => a.swap64();
+      break;
+    case 'isUtf8':
+      fn = () => isUtf8(a);
+      break;
+    case 'isAscii':
+      fn = () => isAscii(a);
+      break;
+  }
+
+  // Warm up so that the call sites get optimized before measuring.
+  for (let i = 0; i < 1e5; i++) fn();
+
+  bench.start();
+  for (let i = 0; i < n; i++) fn();
+  bench.end(n);
+}
@@ -0,0 +1,82 @@
+// Throughput of small-record AEAD encryption, one record per createCipheriv()
+// compared with whole batches in a single AEADBatchJob.
+'use strict';
+const common = require('../common.js');
+const crypto = require('crypto');
+
+const bench = common.createBenchmark(main, {
+  method: ['cipheriv', 'batch-sync', 'batch-async'],
+  cipher: ['aes-256-gcm', 'chacha20-poly1305'],
+  size: [64, 1024],
+  batch: [100],
+  n: [1e5],
+}, {
+  flags: ['--expose-internals'],
+});
+
+function main({ method, cipher, size, batch, n }) {
+  const { internalBinding } = require('internal/test/binding');
+  const {
+    AEADBatchJob,
+    kAEADBatch_AES_256_GCM,
+    kAEADBatch_CHACHA20_POLY1305,
+    kCryptoJobAsync,
+    kCryptoJobSync,
+    kWebCryptoCipherEncrypt,
+  } = internalBinding('crypto');
+
+  const rawKey = crypto.randomBytes(32);
+  const records = [];
+  for (let i = 0; i < batch; i++)
+    records.push([crypto.randomBytes(12), undefined, crypto.randomBytes(size)]);
+
+  switch (method) {
+    case 'cipheriv':
+      bench.start();
+      for (let i = 0; i < n; i++) {
+        const [nonce, , data] = records[i % batch];
+        const c = crypto.createCipheriv(cipher, rawKey, nonce,
+                                        { authTagLength: 16 });
+        c.update(data);
+        c.final();
+        c.getAuthTag();
+      }
+      bench.end(n);
+      break;
+    case 'batch-sync':
+    case 'batch-async': {
+      const variant = cipher === 'aes-256-gcm' ?
+        kAEADBatch_AES_256_GCM : kAEADBatch_CHACHA20_POLY1305;
+      const { kHandle } = require('internal/crypto/util');
+      const handle = crypto.createSecretKey(rawKey)[kHandle];
+      const newJob = (mode) => new AEADBatchJob(
+        mode, kWebCryptoCipherEncrypt, handle, variant, 16, records);
+
+      if (method === 'batch-sync') {
+        bench.start();
+        for (let i = 0; i < n; i += batch) {
+          const [err] = newJob(kCryptoJobSync).run();
+          if (err) throw err;
+        }
+        bench.end(n);
+        break;
+      }
+
+      let done = 0;
+      bench.start();
+      (function next() {
+        if (done >= n) return bench.end(n);
+        const job = newJob(kCryptoJobAsync);
+        job.ondone = (err) => {
+          if (err) throw err;
+          done += batch;
+          next();
+        };
+        job.run();
+      })();
+      break;
+    }
+    default:
+      throw new Error(`Unsupported method ${method}`);
+  }
+}
@@ -0,0 +1,51 @@
+// Throughput of small synchronous random requests, straight from the CSPRNG
+// compared with the per-Environment pool behind pooledRandomFill().
+'use strict';
+const common = require('../common.js');
+const crypto = require('crypto');
+
+const bench = common.createBenchmark(main, {
+  method: ['randomBytes', 'randomFillSync', 'randomUUID', 'pooled'],
+  size: [16, 64, 256],
+  n: [1e6],
+}, {
+  flags: ['--expose-internals'],
+});
+
+function main({ method, size, n }) {
+  const { internalBinding } = require('internal/test/binding');
+  const { pooledRandomFill } = internalBinding('crypto');
+  const buffer = Buffer.alloc(size);
+
+  switch (method) {
+    case 'randomBytes':
+      bench.start();
+      for (let i = 0; i < n; i++) crypto.randomBytes(size);
+      bench.end(n);
+      break;
+    case 'randomFillSync':
+      bench.start();
+      for (let i = 0; i < n; i++) crypto.randomFillSync(buffer);
+      bench.end(n);
+      break;
+    case 'randomUUID': {
+      // Without its JS entropy cache, every call reaches the CSPRNG. The size
+      // does not apply.
+      const options = { disableEntropyCache: true };
+      bench.start();
+      for (let i = 0; i < n; i++) crypto.randomUUID(options);
+      bench.end(n);
+      break;
+    }
+    case 'pooled':
+      bench.start();
+      for (let i = 0; i < n; i++) {
+        if (!pooledRandomFill(buffer, 0, size))
+          throw new Error('CSPRNG failed');
+      }
+      bench.end(n);
+      break;
+    default:
+      throw new Error(`Unsupported method ${method}`);
+  }
+}
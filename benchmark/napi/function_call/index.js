@@ -28,6 +28,7 @@ try {
   process.exit(0);
 }
 const napi = napi_binding.hello;
+const napiFast = napi_binding.helloFast;
 
 let c = 0;
 function js() {
@@ -37,12 +38,16 @@ function js() {
 assert(js() === cxx());
 
 const bench = common.createBenchmark(main, {
-  type: ['js', 'cxx', 'napi'],
+  type: ['js', 'cxx', 'napi', 'napi-fast'],
   n: [1e6, 1e7, 5e7],
 });
 
 function main({ n, type }) {
-  const fn = type === 'cxx' ? cxx : type === 'napi' ? napi : js;
+  const fn = {
+    'cxx': cxx,
+    'napi': napi,
+    'napi-fast': napiFast,
+  }[type] || js;
   bench.start();
   for (let i = 0; i < n; i++) {
     fn();
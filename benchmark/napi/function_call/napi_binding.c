@@ -1,3 +1,4 @@
+#define NAPI_EXPERIMENTAL
 #include <assert.h>
 #include <node_api.h>
 
@@ -10,6 +11,44 @@ static napi_value Hello(napi_env env, napi_callback_info info) {
   return result;
 }
 
+static bool FastHello(void* data,
+                      const node_api_fast_value* args,
+                      size_t argc,
+                      node_api_fast_value* result) {
+  result->number = increment++;
+  return true;
+}
+
+static double SumArray(const double* data, size_t length) {
+  double sum = 0;
+  for (size_t i = 0; i < length; i++) sum += data[i];
+  return sum;
+}
+
+static napi_value Sum(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value array;
+  napi_status status = napi_get_cb_info(env, info, &argc, &array, NULL, NULL);
+  assert(status == napi_ok);
+  void* data;
+  size_t length;
+  status = napi_get_typedarray_info(
+      env, array, NULL, &length, &data, NULL, NULL);
+  assert(status == napi_ok);
+  napi_value result;
+  status = napi_create_double(env, SumArray(data, length), &result);
+  assert(status == napi_ok);
+  return result;
+}
+
+static bool FastSum(void* data,
+                    const node_api_fast_value* args,
+                    size_t argc,
+                    node_api_fast_value* result) {
+  result->number = SumArray(args[0].array.data, args[0].array.length);
+  return true;
+}
+
 NAPI_MODULE_INIT() {
   napi_value hello;
   napi_status status =
@@ -22,5 +61,40 @@ NAPI_MODULE_INIT() {
   assert(status == napi_ok);
   status = napi_set_named_property(env, exports, "hello", hello);
   assert(status == napi_ok);
+
+  status = node_api_create_fast_function(env,
+                                         "helloFast",
+                                         NAPI_AUTO_LENGTH,
+                                         Hello,
+                                         FastHello,
+                                         node_api_fast_number,
+                                         NULL,
+                                         0,
+                                         NULL,
+                                         &hello);
+  assert(status == napi_ok);
+  status = napi_set_named_property(env, exports, "helloFast", hello);
+  assert(status == napi_ok);
+
+  napi_value sum;
+  status = napi_create_function(env, "sum", NAPI_AUTO_LENGTH, Sum, NULL, &sum);
+  assert(status == napi_ok);
+  status = napi_set_named_property(env, exports, "sum", sum);
+  assert(status == napi_ok);
+
+  const node_api_fast_type sum_args[] = {node_api_fast_float64_array};
+  status = node_api_create_fast_function(env,
+                                         "sumFast",
+                                         NAPI_AUTO_LENGTH,
+                                         Sum,
+                                         FastSum,
+                                         node_api_fast_number,
+                                         sum_args,
+                                         1,
+                                         NULL,
+                                         &sum);
+  assert(status == napi_ok);
+  status = napi_set_named_property(env, exports, "sumFast", sum);
+  assert(status == napi_ok);
   return exports;
 }
@@ -0,0 +1,33 @@
+// Compare passing a Float64Array to a regular Node-API function, which has to
+// look the array up through napi_get_typedarray_info(), with a function that
+// also registered a fast-call signature and receives the raw pointer.
+'use strict';
+
+const assert = require('assert');
+const common = require('../../common.js');
+
+let napi_binding;
+try {
+  napi_binding = require(`./build/${common.buildType}/napi_binding`);
+} catch {
+  console.error('typed_array.js NAPI-Binding failed to load');
+  process.exit(0);
+}
+
+const bench = common.createBenchmark(main, {
+  type: ['napi', 'napi-fast'],
+  len: [16, 1024],
+  n: [1e6, 1e7],
+});
+
+function main({ n, len, type }) {
+  const fn = type === 'napi-fast' ? napi_binding.sumFast : napi_binding.sum;
+  const array = new Float64Array(len).fill(1);
+  let total = 0;
+  bench.start();
+  for (let i = 0; i < n; i++) {
+    total += fn(array);
+  }
+  bench.end(n);
+  assert.strictEqual(total, n * len);
+}
@@ -57,6 +57,35 @@ NewWeak(napi_env env, napi_callback_info info) {
   return result;
 }
 
+static napi_value
+NewWeakBatch(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value argv[1];
+  uint32_t count;
+  uint32_t i;
+  void* instance_data;
+
+  NAPI_CALL(env, napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  NAPI_CALL(env, napi_get_value_uint32(env, argv[0], &count));
+  NAPI_CALL(env, napi_get_instance_data(env, &instance_data));
+
+  for (i = 0; i < count; i++) {
+    napi_handle_scope scope;
+    napi_value object;
+    NAPI_CALL(env, napi_open_handle_scope(env, &scope));
+    NAPI_CALL(env, napi_create_object(env, &object));
+    NAPI_CALL(env, napi_add_finalizer(env,
+                                      object,
+                                      instance_data,
+                                      IncrementCounter,
+                                      NULL,
+                                      NULL));
+    NAPI_CALL(env, napi_close_handle_scope(env, scope));
+  }
+
+  return NULL;
+}
+
 static void
 FreeCount(napi_env env, void* data, void* hint) {
   free(data);
@@ -66,7 +95,9 @@ FreeCount(napi_env env, void* data, void* hint) {
 NAPI_MODULE_INIT(/* napi_env env, napi_value exports */) {
   napi_property_descriptor props[] = {
     { "count", NULL, NULL, GetCount, SetCount, NULL, napi_enumerable, NULL },
-    { "newWeak", NULL, NewWeak, NULL, NULL, NULL, napi_enumerable, NULL }
+    { "newWeak", NULL, NewWeak, NULL, NULL, NULL, napi_enumerable, NULL },
+    { "newWeakBatch", NULL, NewWeakBatch, NULL, NULL, NULL, napi_enumerable,
+      NULL }
   };
 
   size_t* count = malloc(sizeof(*count));
@@ -0,0 +1,29 @@
+// Measures how long it takes for the finalizers of a large number of
+// collected objects to run, and how responsive the event loop stays
+// meanwhile.
+//   - finalizers: finalizers run per second.
+//   - turns: event loop turns per second until the last finalizer has run.
+//     Finalizers that block the loop for long stretches lower this rate.
+'use strict';
+const common = require('../../common');
+const addon = require(`./build/${common.buildType}/addon`);
+const bench = common.createBenchmark(main, {
+  measure: ['finalizers', 'turns'],
+  n: [1e5, 1e6],
+}, { flags: ['--expose-gc'] });
+
+function main({ measure, n }) {
+  addon.count = 0;
+  addon.newWeakBatch(n);
+  bench.start();
+  global.gc();
+  let turns = 0;
+  (function poll() {
+    turns++;
+    if (addon.count < n) {
+      setImmediate(poll);
+      return;
+    }
+    bench.end(measure === 'turns' ? turns : n);
+  })();
+}
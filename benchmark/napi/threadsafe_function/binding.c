@@ -0,0 +1,98 @@
+#define NAPI_EXPERIMENTAL
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <node_api.h>
+#include <uv.h>
+
+#define MAX_THREADS 16
+
+typedef struct {
+  napi_threadsafe_function tsfn;
+  uv_thread_t threads[MAX_THREADS];
+  uint32_t thread_count;
+  uint32_t calls_per_thread;
+  napi_ref done;
+} Context;
+
+static void Produce(void* data) {
+  Context* context = data;
+  uint32_t index;
+  for (index = 0; index < context->calls_per_thread; index++) {
+    napi_status status = napi_call_threadsafe_function(
+        context->tsfn, (void*)(uintptr_t)index, napi_tsfn_blocking);
+    assert(status == napi_ok);
+  }
+  napi_release_threadsafe_function(context->tsfn, napi_tsfn_release);
+}
+
+// Calls the JS callback with the number of items it stands for, so that the
+// JS side can count calls the same way in both modes.
+static void CallJs(napi_env env, napi_value cb, void* hint, void* data) {
+  napi_value undefined, count;
+  if (env == NULL) return;
+  napi_get_undefined(env, &undefined);
+  napi_create_uint32(env, 1, &count);
+  napi_call_function(env, undefined, cb, 1, &count, NULL);
+}
+
+static void CallJsBatch(napi_env env,
+                        napi_value cb,
+                        void* hint,
+                        void** data,
+                        size_t size) {
+  napi_value undefined, count;
+  if (env == NULL) return;
+  napi_get_undefined(env, &undefined);
+  napi_create_uint32(env, (uint32_t)size, &count);
+  napi_call_function(env, undefined, cb, 1, &count, NULL);
+}
+
+static void Finalize(napi_env env, void* data, void* hint) {
+  Context* context = data;
+  napi_value undefined, done;
+  uint32_t index;
+  for (index = 0; index < context->thread_count; index++)
+    uv_thread_join(&context->threads[index]);
+  napi_get_undefined(env, &undefined);
+  napi_get_reference_value(env, context->done, &done);
+  napi_delete_reference(env, context->done);
+  free(context);
+  napi_call_function(env, undefined, done, 0, NULL, NULL);
+}
+
+// start(onItems, onDone, calls, threads, batchSize)
+static napi_value Start(napi_env env, napi_callback_info info) {
+  size_t argc = 5;
+  napi_value argv[5], name;
+  uint32_t calls, batch_size, index;
+  Context* context = calloc(1, sizeof(*context));
+
+  napi_get_cb_info(env, info, &argc, argv, NULL, NULL);
+  napi_create_reference(env, argv[1], 1, &context->done);
+  napi_get_value_uint32(env, argv[2], &calls);
+  napi_get_value_uint32(env, argv[3], &context->thread_count);
+  napi_get_value_uint32(env, argv[4], &batch_size);
+  assert(context->thread_count > 0 && context->thread_count <= MAX_THREADS);
+  context->calls_per_thread = calls / context->thread_count;
+
+  napi_create_string_utf8(env, "bench", NAPI_AUTO_LENGTH, &name);
+  napi_create_threadsafe_function(env, argv[0], NULL, name, 0,
+      context->thread_count, context, Finalize, context, CallJs,
+      &context->tsfn);
+  if (batch_size > 0) {
+    node_api_set_threadsafe_function_batch(env, context->tsfn, batch_size,
+        CallJsBatch);
+  }
+
+  for (index = 0; index < context->thread_count; index++)
+    uv_thread_create(&context->threads[index], Produce, context);
+  return NULL;
+}
+
+NAPI_MODULE_INIT() {
+  napi_value start;
+  napi_create_function(env, "start", NAPI_AUTO_LENGTH, Start, NULL, &start);
+  napi_set_named_property(env, exports, "start", start);
+  return exports;
+}
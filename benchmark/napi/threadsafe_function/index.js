@@ -0,0 +1,33 @@
+// Throughput of napi_threadsafe_function calls from worker threads into JS,
+// one call per item versus batched dispatch of up to `batch` items per call.
+// Reports items per second.
+'use strict';
+
+const assert = require('assert');
+const common = require('../../common.js');
+
+let binding;
+try {
+  binding = require(`./build/${common.buildType}/binding`);
+} catch {
+  console.error(`${__filename}: Binding failed to load`);
+  process.exit(0);
+}
+
+const bench = common.createBenchmark(main, {
+  n: [1e6],
+  threads: [1, 4],
+  batch: [0, 64, 1024],
+});
+
+function main({ n, threads, batch }) {
+  const calls = n - (n % threads);
+  let received = 0;
+  bench.start();
+  binding.start((count) => {
+    received += count;
+  }, () => {
+    bench.end(received);
+    assert.strictEqual(received, calls);
+  }, calls, threads, batch);
+}
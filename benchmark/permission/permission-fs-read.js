@@ -0,0 +1,34 @@
+// Cost of the --experimental-permission check on an fs call, with a large
+// allow-list. The paths do not exist, so fs.statSync() returns right after
+// the permission check and the failed stat() syscall.
+'use strict';
+const common = require('../common.js');
+const fs = require('fs');
+const path = require('path');
+
+const kEntries = 500;
+const root = path.resolve('/nonexistent-permission-benchmark');
+const allowed = [];
+for (let i = 0; i < kEntries; i++) {
+  allowed.push(path.join(root, `project-${i % 20}`, 'src', `module-${i}.js`));
+}
+
+const bench = common.createBenchmark(main, {
+  // How many distinct paths are looked up in turn.
+  paths: [1, 64, kEntries],
+  n: [1e6],
+}, {
+  flags: [
+    '--experimental-permission',
+    `--allow-fs-read=${path.resolve(__dirname, '..', '..')},${allowed}`,
+  ],
+});
+
+function main({ paths, n }) {
+  const targets = allowed.slice(0, paths);
+  bench.start();
+  for (let i = 0; i < n; i++) {
+    fs.statSync(targets[i % paths], { throwIfNoEntry: false });
+  }
+  bench.end(n);
+}
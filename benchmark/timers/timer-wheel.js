@@ -0,0 +1,71 @@
+// Cost of arming, cancelling and firing many long timers, either as JS timer
+// list entries or in the native timer wheel. The wheel never waits for real
+// time to pass; it is advanced to the deadlines directly, so `fire` measures
+// the bookkeeping only. JS timers can only fire on the event loop, which
+// would measure the wait rather than the bookkeeping, so they have no `fire`.
+'use strict';
+const common = require('../common.js');
+
+const bench = common.createBenchmark(main, {
+  impl: ['wheel', 'js'],
+  op: ['insert', 'cancel', 'fire'],
+  n: [1e6],
+}, {
+  flags: ['--expose-internals'],
+  combinationFilter({ impl, op }) {
+    return impl !== 'js' || op !== 'fire';
+  },
+});
+
+function noop() {}
+
+function wheel(op, n) {
+  const { internalBinding } = require('internal/test/binding');
+  const binding = internalBinding('timers');
+  const expired = new Uint32Array(1024);
+  const ids = new Array(n);
+  // Spread the deadlines over a minute, like socket timeouts.
+  const start = binding.getLibuvNow();
+  if (op === 'insert') bench.start();
+  for (let i = 0; i < n; i++)
+    ids[i] = binding.timerWheelInsert(start + 1000 + (i % 60000));
+  if (op === 'insert') {
+    bench.end(n);
+  } else if (op === 'cancel') {
+    bench.start();
+    for (let i = 0; i < n; i++) binding.timerWheelCancel(ids[i]);
+    bench.end(n);
+  } else {
+    let fired = 0;
+    bench.start();
+    for (let now = start; fired < n; now += 10) {
+      let count;
+      do {
+        count = binding.timerWheelAdvance(now, expired);
+        fired += count;
+      } while (count === expired.length);
+    }
+    bench.end(n);
+  }
+}
+
+function js(op, n) {
+  const timers = new Array(n);
+  if (op === 'insert') bench.start();
+  for (let i = 0; i < n; i++) timers[i] = setTimeout(noop, 1000 + (i % 60000));
+  if (op === 'insert') {
+    bench.end(n);
+    for (let i = 0; i < n; i++) clearTimeout(timers[i]);
+  } else {
+    bench.start();
+    for (let i = 0; i < n; i++) clearTimeout(timers[i]);
+    bench.end(n);
+  }
+}
+
+function main({ impl, op, n }) {
+  if (impl === 'wheel')
+    wheel(op, n);
+  else
+    js(op, n);
+}
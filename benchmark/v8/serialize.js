@@ -0,0 +1,67 @@
+// Throughput of v8.serialize() and v8.deserialize() for cache-entry sized
+// values, compared with the one-shot native serdes bindings.
+'use strict';
+const common = require('../common.js');
+const v8 = require('v8');
+
+const bench = common.createBenchmark(main, {
+  method: [
+    'serialize',
+    'serialize-native',
+    'serialize-batch',
+    'deserialize',
+    'deserialize-native',
+  ],
+  n: [1e5],
+}, {
+  flags: ['--expose-internals'],
+});
+
+const entry = {
+  key: 'user:12345',
+  expires: 1700000000000,
+  tags: ['a', 'b', 'c'],
+  body: Buffer.from('x'.repeat(256)),
+  meta: { hits: 17, stale: false },
+};
+
+function main({ method, n }) {
+  const { internalBinding } = require('internal/test/binding');
+  const binding = internalBinding('serdes');
+  const serialized = v8.serialize(entry);
+  let result;
+
+  switch (method) {
+    case 'serialize':
+      bench.start();
+      for (let i = 0; i < n; i++) result = v8.serialize(entry);
+      bench.end(n);
+      break;
+    case 'serialize-native':
+      bench.start();
+      for (let i = 0; i < n; i++) result = binding.serialize(entry);
+      bench.end(n);
+      break;
+    case 'serialize-batch': {
+      const batch = new Array(100).fill(entry);
+      bench.start();
+      for (let i = 0; i < n; i += batch.length)
+        result = binding.serializeBatch(batch);
+      bench.end(n);
+      break;
+    }
+    case 'deserialize':
+      bench.start();
+      for (let i = 0; i < n; i++) result = v8.deserialize(serialized);
+      bench.end(n);
+      break;
+    case 'deserialize-native':
+      bench.start();
+      for (let i = 0; i < n; i++) result = binding.deserialize(serialized);
+      bench.end(n);
+      break;
+    default:
+      throw new Error(`Unsupported method ${method}`);
+  }
+  if (result === undefined) throw new Error('No result');
+}
@@ -0,0 +1,74 @@
+// Throughput of MessagePort.postMessage() by the shape of the message.
+// Strings and views on a whole ArrayBuffer are copied as they are, while the
+// other shapes go through the ValueSerializer.
+'use strict';
+const common = require('../common.js');
+const { MessageChannel } = require('worker_threads');
+
+const bench = common.createBenchmark(main, {
+  payload: [
+    'string',
+    'utf16-string',
+    'uint8array',
+    'float64array',
+    'subarray',
+    'flat-object',
+    'nested-object',
+  ],
+  size: [16, 1024],
+  n: [1e5],
+});
+
+function createPayload(payload, size) {
+  switch (payload) {
+    case 'string':
+      return 'a'.repeat(size);
+    case 'utf16-string':
+      return 'é中'.repeat(size / 2);
+    case 'uint8array':
+      return new Uint8Array(size).fill(1);
+    case 'float64array':
+      return new Float64Array(size / 8).fill(0.5);
+    case 'subarray':
+      return new Uint8Array(size * 2).subarray(0, size);
+    case 'flat-object': {
+      const object = {};
+      for (let i = 0; i < size / 16; i++)
+        object[`key${i}`] = i % 2 ? i : `value${i}`;
+      return object;
+    }
+    case 'nested-object':
+      return {
+        id: 1,
+        tags: ['a', 'b', 'c'],
+        data: { buffer: new Uint8Array(size), created: new Date(0) },
+      };
+    default:
+      throw new Error(`Unsupported payload ${payload}`);
+  }
+}
+
+function main({ payload, size, n }) {
+  const message = createPayload(payload, size);
+  const { port1, port2 } = new MessageChannel();
+
+  let received = 0;
+  let sent = 0;
+  port2.on('message', () => {
+    if (++received === n) {
+      bench.end(n);
+      port1.close();
+      return;
+    }
+    // Keep a bounded number of messages in flight, so that this measures
+    // steady state rather than a queue that only grows.
+    if (sent < n) {
+      port1.postMessage(message);
+      sent++;
+    }
+  });
+
+  bench.start();
+  for (; sent < Math.min(n, 100); sent++)
+    port1.postMessage(message);
+}
@@ -0,0 +1,68 @@
+// Throughput of small records sent from a worker to the main thread, either
+// as MessagePort messages or through a shared-memory RingChannel.
+'use strict';
+const common = require('../common.js');
+const { Worker } = require('worker_threads');
+
+const bench = common.createBenchmark(main, {
+  type: ['ring', 'port'],
+  size: [16, 256],
+  n: [1e6],
+}, {
+  flags: ['--expose-internals'],
+});
+
+const workerSource = `
+const { parentPort, workerData } = require('worker_threads');
+const { type, size, n, channel } = workerData;
+const record = new Uint8Array(size);
+parentPort.once('message', () => {
+  if (type === 'ring') {
+    for (let i = 0; i < n; i++) {
+      record[0] = i & 0xff;
+      while (!channel.write(record)) channel.waitForSpace(-1);
+    }
+    channel.close();
+  } else {
+    for (let i = 0; i < n; i++) {
+      record[0] = i & 0xff;
+      parentPort.postMessage(record);
+    }
+  }
+});
+`;
+
+function main({ type, size, n }) {
+  const { internalBinding } = require('internal/test/binding');
+  const { RingChannel } = internalBinding('messaging');
+  const channel = type === 'ring' ? new RingChannel(4096, size) : undefined;
+  const worker = new Worker(workerSource, {
+    eval: true,
+    workerData: { type, size, n, channel },
+    execArgv: ['--expose-internals'],
+  });
+
+  let received = 0;
+  if (type === 'ring') {
+    const out = new Uint8Array(size * 256);
+    const lengths = new Uint32Array(256);
+    channel.onreadable = () => {
+      let count;
+      while ((count = channel.read(out, lengths)) > 0) received += count;
+      if (received === n) {
+        bench.end(n);
+        channel.close();
+      }
+    };
+    channel.start();
+  } else {
+    worker.on('message', () => {
+      if (++received === n) bench.end(n);
+    });
+  }
+
+  worker.on('online', () => {
+    bench.start();
+    worker.postMessage('go');
+  });
+}
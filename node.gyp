@@ -67,6 +67,7 @@
       'src/cleanup_queue.cc',
       'src/connect_wrap.cc',
       'src/connection_wrap.cc',
+      'src/cpu_features.cc',
       'src/dataqueue/queue.cc',
       'src/debug_utils.cc',
       'src/encoding_binding.cc',
@@ -74,6 +75,7 @@
       'src/fs_event_wrap.cc',
       'src/handle_wrap.cc',
       'src/heap_utils.cc',
+      'src/hex_simd.cc',
       'src/histogram.cc',
       'src/js_native_api.h',
       'src/js_native_api_types.h',
@@ -119,6 +121,7 @@
       'src/node_report.cc',
       'src/node_report_module.cc',
       'src/node_report_utils.cc',
+      'src/node_ring_channel.cc',
       'src/node_sea.cc',
       'src/node_serdes.cc',
       'src/node_shadow_realm.cc',
@@ -150,7 +153,9 @@
       'src/stream_wrap.cc',
       'src/string_bytes.cc',
       'src/string_decoder.cc',
+      'src/string_search_simd.cc',
       'src/tcp_wrap.cc',
+      'src/timer_wheel.cc',
       'src/timers.cc',
       'src/timer_wrap.cc',
       'src/tracing/agent.cc',
@@ -180,6 +185,7 @@
       'src/cleanup_queue-inl.h',
       'src/connect_wrap.h',
       'src/connection_wrap.h',
+      'src/cpu_features.h',
       'src/dataqueue/queue.h',
       'src/debug_utils.h',
       'src/debug_utils-inl.h',
@@ -188,15 +194,18 @@
       'src/env.h',
       'src/env-inl.h',
       'src/handle_wrap.h',
+      'src/hex_simd.h',
       'src/histogram.h',
       'src/histogram-inl.h',
       'src/js_stream.h',
       'src/json_utils.h',
       'src/large_pages/node_large_page.cc',
+      'src/large_pages/node_large_page_data.cc',
       'src/large_pages/node_large_page.h',
       'src/memory_tracker.h',
       'src/memory_tracker-inl.h',
       'src/module_wrap.h',
+      'src/mpsc_queue.h',
       'src/node.h',
       'src/node_api.h',
       'src/node_api_types.h',
@@ -237,6 +246,7 @@
       'src/node_realm-inl.h',
       'src/node_report.h',
       'src/node_revert.h',
+      'src/node_ring_channel.h',
       'src/node_root_certs.h',
       'src/node_sea.h',
       'src/node_shadow_realm.h',
@@ -270,7 +280,9 @@
       'src/string_decoder.h',
       'src/string_decoder-inl.h',
       'src/string_search.h',
+      'src/string_search_simd.h',
       'src/tcp_wrap.h',
+      'src/timer_wheel.h',
       'src/timers.h',
       'src/tracing/agent.h',
       'src/tracing/node_trace_buffer.h',
@@ -286,6 +298,7 @@
       'src/util-inl.h',
     ],
     'node_crypto_sources': [
+      'src/crypto/crypto_aead.cc',
       'src/crypto/crypto_aes.cc',
       'src/crypto/crypto_bio.cc',
       'src/crypto/crypto_common.cc',
@@ -310,6 +323,7 @@
       'src/crypto/crypto_scrypt.cc',
       'src/crypto/crypto_tls.cc',
       'src/crypto/crypto_x509.cc',
+      'src/crypto/crypto_aead.h',
       'src/crypto/crypto_bio.h',
       'src/crypto/crypto_clienthello-inl.h',
       'src/crypto/crypto_dh.h',
@@ -1030,15 +1044,25 @@
         'test/cctest/test_aliased_buffer.cc',
         'test/cctest/test_base64.cc',
         'test/cctest/test_base_object_ptr.cc',
+        'test/cctest/test_callback_queue.cc',
         'test/cctest/test_node_postmortem_metadata.cc',
         'test/cctest/test_environment.cc',
+        'test/cctest/test_fs_permission.cc',
+        'test/cctest/test_hex_simd.cc',
+        'test/cctest/test_json_parser.cc',
+        'test/cctest/test_large_pages.cc',
         'test/cctest/test_linked_binding.cc',
+        'test/cctest/test_mpsc_queue.cc',
         'test/cctest/test_node_api.cc',
+        'test/cctest/test_node_messaging.cc',
         'test/cctest/test_per_process.cc',
         'test/cctest/test_platform.cc',
         'test/cctest/test_report.cc',
         'test/cctest/test_json_utils.cc',
+        'test/cctest/test_ring_channel.cc',
         'test/cctest/test_sockaddr.cc',
+        'test/cctest/test_string_search.cc',
+        'test/cctest/test_timer_wheel.cc',
         'test/cctest/test_traced_value.cc',
         'test/cctest/test_util.cc',
         'test/cctest/test_dataqueue.cc',
@@ -1050,7 +1074,9 @@
             'HAVE_OPENSSL=1',
           ],
           'sources': [
+            'test/cctest/test_crypto_aead.cc',
             'test/cctest/test_crypto_clienthello.cc',
+            'test/cctest/test_crypto_random_pool.cc',
             'test/cctest/test_node_crypto.cc',
             'test/cctest/test_quic_cid.cc',
             'test/cctest/test_quic_tokens.cc',
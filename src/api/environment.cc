@@ -1,4 +1,5 @@
 #include <cstdlib>
+#include "large_pages/node_large_page.h"
 #include "node.h"
 #include "node_builtins.h"
 #include "node_context_data.h"
@@ -101,9 +102,18 @@ MaybeLocal<Value> PrepareStackTraceCallback(Local<Context> context,
   return result;
 }
 
+// Large backing stores may be mapped to huge pages directly. Those are always
+// zero-filled.
+static inline bool UseLargePages(size_t size) {
+  return size >= large_pages::kMinDataSize &&
+         large_pages::IsEnabledForData();
+}
+
 void* NodeArrayBufferAllocator::Allocate(size_t size) {
   void* ret;
-  if (zero_fill_field_ || per_process::cli_options->zero_fill_all_buffers)
+  if (UNLIKELY(UseLargePages(size)))
+    ret = large_pages::AllocateData(size);
+  else if (zero_fill_field_ || per_process::cli_options->zero_fill_all_buffers)
     ret = allocator_->Allocate(size);
   else
     ret = allocator_->AllocateUninitialized(size);
@@ -113,7 +123,9 @@ void* NodeArrayBufferAllocator::Allocate(size_t size) {
 }
 
 void* NodeArrayBufferAllocator::AllocateUninitialized(size_t size) {
-  void* ret = allocator_->AllocateUninitialized(size);
+  void* ret = UNLIKELY(UseLargePages(size))
+                  ? large_pages::AllocateData(size)
+                  : allocator_->AllocateUninitialized(size);
   if (LIKELY(ret != nullptr))
     total_mem_usage_.fetch_add(size, std::memory_order_relaxed);
   return ret;
@@ -121,6 +133,17 @@ void* NodeArrayBufferAllocator::AllocateUninitialized(size_t size) {
 
 void* NodeArrayBufferAllocator::Reallocate(
     void* data, size_t old_size, size_t size) {
+  if (UNLIKELY(UseLargePages(old_size) || UseLargePages(size))) {
+    // At least one side lives in a different allocator, so copy over.
+    void* ret = nullptr;
+    if (size > 0) {
+      ret = NodeArrayBufferAllocator::AllocateUninitialized(size);
+      if (ret == nullptr) return nullptr;
+      memcpy(ret, data, std::min(old_size, size));
+    }
+    NodeArrayBufferAllocator::Free(data, old_size);
+    return ret;
+  }
   void* ret = allocator_->Reallocate(data, old_size, size);
   if (LIKELY(ret != nullptr) || UNLIKELY(size == 0))
     total_mem_usage_.fetch_add(size - old_size, std::memory_order_relaxed);
@@ -129,7 +152,10 @@ void* NodeArrayBufferAllocator::Reallocate(
 
 void NodeArrayBufferAllocator::Free(void* data, size_t size) {
   total_mem_usage_.fetch_sub(size, std::memory_order_relaxed);
-  allocator_->Free(data, size);
+  if (UNLIKELY(UseLargePages(size)))
+    large_pages::FreeData(data, size);
+  else
+    allocator_->Free(data, size);
 }
 
 DebuggingArrayBufferAllocator::~DebuggingArrayBufferAllocator() {
@@ -64,6 +64,7 @@ namespace node {
   V(QUIC_LOGSTREAM)                                                            \
   V(QUIC_PACKET)                                                               \
   V(QUIC_UDP)                                                                  \
+  V(RINGCHANNEL)                                                               \
   V(SHUTDOWNWRAP)                                                              \
   V(SIGNALWRAP)                                                                \
   V(STATWATCHER)                                                               \
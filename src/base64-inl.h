@@ -7,6 +7,9 @@
 #include "libbase64.h"
 #include "util.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace node {
 
 static constexpr char base64_table_url[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
@@ -102,6 +105,81 @@ size_t base64_decode_fast(char* const dst, const size_t dstlen,
 }
 
 
+// Chunks handed to the vectorized decoder of deps/base64. The decoder
+// rejects whitespace, the URL-safe alphabet and padding in the middle of the
+// input, all of which Node.js accepts, so every chunk is decoded into a
+// scratch buffer first and only copied to `dst` once it is known to be good:
+// on failure, the vectorized decoder may have written garbage past the bytes
+// it reports, and `dst` can be the tail of a Buffer the caller still owns.
+static constexpr size_t kBase64SimdChunk = 1024;
+// Shorter inputs are not worth the setup cost of the vectorized decoder.
+static constexpr size_t kBase64SimdMinLength = 64;
+
+template <typename TypeName>
+inline void base64_translate_chunk(char* out,
+                                   const TypeName* src,
+                                   size_t n) {
+  for (size_t j = 0; j < n; j++) {
+    const unsigned c = static_cast<unsigned>(src[j]);
+    // Map the URL-safe alphabet onto the standard one and characters that do
+    // not fit into a byte onto one that the decoder rejects.
+    out[j] = c == '-' ? '+' : c == '_' ? '/' : c > 0xff ? '*' : c;
+  }
+}
+
+// Decodes the longest prefix of `src` that consists of complete, padding-free
+// groups of the standard or the URL-safe alphabet with the vectorized
+// decoder. Returns the number of bytes written to `dst` and stores the number
+// of consumed characters in `*consumed`, which is a multiple of four. The
+// caller decodes the rest with the forgiving scalar decoder, which produces
+// the same output for the prefix, so stopping early is always safe.
+template <typename TypeName>
+size_t base64_decode_simd(char* const dst, const size_t dstlen,
+                          const TypeName* const src, size_t srclen,
+                          size_t* const consumed) {
+  *consumed = 0;
+  if (srclen < kBase64SimdMinLength)
+    return 0;
+  // The padding is left to the scalar decoder.
+  while (srclen > 0 && src[srclen - 1] == '=')
+    srclen--;
+
+  char in[kBase64SimdChunk];
+  char out[kBase64SimdChunk / 4 * 3];
+  bool translate = sizeof(TypeName) > 1;
+  size_t i = 0;
+  size_t k = 0;
+  while (srclen - i >= 4) {
+    const size_t n = std::min(srclen - i, kBase64SimdChunk) / 4 * 4;
+    const size_t expected = n / 4 * 3;
+    if (dstlen - k < expected)
+      break;
+    size_t outlen = 0;
+    bool ok = false;
+    if (!translate) {
+      ok = ::base64_decode(reinterpret_cast<const char*>(src + i), n,
+                           out, &outlen, 0) == 1 &&
+           outlen == expected;
+      // Retry the chunk in case it uses the URL-safe alphabet, and keep
+      // translating the following chunks if it does.
+      translate = !ok;
+    }
+    if (translate) {
+      base64_translate_chunk(in, src + i, n);
+      ok = ::base64_decode(in, n, out, &outlen, 0) == 1 &&
+           outlen == expected;
+    }
+    if (!ok)
+      break;
+    memcpy(dst + k, out, expected);
+    i += n;
+    k += expected;
+  }
+  *consumed = i;
+  return k;
+}
+
+
 template <typename TypeName>
 size_t base64_decoded_size(const TypeName* src, size_t size) {
   // 1-byte input cannot be decoded
@@ -121,7 +199,11 @@ template <typename TypeName>
 size_t base64_decode(char* const dst, const size_t dstlen,
                      const TypeName* const src, const size_t srclen) {
   const size_t decoded_size = base64_decoded_size(src, srclen);
-  return base64_decode_fast(dst, dstlen, src, srclen, decoded_size);
+  const size_t available = dstlen < decoded_size ? dstlen : decoded_size;
+  size_t i;
+  const size_t k = base64_decode_simd(dst, available, src, srclen, &i);
+  return k + base64_decode_fast(dst + k, dstlen - k, src + i, srclen - i,
+                                decoded_size - k);
 }
 
 
@@ -144,9 +226,9 @@ inline size_t base64_encode(const char* src,
   unsigned a;
   unsigned b;
   unsigned c;
-  unsigned i;
-  unsigned k;
-  unsigned n;
+  size_t i;
+  size_t k;
+  size_t n;
 
   const char* table = base64_table_url;
 
@@ -154,6 +236,17 @@ inline size_t base64_encode(const char* src,
   k = 0;
   n = slen / 3 * 3;
 
+  // Complete groups need no padding, so the vectorized encoder can produce
+  // them and only the alphabet needs to be fixed up afterwards.
+  if (n >= kBase64SimdMinLength) {
+    ::base64_encode(src, n, dst, &k, 0);
+    for (size_t j = 0; j < k; j++) {
+      const char ch = dst[j];
+      dst[j] = ch == '+' ? '-' : ch == '/' ? '_' : ch;
+    }
+    i = n;
+  }
+
   while (i < n) {
     a = src[i + 0] & 0xff;
     b = src[i + 1] & 0xff;
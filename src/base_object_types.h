@@ -19,6 +19,7 @@ namespace node {
   V(url_binding_data, url::BindingData)
 
 #define UNSERIALIZABLE_BINDING_TYPES(V)                                        \
+  V(crypto_random_pool, crypto::RandomPool)                                    \
   V(http2_binding_data, http2::BindingData)                                    \
   V(http_parser_binding_data, http_parser::BindingData)                        \
   V(quic_binding_data, quic::BindingData)
@@ -4,51 +4,69 @@
 #if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
 
 #include "callback_queue.h"
+#include "util.h"
+
+#include <algorithm>
+#include <new>
 
 namespace node {
 
+template <typename R, typename... Args>
+CallbackQueue<R, Args...>::~CallbackQueue() {
+  while (Shift()) {
+  }
+  if (!storage_) return;
+  CHECK_EQ(storage_->outstanding, 0);
+  FreeSlabs(storage_->spare);
+  FreeSlabs(storage_->current);
+}
+
 template <typename R, typename... Args>
 template <typename Fn>
-std::unique_ptr<typename CallbackQueue<R, Args...>::Callback>
-CallbackQueue<R, Args...>::CreateCallback(Fn&& fn, CallbackFlags::Flags flags) {
-  return std::make_unique<CallbackImpl<Fn>>(std::move(fn), flags);
+void CallbackQueue<R, Args...>::Push(Fn&& fn, CallbackFlags::Flags flags) {
+  using Impl = CallbackImpl<Fn>;
+  static_assert(alignof(Impl) <= alignof(std::max_align_t),
+                "Over-aligned callbacks are not supported");
+  Callback* callback =
+      new (Allocate(sizeof(Impl))) Impl(std::move(fn), flags);
+  Storage* storage = storage_.get();
+  callback->slab_ = storage->current;
+  if (storage->tail != nullptr)
+    storage->tail->next_ = callback;
+  else
+    storage->head = callback;
+  storage->tail = callback;
+  size_++;
 }
 
 template <typename R, typename... Args>
-std::unique_ptr<typename CallbackQueue<R, Args...>::Callback>
+typename CallbackQueue<R, Args...>::CallbackPointer
 CallbackQueue<R, Args...>::Shift() {
-  std::unique_ptr<Callback> ret = std::move(head_);
-  if (ret) {
-    head_ = ret->get_next();
-    if (!head_)
-      tail_ = nullptr;  // The queue is now empty.
-    size_--;
-  }
-  return ret;
+  if (!storage_ || storage_->head == nullptr) return CallbackPointer();
+  Storage* storage = storage_.get();
+  Callback* callback = storage->head;
+  storage->head = callback->next_;
+  if (storage->head == nullptr)
+    storage->tail = nullptr;  // The queue is now empty.
+  storage->outstanding++;
+  size_--;
+  return CallbackPointer(callback);
 }
 
 template <typename R, typename... Args>
-void CallbackQueue<R, Args...>::Push(std::unique_ptr<Callback> cb) {
-  Callback* prev_tail = tail_;
-
-  size_++;
-  tail_ = cb.get();
-  if (prev_tail != nullptr)
-    prev_tail->set_next(std::move(cb));
-  else
-    head_ = std::move(cb);
+void CallbackQueue<R, Args...>::Swap(CallbackQueue* other) {
+  DCHECK(!storage_ || storage_->outstanding == 0);
+  DCHECK(!other->storage_ || other->storage_->outstanding == 0);
+  storage_.swap(other->storage_);
+  const size_t size = size_.load();
+  size_ = other->size_.load();
+  other->size_ = size;
 }
 
 template <typename R, typename... Args>
-void CallbackQueue<R, Args...>::ConcatMove(CallbackQueue<R, Args...>&& other) {
-  size_ += other.size_;
-  if (tail_ != nullptr)
-    tail_->set_next(std::move(other.head_));
-  else
-    head_ = std::move(other.head_);
-  tail_ = other.tail_;
-  other.tail_ = nullptr;
-  other.size_ = 0;
+bool CallbackQueue<R, Args...>::idle() const {
+  return !storage_ ||
+         (storage_->head == nullptr && storage_->outstanding == 0);
 }
 
 template <typename R, typename... Args>
@@ -57,24 +75,122 @@ size_t CallbackQueue<R, Args...>::size() const {
 }
 
 template <typename R, typename... Args>
-CallbackQueue<R, Args...>::Callback::Callback(CallbackFlags::Flags flags)
-  : flags_(flags) {}
+char* CallbackQueue<R, Args...>::SlabData(Slab* slab) {
+  return reinterpret_cast<char*>(slab) +
+         RoundUp(sizeof(Slab), alignof(std::max_align_t));
+}
 
 template <typename R, typename... Args>
-CallbackFlags::Flags CallbackQueue<R, Args...>::Callback::flags() const {
-  return flags_;
+void* CallbackQueue<R, Args...>::Allocate(size_t size) {
+  size = RoundUp(size, alignof(std::max_align_t));
+  if (!storage_) storage_ = std::make_unique<Storage>();
+  Storage* storage = storage_.get();
+  Slab* slab = storage->current;
+  if (slab == nullptr || slab->capacity - slab->used < size) {
+    if (size <= kSlabSize && storage->spare != nullptr) {
+      slab = storage->spare;
+      storage->spare = slab->next;
+      storage->spare_count--;
+    } else {
+      // Callbacks that do not fit into a regular slab get one of their own.
+      const size_t capacity = std::max(size, kSlabSize);
+      slab = static_cast<Slab*>(::operator new(
+          RoundUp(sizeof(Slab), alignof(std::max_align_t)) + capacity));
+      slab->storage = storage;
+      slab->capacity = capacity;
+    }
+    slab->next = nullptr;
+    slab->used = 0;
+    slab->live = 0;
+    Slab* previous = storage->current;
+    storage->current = slab;
+    if (previous != nullptr && previous->live == 0) Recycle(previous);
+  }
+  void* ptr = SlabData(slab) + slab->used;
+  slab->used += size;
+  slab->live++;
+  return ptr;
+}
+
+template <typename R, typename... Args>
+void CallbackQueue<R, Args...>::Release(Callback* callback) {
+  Slab* slab = callback->slab_;
+  Storage* storage = slab->storage;
+  callback->~Callback();
+  storage->outstanding--;
+  if (--slab->live > 0) return;
+  // The current slab is simply rewound, which keeps a queue that is drained
+  // as fast as it is filled inside the same slab.
+  if (slab == storage->current)
+    slab->used = 0;
+  else
+    Recycle(slab);
+}
+
+template <typename R, typename... Args>
+void CallbackQueue<R, Args...>::Recycle(Slab* slab) {
+  Storage* storage = slab->storage;
+  if (slab->capacity == kSlabSize && storage->spare_count < kMaxSpareSlabs) {
+    slab->next = storage->spare;
+    storage->spare = slab;
+    storage->spare_count++;
+  } else {
+    ::operator delete(slab);
+  }
+}
+
+template <typename R, typename... Args>
+void CallbackQueue<R, Args...>::FreeSlabs(Slab* slab) {
+  while (slab != nullptr) {
+    Slab* next = slab->next;
+    ::operator delete(slab);
+    slab = next;
+  }
+}
+
+template <typename R, typename... Args>
+CallbackQueue<R, Args...>::CallbackPointer::CallbackPointer(
+    Callback* callback)
+  : callback_(callback) {}
+
+template <typename R, typename... Args>
+CallbackQueue<R, Args...>::CallbackPointer::CallbackPointer(
+    CallbackPointer&& other)
+  : callback_(other.callback_) {
+  other.callback_ = nullptr;
+}
+
+template <typename R, typename... Args>
+typename CallbackQueue<R, Args...>::CallbackPointer&
+CallbackQueue<R, Args...>::CallbackPointer::operator=(
+    CallbackPointer&& other) {
+  if (this != &other) {
+    reset();
+    callback_ = other.callback_;
+    other.callback_ = nullptr;
+  }
+  return *this;
+}
+
+template <typename R, typename... Args>
+CallbackQueue<R, Args...>::CallbackPointer::~CallbackPointer() {
+  reset();
 }
 
 template <typename R, typename... Args>
-std::unique_ptr<typename CallbackQueue<R, Args...>::Callback>
-CallbackQueue<R, Args...>::Callback::get_next() {
-  return std::move(next_);
+void CallbackQueue<R, Args...>::CallbackPointer::reset() {
+  Callback* callback = callback_;
+  callback_ = nullptr;
+  if (callback != nullptr) Release(callback);
 }
 
 template <typename R, typename... Args>
-void CallbackQueue<R, Args...>::Callback::set_next(
-    std::unique_ptr<Callback> next) {
-  next_ = std::move(next);
+CallbackQueue<R, Args...>::Callback::Callback(CallbackFlags::Flags flags)
+  : flags_(flags) {}
+
+template <typename R, typename... Args>
+CallbackFlags::Flags CallbackQueue<R, Args...>::Callback::flags() const {
+  return flags_;
 }
 
 template <typename R, typename... Args>
@@ -4,6 +4,8 @@
 #if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
 
 #include <atomic>
+#include <cstddef>
+#include <memory>
 
 namespace node {
 
@@ -16,12 +18,20 @@ enum Flags {
 
 // A queue of C++ functions that take Args... as arguments and return R
 // (this is similar to the signature of std::function).
-// New entries are added using `CreateCallback()`/`Push()`, and removed using
-// `Shift()`.
+// New entries are added using `Push()`, and removed using `Shift()`.
 // The `refed` flag is left for easier use in situations in which some of these
 // should be run even if nothing else is keeping the event loop alive.
+//
+// Callbacks are constructed in place in slabs owned by the queue, so pushing
+// one does not allocate once the queue has warmed up. A callback is destroyed
+// when the pointer returned by `Shift()` is reset, and a slab is reused once
+// all of its callbacks are gone. That may be after the queue has moved on to
+// later callbacks, e.g. when a callback drains the queue re-entrantly.
 template <typename R, typename... Args>
 class CallbackQueue {
+  struct Slab;
+  struct Storage;
+
  public:
   class Callback {
    public:
@@ -33,29 +43,60 @@ class CallbackQueue {
     inline CallbackFlags::Flags flags() const;
 
    private:
-    inline std::unique_ptr<Callback> get_next();
-    inline void set_next(std::unique_ptr<Callback> next);
-
     CallbackFlags::Flags flags_;
-    std::unique_ptr<Callback> next_;
+    Callback* next_ = nullptr;
+    Slab* slab_ = nullptr;
 
     friend class CallbackQueue;
   };
 
+  // Owns a callback that has been shifted off the queue.
+  class CallbackPointer {
+   public:
+    CallbackPointer() = default;
+    inline explicit CallbackPointer(Callback* callback);
+    inline CallbackPointer(CallbackPointer&& other);
+    inline CallbackPointer& operator=(CallbackPointer&& other);
+    inline ~CallbackPointer();
+
+    CallbackPointer(const CallbackPointer&) = delete;
+    CallbackPointer& operator=(const CallbackPointer&) = delete;
+
+    Callback* operator->() const { return callback_; }
+    explicit operator bool() const { return callback_ != nullptr; }
+    inline void reset();
+
+   private:
+    Callback* callback_ = nullptr;
+  };
+
+  CallbackQueue() = default;
+  inline ~CallbackQueue();
+
+  CallbackQueue(const CallbackQueue&) = delete;
+  CallbackQueue& operator=(const CallbackQueue&) = delete;
+
   template <typename Fn>
-  inline std::unique_ptr<Callback> CreateCallback(
-      Fn&& fn, CallbackFlags::Flags);
+  inline void Push(Fn&& fn, CallbackFlags::Flags flags);
+  inline CallbackPointer Shift();
+
+  // Exchanges the contents, including the slabs, of two queues. Both must be
+  // idle() unless they are empty. This is how callbacks that were pushed
+  // under a lock are taken out to run without it.
+  inline void Swap(CallbackQueue* other);
 
-  inline std::unique_ptr<Callback> Shift();
-  inline void Push(std::unique_ptr<Callback> cb);
-  // ConcatMove adds elements from 'other' to the end of this list, and clears
-  // 'other' afterwards.
-  inline void ConcatMove(CallbackQueue&& other);
+  // Whether the queue is empty and every callback shifted off it has been
+  // destroyed.
+  inline bool idle() const;
 
   // size() is atomic and may be called from any thread.
   inline size_t size() const;
 
  private:
+  static constexpr size_t kSlabSize = 4096;
+  // Slabs kept around for reuse after the current one fills up.
+  static constexpr size_t kMaxSpareSlabs = 4;
+
   template <typename Fn>
   class CallbackImpl final : public Callback {
    public:
@@ -66,9 +107,35 @@ class CallbackQueue {
     Fn callback_;
   };
 
+  struct Slab {
+    Storage* storage;
+    Slab* next;
+    size_t capacity;
+    size_t used;
+    // Callbacks in this slab that have not been destroyed.
+    size_t live;
+  };
+
+  // Kept behind a pointer so that slabs can find their queue after Swap().
+  struct Storage {
+    Callback* head = nullptr;
+    Callback* tail = nullptr;
+    // The slab that new callbacks are allocated from.
+    Slab* current = nullptr;
+    Slab* spare = nullptr;
+    size_t spare_count = 0;
+    // Callbacks that have been shifted but not destroyed.
+    size_t outstanding = 0;
+  };
+
+  static inline char* SlabData(Slab* slab);
+  inline void* Allocate(size_t size);
+  static inline void Release(Callback* callback);
+  static inline void Recycle(Slab* slab);
+  static inline void FreeSlabs(Slab* slab);
+
   std::atomic<size_t> size_ {0};
-  std::unique_ptr<Callback> head_;
-  Callback* tail_ = nullptr;
+  std::unique_ptr<Storage> storage_;
 };
 
 }  // namespace node
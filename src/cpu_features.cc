@@ -0,0 +1,57 @@
+#include "cpu_features.h"
+
+#if defined(NODE_SIMD_X64) && defined(_MSC_VER)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+namespace node {
+namespace cpu_features {
+
+namespace {
+
+struct Features {
+  bool ssse3 = false;
+  bool avx2 = false;
+
+  Features() {
+#if defined(NODE_SIMD_X64) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    const int max_leaf = info[0];
+    __cpuid(info, 1);
+    ssse3 = (info[2] & (1 << 9)) != 0;
+    // AVX2 also needs the OS to preserve the YMM registers (OSXSAVE + XCR0).
+    const bool os_avx = (info[2] & (1 << 27)) != 0 &&
+                        (info[2] & (1 << 28)) != 0 &&
+                        (_xgetbv(0) & 0x6) == 0x6;
+    if (max_leaf >= 7 && os_avx) {
+      __cpuidex(info, 7, 0);
+      avx2 = (info[1] & (1 << 5)) != 0;
+    }
+#elif defined(NODE_SIMD_X64)
+    // __builtin_cpu_supports() takes the OS support for AVX into account.
+    __builtin_cpu_init();
+    ssse3 = __builtin_cpu_supports("ssse3");
+    avx2 = __builtin_cpu_supports("avx2");
+#endif
+  }
+};
+
+const Features& GetFeatures() {
+  static const Features features;
+  return features;
+}
+
+}  // anonymous namespace
+
+bool HasSSSE3() {
+  return GetFeatures().ssse3;
+}
+
+bool HasAVX2() {
+  return GetFeatures().avx2;
+}
+
+}  // namespace cpu_features
+}  // namespace node
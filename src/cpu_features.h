@@ -0,0 +1,46 @@
+#ifndef SRC_CPU_FEATURES_H_
+#define SRC_CPU_FEATURES_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+// Helpers for the hand-vectorized kernels in src/. Only the x86-64 and arm64
+// baselines (SSE2 and NEON) are assumed to be present; anything newer is
+// detected at runtime and compiled in through per-function target attributes
+// so that the rest of the binary keeps the default target.
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define NODE_SIMD_X64 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define NODE_SIMD_ARM64 1
+#endif
+
+#if defined(NODE_SIMD_X64) && (defined(__GNUC__) || defined(__clang__))
+#define NODE_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define NODE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+// MSVC makes all intrinsics available without changing the target.
+#define NODE_TARGET_SSSE3
+#define NODE_TARGET_AVX2
+#endif
+
+// Kernels are written once, without a target attribute, and forced inline
+// into the target-specific entry points.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define NODE_SIMD_INLINE __forceinline
+#else
+#define NODE_SIMD_INLINE inline __attribute__((always_inline))
+#endif
+
+namespace node {
+namespace cpu_features {
+
+// These are computed once per process and are cheap to call afterwards.
+bool HasSSSE3();
+bool HasAVX2();
+
+}  // namespace cpu_features
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_CPU_FEATURES_H_
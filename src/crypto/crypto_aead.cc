@@ -0,0 +1,376 @@
+#include "crypto/crypto_aead.h"
+#include "async_wrap-inl.h"
+#include "base_object-inl.h"
+#include "crypto/crypto_cipher.h"
+#include "crypto/crypto_keys.h"
+#include "crypto/crypto_util.h"
+#include "env-inl.h"
+#include "memory_tracker-inl.h"
+#include "threadpoolwork-inl.h"
+#include "v8.h"
+
+#include <vector>
+
+namespace node {
+
+using v8::Array;
+using v8::FunctionCallbackInfo;
+using v8::Just;
+using v8::Local;
+using v8::Maybe;
+using v8::Object;
+using v8::Uint32;
+using v8::Value;
+
+namespace crypto {
+namespace {
+constexpr unsigned int kMaxAEADTagLength = 16;
+constexpr size_t kChaCha20Poly1305NonceLength = 12;
+
+bool IsValidGCMTagLength(unsigned int tag_len) {
+  return tag_len == 4 || tag_len == 8 || (tag_len >= 12 && tag_len <= 16);
+}
+
+const EVP_CIPHER* GetAEADBatchCipher(uint32_t variant) {
+  switch (variant) {
+#define V(name, nid)                                                          \
+    case kAEADBatch_ ## name:                                                 \
+      return EVP_get_cipherbynid(nid);
+    AEAD_BATCH_VARIANTS(V)
+#undef V
+    default:
+      return nullptr;
+  }
+}
+}  // namespace
+
+// The cipher and the key are only set up once; each record then only resets
+// the nonce, which for both AES-GCM and ChaCha20-Poly1305 leaves the expanded
+// key in place.
+bool AEADBatchCipher(const AEADBatchConfig& params, ByteSource* out) {
+  CHECK_EQ(params.key->GetKeyType(), kKeyTypeSecret);
+
+  const bool encrypt = params.cipher_mode == kWebCryptoCipherEncrypt;
+
+  CipherCtxPointer ctx(EVP_CIPHER_CTX_new());
+  if (!ctx ||
+      !EVP_CipherInit_ex(
+          ctx.get(),
+          params.cipher,
+          nullptr,
+          reinterpret_cast<const unsigned char*>(
+              params.key->GetSymmetricKey()),
+          nullptr,
+          encrypt)) {
+    return false;
+  }
+
+  // Allocate at least one byte so that the final call always has somewhere
+  // to point to, even if every record decrypts to nothing.
+  ByteSource::Builder buf(std::max<size_t>(params.output_length, 1));
+  unsigned char* output = buf.data<unsigned char>();
+  const unsigned char* data = params.data.data<unsigned char>();
+  size_t nonce_length = EVP_CIPHER_iv_length(params.cipher);
+  size_t total = 0;
+
+  for (const AEADBatchConfig::Record& record : params.records) {
+    size_t length = record.input_length;
+    if (!encrypt) length -= params.tag_length;
+
+    if (record.nonce_length != nonce_length) {
+      if (!EVP_CIPHER_CTX_ctrl(ctx.get(),
+                               EVP_CTRL_AEAD_SET_IVLEN,
+                               record.nonce_length,
+                               nullptr)) {
+        return false;
+      }
+      nonce_length = record.nonce_length;
+    }
+
+    if (!EVP_CipherInit_ex(ctx.get(),
+                           nullptr,
+                           nullptr,
+                           nullptr,
+                           data + record.nonce_offset,
+                           encrypt)) {
+      return false;
+    }
+
+    // When decrypting, the tag is the tail of the input.
+    if (!encrypt &&
+        !EVP_CIPHER_CTX_ctrl(
+            ctx.get(),
+            EVP_CTRL_AEAD_SET_TAG,
+            params.tag_length,
+            const_cast<unsigned char*>(data + record.input_offset + length))) {
+      return false;
+    }
+
+    int out_len;
+    if (record.additional_data_length > 0 &&
+        !EVP_CipherUpdate(ctx.get(),
+                          nullptr,
+                          &out_len,
+                          data + record.additional_data_offset,
+                          record.additional_data_length)) {
+      return false;
+    }
+
+    if (length > 0) {
+      if (!EVP_CipherUpdate(ctx.get(),
+                            output + total,
+                            &out_len,
+                            data + record.input_offset,
+                            length)) {
+        return false;
+      }
+      total += out_len;
+    }
+
+    // Fails if a record does not authenticate.
+    if (!EVP_CipherFinal_ex(ctx.get(), output + total, &out_len))
+      return false;
+    total += out_len;
+
+    if (encrypt) {
+      if (!EVP_CIPHER_CTX_ctrl(ctx.get(),
+                               EVP_CTRL_AEAD_GET_TAG,
+                               params.tag_length,
+                               output + total)) {
+        return false;
+      }
+      total += params.tag_length;
+    }
+  }
+
+  CHECK_EQ(total, params.output_length);
+  *out = std::move(buf).release(total);
+  return true;
+}
+
+AEADBatchConfig::AEADBatchConfig(AEADBatchConfig&& other) noexcept
+    : mode(other.mode),
+      cipher_mode(other.cipher_mode),
+      cipher(other.cipher),
+      key(std::move(other.key)),
+      tag_length(other.tag_length),
+      data(std::move(other.data)),
+      records(std::move(other.records)),
+      output_length(other.output_length) {}
+
+AEADBatchConfig& AEADBatchConfig::operator=(AEADBatchConfig&& other) noexcept {
+  if (&other == this) return *this;
+  this->~AEADBatchConfig();
+  return *new (this) AEADBatchConfig(std::move(other));
+}
+
+void AEADBatchConfig::MemoryInfo(MemoryTracker* tracker) const {
+  tracker->TrackField("key", key);
+  tracker->TrackFieldWithSize("data", data.size());
+  tracker->TrackFieldWithSize("records", records.size() * sizeof(Record));
+}
+
+// new AEADBatchJob(mode, cipherMode, key, variant, tagLength, records)
+// where each entry of records is an array [nonce, additionalData, input] and
+// additionalData may be undefined.
+void AEADBatchJob::New(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  CHECK(args.IsConstructCall());
+
+  AEADBatchConfig params;
+  params.mode = GetCryptoJobMode(args[0]);
+
+  CHECK(args[1]->IsUint32());  // Cipher Mode
+  uint32_t cmode = args[1].As<Uint32>()->Value();
+  CHECK_LE(cmode, WebCryptoCipherMode::kWebCryptoCipherDecrypt);
+  params.cipher_mode = static_cast<WebCryptoCipherMode>(cmode);
+  const bool encrypt = params.cipher_mode == kWebCryptoCipherEncrypt;
+
+  CHECK(args[2]->IsObject());  // KeyObject
+  KeyObjectHandle* key;
+  ASSIGN_OR_RETURN_UNWRAP(&key, args[2]);
+  params.key = key->Data();
+  if (params.key->GetKeyType() != kKeyTypeSecret)
+    return THROW_ERR_CRYPTO_INVALID_KEYTYPE(env);
+
+  CHECK(args[3]->IsUint32());  // Variant
+  params.cipher = GetAEADBatchCipher(args[3].As<Uint32>()->Value());
+  if (params.cipher == nullptr)
+    return THROW_ERR_CRYPTO_UNKNOWN_CIPHER(env);
+  if (params.key->GetSymmetricKeySize() !=
+      static_cast<size_t>(EVP_CIPHER_key_length(params.cipher))) {
+    return THROW_ERR_CRYPTO_INVALID_KEYLEN(env);
+  }
+  const bool is_gcm = EVP_CIPHER_mode(params.cipher) == EVP_CIPH_GCM_MODE;
+
+  CHECK(args[4]->IsUint32());  // Tag Length
+  params.tag_length = args[4].As<Uint32>()->Value();
+  if (is_gcm ? !IsValidGCMTagLength(params.tag_length)
+             : (params.tag_length == 0 ||
+                params.tag_length > kMaxAEADTagLength)) {
+    return THROW_ERR_CRYPTO_INVALID_TAG_LENGTH(env);
+  }
+
+  CHECK(args[5]->IsArray());  // Records
+  Local<Array> records = args[5].As<Array>();
+  const uint32_t count = records->Length();
+
+  // All of the records are fetched before any of them is measured. Element
+  // getters are user code, and could otherwise detach or shrink a buffer
+  // that has already been sized.
+  struct RecordParts {
+    Local<Value> nonce;
+    Local<Value> additional_data;
+    Local<Value> input;
+  };
+  std::vector<RecordParts> parts;
+  for (uint32_t i = 0; i < count; i++) {
+    Local<Value> record;
+    if (!records->Get(env->context(), i).ToLocal(&record)) return;
+    if (!record->IsArray() || record.As<Array>()->Length() < 3) {
+      return THROW_ERR_INVALID_ARG_TYPE(
+          env, "records[%d] must be [nonce, additionalData, data]", i);
+    }
+    Local<Array> fields = record.As<Array>();
+    RecordParts part;
+    if (!fields->Get(env->context(), 0).ToLocal(&part.nonce) ||
+        !fields->Get(env->context(), 1).ToLocal(&part.additional_data) ||
+        !fields->Get(env->context(), 2).ToLocal(&part.input)) {
+      return;
+    }
+    parts.push_back(part);
+  }
+
+  // No user code runs from here on, so the sizes measured below are the sizes
+  // that get copied.
+  size_t data_length = 0;
+  params.output_length = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    RecordParts* part = &parts[i];
+    if (!IsAnyByteSource(part->nonce) ||
+        !(part->additional_data->IsUndefined() ||
+          IsAnyByteSource(part->additional_data)) ||
+        !IsAnyByteSource(part->input)) {
+      return THROW_ERR_INVALID_ARG_TYPE(
+          env, "records[%d] must be [nonce, additionalData, data]", i);
+    }
+    if (part->additional_data->IsUndefined())
+      part->additional_data = Local<Value>();
+
+    ArrayBufferOrViewContents<char> nonce(part->nonce);
+    if (is_gcm ? (nonce.size() == 0 || !nonce.CheckSizeInt32())
+               : nonce.size() != kChaCha20Poly1305NonceLength) {
+      return THROW_ERR_CRYPTO_INVALID_IV(env);
+    }
+
+    ArrayBufferOrViewContents<char> additional_data(part->additional_data);
+    if (!additional_data.CheckSizeInt32())
+      return THROW_ERR_OUT_OF_RANGE(env, "additionalData is too big");
+
+    ArrayBufferOrViewContents<char> input(part->input);
+    if (!input.CheckSizeInt32())
+      return THROW_ERR_OUT_OF_RANGE(env, "data is too large");
+    if (!encrypt && input.size() < params.tag_length)
+      return THROW_ERR_CRYPTO_INVALID_AUTH_TAG(env);
+
+    params.records.push_back({
+        data_length,
+        nonce.size(),
+        data_length + nonce.size(),
+        additional_data.size(),
+        data_length + nonce.size() + additional_data.size(),
+        input.size(),
+    });
+    data_length += nonce.size() + additional_data.size() + input.size();
+    params.output_length += encrypt ? input.size() + params.tag_length
+                                    : input.size() - params.tag_length;
+  }
+
+  // Unlike the single-message cipher jobs, the inputs are copied even for
+  // synchronous jobs, because they have to be packed anyway.
+  ByteSource::Builder data(data_length);
+  for (uint32_t i = 0; i < count; i++) {
+    const AEADBatchConfig::Record& record = params.records[i];
+    const RecordParts& part = parts[i];
+    ArrayBufferOrViewContents<char> nonce(part.nonce);
+    ArrayBufferOrViewContents<char> additional_data(part.additional_data);
+    ArrayBufferOrViewContents<char> input(part.input);
+    CHECK_EQ(nonce.size(), record.nonce_length);
+    CHECK_EQ(additional_data.size(), record.additional_data_length);
+    CHECK_EQ(input.size(), record.input_length);
+    nonce.CopyTo(data.data<char>() + record.nonce_offset, nonce.size());
+    additional_data.CopyTo(data.data<char>() + record.additional_data_offset,
+                           additional_data.size());
+    input.CopyTo(data.data<char>() + record.input_offset, input.size());
+  }
+  params.data = std::move(data).release();
+
+  new AEADBatchJob(env, args.This(), params.mode, std::move(params));
+}
+
+AEADBatchJob::AEADBatchJob(Environment* env,
+                           Local<Object> object,
+                           CryptoJobMode mode,
+                           AEADBatchConfig&& params)
+    : CryptoJob<AEADBatchTraits>(env,
+                                 object,
+                                 AsyncWrap::PROVIDER_CIPHERREQUEST,
+                                 mode,
+                                 std::move(params)) {}
+
+void AEADBatchJob::DoThreadPoolWork() {
+  if (!AEADBatchCipher(*params(), &out_)) {
+    CryptoErrorStore* errors = this->errors();
+    errors->Capture();
+    if (errors->Empty())
+      errors->Insert(NodeCryptoError::CIPHER_JOB_FAILED);
+    return;
+  }
+  success_ = true;
+}
+
+Maybe<bool> AEADBatchJob::ToResult(Local<Value>* err, Local<Value>* result) {
+  Environment* env = AsyncWrap::env();
+  CryptoErrorStore* errors = this->errors();
+  if (success_) {
+    CHECK(errors->Empty());
+    *err = v8::Undefined(env->isolate());
+    *result = out_.ToArrayBuffer(env);
+    return Just(!result->IsEmpty());
+  }
+
+  if (errors->Empty())
+    errors->Capture();
+  CHECK(!errors->Empty());
+  *result = v8::Undefined(env->isolate());
+  return Just(errors->ToException(env).ToLocal(err));
+}
+
+void AEADBatchJob::MemoryInfo(MemoryTracker* tracker) const {
+  tracker->TrackFieldWithSize("out", out_.size());
+  CryptoJob<AEADBatchTraits>::MemoryInfo(tracker);
+}
+
+void AEADBatchJob::Initialize(Environment* env, Local<Object> target) {
+  CryptoJob<AEADBatchTraits>::Initialize(New, env, target);
+}
+
+void AEADBatchJob::RegisterExternalReferences(
+    ExternalReferenceRegistry* registry) {
+  CryptoJob<AEADBatchTraits>::RegisterExternalReferences(New, registry);
+}
+
+void AEAD::Initialize(Environment* env, Local<Object> target) {
+  AEADBatchJob::Initialize(env, target);
+
+#define V(name, _) NODE_DEFINE_CONSTANT(target, kAEADBatch_ ## name);
+  AEAD_BATCH_VARIANTS(V)
+#undef V
+}
+
+void AEAD::RegisterExternalReferences(ExternalReferenceRegistry* registry) {
+  AEADBatchJob::RegisterExternalReferences(registry);
+}
+
+}  // namespace crypto
+}  // namespace node
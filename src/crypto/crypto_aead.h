@@ -0,0 +1,112 @@
+#ifndef SRC_CRYPTO_CRYPTO_AEAD_H_
+#define SRC_CRYPTO_CRYPTO_AEAD_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include "crypto/crypto_cipher.h"
+#include "crypto/crypto_keys.h"
+#include "crypto/crypto_util.h"
+#include "env.h"
+#include "v8.h"
+
+#include <vector>
+
+namespace node {
+namespace crypto {
+
+#define AEAD_BATCH_VARIANTS(V)                                                \
+  V(AES_128_GCM, NID_aes_128_gcm)                                             \
+  V(AES_192_GCM, NID_aes_192_gcm)                                             \
+  V(AES_256_GCM, NID_aes_256_gcm)                                             \
+  V(CHACHA20_POLY1305, NID_chacha20_poly1305)
+
+enum AEADBatchVariant {
+#define V(name, _) kAEADBatch_ ## name,
+  AEAD_BATCH_VARIANTS(V)
+#undef V
+};
+
+// A batch of independent messages that are all encrypted, or all decrypted,
+// with one key. The nonce, additional data and input of every record are
+// copied back to back into |data|, so that the job never touches JS memory.
+struct AEADBatchConfig final : public MemoryRetainer {
+  struct Record {
+    size_t nonce_offset;
+    size_t nonce_length;
+    size_t additional_data_offset;
+    size_t additional_data_length;
+    size_t input_offset;
+    size_t input_length;
+  };
+
+  CryptoJobMode mode;
+  WebCryptoCipherMode cipher_mode;
+  const EVP_CIPHER* cipher;
+  std::shared_ptr<KeyObjectData> key;
+  unsigned int tag_length;
+  ByteSource data;
+  std::vector<Record> records;
+  size_t output_length;
+
+  AEADBatchConfig() = default;
+
+  AEADBatchConfig(AEADBatchConfig&& other) noexcept;
+
+  AEADBatchConfig& operator=(AEADBatchConfig&& other) noexcept;
+
+  void MemoryInfo(MemoryTracker* tracker) const override;
+  SET_MEMORY_INFO_NAME(AEADBatchConfig)
+  SET_SELF_SIZE(AEADBatchConfig)
+};
+
+// Encrypts or decrypts all of the records in |params| with a single context,
+// and on success sets |out| to the packed outputs.
+bool AEADBatchCipher(const AEADBatchConfig& params, ByteSource* out);
+
+struct AEADBatchTraits final {
+  static constexpr const char* JobName = "AEADBatchJob";
+
+  using AdditionalParameters = AEADBatchConfig;
+};
+
+// Runs every record of an AEADBatchConfig through a single EVP_CIPHER_CTX,
+// so the key schedule is set up once per batch rather than once per message.
+// When encrypting, each input becomes its ciphertext followed by its tag.
+// When decrypting, each input is a ciphertext followed by its tag and becomes
+// its plaintext. Either way the outputs are packed back to back, in record
+// order, into a single ArrayBuffer. If any record fails to authenticate, the
+// whole job fails.
+class AEADBatchJob final : public CryptoJob<AEADBatchTraits> {
+ public:
+  static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void Initialize(Environment* env, v8::Local<v8::Object> target);
+  static void RegisterExternalReferences(ExternalReferenceRegistry* registry);
+
+  AEADBatchJob(Environment* env,
+               v8::Local<v8::Object> object,
+               CryptoJobMode mode,
+               AEADBatchConfig&& params);
+
+  void DoThreadPoolWork() override;
+
+  v8::Maybe<bool> ToResult(
+      v8::Local<v8::Value>* err,
+      v8::Local<v8::Value>* result) override;
+
+  SET_SELF_SIZE(AEADBatchJob)
+  void MemoryInfo(MemoryTracker* tracker) const override;
+
+ private:
+  ByteSource out_;
+  bool success_ = false;
+};
+
+namespace AEAD {
+void Initialize(Environment* env, v8::Local<v8::Object> target);
+void RegisterExternalReferences(ExternalReferenceRegistry* registry);
+}  // namespace AEAD
+}  // namespace crypto
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+#endif  // SRC_CRYPTO_CRYPTO_AEAD_H_
@@ -3,19 +3,37 @@
 #include "crypto/crypto_util.h"
 #include "env-inl.h"
 #include "memory_tracker-inl.h"
+#include "node_external_reference.h"
+#include "node_realm-inl.h"
 #include "threadpoolwork-inl.h"
+#include "v8-fast-api-calls.h"
 #include "v8.h"
 
 #include <openssl/bn.h>
+#include <openssl/crypto.h>
 #include <openssl/rand.h>
 
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+
 namespace node {
 
 using v8::ArrayBuffer;
 using v8::BackingStore;
 using v8::Boolean;
+using v8::CFunction;
+using v8::Context;
+using v8::FastApiCallbackOptions;
+using v8::FastApiTypedArray;
 using v8::FunctionCallbackInfo;
+using v8::HandleScope;
 using v8::Int32;
+using v8::Isolate;
 using v8::Just;
 using v8::Local;
 using v8::Maybe;
@@ -222,17 +240,219 @@ Maybe<bool> CheckPrimeTraits::EncodeOutput(
   return Just(true);
 }
 
+namespace {
+// Bumped in the child after every fork(), so that a RandomPool can tell that
+// its cache was inherited from the parent.
+std::atomic<uint64_t> fork_generation{0};
+
+#ifndef _WIN32
+void OnForkChild() {
+  fork_generation.fetch_add(1, std::memory_order_relaxed);
+}
+#endif
+
+uint64_t CurrentForkGeneration() {
+  return fork_generation.load(std::memory_order_relaxed);
+}
+
+void WipeBuffer(std::unique_ptr<unsigned char[]>* buffer) {
+  if (*buffer) {
+    OPENSSL_cleanse(buffer->get(), RandomPool::kBufferSize);
+    buffer->reset();
+  }
+}
+
+// pooledRandomFill(buffer, offset, size) returns false if the CSPRNG failed.
+bool FastPooledRandomFill(Local<Value> receiver,
+                          const FastApiTypedArray<uint8_t>& buffer,
+                          uint32_t offset,
+                          uint32_t size,
+                          FastApiCallbackOptions& options) {
+  Isolate* isolate = Isolate::GetCurrent();
+  HandleScope handle_scope(isolate);
+  RandomPool* pool =
+      Realm::GetBindingData<RandomPool>(isolate->GetCurrentContext());
+  // Creating the pool allocates, so leave that to the slow path.
+  if (pool == nullptr) {
+    options.fallback = true;
+    return false;
+  }
+  CHECK_LE(static_cast<uint64_t>(offset) + size, buffer.length());
+  uint8_t* data;
+  CHECK(buffer.getStorageIfAligned(&data));
+  return pool->Fill(data + offset, size);
+}
+
+CFunction fast_pooled_random_fill(CFunction::Make(FastPooledRandomFill));
+}  // namespace
+
+class RandomPool::RefillWork final : public ThreadPoolWork {
+ public:
+  RefillWork(Environment* env, RandomPool* pool)
+      : ThreadPoolWork(env, "crypto"),
+        pool_(pool),
+        fork_generation_(CurrentForkGeneration()),
+        buffer_(new unsigned char[kBufferSize]) {}
+
+  ~RefillWork() override { WipeBuffer(&buffer_); }
+
+  void DoThreadPoolWork() override {
+    success_ = CSPRNG(buffer_.get(), kBufferSize).is_ok();
+  }
+
+  void AfterThreadPoolWork(int status) override {
+    std::unique_ptr<RefillWork> self(this);
+    // The pool was destroyed while the refill was in flight.
+    if (pool_ == nullptr) return;
+    pool_->refill_ = nullptr;
+    // A failed refill is not an error by itself. The next request that
+    // finds the pool empty refills it synchronously and reports failure.
+    if (status == 0 && success_ &&
+        fork_generation_ == CurrentForkGeneration()) {
+      pool_->OnRefilled(std::move(buffer_));
+    }
+  }
+
+  void Detach() { pool_ = nullptr; }
+
+ private:
+  RandomPool* pool_;
+  const uint64_t fork_generation_;
+  std::unique_ptr<unsigned char[]> buffer_;
+  bool success_ = false;
+};
+
+RandomPool::RandomPool(Realm* realm, Local<Object> object)
+    : BaseObject(realm, object), fork_generation_(CurrentForkGeneration()) {
+#ifndef _WIN32
+  static std::once_flag register_at_fork;
+  std::call_once(register_at_fork, []() {
+    CHECK_EQ(pthread_atfork(nullptr, nullptr, OnForkChild), 0);
+  });
+#endif
+}
+
+RandomPool::~RandomPool() {
+  if (refill_ != nullptr) refill_->Detach();
+  WipeBuffer(&buffer_);
+  WipeBuffer(&spare_);
+}
+
+void RandomPool::Discard() {
+  WipeBuffer(&buffer_);
+  WipeBuffer(&spare_);
+  offset_ = kBufferSize;
+  fork_generation_ = CurrentForkGeneration();
+}
+
+bool RandomPool::RefillNow() {
+  if (!buffer_) buffer_.reset(new unsigned char[kBufferSize]);
+  offset_ = kBufferSize;
+  if (!CSPRNG(buffer_.get(), kBufferSize).is_ok()) return false;
+  offset_ = 0;
+  return true;
+}
+
+void RandomPool::OnRefilled(std::unique_ptr<unsigned char[]> buffer) {
+  CHECK(!spare_);
+  spare_ = std::move(buffer);
+}
+
+RandomPool* RandomPool::Get(Realm* realm) {
+  Local<Context> context = realm->context();
+  RandomPool* pool = Realm::GetBindingData<RandomPool>(context);
+  if (pool != nullptr) return pool;
+  if (realm->env()->isolate_data()->options()->build_snapshot) return nullptr;
+
+  Local<Object> object;
+  if (!BaseObject::MakeLazilyInitializedJSTemplate(realm->env())
+           ->InstanceTemplate()
+           ->NewInstance(context)
+           .ToLocal(&object)) {
+    return nullptr;
+  }
+  return realm->AddBindingData<RandomPool>(context, object);
+}
+
+bool RandomPool::Fill(unsigned char* data, size_t size) {
+  // The buffer may not even exist yet.
+  if (size == 0) return true;
+  if (size > kMaxPooledSize) return CSPRNG(data, size).is_ok();
+
+  if (UNLIKELY(fork_generation_ != CurrentForkGeneration())) Discard();
+
+  if (kBufferSize - offset_ < size) {
+    if (spare_) {
+      WipeBuffer(&buffer_);
+      buffer_ = std::move(spare_);
+      offset_ = 0;
+    } else if (!RefillNow()) {
+      return false;
+    }
+  }
+
+  unsigned char* source = buffer_.get() + offset_;
+  memcpy(data, source, size);
+  OPENSSL_cleanse(source, size);
+  offset_ += size;
+
+  if (kBufferSize - offset_ < kRefillThreshold && !spare_ &&
+      refill_ == nullptr) {
+    refill_ = new RefillWork(env(), this);
+    refill_->ScheduleWork();
+  }
+  return true;
+}
+
+void RandomPool::SlowFill(const FunctionCallbackInfo<Value>& args) {
+  CHECK(IsAnyByteSource(args[0]));  // Buffer to fill
+  CHECK(args[1]->IsUint32());  // Offset
+  CHECK(args[2]->IsUint32());  // Size
+
+  ArrayBufferOrViewContents<unsigned char> buffer(args[0]);
+  const uint32_t offset = args[1].As<Uint32>()->Value();
+  const uint32_t size = args[2].As<Uint32>()->Value();
+  CHECK_LE(static_cast<uint64_t>(offset) + size, buffer.size());
+
+  RandomPool* pool = Get(Realm::GetCurrent(args));
+  unsigned char* data = buffer.data() + offset;
+  args.GetReturnValue().Set(pool != nullptr ? pool->Fill(data, size)
+                                            : CSPRNG(data, size).is_ok());
+}
+
+void RandomPool::MemoryInfo(MemoryTracker* tracker) const {
+  tracker->TrackFieldWithSize("buffer", buffer_ ? kBufferSize : 0);
+  tracker->TrackFieldWithSize("spare", spare_ ? kBufferSize : 0);
+}
+
+void RandomPool::Initialize(Environment* env, Local<Object> target) {
+  SetFastMethod(env->context(),
+                target,
+                "pooledRandomFill",
+                SlowFill,
+                &fast_pooled_random_fill);
+}
+
+void RandomPool::RegisterExternalReferences(
+    ExternalReferenceRegistry* registry) {
+  registry->Register(SlowFill);
+  registry->Register(FastPooledRandomFill);
+  registry->Register(fast_pooled_random_fill.GetTypeInfo());
+}
+
 namespace Random {
 void Initialize(Environment* env, Local<Object> target) {
   RandomBytesJob::Initialize(env, target);
   RandomPrimeJob::Initialize(env, target);
   CheckPrimeJob::Initialize(env, target);
+  RandomPool::Initialize(env, target);
 }
 
 void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   RandomBytesJob::RegisterExternalReferences(registry);
   RandomPrimeJob::RegisterExternalReferences(registry);
   CheckPrimeJob::RegisterExternalReferences(registry);
+  RandomPool::RegisterExternalReferences(registry);
 }
 }  // namespace Random
 }  // namespace crypto
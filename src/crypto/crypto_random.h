@@ -10,6 +10,11 @@
 #include "node_internals.h"
 #include "v8.h"
 
+#include <memory>
+
+// Forward declare test fixture for `friend` declaration.
+class RandomPoolTest;
+
 namespace node {
 namespace crypto {
 struct RandomBytesConfig final : public MemoryRetainer {
@@ -119,6 +124,60 @@ struct CheckPrimeTraits final {
 
 using CheckPrimeJob = DeriveBitsJob<CheckPrimeTraits>;
 
+// Serves small random requests on the main thread from a per-Environment
+// cache of CSPRNG output, so that they do not each take the lock around
+// OpenSSL's DRBG. The cache is refilled in large batches: while requests are
+// served from the active buffer, a second buffer is filled on the threadpool
+// once the active one runs low. Bytes are wiped from the cache as they are
+// handed out, and the whole cache is discarded in a forked child, so no two
+// processes ever share output.
+//
+// The pool is created on first use rather than with the binding, and not at
+// all while a snapshot is being built, since it cannot be serialized.
+class RandomPool final : public BaseObject {
+ public:
+  // Larger requests already amortize the lock, and go to the CSPRNG directly.
+  static constexpr size_t kMaxPooledSize = 256;
+  static constexpr size_t kBufferSize = 16 * 1024;
+  static constexpr size_t kRefillThreshold = kBufferSize / 2;
+
+  RandomPool(Realm* realm, v8::Local<v8::Object> object);
+  ~RandomPool() override;
+
+  static void Initialize(Environment* env, v8::Local<v8::Object> target);
+  static void RegisterExternalReferences(ExternalReferenceRegistry* registry);
+
+  // Returns the pool of |realm|, creating it if needed. Returns nullptr while
+  // a snapshot is being built.
+  static RandomPool* Get(Realm* realm);
+
+  // Fills |size| bytes at |data|. Returns false if the CSPRNG failed.
+  bool Fill(unsigned char* data, size_t size);
+
+  SET_BINDING_ID(crypto_random_pool)
+  void MemoryInfo(MemoryTracker* tracker) const override;
+  SET_MEMORY_INFO_NAME(RandomPool)
+  SET_SELF_SIZE(RandomPool)
+
+ private:
+  class RefillWork;
+
+  static void SlowFill(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  void Discard();
+  bool RefillNow();
+  void OnRefilled(std::unique_ptr<unsigned char[]> buffer);
+
+  std::unique_ptr<unsigned char[]> buffer_;
+  std::unique_ptr<unsigned char[]> spare_;
+  // Bytes of buffer_ before this offset have been handed out already.
+  size_t offset_ = kBufferSize;
+  uint64_t fork_generation_;
+  RefillWork* refill_ = nullptr;
+
+  friend class ::RandomPoolTest;
+};
+
 namespace Random {
 void Initialize(Environment* env, v8::Local<v8::Object> target);
 void RegisterExternalReferences(ExternalReferenceRegistry* registry);
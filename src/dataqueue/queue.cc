@@ -7,11 +7,12 @@
 #include <node_bob-inl.h>
 #include <node_errors.h>
 #include <node_external_reference.h>
-#include <node_file-inl.h>
-#include <stream_base-inl.h>
 #include <util-inl.h>
 #include <uv.h>
 #include <v8.h>
+#ifndef _WIN32
+#include <poll.h>
+#endif
 #include <algorithm>
 #include <deque>
 #include <initializer_list>
@@ -20,6 +21,7 @@
 
 namespace node {
 
+using v8::ArrayBuffer;
 using v8::ArrayBufferView;
 using v8::BackingStore;
 using v8::Local;
@@ -36,6 +38,13 @@ class EntryImpl : public DataQueue::Entry {
   virtual std::shared_ptr<DataQueue::Reader> get_reader() = 0;
 };
 
+// A best-effort check whether a file has changed since `original` was taken,
+// based on its size and modification time only.
+bool IsModified(const uv_stat_t& original, const uv_stat_t& current) {
+  return current.st_size != original.st_size ||
+         current.st_mtim.tv_nsec != original.st_mtim.tv_nsec;
+}
+
 class DataQueueImpl final : public DataQueue,
                             public std::enable_shared_from_this<DataQueueImpl> {
  public:
@@ -162,6 +171,14 @@ class DataQueueImpl final : public DataQueue,
         "entries", entries_, "std::vector<std::unique_ptr<Entry>>");
   }
 
+  bool GetExtents(std::vector<Extent>* extents) const override {
+    if (!idempotent_) return false;
+    for (const auto& entry : entries_) {
+      if (!entry->GetExtents(extents)) return false;
+    }
+    return true;
+  }
+
   std::shared_ptr<Reader> get_reader() override;
   SET_MEMORY_INFO_NAME(DataQueue)
   SET_SELF_SIZE(DataQueueImpl)
@@ -554,6 +571,10 @@ class EmptyEntry final : public EntryImpl {
 
   bool is_idempotent() const override { return true; }
 
+  bool GetExtents(std::vector<DataQueue::Extent>* extents) const override {
+    return true;
+  }
+
   SET_NO_MEMORY_INFO()
   SET_MEMORY_INFO_NAME(EmptyEntry)
   SET_SELF_SIZE(EmptyEntry)
@@ -666,6 +687,14 @@ class InMemoryEntry final : public EntryImpl {
 
   bool is_idempotent() const override { return true; }
 
+  bool GetExtents(std::vector<DataQueue::Extent>* extents) const override {
+    if (byte_length_ > 0) {
+      extents->push_back(
+          {backing_store_, nullptr, uv_stat_t(), offset_, byte_length_});
+    }
+    return true;
+  }
+
   void MemoryInfo(node::MemoryTracker* tracker) const override {
     tracker->TrackField(
         "store", backing_store_, "std::shared_ptr<v8::BackingStore>");
@@ -726,6 +755,10 @@ class DataQueueEntry : public EntryImpl {
   // must fail with an error when a variance is detected.
   bool is_idempotent() const override { return data_queue_->is_idempotent(); }
 
+  bool GetExtents(std::vector<DataQueue::Extent>* extents) const override {
+    return data_queue_->GetExtents(extents);
+  }
+
   void MemoryInfo(node::MemoryTracker* tracker) const override {
     tracker->TrackField(
         "data_queue", data_queue_, "std::shared_ptr<DataQueue>");
@@ -830,6 +863,12 @@ class FdEntry final : public EntryImpl {
 
   bool is_idempotent() const override { return true; }
 
+  bool GetExtents(std::vector<DataQueue::Extent>* extents) const override {
+    if (end_ > start_)
+      extents->push_back({nullptr, path_, stat_, start_, end_ - start_});
+    return true;
+  }
+
   Environment* env() const { return env_; }
 
   SET_NO_MEMORY_INFO()
@@ -844,8 +883,7 @@ class FdEntry final : public EntryImpl {
   uint64_t end_ = 0;
 
   bool is_modified(const uv_stat_t& other) {
-    return other.st_size != stat_.st_size ||
-           other.st_mtim.tv_nsec != stat_.st_mtim.tv_nsec;
+    return IsModified(stat_, other);
   }
 
   static bool CheckModified(FdEntry* entry, int fd) {
@@ -861,10 +899,18 @@ class FdEntry final : public EntryImpl {
     return entry->is_modified(req.statbuf);
   }
 
+  // Reads the file with plain uv_fs_read() requests on the thread pool,
+  // keeping up to kMaxReadAhead of them in flight ahead of the consumer.
+  // Reads start small and grow, in number and in size, each time a pull has
+  // to wait for the disk. Buffers handed to the consumer are recycled once
+  // its done callback has been called.
   class ReaderImpl final : public DataQueue::Reader,
-                           public StreamListener,
                            public std::enable_shared_from_this<ReaderImpl> {
    public:
+    static constexpr size_t kMinChunkSize = 64 * 1024;
+    static constexpr size_t kMaxChunkSize = 1024 * 1024;
+    static constexpr size_t kMaxReadAhead = 4;
+
     static std::shared_ptr<ReaderImpl> Create(FdEntry* entry) {
       uv_fs_t req;
       auto cleanup = OnScopeLeave([&] { uv_fs_req_cleanup(&req); });
@@ -874,74 +920,30 @@ class FdEntry final : public EntryImpl {
         uv_fs_close(nullptr, &req, file, nullptr);
         return nullptr;
       }
-      Realm* realm = entry->env()->principal_realm();
-      return std::make_shared<ReaderImpl>(
-          BaseObjectPtr<fs::FileHandle>(fs::FileHandle::New(
-              realm->GetBindingData<fs::BindingData>(realm->context()),
-              file,
-              Local<Object>(),
-              entry->start_,
-              entry->end_ - entry->start_)),
-          entry);
+#ifdef POSIX_FADV_SEQUENTIAL
+      // Only a hint; the kernel may grow its own read-ahead window for us.
+      posix_fadvise(file,
+                    entry->start_,
+                    entry->end_ - entry->start_,
+                    POSIX_FADV_SEQUENTIAL);
+#endif
+      return std::make_shared<ReaderImpl>(file, entry);
     }
 
-    explicit ReaderImpl(BaseObjectPtr<fs::FileHandle> handle, FdEntry* entry)
-        : env_(handle->env()), handle_(std::move(handle)), entry_(entry) {
-      handle_->PushStreamListener(this);
-      handle_->env()->AddCleanupHook(cleanup, this);
+    ReaderImpl(uv_file file, FdEntry* entry)
+        : env_(entry->env()),
+          entry_(entry),
+          file_(file),
+          offset_(entry->start_),
+          end_(entry->end_) {
+      env_->AddCleanupHook(cleanup, this);
     }
 
     ~ReaderImpl() override {
-      handle_->env()->RemoveCleanupHook(cleanup, this);
+      env_->RemoveCleanupHook(cleanup, this);
       DrainAndClose();
-      handle_->RemoveStreamListener(this);
-    }
-
-    uv_buf_t OnStreamAlloc(size_t suggested_size) override {
-      return env_->allocate_managed_buffer(suggested_size);
-    }
-
-    void OnStreamRead(ssize_t nread, const uv_buf_t& buf) override {
-      std::shared_ptr<v8::BackingStore> store =
-          env_->release_managed_buffer(buf);
-
-      if (ended_) {
-        // If we got here and ended_ is true, it means we ended and drained
-        // while the read was pending. We're just going to do nothing.
-        CHECK(pending_pulls_.empty());
-        return;
-      }
-
-      CHECK(reading_);
-      auto pending = DequeuePendingPull();
-
-      if (CheckModified(entry_, handle_->GetFD())) {
-        DrainAndClose();
-        // The file was modified while the read was pending. We need to error.
-        std::move(pending.next)(UV_EINVAL, nullptr, 0, [](uint64_t) {});
-        return;
-      }
-
-      if (nread < 0) {
-        if (nread == UV_EOF) {
-          std::move(pending.next)(bob::STATUS_EOS, nullptr, 0, [](uint64_t) {});
-        } else {
-          std::move(pending.next)(nread, nullptr, 0, [](uint64_t) {});
-        }
-
-        return DrainAndClose();
-      }
-
-      DataQueue::Vec vec;
-      vec.base = static_cast<uint8_t*>(store->Data());
-      vec.len = static_cast<uint64_t>(nread);
-      std::move(pending.next)(
-          bob::STATUS_CONTINUE, &vec, 1, [store](uint64_t) {});
-
-      if (pending_pulls_.empty()) {
-        reading_ = false;
-        if (handle_->IsAlive()) handle_->ReadStop();
-      }
+      // Every read in flight holds a reference to the reader.
+      CHECK_EQ(in_flight_, 0);
     }
 
     int Pull(Next next,
@@ -949,23 +951,40 @@ class FdEntry final : public EntryImpl {
              DataQueue::Vec* data,
              size_t count,
              size_t max_count_hint = bob::kMaxCountHint) override {
-      if (ended_ || !handle_->IsAlive()) {
+      if (ended_) {
         std::move(next)(bob::STATUS_EOS, nullptr, 0, [](uint64_t) {});
         return bob::STATUS_EOS;
       }
 
-      if (FdEntry::CheckModified(entry_, handle_->GetFD())) {
+      if (FdEntry::CheckModified(entry_, file_)) {
+        error_ = UV_EINVAL;
         DrainAndClose();
         std::move(next)(UV_EINVAL, nullptr, 0, [](uint64_t) {});
         return UV_EINVAL;
       }
 
-      pending_pulls_.emplace_back(std::move(next), shared_from_this());
-      if (!reading_) {
-        reading_ = true;
-        handle_->ReadStart();
+      if (reads_.empty() && offset_ == end_) {
+        DrainAndClose();
+        std::move(next)(bob::STATUS_EOS, nullptr, 0, [](uint64_t) {});
+        return bob::STATUS_EOS;
+      }
+
+      // The consumer is waiting for data that is not there yet, so it is
+      // faster than the reads: read further ahead and in larger chunks.
+      const bool waiting =
+          reads_.empty() ? offset_ > entry_->start_ : !reads_.front()->done;
+      if (waiting) {
+        window_ = std::min(window_ + 1, kMaxReadAhead);
+        chunk_size_ = std::min(chunk_size_ * 2, kMaxChunkSize);
       }
-      return bob::STATUS_WAIT;
+
+      std::shared_ptr<ReaderImpl> self = shared_from_this();
+      pending_pulls_.emplace_back(std::move(next), self);
+      ReadAhead();
+      Deliver();
+      if (!pending_pulls_.empty()) return bob::STATUS_WAIT;
+      // The pull was answered synchronously, possibly with an error.
+      return ended_ ? error_ : bob::STATUS_CONTINUE;
     }
 
     SET_NO_MEMORY_INFO()
@@ -980,11 +999,30 @@ class FdEntry final : public EntryImpl {
           : next(std::move(next)), self(std::move(self)) {}
     };
 
+    struct Read {
+      uv_fs_t req;
+      // Keeps the reader alive while the request is in flight.
+      std::shared_ptr<ReaderImpl> reader;
+      std::shared_ptr<BackingStore> store;
+      uint64_t offset = 0;
+      size_t length = 0;
+      size_t filled = 0;
+      int status = 0;
+      bool done = false;
+    };
+
     Environment* env_;
-    BaseObjectPtr<fs::FileHandle> handle_;
     FdEntry* entry_;
+    uv_file file_;
+    uint64_t offset_;
+    uint64_t end_;
+    size_t chunk_size_ = kMinChunkSize;
+    size_t window_ = 1;
+    size_t in_flight_ = 0;
+    std::deque<std::unique_ptr<Read>> reads_;
     std::deque<PendingPull> pending_pulls_;
-    bool reading_ = false;
+    std::vector<std::shared_ptr<BackingStore>> free_stores_;
+    int error_ = bob::STATUS_EOS;
     bool ended_ = false;
 
     static void cleanup(void* self) {
@@ -992,6 +1030,151 @@ class FdEntry final : public EntryImpl {
       ptr->DrainAndClose();
     }
 
+    // Issues reads for the next chunks of the file until the read-ahead
+    // window is full. Completed reads that have not been pulled yet count
+    // against the window, which is what bounds the memory used.
+    void ReadAhead() {
+      while (!ended_ && reads_.size() < window_ && offset_ < end_) {
+        auto read = std::make_unique<Read>();
+        read->offset = offset_;
+        read->length = std::min<uint64_t>(chunk_size_, end_ - offset_);
+        read->store = AllocateStore(read->length);
+        offset_ += read->length;
+        reads_.push_back(std::move(read));
+        Dispatch(reads_.back().get());
+      }
+    }
+
+    void Dispatch(Read* read) {
+      uv_buf_t buf =
+          uv_buf_init(static_cast<char*>(read->store->Data()) + read->filled,
+                      read->length - read->filled);
+      read->req.data = read;
+      const int err = uv_fs_read(env_->event_loop(),
+                                 &read->req,
+                                 file_,
+                                 &buf,
+                                 1,
+                                 read->offset + read->filled,
+                                 OnRead);
+      if (err < 0) {
+        read->status = err;
+        read->done = true;
+        return;
+      }
+      read->reader = shared_from_this();
+      in_flight_++;
+      env_->IncreaseWaitingRequestCounter();
+    }
+
+    static void OnRead(uv_fs_t* req) {
+      Read* read = static_cast<Read*>(req->data);
+      std::shared_ptr<ReaderImpl> self = std::move(read->reader);
+      const ssize_t result = req->result;
+      uv_fs_req_cleanup(req);
+      self->in_flight_--;
+      self->env_->DecreaseWaitingRequestCounter();
+
+      if (self->ended_) {
+        // Drained while the read was in flight; only the descriptor is left
+        // to close once nothing uses it anymore.
+        auto it = std::find_if(
+            self->reads_.begin(), self->reads_.end(), [read](const auto& r) {
+              return r.get() == read;
+            });
+        CHECK_NE(it, self->reads_.end());
+        self->reads_.erase(it);
+        self->CloseFile();
+        return;
+      }
+
+      if (result < 0) {
+        read->status = result;
+        read->done = true;
+      } else if (result == 0) {
+        // The file got shorter since the entry was created.
+        read->status = UV_EINVAL;
+        read->done = true;
+      } else if ((read->filled += result) < read->length) {
+        // A short read; continue where it stopped.
+        self->Dispatch(read);
+      } else {
+        read->done = true;
+      }
+      if (!read->done || self->pending_pulls_.empty()) return;
+
+      if (CheckModified(self->entry_, self->file_)) {
+        // The file was modified while the read was pending.
+        auto pending = self->DequeuePendingPull();
+        self->error_ = UV_EINVAL;
+        self->DrainAndClose();
+        std::move(pending.next)(UV_EINVAL, nullptr, 0, [](uint64_t) {});
+        return;
+      }
+      self->Deliver();
+    }
+
+    // Hands completed reads to the pending pulls, in file order.
+    void Deliver() {
+      std::shared_ptr<ReaderImpl> self = shared_from_this();
+      while (!ended_ && !pending_pulls_.empty() && !reads_.empty() &&
+             reads_.front()->done) {
+        auto pending = DequeuePendingPull();
+        const int status = reads_.front()->status;
+        if (status < 0) {
+          error_ = status;
+          DrainAndClose();
+          std::move(pending.next)(status, nullptr, 0, [](uint64_t) {});
+          return;
+        }
+
+        DataQueue::Vec vecs[kMaxReadAhead];
+        std::vector<std::shared_ptr<BackingStore>> stores;
+        size_t count = 0;
+        while (count < kMaxReadAhead && !reads_.empty() &&
+               reads_.front()->done && reads_.front()->status == 0) {
+          Read* read = reads_.front().get();
+          vecs[count].base = static_cast<uint8_t*>(read->store->Data());
+          vecs[count].len = read->filled;
+          stores.push_back(std::move(read->store));
+          reads_.pop_front();
+          count++;
+        }
+
+        std::move(pending.next)(
+            bob::STATUS_CONTINUE,
+            vecs,
+            count,
+            [weak = weak_from_this(), stores = std::move(stores)](uint64_t) {
+              if (auto reader = weak.lock()) reader->Recycle(stores);
+            });
+        // Consumers that copy the data have already given the buffers back.
+        ReadAhead();
+      }
+    }
+
+    std::shared_ptr<BackingStore> AllocateStore(size_t length) {
+      if (!free_stores_.empty() &&
+          free_stores_.back()->ByteLength() >= length) {
+        std::shared_ptr<BackingStore> store = std::move(free_stores_.back());
+        free_stores_.pop_back();
+        return store;
+      }
+      NoArrayBufferZeroFillScope no_zero_fill_scope(env_->isolate_data());
+      return ArrayBuffer::NewBackingStore(env_->isolate(), length);
+    }
+
+    void Recycle(const std::vector<std::shared_ptr<BackingStore>>& stores) {
+      for (const auto& store : stores) {
+        // Buffers from before the last increase of the chunk size are
+        // simply dropped.
+        if (free_stores_.size() < kMaxReadAhead &&
+            store->ByteLength() == chunk_size_) {
+          free_stores_.push_back(store);
+        }
+      }
+    }
+
     void DrainAndClose() {
       if (ended_) return;
       ended_ = true;
@@ -999,18 +1182,29 @@ class FdEntry final : public EntryImpl {
         auto pending = DequeuePendingPull();
         std::move(pending.next)(bob::STATUS_EOS, nullptr, 0, [](uint64_t) {});
       }
-      handle_->ReadStop();
-
-      // We fallback to a sync close on the raw fd here because it is the
-      // easiest, simplest thing to do. All of FileHandle's close mechanisms
-      // assume async close and cleanup, while DrainAndClose might be running
-      // in the destructor during GC, for instance. As a todo, FileHandle could
-      // provide a sync mechanism for closing the FD but, for now, this
-      // approach works.
-      int fd = handle_->Release();
+      free_stores_.clear();
+
+      // Reads that have not started yet complete with UV_ECANCELED. The
+      // others hold on to the descriptor until they are done.
+      for (auto it = reads_.begin(); it != reads_.end();) {
+        if ((*it)->done) {
+          it = reads_.erase(it);
+        } else {
+          uv_cancel(reinterpret_cast<uv_req_t*>(&(*it)->req));
+          ++it;
+        }
+      }
+      CloseFile();
+    }
+
+    void CloseFile() {
+      if (in_flight_ > 0 || file_ < 0) return;
+      // A sync close keeps this usable from the destructor during GC, just
+      // like the rest of the teardown here.
       uv_fs_t req;
-      uv_fs_close(nullptr, &req, fd, nullptr);
+      uv_fs_close(nullptr, &req, file_, nullptr);
       uv_fs_req_cleanup(&req);
+      file_ = -1;
     }
 
     PendingPull DequeuePendingPull() {
@@ -1027,8 +1221,104 @@ class FdEntry final : public EntryImpl {
 
 // ============================================================================
 
+// How long a write waits for a non-blocking `fd` to become writable again
+// before it gives up with UV_EAGAIN, so that a peer which stops reading
+// cannot hold on to a threadpool thread.
+constexpr int kWritableTimeoutMs = 1000;
+
+// Called when a write to `fd` returned UV_EAGAIN. Returns false if `fd` did
+// not become writable in time, or if there is no way to wait, in which case
+// the error is passed on.
+bool WaitUntilWritable(uv_file fd) {
+#ifdef _WIN32
+  return false;
+#else
+  pollfd pfd = {fd, POLLOUT, 0};
+  const int result = poll(&pfd, 1, kWritableTimeoutMs);
+  // An interrupted wait just retries the write, which waits again.
+  return result > 0 || (result == -1 && errno == EINTR);
+#endif
+}
+
+int WriteMemoryExtent(const DataQueue::Extent& extent,
+                      uv_file fd,
+                      uint64_t* written) {
+  char* data = static_cast<char*>(extent.store->Data()) + extent.offset;
+  uint64_t remaining = extent.length;
+  while (remaining > 0) {
+    const uint64_t chunk = std::min<uint64_t>(remaining, 1 << 30);
+    uv_buf_t buf = uv_buf_init(data, static_cast<unsigned int>(chunk));
+    uv_fs_t req;
+    int result = uv_fs_write(nullptr, &req, fd, &buf, 1, -1, nullptr);
+    uv_fs_req_cleanup(&req);
+    if (result == UV_EINTR) continue;
+    if (result == UV_EAGAIN && WaitUntilWritable(fd)) continue;
+    if (result < 0) return result;
+    data += result;
+    remaining -= result;
+    *written += result;
+  }
+  return 0;
+}
+
+int WriteFileExtent(const DataQueue::Extent& extent,
+                    uv_file fd,
+                    uint64_t* written) {
+  uv_fs_t req;
+  const int file =
+      uv_fs_open(nullptr, &req, extent.path->out(), O_RDONLY, 0, nullptr);
+  uv_fs_req_cleanup(&req);
+  if (file < 0) return file;
+  auto close = OnScopeLeave([file] {
+    uv_fs_t req;
+    uv_fs_close(nullptr, &req, file, nullptr);
+    uv_fs_req_cleanup(&req);
+  });
+
+  const bool modified = uv_fs_fstat(nullptr, &req, file, nullptr) < 0 ||
+                        IsModified(extent.stat, req.statbuf);
+  uv_fs_req_cleanup(&req);
+  if (modified) return UV_EINVAL;
+
+  int64_t offset = extent.offset;
+  uint64_t remaining = extent.length;
+  while (remaining > 0) {
+    // libuv tries copy_file_range() and sendfile() before it falls back to
+    // reading and writing through a buffer.
+    int result = uv_fs_sendfile(nullptr,
+                                &req,
+                                fd,
+                                file,
+                                offset,
+                                std::min<uint64_t>(remaining, 1 << 30),
+                                nullptr);
+    uv_fs_req_cleanup(&req);
+    if (result == UV_EINTR) continue;
+    if (result == UV_EAGAIN && WaitUntilWritable(fd)) continue;
+    if (result < 0) return result;
+    // The file got shorter since the extent was created.
+    if (result == 0) return UV_EINVAL;
+    offset += result;
+    remaining -= result;
+    *written += result;
+  }
+  return 0;
+}
+
 }  // namespace
 
+int DataQueue::WriteExtents(const std::vector<Extent>& extents,
+                            uv_file fd,
+                            uint64_t* written) {
+  *written = 0;
+  for (const Extent& extent : extents) {
+    const int err = extent.store ? WriteMemoryExtent(extent, fd, written)
+                                 : WriteFileExtent(extent, fd, written);
+    if (err < 0) return err;
+  }
+  return 0;
+}
+
 std::shared_ptr<DataQueue> DataQueue::CreateIdempotent(
     std::vector<std::unique_ptr<Entry>> list) {
   // Any entry is invalid for an idempotent DataQueue if any of the entries
@@ -131,6 +131,21 @@ class DataQueue : public MemoryRetainer {
     uint64_t len;
   };
 
+  // A contiguous piece of an idempotent DataQueue: either a range of a
+  // v8::BackingStore or a range of a file. Extents let consumers that write
+  // the data somewhere else natively skip the Reader, which copies every
+  // chunk through a managed buffer. See GetExtents() and WriteExtents().
+  struct Extent {
+    // Set for memory-resident data.
+    std::shared_ptr<v8::BackingStore> store;
+    // Set for file-backed data. The file is only read if it still matches
+    // `stat`, just like FdEntry readers do.
+    std::shared_ptr<BufferValue> path;
+    uv_stat_t stat;
+    uint64_t offset;
+    uint64_t length;
+  };
+
   // A DataQueue::Reader consumes the DataQueue. If the data queue is
   // idempotent, multiple Readers can be attached to the DataQueue at
   // any given time, all guaranteed to yield the same result when the
@@ -178,6 +193,12 @@ class DataQueue : public MemoryRetainer {
     // idempotent and cannot preserve that quality, subsequent reads
     // must fail with an error when a variance is detected.
     virtual bool is_idempotent() const = 0;
+
+    // Appends the extents that make up this entry to `extents`. Returns
+    // false if the data can only be obtained through a Reader.
+    virtual bool GetExtents(std::vector<Extent>* extents) const {
+      return false;
+    }
   };
 
   // Creates an idempotent DataQueue with a pre-established collection
@@ -285,6 +306,27 @@ class DataQueue : public MemoryRetainer {
   // been set, maybeCapRemaining() will return std::nullopt.
   virtual std::optional<uint64_t> maybeCapRemaining() const = 0;
 
+  // Appends the extents of all entries to `extents`, in order. This is only
+  // possible for idempotent DataQueues whose entries all provide extents;
+  // otherwise false is returned and the data must be read with a Reader.
+  virtual bool GetExtents(std::vector<Extent>* extents) const = 0;
+
+  // Writes the data described by `extents` to `fd`, starting at its current
+  // position. File-backed extents are transferred by the kernel with
+  // copy_file_range() or sendfile() where available, and memory-resident
+  // ones are written straight from their BackingStores. If `fd` is a
+  // non-blocking socket or pipe, this waits a bounded time for it to become
+  // writable, and returns UV_EAGAIN if it does not. The caller can then
+  // wait for `fd` on the event loop and write the rest, from `written` on.
+  //
+  // This blocks and must not be called on the event loop thread. Returns 0
+  // or a negative libuv error code, e.g. UV_EINVAL if a file has been
+  // modified since the extent was created. `written` is set to the number
+  // of bytes written in either case.
+  static int WriteExtents(const std::vector<Extent>& extents,
+                          uv_file fd,
+                          uint64_t* written);
+
   static void Initialize(Environment* env, v8::Local<v8::Object> target);
   static void RegisterExternalReferences(ExternalReferenceRegistry* registry);
 };
@@ -4,10 +4,11 @@
 #include "node_errors.h"
 #include "node_external_reference.h"
 #include "simdutf.h"
-#include "string_bytes.h"
 #include "v8.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <limits>
 
 namespace node {
 namespace encoding_binding {
@@ -23,9 +24,89 @@ using v8::MaybeLocal;
 using v8::Object;
 using v8::ObjectTemplate;
 using v8::String;
+using v8::Uint32;
 using v8::Uint8Array;
 using v8::Value;
 
+namespace {
+
+constexpr uint16_t kReplacementCharacter = 0xFFFD;
+constexpr uint16_t kByteOrderMark = 0xFEFF;
+
+// Length of the UTF-8 sequence that starts with `lead`, or 0 if `lead` cannot
+// start a sequence.
+inline size_t SequenceLength(uint8_t lead) {
+  if (lead < 0x80) return 1;
+  if (lead >= 0xC2 && lead <= 0xDF) return 2;
+  if (lead >= 0xE0 && lead <= 0xEF) return 3;
+  if (lead >= 0xF0 && lead <= 0xF4) return 4;
+  return 0;
+}
+
+// Whether `byte` can be the `index`-th byte of a sequence that starts with
+// `lead`. The second byte has tighter bounds that rule out overlong forms,
+// surrogates and code points above U+10FFFF, see
+// https://encoding.spec.whatwg.org/#utf-8-decoder
+inline bool IsContinuation(uint8_t lead, size_t index, uint8_t byte) {
+  if (index == 1) {
+    switch (lead) {
+      case 0xE0: return byte >= 0xA0 && byte <= 0xBF;
+      case 0xED: return byte >= 0x80 && byte <= 0x9F;
+      case 0xF0: return byte >= 0x90 && byte <= 0xBF;
+      case 0xF4: return byte >= 0x80 && byte <= 0x8F;
+    }
+  }
+  return byte >= 0x80 && byte <= 0xBF;
+}
+
+// Length of the valid but incomplete sequence at the end of `data`, if any.
+size_t IncompleteTailLength(const uint8_t* data, size_t length) {
+  for (size_t k = 1; k <= std::min<size_t>(3, length); k++) {
+    const uint8_t lead = data[length - k];
+    if (lead >= 0x80 && lead <= 0xBF) continue;
+    if (SequenceLength(lead) <= k) return 0;
+    for (size_t j = 1; j < k; j++) {
+      if (!IsContinuation(lead, j, data[length - k + j])) return 0;
+    }
+    return k;
+  }
+  return 0;
+}
+
+// Creates a string from UTF-8 without BOM handling. Valid input is checked
+// and transcoded with simdutf, which is considerably faster than V8's own
+// decoder for non-ASCII text; invalid input is left to V8, which implements
+// the replacement rules of the Encoding Standard.
+MaybeLocal<String> MakeUTF8String(Isolate* isolate,
+                                  const char* data,
+                                  size_t length) {
+  if (length > static_cast<size_t>(std::numeric_limits<int>::max()))
+    return MaybeLocal<String>();
+  if (simdutf::validate_ascii(data, length)) {
+    return String::NewFromOneByte(isolate,
+                                  reinterpret_cast<const uint8_t*>(data),
+                                  v8::NewStringType::kNormal,
+                                  static_cast<int>(length));
+  }
+  if (simdutf::validate_utf8(data, length)) {
+    const size_t utf16_length = simdutf::utf16_length_from_utf8(data, length);
+    if (utf16_length > static_cast<size_t>(String::kMaxLength))
+      return MaybeLocal<String>();
+    MaybeStackBuffer<uint16_t> utf16(utf16_length);
+    const size_t written = simdutf::convert_valid_utf8_to_utf16(
+        data, length, reinterpret_cast<char16_t*>(utf16.out()));
+    CHECK_EQ(written, utf16_length);
+    return String::NewFromTwoByte(isolate,
+                                  utf16.out(),
+                                  v8::NewStringType::kNormal,
+                                  static_cast<int>(utf16_length));
+  }
+  return String::NewFromUtf8(
+      isolate, data, v8::NewStringType::kNormal, static_cast<int>(length));
+}
+
+}  // anonymous namespace
+
 void BindingData::MemoryInfo(MemoryTracker* tracker) const {
   tracker->TrackField("encode_into_results_buffer",
                       encode_into_results_buffer_);
@@ -182,20 +263,154 @@ void BindingData::DecodeUTF8(const FunctionCallbackInfo<Value>& args) {
 
   if (length == 0) return args.GetReturnValue().SetEmptyString();
 
-  Local<Value> error;
-  MaybeLocal<Value> maybe_ret =
-      StringBytes::Encode(env->isolate(), data, length, UTF8, &error);
-  Local<Value> ret;
-
-  if (!maybe_ret.ToLocal(&ret)) {
-    CHECK(!error.IsEmpty());
-    env->isolate()->ThrowException(error);
+  Local<String> ret;
+  if (!MakeUTF8String(env->isolate(), data, length).ToLocal(&ret)) {
+    env->isolate()->ThrowException(ERR_STRING_TOO_LONG(env->isolate()));
     return;
   }
 
   args.GetReturnValue().Set(ret);
 }
 
+UTF8Decoder::UTF8Decoder(Environment* env,
+                         Local<Object> object,
+                         uint32_t flags)
+    : BaseObject(env, object),
+      fatal_((flags & kFatal) != 0),
+      ignore_bom_((flags & kIgnoreBOM) != 0) {
+  MakeWeak();
+}
+
+void UTF8Decoder::New(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  CHECK(args.IsConstructCall());
+  CHECK(args[0]->IsUint32());
+  new UTF8Decoder(env, args.This(), args[0].As<Uint32>()->Value());
+}
+
+void UTF8Decoder::ResetState() {
+  bom_seen_ = false;
+  pending_length_ = 0;
+}
+
+void UTF8Decoder::Reset(const FunctionCallbackInfo<Value>& args) {
+  UTF8Decoder* decoder;
+  ASSIGN_OR_RETURN_UNWRAP(&decoder, args.This());
+  decoder->ResetState();
+}
+
+void UTF8Decoder::Decode(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+  UTF8Decoder* decoder;
+  ASSIGN_OR_RETURN_UNWRAP(&decoder, args.This());
+
+  if (!(args[0]->IsArrayBuffer() || args[0]->IsSharedArrayBuffer() ||
+        args[0]->IsArrayBufferView())) {
+    return THROW_ERR_INVALID_ARG_TYPE(
+        isolate,
+        "The \"input\" argument must be an instance of SharedArrayBuffer, "
+        "ArrayBuffer or ArrayBufferView.");
+  }
+  CHECK(args[1]->IsUint32());
+  const bool flush = (args[1].As<Uint32>()->Value() & kFlush) != 0;
+
+  ArrayBufferViewContents<uint8_t> input(args[0]);
+  const uint8_t* data = input.data();
+  const size_t length = input.length();
+
+  // The stream is over after a flush, and also after an error in fatal mode.
+  bool done = flush;
+  auto cleanup = OnScopeLeave([&]() {
+    if (done) decoder->ResetState();
+  });
+  auto throw_invalid = [&]() {
+    done = true;
+    THROW_ERR_ENCODING_INVALID_ENCODED_DATA(
+        isolate, "The encoded data was not valid for encoding utf-8");
+  };
+
+  // Complete the code point left over from the previous chunk.
+  uint16_t head[2];
+  size_t head_length = 0;
+  size_t pos = 0;
+  while (decoder->pending_length_ > 0 && pos < length) {
+    const uint8_t lead = decoder->pending_[0];
+    if (!IsContinuation(lead, decoder->pending_length_, data[pos])) {
+      // The offending byte starts over in the body below.
+      if (decoder->fatal_) return throw_invalid();
+      head[head_length++] = kReplacementCharacter;
+      decoder->pending_length_ = 0;
+      break;
+    }
+    decoder->pending_[decoder->pending_length_++] = data[pos++];
+    if (decoder->pending_length_ == SequenceLength(lead)) {
+      head_length = simdutf::convert_valid_utf8_to_utf16(
+          reinterpret_cast<const char*>(decoder->pending_),
+          decoder->pending_length_,
+          reinterpret_cast<char16_t*>(head));
+      decoder->pending_length_ = 0;
+    }
+  }
+  if (decoder->pending_length_ > 0) {
+    // The whole chunk went into the pending code point.
+    if (!flush) return args.GetReturnValue().SetEmptyString();
+    if (decoder->fatal_) return throw_invalid();
+    head[head_length++] = kReplacementCharacter;
+    decoder->pending_length_ = 0;
+  }
+
+  // Hold back an incomplete code point at the end, unless this is the last
+  // chunk, in which case it decodes to U+FFFD.
+  const char* body = reinterpret_cast<const char*>(data + pos);
+  size_t body_length = length - pos;
+  if (!flush) {
+    const size_t tail = IncompleteTailLength(data + pos, body_length);
+    body_length -= tail;
+    memcpy(decoder->pending_, body + body_length, tail);
+    decoder->pending_length_ = tail;
+  }
+
+  if (decoder->fatal_ && !simdutf::validate_utf8(body, body_length))
+    return throw_invalid();
+
+  if (!decoder->bom_seen_) {
+    if (head_length > 0) {
+      if (!decoder->ignore_bom_ && head[0] == kByteOrderMark) {
+        head_length--;
+        if (head_length > 0) head[0] = head[1];
+      }
+      decoder->bom_seen_ = true;
+    } else if (body_length > 0) {
+      if (!decoder->ignore_bom_ && body_length >= 3 &&
+          memcmp(body, "\xEF\xBB\xBF", 3) == 0) {
+        body += 3;
+        body_length -= 3;
+      }
+      decoder->bom_seen_ = true;
+    }
+  }
+
+  Local<String> result = String::Empty(isolate);
+  if (head_length > 0) {
+    result = String::NewFromTwoByte(isolate,
+                                    head,
+                                    v8::NewStringType::kNormal,
+                                    static_cast<int>(head_length))
+                 .ToLocalChecked();
+  }
+  if (body_length > 0) {
+    Local<String> str;
+    if (!MakeUTF8String(isolate, body, body_length).ToLocal(&str)) {
+      done = true;
+      isolate->ThrowException(ERR_STRING_TOO_LONG(isolate));
+      return;
+    }
+    result = head_length > 0 ? String::Concat(isolate, result, str) : str;
+  }
+  args.GetReturnValue().Set(result);
+}
+
 void BindingData::ToASCII(const v8::FunctionCallbackInfo<v8::Value>& args) {
   Environment* env = Environment::GetCurrent(args);
   CHECK_GE(args.Length(), 1);
@@ -227,6 +442,14 @@ void BindingData::CreatePerIsolateProperties(IsolateData* isolate_data,
   SetMethodNoSideEffect(isolate, target, "decodeUTF8", DecodeUTF8);
   SetMethodNoSideEffect(isolate, target, "toASCII", ToASCII);
   SetMethodNoSideEffect(isolate, target, "toUnicode", ToUnicode);
+
+  Local<FunctionTemplate> decoder =
+      NewFunctionTemplate(isolate, UTF8Decoder::New);
+  decoder->InstanceTemplate()->SetInternalFieldCount(
+      UTF8Decoder::kInternalFieldCount);
+  SetProtoMethod(isolate, decoder, "decode", UTF8Decoder::Decode);
+  SetProtoMethod(isolate, decoder, "reset", UTF8Decoder::Reset);
+  SetConstructorFunction(isolate, target, "UTF8Decoder", decoder);
 }
 
 void BindingData::CreatePerContextProperties(Local<Object> target,
@@ -244,6 +467,9 @@ void BindingData::RegisterTimerExternalReferences(
   registry->Register(DecodeUTF8);
   registry->Register(ToASCII);
   registry->Register(ToUnicode);
+  registry->Register(UTF8Decoder::New);
+  registry->Register(UTF8Decoder::Decode);
+  registry->Register(UTF8Decoder::Reset);
 }
 
 }  // namespace encoding_binding
@@ -5,6 +5,7 @@
 
 #include <cinttypes>
 #include "aliased_buffer.h"
+#include "base_object.h"
 #include "node_snapshotable.h"
 #include "v8-fast-api-calls.h"
 
@@ -50,6 +51,44 @@ class BindingData : public SnapshotableObject {
   InternalFieldInfo* internal_field_info_ = nullptr;
 };
 
+// Incremental UTF-8 decoder for TextDecoder with `stream: true`. It keeps an
+// incomplete code point at the end of a chunk (at most three bytes) until the
+// next chunk arrives, so that every chunk can be validated and transcoded in
+// bulk instead of going through ICU or StringDecoder.
+class UTF8Decoder : public BaseObject {
+ public:
+  // Same values as the CONVERTER_FLAGS_* used by the ICU converters.
+  enum Flags : uint32_t {
+    kFlush = 0x1,
+    kFatal = 0x2,
+    kIgnoreBOM = 0x4,
+  };
+
+  UTF8Decoder(Environment* env, v8::Local<v8::Object> object, uint32_t flags);
+
+  // new UTF8Decoder(flags)
+  static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
+  // decoder.decode(input, flags)
+  static void Decode(const v8::FunctionCallbackInfo<v8::Value>& args);
+  // decoder.reset()
+  static void Reset(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  SET_NO_MEMORY_INFO()
+  SET_MEMORY_INFO_NAME(UTF8Decoder)
+  SET_SELF_SIZE(UTF8Decoder)
+
+ private:
+  void ResetState();
+
+  const bool fatal_;
+  const bool ignore_bom_;
+  // Whether anything has been decoded since the last reset. Only the very
+  // first code point of a stream can be a BOM.
+  bool bom_seen_ = false;
+  uint8_t pending_[4];
+  size_t pending_length_ = 0;
+};
+
 }  // namespace encoding_binding
 
 }  // namespace node
@@ -559,8 +559,7 @@ inline void IsolateData::set_options(
 
 template <typename Fn>
 void Environment::SetImmediate(Fn&& cb, CallbackFlags::Flags flags) {
-  auto callback = native_immediates_.CreateCallback(std::move(cb), flags);
-  native_immediates_.Push(std::move(callback));
+  native_immediates_.Push(std::move(cb), flags);
 
   if (flags & CallbackFlags::kRefed) {
     if (immediate_info()->ref_count() == 0)
@@ -571,11 +570,9 @@ void Environment::SetImmediate(Fn&& cb, CallbackFlags::Flags flags) {
 
 template <typename Fn>
 void Environment::SetImmediateThreadsafe(Fn&& cb, CallbackFlags::Flags flags) {
-  auto callback = native_immediates_threadsafe_.CreateCallback(
-      std::move(cb), flags);
   {
     Mutex::ScopedLock lock(native_immediates_threadsafe_mutex_);
-    native_immediates_threadsafe_.Push(std::move(callback));
+    native_immediates_threadsafe_.Push(std::move(cb), flags);
     if (task_queues_async_initialized_)
       uv_async_send(&task_queues_async_);
   }
@@ -583,11 +580,9 @@ void Environment::SetImmediateThreadsafe(Fn&& cb, CallbackFlags::Flags flags) {
 
 template <typename Fn>
 void Environment::RequestInterrupt(Fn&& cb) {
-  auto callback = native_immediates_interrupts_.CreateCallback(
-      std::move(cb), CallbackFlags::kRefed);
   {
     Mutex::ScopedLock lock(native_immediates_threadsafe_mutex_);
-    native_immediates_interrupts_.Push(std::move(callback));
+    native_immediates_interrupts_.Push(std::move(cb), CallbackFlags::kRefed);
     if (task_queues_async_initialized_)
       uv_async_send(&task_queues_async_);
   }
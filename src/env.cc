@@ -1120,7 +1120,7 @@ void Environment::RunAndClearInterrupts() {
     NativeImmediateQueue queue;
     {
       Mutex::ScopedLock lock(native_immediates_threadsafe_mutex_);
-      queue.ConcatMove(std::move(native_immediates_interrupts_));
+      queue.Swap(&native_immediates_interrupts_);
     }
     DebugSealHandleScope seal_handle_scope(isolate());
 
@@ -1143,6 +1143,13 @@ void Environment::RunAndClearNativeImmediates(bool only_refed) {
 
   size_t ref_count = 0;
 
+  TRACE_COUNTER2(TRACING_CATEGORY_NODE1(environment),
+                 "NativeImmediates",
+                 "queued",
+                 native_immediates_.size(),
+                 "threadsafe",
+                 native_immediates_threadsafe_.size());
+
   // Handle interrupts first. These functions are not allowed to throw
   // exceptions, so we do not need to handle that.
   RunAndClearInterrupts();
@@ -1183,12 +1190,18 @@ void Environment::RunAndClearNativeImmediates(bool only_refed) {
   // This is intentionally placed after the `ref_count` handling, because when
   // refed threadsafe immediates are created, they are not counted towards the
   // count in immediate_info() either.
-  NativeImmediateQueue threadsafe_immediates;
+  // Swapping with threadsafe_immediates_ hands its now unused slabs to the
+  // producers. If a callback from it is still running further up the stack,
+  // the new batch goes into a queue of its own instead.
+  NativeImmediateQueue nested_threadsafe_immediates;
+  NativeImmediateQueue* threadsafe_immediates =
+      threadsafe_immediates_.idle() ? &threadsafe_immediates_
+                                    : &nested_threadsafe_immediates;
   if (native_immediates_threadsafe_.size() > 0) {
     Mutex::ScopedLock lock(native_immediates_threadsafe_mutex_);
-    threadsafe_immediates.ConcatMove(std::move(native_immediates_threadsafe_));
+    threadsafe_immediates->Swap(&native_immediates_threadsafe_);
   }
-  while (drain_list(&threadsafe_immediates)) {}
+  while (drain_list(threadsafe_immediates)) {}
 }
 
 void Environment::RequestInterruptFromV8() {
@@ -1132,6 +1132,9 @@ class Environment : public MemoryRetainer {
   Mutex native_immediates_threadsafe_mutex_;
   NativeImmediateQueue native_immediates_threadsafe_;
   NativeImmediateQueue native_immediates_interrupts_;
+  // Threadsafe immediates are swapped in here to run without holding the
+  // mutex. Only touched on the Environment's thread.
+  NativeImmediateQueue threadsafe_immediates_;
   // Also guarded by native_immediates_threadsafe_mutex_. This can be used when
   // trying to post tasks from other threads to an Environment, as the libuv
   // handle for the immediate queues (task_queues_async_) may not be initialized
@@ -0,0 +1,298 @@
+#include "hex_simd.h"
+#include "util.h"
+
+#if defined(NODE_SIMD_X64)
+#include <immintrin.h>
+#elif defined(NODE_SIMD_ARM64)
+#include <arm_neon.h>
+#endif
+
+namespace node {
+namespace hex {
+
+namespace {
+
+// The kernels below are parameterized over an `Ops` class that provides
+//
+//   kBlock    the number of bytes encoded or decoded per step,
+//   Encode()  writes the 2 * kBlock hex digits of `src` to `dst`,
+//   Decode()  decodes 2 * kBlock hex digits of `src` into `dst`; if one of
+//             them is invalid it returns false without touching `dst`.
+//
+// The digits are converted with arithmetic rather than a table: a character
+// `c` is a digit if `c - '0'` is at most 9, and a letter if `(c | 0x20) - 'a'`
+// is at most 5, which also accepts the uppercase letters.
+
+template <typename Ops>
+NODE_SIMD_INLINE size_t EncodeLoop(const uint8_t* src,
+                                   size_t length,
+                                   char* dst) {
+  size_t i = 0;
+  for (; length - i >= Ops::kBlock; i += Ops::kBlock)
+    Ops::Encode(src + i, dst + 2 * i);
+  return i;
+}
+
+template <typename Ops>
+NODE_SIMD_INLINE size_t DecodeLoop(const uint8_t* src,
+                                   size_t max_bytes,
+                                   char* dst) {
+  size_t k = 0;
+  for (; max_bytes - k >= Ops::kBlock; k += Ops::kBlock) {
+    if (!Ops::Decode(src + 2 * k, dst + k))
+      break;
+  }
+  return k;
+}
+
+#if defined(NODE_SIMD_X64)
+
+struct SSSE3Ops {
+  static constexpr size_t kBlock = 16;
+
+  NODE_TARGET_SSSE3 static inline void Encode(const uint8_t* src, char* dst) {
+    const __m128i digits = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6',
+                                         '7', '8', '9', 'a', 'b', 'c', 'd',
+                                         'e', 'f');
+    const __m128i low_nibble = _mm_set1_epi8(0x0f);
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    __m128i hi = _mm_shuffle_epi8(
+        digits, _mm_and_si128(_mm_srli_epi16(x, 4), low_nibble));
+    __m128i lo = _mm_shuffle_epi8(digits, _mm_and_si128(x, low_nibble));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst),
+                     _mm_unpacklo_epi8(hi, lo));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16),
+                     _mm_unpackhi_epi8(hi, lo));
+  }
+
+  NODE_TARGET_SSSE3 static inline bool Decode(const uint8_t* src, char* dst) {
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i five = _mm_set1_epi8(5);
+    __m128i c0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    __m128i c1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+
+    __m128i d0 = _mm_sub_epi8(c0, _mm_set1_epi8('0'));
+    __m128i d1 = _mm_sub_epi8(c1, _mm_set1_epi8('0'));
+    __m128i l0 = _mm_sub_epi8(_mm_or_si128(c0, _mm_set1_epi8(0x20)),
+                              _mm_set1_epi8('a'));
+    __m128i l1 = _mm_sub_epi8(_mm_or_si128(c1, _mm_set1_epi8(0x20)),
+                              _mm_set1_epi8('a'));
+    __m128i is_digit0 = _mm_cmpeq_epi8(_mm_min_epu8(d0, nine), d0);
+    __m128i is_digit1 = _mm_cmpeq_epi8(_mm_min_epu8(d1, nine), d1);
+    __m128i is_letter0 = _mm_cmpeq_epi8(_mm_min_epu8(l0, five), l0);
+    __m128i is_letter1 = _mm_cmpeq_epi8(_mm_min_epu8(l1, five), l1);
+    __m128i valid = _mm_and_si128(_mm_or_si128(is_digit0, is_letter0),
+                                  _mm_or_si128(is_digit1, is_letter1));
+    if (_mm_movemask_epi8(valid) != 0xffff)
+      return false;
+
+    const __m128i ten = _mm_set1_epi8(10);
+    __m128i n0 = _mm_or_si128(_mm_and_si128(is_digit0, d0),
+                              _mm_and_si128(is_letter0, _mm_add_epi8(l0, ten)));
+    __m128i n1 = _mm_or_si128(_mm_and_si128(is_digit1, d1),
+                              _mm_and_si128(is_letter1, _mm_add_epi8(l1, ten)));
+    // Each pair of nibbles becomes `16 * hi + lo` in a 16-bit lane.
+    const __m128i weights = _mm_set1_epi16(0x0110);
+    __m128i bytes = _mm_packus_epi16(_mm_maddubs_epi16(n0, weights),
+                                     _mm_maddubs_epi16(n1, weights));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), bytes);
+    return true;
+  }
+};
+
+struct AVX2Ops {
+  static constexpr size_t kBlock = 32;
+
+  NODE_TARGET_AVX2 static inline void Encode(const uint8_t* src, char* dst) {
+    const __m256i digits = _mm256_setr_epi8(
+        '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd',
+        'e', 'f', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b',
+        'c', 'd', 'e', 'f');
+    const __m256i low_nibble = _mm256_set1_epi8(0x0f);
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+    __m256i hi = _mm256_shuffle_epi8(
+        digits, _mm256_and_si256(_mm256_srli_epi16(x, 4), low_nibble));
+    __m256i lo = _mm256_shuffle_epi8(digits, _mm256_and_si256(x, low_nibble));
+    // The unpack instructions work within 128-bit lanes, so `first` holds
+    // the digits of bytes 0-7 and 16-23, and `second` those of 8-15 and
+    // 24-31.
+    __m256i first = _mm256_unpacklo_epi8(hi, lo);
+    __m256i second = _mm256_unpackhi_epi8(hi, lo);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst),
+                        _mm256_permute2x128_si256(first, second, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 32),
+                        _mm256_permute2x128_si256(first, second, 0x31));
+  }
+
+  NODE_TARGET_AVX2 static inline bool Decode(const uint8_t* src, char* dst) {
+    const __m256i nine = _mm256_set1_epi8(9);
+    const __m256i five = _mm256_set1_epi8(5);
+    __m256i c0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+    __m256i c1 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 32));
+
+    __m256i d0 = _mm256_sub_epi8(c0, _mm256_set1_epi8('0'));
+    __m256i d1 = _mm256_sub_epi8(c1, _mm256_set1_epi8('0'));
+    __m256i l0 = _mm256_sub_epi8(_mm256_or_si256(c0, _mm256_set1_epi8(0x20)),
+                                 _mm256_set1_epi8('a'));
+    __m256i l1 = _mm256_sub_epi8(_mm256_or_si256(c1, _mm256_set1_epi8(0x20)),
+                                 _mm256_set1_epi8('a'));
+    __m256i is_digit0 = _mm256_cmpeq_epi8(_mm256_min_epu8(d0, nine), d0);
+    __m256i is_digit1 = _mm256_cmpeq_epi8(_mm256_min_epu8(d1, nine), d1);
+    __m256i is_letter0 = _mm256_cmpeq_epi8(_mm256_min_epu8(l0, five), l0);
+    __m256i is_letter1 = _mm256_cmpeq_epi8(_mm256_min_epu8(l1, five), l1);
+    __m256i valid =
+        _mm256_and_si256(_mm256_or_si256(is_digit0, is_letter0),
+                         _mm256_or_si256(is_digit1, is_letter1));
+    if (_mm256_movemask_epi8(valid) != -1)
+      return false;
+
+    const __m256i ten = _mm256_set1_epi8(10);
+    __m256i n0 =
+        _mm256_or_si256(_mm256_and_si256(is_digit0, d0),
+                        _mm256_and_si256(is_letter0, _mm256_add_epi8(l0, ten)));
+    __m256i n1 =
+        _mm256_or_si256(_mm256_and_si256(is_digit1, d1),
+                        _mm256_and_si256(is_letter1, _mm256_add_epi8(l1, ten)));
+    const __m256i weights = _mm256_set1_epi16(0x0110);
+    __m256i bytes = _mm256_packus_epi16(_mm256_maddubs_epi16(n0, weights),
+                                        _mm256_maddubs_epi16(n1, weights));
+    // Undo the lane interleaving of the pack instruction.
+    bytes = _mm256_permute4x64_epi64(bytes, 0xd8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), bytes);
+    return true;
+  }
+};
+
+NODE_TARGET_SSSE3 size_t EncodeSSSE3(const uint8_t* src,
+                                     size_t length,
+                                     char* dst) {
+  return EncodeLoop<SSSE3Ops>(src, length, dst);
+}
+
+NODE_TARGET_SSSE3 size_t DecodeSSSE3(const uint8_t* src,
+                                     size_t max_bytes,
+                                     char* dst) {
+  return DecodeLoop<SSSE3Ops>(src, max_bytes, dst);
+}
+
+NODE_TARGET_AVX2 size_t EncodeAVX2(const uint8_t* src,
+                                   size_t length,
+                                   char* dst) {
+  return EncodeLoop<AVX2Ops>(src, length, dst);
+}
+
+NODE_TARGET_AVX2 size_t DecodeAVX2(const uint8_t* src,
+                                   size_t max_bytes,
+                                   char* dst) {
+  return DecodeLoop<AVX2Ops>(src, max_bytes, dst);
+}
+
+#elif defined(NODE_SIMD_ARM64)
+
+struct NEONOps {
+  static constexpr size_t kBlock = 16;
+
+  static NODE_SIMD_INLINE void Encode(const uint8_t* src, char* dst) {
+    static const uint8_t kDigits[] = {'0', '1', '2', '3', '4', '5', '6', '7',
+                                      '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
+    const uint8x16_t digits = vld1q_u8(kDigits);
+    uint8x16_t x = vld1q_u8(src);
+    uint8x16x2_t out;
+    out.val[0] = vqtbl1q_u8(digits, vshrq_n_u8(x, 4));
+    out.val[1] = vqtbl1q_u8(digits, vandq_u8(x, vdupq_n_u8(0x0f)));
+    // vst2q_u8 interleaves the high and the low digits.
+    vst2q_u8(reinterpret_cast<uint8_t*>(dst), out);
+  }
+
+  static NODE_SIMD_INLINE bool Decode(const uint8_t* src, char* dst) {
+    // vld2q_u8 splits the input into the high and the low digits.
+    uint8x16x2_t c = vld2q_u8(src);
+    uint8x16_t n[2];
+    uint8x16_t valid = vdupq_n_u8(0xff);
+    for (int i = 0; i < 2; i++) {
+      uint8x16_t d = vsubq_u8(c.val[i], vdupq_n_u8('0'));
+      uint8x16_t l = vsubq_u8(vorrq_u8(c.val[i], vdupq_n_u8(0x20)),
+                              vdupq_n_u8('a'));
+      uint8x16_t is_digit = vcleq_u8(d, vdupq_n_u8(9));
+      uint8x16_t is_letter = vcleq_u8(l, vdupq_n_u8(5));
+      valid = vandq_u8(valid, vorrq_u8(is_digit, is_letter));
+      n[i] = vbslq_u8(is_digit, d, vaddq_u8(l, vdupq_n_u8(10)));
+    }
+    if (vminvq_u8(valid) != 0xff)
+      return false;
+    vst1q_u8(reinterpret_cast<uint8_t*>(dst),
+             vorrq_u8(vshlq_n_u8(n[0], 4), n[1]));
+    return true;
+  }
+};
+
+#endif  // defined(NODE_SIMD_ARM64)
+
+enum class Implementation { kScalar, kSSSE3, kAVX2, kNEON };
+
+Implementation GetImplementation() {
+  static const Implementation implementation = []() {
+#if defined(NODE_SIMD_X64)
+    if (cpu_features::HasAVX2()) return Implementation::kAVX2;
+    if (cpu_features::HasSSSE3()) return Implementation::kSSSE3;
+    return Implementation::kScalar;
+#elif defined(NODE_SIMD_ARM64)
+    return Implementation::kNEON;
+#else
+    return Implementation::kScalar;
+#endif
+  }();
+  return implementation;
+}
+
+}  // anonymous namespace
+
+size_t EncodeBlocks(const uint8_t* src, size_t length, char* dst) {
+  switch (GetImplementation()) {
+#if defined(NODE_SIMD_X64)
+    case Implementation::kAVX2:
+      return EncodeAVX2(src, length, dst);
+    case Implementation::kSSSE3:
+      return EncodeSSSE3(src, length, dst);
+#elif defined(NODE_SIMD_ARM64)
+    case Implementation::kNEON:
+      return EncodeLoop<NEONOps>(src, length, dst);
+#endif
+    default:
+      return 0;
+  }
+}
+
+size_t DecodeBlocks(const uint8_t* src, size_t max_bytes, char* dst) {
+  switch (GetImplementation()) {
+#if defined(NODE_SIMD_X64)
+    case Implementation::kAVX2:
+      return DecodeAVX2(src, max_bytes, dst);
+    case Implementation::kSSSE3:
+      return DecodeSSSE3(src, max_bytes, dst);
+#elif defined(NODE_SIMD_ARM64)
+    case Implementation::kNEON:
+      return DecodeLoop<NEONOps>(src, max_bytes, dst);
+#endif
+    default:
+      return 0;
+  }
+}
+
+const char* SimdImplementation() {
+  switch (GetImplementation()) {
+    case Implementation::kAVX2:
+      return "avx2";
+    case Implementation::kSSSE3:
+      return "ssse3";
+    case Implementation::kNEON:
+      return "neon";
+    case Implementation::kScalar:
+      return "scalar";
+  }
+  UNREACHABLE();
+}
+
+}  // namespace hex
+}  // namespace node
@@ -0,0 +1,39 @@
+#ifndef SRC_HEX_SIMD_H_
+#define SRC_HEX_SIMD_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include "cpu_features.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace node {
+namespace hex {
+
+// Vectorized kernels for the "hex" encoding of StringBytes. They only handle
+// whole blocks of input and leave the remainder, as well as the exact
+// position of an invalid digit, to the scalar loops in string_bytes.cc.
+//
+// The implementation (AVX2 or SSSE3 on x86-64, NEON on arm64) is picked on
+// first use. Without any of these, both functions return 0.
+
+// Encodes a prefix of `src` as lowercase hex digits into `dst`, which must
+// have room for `2 * length` characters. Returns the number of encoded bytes
+// of `src`; twice as many characters have been written.
+size_t EncodeBlocks(const uint8_t* src, size_t length, char* dst);
+
+// Decodes the longest prefix of at most `max_bytes` pairs of `src` that
+// consists of whole blocks of valid hex digits into `dst`. Returns the number
+// of decoded bytes; twice as many characters of `src` have been consumed.
+size_t DecodeBlocks(const uint8_t* src, size_t max_bytes, char* dst);
+
+// Name of the selected implementation, for tests and diagnostics.
+const char* SimdImplementation();
+
+}  // namespace hex
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_HEX_SIMD_H_
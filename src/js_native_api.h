@@ -108,6 +108,19 @@ NAPI_EXTERN napi_status NAPI_CDECL napi_create_function(napi_env env,
                                                         napi_callback cb,
                                                         void* data,
                                                         napi_value* result);
+#ifdef NAPI_EXPERIMENTAL
+NAPI_EXTERN napi_status NAPI_CDECL
+node_api_create_fast_function(napi_env env,
+                              const char* utf8name,
+                              size_t length,
+                              napi_callback cb,
+                              node_api_fast_callback fast_cb,
+                              node_api_fast_type return_type,
+                              const node_api_fast_type* arg_types,
+                              size_t arg_count,
+                              void* data,
+                              napi_value* result);
+#endif  // NAPI_EXPERIMENTAL
 NAPI_EXTERN napi_status NAPI_CDECL napi_create_error(napi_env env,
                                                      napi_value code,
                                                      napi_value msg,
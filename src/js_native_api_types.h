@@ -4,8 +4,9 @@
 // This file needs to be compatible with C compilers.
 // This is a public include file, and these includes have essentially
 // became part of it's API.
-#include <stddef.h>  // NOLINT(modernize-deprecated-headers)
-#include <stdint.h>  // NOLINT(modernize-deprecated-headers)
+#include <stdbool.h>  // NOLINT(modernize-deprecated-headers)
+#include <stddef.h>   // NOLINT(modernize-deprecated-headers)
+#include <stdint.h>   // NOLINT(modernize-deprecated-headers)
 
 #if !defined __cplusplus || (defined(_MSC_VER) && _MSC_VER < 1900)
 typedef uint16_t char16_t;
@@ -164,4 +165,36 @@ typedef struct {
 } napi_type_tag;
 #endif  // NAPI_VERSION >= 8
 
+#ifdef NAPI_EXPERIMENTAL
+// Argument and return types understood by node_api_create_fast_function().
+typedef enum {
+  node_api_fast_void,  // Only valid as a return type.
+  node_api_fast_number,
+  node_api_fast_boolean,
+  node_api_fast_uint8_array,
+  node_api_fast_int32_array,
+  node_api_fast_float64_array,
+} node_api_fast_type;
+
+typedef union {
+  double number;
+  bool boolean;
+  // Typed arrays are passed as a pointer to their first element and their
+  // length in elements. The memory is only valid during the call.
+  struct {
+    void* data;
+    size_t length;
+  } array;
+} node_api_fast_value;
+
+// Called directly from optimized code. It must not call into Node-API or
+// JavaScript, and cannot throw; returning false makes the engine repeat the
+// call through the regular napi_callback instead.
+typedef bool(NAPI_CDECL* node_api_fast_callback)(
+    void* data,
+    const node_api_fast_value* args,
+    size_t argc,
+    node_api_fast_value* result);
+#endif  // NAPI_EXPERIMENTAL
+
 #endif  // SRC_JS_NATIVE_API_TYPES_H_
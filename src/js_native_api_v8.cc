@@ -1,11 +1,13 @@
 #include <algorithm>
 #include <climits>  // INT_MAX
 #include <cmath>
+#include <type_traits>
 #define NAPI_EXPERIMENTAL
 #include "env-inl.h"
 #include "js_native_api.h"
 #include "js_native_api_v8.h"
 #include "util-inl.h"
+#include "v8-fast-api-calls.h"
 
 #define CHECK_MAYBE_NOTHING(env, maybe, status)                                \
   RETURN_STATUS_IF_FALSE((env), !((maybe).IsNothing()), (status))
@@ -241,11 +243,14 @@ class CallbackBundle {
  public:
   // Creates an object to be made available to the static function callback
   // wrapper, used to retrieve the native callback function and data pointer.
-  static inline v8::Local<v8::Value> New(napi_env env,
-                                         napi_callback cb,
-                                         void* data) {
+  static inline v8::Local<v8::Value> New(
+      napi_env env,
+      napi_callback cb,
+      void* data,
+      node_api_fast_callback fast_cb = nullptr) {
     CallbackBundle* bundle = new CallbackBundle();
     bundle->cb = cb;
+    bundle->fast_cb = fast_cb;
     bundle->cb_data = data;
     bundle->env = env;
 
@@ -257,6 +262,7 @@ class CallbackBundle {
   napi_env env;   // Necessary to invoke C++ NAPI callback
   void* cb_data;  // The user provided callback data
   napi_callback cb;
+  node_api_fast_callback fast_cb;  // Only set for fast functions
 
  private:
   static void Delete(napi_env env, void* data, void* hint) {
@@ -401,6 +407,138 @@ class FunctionCallbackWrapper : public CallbackWrapperBase {
   }
 };
 
+// Functions created through node_api_create_fast_function() get a
+// v8::CFunction next to their regular callback. V8 needs the exact C++
+// signature of that function, so one trampoline is instantiated for every
+// supported combination of argument and return types, and the right one is
+// picked at runtime from the types the addon declared. The trampolines only
+// unpack their arguments into node_api_fast_value and forward them, together
+// with the user data, to the addon's node_api_fast_callback.
+class FastCallbackWrapper {
+ public:
+  // Keeps the number of trampolines (5^n argument combinations for each of
+  // the 3 return types) reasonable.
+  static constexpr size_t kMaxArgs = 3;
+
+  static const v8::CFunction* Select(node_api_fast_type return_type,
+                                     const node_api_fast_type* arg_types,
+                                     size_t arg_count) {
+    if (arg_count > kMaxArgs) return nullptr;
+    switch (return_type) {
+      case node_api_fast_void:
+        return SelectArgs<void>(arg_types, arg_count);
+      case node_api_fast_number:
+        return SelectArgs<double>(arg_types, arg_count);
+      case node_api_fast_boolean:
+        return SelectArgs<bool>(arg_types, arg_count);
+      default:
+        return nullptr;
+    }
+  }
+
+  static inline napi_status NewFunction(napi_env env,
+                                        napi_callback cb,
+                                        const v8::CFunction* fast_function,
+                                        node_api_fast_callback fast_cb,
+                                        void* cb_data,
+                                        v8::Local<v8::Function>* result) {
+    v8::Local<v8::Value> cbdata =
+        v8impl::CallbackBundle::New(env, cb, cb_data, fast_cb);
+    RETURN_STATUS_IF_FALSE(env, !cbdata.IsEmpty(), napi_generic_failure);
+
+    v8::Local<v8::FunctionTemplate> tpl =
+        v8::FunctionTemplate::New(env->isolate,
+                                  FunctionCallbackWrapper::Invoke,
+                                  cbdata,
+                                  v8::Local<v8::Signature>(),
+                                  0,
+                                  v8::ConstructorBehavior::kThrow,
+                                  v8::SideEffectType::kHasSideEffect,
+                                  fast_function);
+    v8::MaybeLocal<v8::Function> maybe_function =
+        tpl->GetFunction(env->context());
+    CHECK_MAYBE_EMPTY(env, maybe_function, napi_generic_failure);
+
+    *result = maybe_function.ToLocalChecked();
+    return napi_clear_last_error(env);
+  }
+
+ private:
+  template <typename R, typename... Args>
+  static const v8::CFunction* SelectArgs(const node_api_fast_type* types,
+                                         size_t remaining) {
+    if (remaining == 0) {
+      static const v8::CFunction function =
+          v8::CFunction::Make(Trampoline<R, Args...>);
+      return &function;
+    }
+    if constexpr (sizeof...(Args) < kMaxArgs) {
+      using Uint8Array = const v8::FastApiTypedArray<uint8_t>&;
+      using Int32Array = const v8::FastApiTypedArray<int32_t>&;
+      using Float64Array = const v8::FastApiTypedArray<double>&;
+      switch (types[0]) {
+        case node_api_fast_number:
+          return SelectArgs<R, Args..., double>(types + 1, remaining - 1);
+        case node_api_fast_boolean:
+          return SelectArgs<R, Args..., bool>(types + 1, remaining - 1);
+        case node_api_fast_uint8_array:
+          return SelectArgs<R, Args..., Uint8Array>(types + 1, remaining - 1);
+        case node_api_fast_int32_array:
+          return SelectArgs<R, Args..., Int32Array>(types + 1, remaining - 1);
+        case node_api_fast_float64_array:
+          return SelectArgs<R, Args..., Float64Array>(types + 1,
+                                                      remaining - 1);
+        default:
+          break;
+      }
+    }
+    return nullptr;
+  }
+
+  static inline bool Unpack(double value, node_api_fast_value* out) {
+    out->number = value;
+    return true;
+  }
+
+  static inline bool Unpack(bool value, node_api_fast_value* out) {
+    out->boolean = value;
+    return true;
+  }
+
+  template <typename T>
+  static inline bool Unpack(const v8::FastApiTypedArray<T>& value,
+                            node_api_fast_value* out) {
+    T* data;
+    // Misaligned views cannot be handed out as T*; take the slow path.
+    if (!value.getStorageIfAligned(&data)) return false;
+    out->array.data = data;
+    out->array.length = value.length();
+    return true;
+  }
+
+  template <typename R, typename... Args>
+  static R Trampoline(v8::Local<v8::Object> receiver,
+                      Args... args,
+                      v8::FastApiCallbackOptions& options) {
+    CallbackBundle* bundle = reinterpret_cast<CallbackBundle*>(
+        options.data.As<v8::External>()->Value());
+    // One extra element so that the array is never empty.
+    node_api_fast_value values[sizeof...(Args) + 1];
+    node_api_fast_value result = {};
+    size_t i = 0;
+    bool ok = (true && ... && Unpack(args, &values[i++]));
+    if (!ok ||
+        !bundle->fast_cb(bundle->cb_data, values, sizeof...(Args), &result)) {
+      options.fallback = true;
+    }
+    if constexpr (std::is_same_v<R, double>) {
+      return result.number;
+    } else if constexpr (std::is_same_v<R, bool>) {
+      return result.boolean;
+    }
+  }
+};
+
 inline napi_status Wrap(napi_env env,
                         napi_value js_object,
                         void* native_object,
@@ -471,6 +609,58 @@ inline bool CanBeHeldWeakly(v8::Local<v8::Value> value) {
 
 }  // end of anonymous namespace
 
+RefTracker* FinalizerQueue::Pop() {
+  // When finalizers keep being queued while others are drained, the consumed
+  // prefix never reaches the end of the vector. Drop it once it is large.
+  if (head_ >= 1024 && head_ * 2 >= entries_.size()) {
+    size_t live = 0;
+    for (size_t i = head_; i < entries_.size(); i++) {
+      RefTracker* tracker = entries_[i];
+      if (tracker == nullptr) continue;
+      tracker->queue_index_ = live;
+      entries_[live++] = tracker;
+    }
+    entries_.resize(live);
+    head_ = 0;
+  }
+  while (head_ < entries_.size()) {
+    RefTracker* tracker = entries_[head_++];
+    if (tracker == nullptr) continue;  // Erased while waiting.
+    tracker->queue_index_ = SIZE_MAX;
+    size_--;
+    return tracker;
+  }
+  entries_.clear();
+  head_ = 0;
+  return nullptr;
+}
+
+void* SlabAllocator::Allocate(size_t size) {
+  CHECK_LE(size, kBlockSize);
+  if (free_list_ == nullptr) {
+    std::unique_ptr<Block[]> chunk(new Block[kBlocksPerChunk]);
+    for (size_t i = kBlocksPerChunk; i-- > 0;) {
+      chunk[i].owner = this;
+      chunk[i].next_free = free_list_;
+      free_list_ = &chunk[i];
+    }
+    chunks_.emplace_back(std::move(chunk));
+  }
+  Block* block = free_list_;
+  free_list_ = block->next_free;
+  live_++;
+  return block->storage;
+}
+
+void SlabAllocator::Free(void* ptr) {
+  Block* block = reinterpret_cast<Block*>(static_cast<char*>(ptr) -
+                                          offsetof(Block, storage));
+  SlabAllocator* owner = block->owner;
+  block->next_free = owner->free_list_;
+  owner->free_list_ = block;
+  owner->live_--;
+}
+
 void Finalizer::ResetFinalizer() {
   finalize_callback_ = nullptr;
   finalize_data_ = nullptr;
@@ -582,13 +772,27 @@ Reference* Reference::New(napi_env env,
                           napi_finalize finalize_callback,
                           void* finalize_data,
                           void* finalize_hint) {
-  return new Reference(env,
-                       value,
-                       initial_refcount,
-                       ownership,
-                       finalize_callback,
-                       finalize_data,
-                       finalize_hint);
+  return new (env) Reference(env,
+                             value,
+                             initial_refcount,
+                             ownership,
+                             finalize_callback,
+                             finalize_data,
+                             finalize_hint);
+}
+
+void* Reference::operator new(size_t size, napi_env env) {
+  static_assert(sizeof(Reference) <= SlabAllocator::kBlockSize,
+                "SlabAllocator::kBlockSize is too small for a Reference");
+  return env->reference_slab.Allocate(size);
+}
+
+void Reference::operator delete(void* ptr, napi_env env) {
+  SlabAllocator::Free(ptr);
+}
+
+void Reference::operator delete(void* ptr) {
+  SlabAllocator::Free(ptr);
 }
 
 uint32_t Reference::Ref() {
@@ -737,6 +941,45 @@ napi_status NAPI_CDECL napi_create_function(napi_env env,
   return GET_RETURN_STATUS(env);
 }
 
+napi_status NAPI_CDECL
+node_api_create_fast_function(napi_env env,
+                              const char* utf8name,
+                              size_t length,
+                              napi_callback cb,
+                              node_api_fast_callback fast_cb,
+                              node_api_fast_type return_type,
+                              const node_api_fast_type* arg_types,
+                              size_t arg_count,
+                              void* callback_data,
+                              napi_value* result) {
+  NAPI_PREAMBLE(env);
+  CHECK_ARG(env, result);
+  CHECK_ARG(env, cb);
+  CHECK_ARG(env, fast_cb);
+  if (arg_count > 0) CHECK_ARG(env, arg_types);
+
+  const v8::CFunction* fast_function =
+      v8impl::FastCallbackWrapper::Select(return_type, arg_types, arg_count);
+  RETURN_STATUS_IF_FALSE(env, fast_function != nullptr, napi_invalid_arg);
+
+  v8::Local<v8::Function> return_value;
+  v8::EscapableHandleScope scope(env->isolate);
+  v8::Local<v8::Function> fn;
+  STATUS_CALL(v8impl::FastCallbackWrapper::NewFunction(
+      env, cb, fast_function, fast_cb, callback_data, &fn));
+  return_value = scope.Escape(fn);
+
+  if (utf8name != nullptr) {
+    v8::Local<v8::String> name_string;
+    CHECK_NEW_FROM_UTF8_LEN(env, name_string, utf8name, length);
+    return_value->SetName(name_string);
+  }
+
+  *result = v8impl::JsValueFromV8LocalValue(return_value);
+
+  return GET_RETURN_STATUS(env);
+}
+
 napi_status NAPI_CDECL
 napi_define_class(napi_env env,
                   const char* utf8name,
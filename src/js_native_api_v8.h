@@ -1,6 +1,9 @@
 #ifndef SRC_JS_NATIVE_API_V8_H_
 #define SRC_JS_NATIVE_API_V8_H_
 
+#include <cstddef>
+#include <memory>
+#include <vector>
 #include "js_native_api_types.h"
 #include "js_native_api_v8_internals.h"
 
@@ -43,8 +46,80 @@ class RefTracker {
   }
 
  private:
+  friend class FinalizerQueue;
+
   RefList* next_ = nullptr;
   RefList* prev_ = nullptr;
+  // Position in the FinalizerQueue this tracker is waiting in, if any.
+  size_t queue_index_ = SIZE_MAX;
+};
+
+// FIFO of RefTrackers whose finalizers are waiting to run. Every tracker
+// remembers its slot, so removing one that is about to be deleted is O(1) and
+// leaves a hole that Pop() skips. Unlike a hash set, pushing millions of
+// entries during a single GC needs no per-entry allocation.
+class FinalizerQueue {
+ public:
+  inline void Push(RefTracker* tracker) {
+    if (tracker->queue_index_ != SIZE_MAX) return;
+    tracker->queue_index_ = entries_.size();
+    entries_.push_back(tracker);
+    size_++;
+  }
+
+  inline void Erase(RefTracker* tracker) {
+    if (tracker->queue_index_ == SIZE_MAX) return;
+    entries_[tracker->queue_index_] = nullptr;
+    tracker->queue_index_ = SIZE_MAX;
+    size_--;
+  }
+
+  // Returns the oldest tracker, or nullptr if the queue is empty.
+  RefTracker* Pop();
+
+  inline size_t size() const { return size_; }
+  inline bool empty() const { return size_ == 0; }
+
+ private:
+  std::vector<RefTracker*> entries_;
+  size_t head_ = 0;
+  size_t size_ = 0;
+};
+
+// Hands out fixed-size blocks carved from larger chunks, so that creating and
+// deleting large numbers of References does not go through malloc() for each
+// of them and keeps them close together in memory. Each block starts with a
+// pointer to its allocator, which lets Free() be called with nothing but the
+// block, as class-specific operator delete is. Chunks are only released when
+// the allocator is destroyed together with its napi_env.
+class SlabAllocator {
+ public:
+  static constexpr size_t kBlockSize = 96;
+
+  SlabAllocator() = default;
+  SlabAllocator(const SlabAllocator&) = delete;
+  SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+  void* Allocate(size_t size);
+  static void Free(void* ptr);
+
+  // Number of blocks currently handed out.
+  inline size_t live() const { return live_; }
+
+ private:
+  static constexpr size_t kBlocksPerChunk = 256;
+
+  struct Block {
+    SlabAllocator* owner;
+    union {
+      Block* next_free;
+      alignas(alignof(std::max_align_t)) char storage[kBlockSize];
+    };
+  };
+
+  std::vector<std::unique_ptr<Block[]>> chunks_;
+  Block* free_list_ = nullptr;
+  size_t live_ = 0;
 };
 
 class Finalizer;
@@ -110,13 +185,13 @@ struct napi_env__ {
   // Implementation should drain the queue at the time it is safe to call
   // into JavaScript.
   virtual void EnqueueFinalizer(v8impl::RefTracker* finalizer) {
-    pending_finalizers.emplace(finalizer);
+    pending_finalizers.Push(finalizer);
   }
 
   // Remove the finalizer from the scheduled second pass weak callback queue.
   // The finalizer can be deleted after this call.
   virtual void DequeueFinalizer(v8impl::RefTracker* finalizer) {
-    pending_finalizers.erase(finalizer);
+    pending_finalizers.Erase(finalizer);
   }
 
   virtual void DeleteMe() {
@@ -140,8 +215,10 @@ struct napi_env__ {
   // have such a callback. See `~napi_env__()` above for details.
   v8impl::RefTracker::RefList reflist;
   v8impl::RefTracker::RefList finalizing_reflist;
-  // The invocation order of the finalizers is not determined.
-  std::unordered_set<v8impl::RefTracker*> pending_finalizers;
+  // Finalizers run in the order in which their values were collected.
+  v8impl::FinalizerQueue pending_finalizers;
+  // Backing store for every v8impl::Reference created in this env.
+  v8impl::SlabAllocator reference_slab;
   napi_extended_error_info last_error;
   int open_handle_scopes = 0;
   int open_callback_scopes = 0;
@@ -410,6 +487,12 @@ class Reference : public RefBase {
                         void* finalize_hint = nullptr);
 
   virtual ~Reference();
+
+  // References are allocated from their env's reference_slab.
+  static void* operator new(size_t size, napi_env env);
+  static void operator delete(void* ptr, napi_env env);
+  static void operator delete(void* ptr);
+
   uint32_t Ref();
   uint32_t Unref();
   v8::Local<v8::Value> Get();
@@ -1,17 +1,490 @@
 #include "json_parser.h"
 #include "node_errors.h"
 #include "node_v8_platform-inl.h"
+#include "simdutf.h"
 #include "util-inl.h"
 
+#include <cfloat>
+#include <cstring>
+#include <unordered_map>
+
 namespace node {
+using v8::Array;
 using v8::ArrayBuffer;
 using v8::Context;
 using v8::Isolate;
 using v8::Local;
+using v8::MaybeLocal;
+using v8::Name;
+using v8::NewStringType;
+using v8::Number;
 using v8::Object;
 using v8::String;
 using v8::Value;
 
+namespace json {
+
+namespace {
+
+constexpr bool IsWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+constexpr bool IsDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+constexpr int HexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+// Whether a word contains a byte that ends the fast scan of a string: a
+// quote, a backslash or a control character.
+inline bool HasSpecialByte(uint64_t word) {
+  constexpr uint64_t kOnes = 0x0101010101010101;
+  constexpr uint64_t kHighBits = 0x8080808080808080;
+  const uint64_t quote = word ^ (kOnes * '"');
+  const uint64_t backslash = word ^ (kOnes * '\\');
+  return (((quote - kOnes) & ~quote) | ((backslash - kOnes) & ~backslash) |
+          ((word - kOnes * 0x20) & ~word)) &
+         kHighBits;
+}
+
+#if FLT_EVAL_METHOD == 0
+constexpr double kPowersOfTen[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+#endif
+
+}  // anonymous namespace
+
+void Document::SkipWhitespace(size_t* pos) const {
+  while (*pos < source_.size() && IsWhitespace(source_[*pos])) ++*pos;
+}
+
+bool Document::ParseLiteral(size_t* pos,
+                            std::string_view literal,
+                            Node::Type type) {
+  if (source_.substr(*pos, literal.size()) != literal) return false;
+  *pos += literal.size();
+  Node node{type, Node::kNone, 0, {0}};
+  nodes_.push_back(node);
+  return true;
+}
+
+bool Document::ParseString(size_t* pos) {
+  const char* data = source_.data();
+  const size_t size = source_.size();
+  const size_t start = *pos + 1;
+  uint64_t high_bits = 0;
+  uint8_t flags = Node::kNone;
+  size_t i = start;
+  for (;;) {
+    // Skip eight plain bytes at a time.
+    while (i + 8 <= size) {
+      uint64_t word;
+      memcpy(&word, data + i, sizeof(word));
+      if (HasSpecialByte(word)) break;
+      high_bits |= word;
+      i += 8;
+    }
+    if (i >= size) return false;
+    const uint8_t c = static_cast<uint8_t>(data[i]);
+    if (c == '"') break;
+    if (c < 0x20) return false;
+    if (c == '\\') {
+      flags |= Node::kEscaped;
+      if (++i >= size) return false;
+      switch (data[i]) {
+        case '"':
+        case '\\':
+        case '/':
+        case 'b':
+        case 'f':
+        case 'n':
+        case 'r':
+        case 't':
+          break;
+        case 'u':
+          if (i + 4 >= size) return false;
+          for (size_t k = 1; k <= 4; k++) {
+            if (HexValue(data[i + k]) < 0) return false;
+          }
+          i += 4;
+          break;
+        default:
+          return false;
+      }
+    }
+    high_bits |= c;
+    i++;
+  }
+  if ((high_bits & 0x8080808080808080) == 0) flags |= Node::kAscii;
+  Node node{Node::kString, flags, i - start, {start}};
+  nodes_.push_back(node);
+  *pos = i + 1;
+  return true;
+}
+
+bool Document::ParseNumber(size_t* pos) {
+  const char* data = source_.data();
+  const size_t size = source_.size();
+  const size_t start = *pos;
+  size_t i = start;
+  const bool negative = data[i] == '-';
+  if (negative) i++;
+
+  // Accumulate up to 15 digits, which is exact in a double, and the decimal
+  // exponent that applies to them.
+  uint64_t mantissa = 0;
+  int digits = 0;
+  int exponent = 0;
+  if (i >= size || !IsDigit(data[i])) return false;
+  if (data[i] == '0') {
+    i++;
+  } else {
+    for (; i < size && IsDigit(data[i]); i++, digits++)
+      mantissa = mantissa * 10 + (data[i] - '0');
+  }
+  if (i < size && data[i] == '.') {
+    if (++i >= size || !IsDigit(data[i])) return false;
+    for (; i < size && IsDigit(data[i]); i++, digits++, exponent--)
+      mantissa = mantissa * 10 + (data[i] - '0');
+  }
+  bool exponent_fits = true;
+  if (i < size && (data[i] == 'e' || data[i] == 'E')) {
+    i++;
+    const bool exponent_negative = i < size && data[i] == '-';
+    if (i < size && (data[i] == '-' || data[i] == '+')) i++;
+    if (i >= size || !IsDigit(data[i])) return false;
+    int value = 0;
+    for (; i < size && IsDigit(data[i]); i++) {
+      if (value < 10000) {
+        value = value * 10 + (data[i] - '0');
+      } else {
+        exponent_fits = false;
+      }
+    }
+    exponent += exponent_negative ? -value : value;
+  }
+
+  Node node{Node::kNumber, Node::kNone, i - start, {start}};
+#if FLT_EVAL_METHOD == 0
+  // With at most 15 digits and a power of ten that is exact in a double, a
+  // single multiplication or division is correctly rounded.
+  if (digits <= 15 && exponent_fits && exponent >= -22 && exponent <= 22) {
+    double value = static_cast<double>(mantissa);
+    if (exponent < 0)
+      value /= kPowersOfTen[-exponent];
+    else
+      value *= kPowersOfTen[exponent];
+    node.flags = Node::kExact;
+    node.number = negative ? -value : value;
+  }
+#endif
+  nodes_.push_back(node);
+  *pos = i;
+  return true;
+}
+
+bool Document::Parse(std::string_view source) {
+  source_ = source;
+  nodes_.clear();
+  // Indices of the arrays and objects that are still open.
+  std::vector<size_t> open;
+  size_t pos = 0;
+
+  auto parse_key = [&]() {
+    if (pos >= source_.size() || source_[pos] != '"' || !ParseString(&pos))
+      return false;
+    SkipWhitespace(&pos);
+    if (pos >= source_.size() || source_[pos] != ':') return false;
+    pos++;
+    SkipWhitespace(&pos);
+    return true;
+  };
+
+  SkipWhitespace(&pos);
+  for (;;) {
+    // Parse the value at `pos`, which is not whitespace.
+    if (pos >= source_.size()) return false;
+    switch (source_[pos]) {
+      case '[':
+      case '{': {
+        const bool is_object = source_[pos] == '{';
+        Node node{is_object ? Node::kObject : Node::kArray,
+                  Node::kNone,
+                  0,
+                  {0}};
+        nodes_.push_back(node);
+        pos++;
+        SkipWhitespace(&pos);
+        if (pos < source_.size() && source_[pos] == (is_object ? '}' : ']')) {
+          pos++;
+          break;
+        }
+        open.push_back(nodes_.size() - 1);
+        if (is_object && !parse_key()) return false;
+        continue;
+      }
+      case '"':
+        if (!ParseString(&pos)) return false;
+        break;
+      case 't':
+        if (!ParseLiteral(&pos, "true", Node::kTrue)) return false;
+        break;
+      case 'f':
+        if (!ParseLiteral(&pos, "false", Node::kFalse)) return false;
+        break;
+      case 'n':
+        if (!ParseLiteral(&pos, "null", Node::kNull)) return false;
+        break;
+      default:
+        if (!ParseNumber(&pos)) return false;
+        break;
+    }
+
+    // A value is complete. Add it to the enclosing containers and close
+    // those that end here.
+    for (;;) {
+      if (open.empty()) {
+        SkipWhitespace(&pos);
+        return pos == source_.size();
+      }
+      Node& container = nodes_[open.back()];
+      container.length++;
+      SkipWhitespace(&pos);
+      if (pos >= source_.size()) return false;
+      const bool is_object = container.type == Node::kObject;
+      if (source_[pos] == ',') {
+        pos++;
+        SkipWhitespace(&pos);
+        if (is_object && !parse_key()) return false;
+        break;
+      }
+      if (source_[pos] != (is_object ? '}' : ']')) return false;
+      pos++;
+      open.pop_back();
+    }
+  }
+}
+
+MaybeLocal<Value> Document::ToValue(Local<Context> context) const {
+  Isolate* isolate = context->GetIsolate();
+
+  // Most documents repeat the same keys in many objects, so each distinct
+  // key is only converted and internalized once.
+  std::unordered_map<std::string_view, Local<String>> keys;
+  std::u16string scratch;
+
+  auto to_string = [&](const Node& node, bool is_key) -> MaybeLocal<String> {
+    const std::string_view text = source_.substr(node.offset, node.length);
+    const NewStringType type =
+        is_key ? NewStringType::kInternalized : NewStringType::kNormal;
+    if (!(node.flags & Node::kEscaped)) {
+      if (is_key) {
+        auto it = keys.find(text);
+        if (it != keys.end()) return it->second;
+      }
+      MaybeLocal<String> maybe_string =
+          (node.flags & Node::kAscii)
+              ? String::NewFromOneByte(
+                    isolate,
+                    reinterpret_cast<const uint8_t*>(text.data()),
+                    type,
+                    text.size())
+              : String::NewFromUtf8(isolate, text.data(), type, text.size());
+      Local<String> string;
+      if (is_key && maybe_string.ToLocal(&string)) keys.emplace(text, string);
+      return maybe_string;
+    }
+
+    // Decode the escape sequences. The plain runs in between are UTF-8 and
+    // are converted with simdutf; if one of them is not valid, let V8 parse
+    // the whole literal so that invalid bytes are replaced in the same way
+    // as by buffer.toString().
+    scratch.clear();
+    size_t i = 0;
+    while (i < text.size()) {
+      size_t run = text.find('\\', i);
+      if (run == std::string_view::npos) run = text.size();
+      if (run > i) {
+        const char* chunk = text.data() + i;
+        const size_t chunk_length = run - i;
+        if (!simdutf::validate_utf8(chunk, chunk_length)) {
+          Local<String> literal;
+          Local<Value> value;
+          if (!String::NewFromUtf8(isolate,
+                                   text.data() - 1,
+                                   NewStringType::kNormal,
+                                   text.size() + 2)
+                   .ToLocal(&literal) ||
+              !v8::JSON::Parse(context, literal).ToLocal(&value)) {
+            return MaybeLocal<String>();
+          }
+          return value.As<String>();
+        }
+        const size_t offset = scratch.size();
+        scratch.resize(offset +
+                       simdutf::utf16_length_from_utf8(chunk, chunk_length));
+        const size_t written = simdutf::convert_valid_utf8_to_utf16(
+            chunk, chunk_length, &scratch[offset]);
+        CHECK_EQ(offset + written, scratch.size());
+      }
+      if (run == text.size()) break;
+      const char escape = text[run + 1];
+      i = run + 2;
+      switch (escape) {
+        case 'b':
+          scratch.push_back(u'\b');
+          break;
+        case 'f':
+          scratch.push_back(u'\f');
+          break;
+        case 'n':
+          scratch.push_back(u'\n');
+          break;
+        case 'r':
+          scratch.push_back(u'\r');
+          break;
+        case 't':
+          scratch.push_back(u'\t');
+          break;
+        case 'u': {
+          char16_t code_unit = 0;
+          for (size_t k = 0; k < 4; k++)
+            code_unit = (code_unit << 4) | HexValue(text[i + k]);
+          scratch.push_back(code_unit);
+          i += 4;
+          break;
+        }
+        default:
+          // '"', '\\' and '/' stand for themselves.
+          scratch.push_back(escape);
+          break;
+      }
+    }
+    return String::NewFromTwoByte(isolate,
+                                  reinterpret_cast<const uint16_t*>(
+                                      scratch.data()),
+                                  type,
+                                  scratch.size());
+  };
+
+  struct Frame {
+    const Node* node;
+    // Position of the first element or key in `values`.
+    size_t start;
+    // Number of entries in `values` that make up the container.
+    size_t length;
+  };
+  std::vector<Frame> frames;
+  std::vector<Local<Value>> values;
+
+  for (const Node& node : nodes_) {
+    Local<Value> value;
+    switch (node.type) {
+      case Node::kNull:
+        value = v8::Null(isolate);
+        break;
+      case Node::kTrue:
+        value = v8::True(isolate);
+        break;
+      case Node::kFalse:
+        value = v8::False(isolate);
+        break;
+      case Node::kNumber:
+        if (node.flags & Node::kExact) {
+          value = Number::New(isolate, node.number);
+        } else {
+          Local<String> text;
+          double number;
+          if (!String::NewFromOneByte(isolate,
+                                      reinterpret_cast<const uint8_t*>(
+                                          source_.data() + node.offset),
+                                      NewStringType::kNormal,
+                                      node.length)
+                   .ToLocal(&text) ||
+              !text->NumberValue(context).To(&number)) {
+            return MaybeLocal<Value>();
+          }
+          value = Number::New(isolate, number);
+        }
+        break;
+      case Node::kString: {
+        // Inside an object, the entries alternate between keys and values.
+        const bool is_key = !frames.empty() &&
+                            frames.back().node->type == Node::kObject &&
+                            (values.size() - frames.back().start) % 2 == 0;
+        Local<String> string;
+        if (!to_string(node, is_key).ToLocal(&string)) {
+          return MaybeLocal<Value>();
+        }
+        value = string;
+        break;
+      }
+      case Node::kArray:
+      case Node::kObject:
+        frames.push_back(
+            {&node,
+             values.size(),
+             node.type == Node::kObject ? 2 * node.length : node.length});
+        break;
+    }
+    if (!value.IsEmpty()) values.push_back(value);
+
+    // Create the containers whose entries are all there.
+    while (!frames.empty() &&
+           values.size() - frames.back().start == frames.back().length) {
+      const Frame frame = frames.back();
+      frames.pop_back();
+      Local<Value> container;
+      if (frame.node->type == Node::kArray) {
+        container =
+            Array::New(isolate, values.data() + frame.start, frame.length);
+      } else {
+        Local<Object> object = Object::New(isolate);
+        for (size_t k = frame.start; k < values.size(); k += 2) {
+          if (object
+                  ->CreateDataProperty(
+                      context, values[k].As<Name>(), values[k + 1])
+                  .IsNothing()) {
+            return MaybeLocal<Value>();
+          }
+        }
+        container = object;
+      }
+      values.resize(frame.start);
+      values.push_back(container);
+    }
+  }
+
+  CHECK_EQ(values.size(), 1);
+  return values[0];
+}
+
+MaybeLocal<Value> Parse(Local<Context> context, std::string_view source) {
+  Isolate* isolate = context->GetIsolate();
+  Document document;
+  if (document.Parse(source)) return document.ToValue(context);
+
+  // Let V8 report the syntax error, so that the message and position are
+  // the same as with JSON.parse().
+  Local<String> string;
+  if (!String::NewFromUtf8(
+           isolate, source.data(), NewStringType::kNormal, source.size())
+           .ToLocal(&string)) {
+    isolate->ThrowException(ERR_STRING_TOO_LONG(isolate));
+    return MaybeLocal<Value>();
+  }
+  return v8::JSON::Parse(context, string);
+}
+
+}  // namespace json
+
 static Isolate* NewIsolate(v8::ArrayBuffer::Allocator* allocator) {
   Isolate* isolate = Isolate::Allocate();
   CHECK_NOT_NULL(isolate);
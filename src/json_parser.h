@@ -6,10 +6,83 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 #include "util.h"
 #include "v8.h"
 
 namespace node {
+namespace json {
+
+// A JSON document parsed from UTF-8 without V8. Parse() checks the JSON
+// syntax and records the values in a flat "tape" in document order, which
+// can be done on any thread. It does not validate the UTF-8 inside strings;
+// ToValue() turns the tape into JS values on the thread that owns the
+// isolate, and replaces invalid bytes with U+FFFD as buffer.toString() does.
+class Document {
+ public:
+  struct Node {
+    enum Type : uint8_t {
+      kNull,
+      kTrue,
+      kFalse,
+      kNumber,
+      kString,
+      kArray,
+      kObject,
+    };
+    enum Flags : uint8_t {
+      kNone = 0,
+      // kString: the raw bytes are all ASCII.
+      kAscii = 1 << 0,
+      // kString: the raw bytes contain escape sequences.
+      kEscaped = 1 << 1,
+      // kNumber: `number` holds the exact value. Otherwise the value is
+      // converted from the source text by V8.
+      kExact = 1 << 2,
+    };
+
+    Type type;
+    uint8_t flags;
+    // kNumber, kString: length of the source text, without the quotes.
+    // kArray: number of elements. kObject: number of members; each member
+    // is a kString key node followed by the nodes of its value.
+    size_t length;
+    union {
+      // kNumber, kString: position of the source text.
+      size_t offset;
+      // kNumber with kExact.
+      double number;
+    };
+  };
+
+  // Returns false if `source` is not valid JSON. `source` must outlive the
+  // document.
+  bool Parse(std::string_view source);
+
+  // Must only be called after Parse() succeeded.
+  v8::MaybeLocal<v8::Value> ToValue(v8::Local<v8::Context> context) const;
+
+  const std::vector<Node>& nodes() const { return nodes_; }
+
+ private:
+  bool ParseString(size_t* pos);
+  bool ParseNumber(size_t* pos);
+  bool ParseLiteral(size_t* pos, std::string_view literal, Node::Type type);
+  void SkipWhitespace(size_t* pos) const;
+
+  std::string_view source_;
+  std::vector<Node> nodes_;
+};
+
+// Equivalent to JSON.parse(buffer.toString()) for a buffer that holds
+// `source`, without creating the intermediate string. Like JSON.parse, this
+// throws a SyntaxError for invalid input.
+v8::MaybeLocal<v8::Value> Parse(v8::Local<v8::Context> context,
+                                std::string_view source);
+
+}  // namespace json
+
 // This is intended to be used to get some top-level fields out of a JSON
 // without having to spin up a full Node.js environment that unnecessarily
 // complicates things.
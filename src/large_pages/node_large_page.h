@@ -25,9 +25,46 @@
 
 #if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
 
+#include <cstddef>
+#include <cstdint>
+
+namespace v8 {
+class PageAllocator;
+}  // namespace v8
+
 namespace node {
 int MapStaticCodeToLargePages();
 const char* LargePagesError(int status);
+
+// Huge pages for ArrayBuffers and the V8 heap (--use-largepages-data).
+namespace large_pages {
+
+// ArrayBuffers smaller than this come from the regular allocator.
+constexpr size_t kMinDataSize = 2 * 1024 * 1024;
+
+// Must be called before the platform is created. When `prefault` is set,
+// memory is faulted in as soon as it is allocated or committed.
+int EnableForData(bool prefault);
+bool IsEnabledForData();
+
+// Returns zero-filled memory, or nullptr. `size` must be >= kMinDataSize.
+void* AllocateData(size_t size);
+void FreeData(void* data, size_t size);
+
+// The allocator for V8 heap reservations, or nullptr if not enabled.
+v8::PageAllocator* GetDataPageAllocator();
+
+struct DataStats {
+  // Bytes currently held by ArrayBuffers allocated through AllocateData().
+  uint64_t array_buffer_bytes;
+  // Process-wide bytes on transparent and hugetlbfs huge pages, or -1 if the
+  // kernel does not tell.
+  int64_t anon_huge_pages;
+  int64_t hugetlb;
+};
+bool GetDataStats(DataStats* stats);
+
+}  // namespace large_pages
 }  // namespace node
 
 #endif  // NODE_WANT_INTERNALS
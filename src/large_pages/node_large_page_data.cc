@@ -0,0 +1,295 @@
+// Huge pages for data, as opposed to the static code handled in
+// node_large_page.cc. With --use-largepages-data, large ArrayBuffer backing
+// stores are mapped directly from the kernel, from the hugetlbfs pool when the
+// administrator has reserved one and as transparent huge pages (THP)
+// otherwise. The V8 heap gets a PageAllocator that asks for THP on its
+// reservations, much like V8 itself does when built with ENABLE_HUGEPAGE.
+// Neither the heap nor small buffers use hugetlbfs: V8 decommits and discards
+// memory at the granularity of ordinary pages, which hugetlbfs cannot do.
+
+#include "node_large_page.h"
+#include "util.h"
+#include "v8-platform.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+#endif  // defined(__linux__)
+
+namespace node {
+namespace large_pages {
+
+#if defined(__linux__) && !defined(V8_ENABLE_SANDBOX)
+
+namespace {
+
+constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
+bool enabled = false;
+bool prefault = false;
+std::atomic<uint64_t> array_buffer_bytes {0};
+
+// Advises the kernel to back the huge page aligned part of a mapping with
+// transparent huge pages. This is only a hint and failure is harmless.
+void AdviseHugePages(void* address, size_t length) {
+  const uintptr_t start =
+      RoundUp(reinterpret_cast<uintptr_t>(address), kHugePageSize);
+  const uintptr_t end =
+      (reinterpret_cast<uintptr_t>(address) + length) & ~(kHugePageSize - 1);
+  if (end > start) {
+    madvise(reinterpret_cast<void*>(start), end - start, MADV_HUGEPAGE);
+  }
+}
+
+int GetProtection(v8::PageAllocator::Permission access) {
+  switch (access) {
+    case v8::PageAllocator::kNoAccess:
+    case v8::PageAllocator::kNoAccessWillJitLater:
+      return PROT_NONE;
+    case v8::PageAllocator::kRead:
+      return PROT_READ;
+    case v8::PageAllocator::kReadWrite:
+      return PROT_READ | PROT_WRITE;
+    case v8::PageAllocator::kReadWriteExecute:
+      return PROT_READ | PROT_WRITE | PROT_EXEC;
+    case v8::PageAllocator::kReadExecute:
+      return PROT_READ | PROT_EXEC;
+  }
+  UNREACHABLE();
+}
+
+// Follows the semantics of V8's own POSIX page allocator.
+class HugePageAllocator final : public v8::PageAllocator {
+ public:
+  HugePageAllocator() : page_size_(sysconf(_SC_PAGESIZE)) {}
+
+  size_t AllocatePageSize() override { return page_size_; }
+  size_t CommitPageSize() override { return page_size_; }
+  void SetRandomMmapSeed(int64_t seed) override {}
+  // Let the kernel pick, which is randomized as well.
+  void* GetRandomMmapAddr() override { return nullptr; }
+
+  void* AllocatePages(void* hint,
+                      size_t length,
+                      size_t alignment,
+                      Permission access) override {
+    // Over-allocate so that an aligned block of `length` bytes is in there,
+    // then cut off the rest.
+    const size_t request = length + alignment - page_size_;
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    if (access == kNoAccess || access == kNoAccessWillJitLater)
+      flags |= MAP_NORESERVE;
+    if (hint != nullptr)
+      hint = reinterpret_cast<void*>(
+          RoundUp(reinterpret_cast<uintptr_t>(hint), alignment));
+    void* result = mmap(hint, request, GetProtection(access), flags, -1, 0);
+    if (result == MAP_FAILED) return nullptr;
+    char* base = static_cast<char*>(result);
+    char* aligned = reinterpret_cast<char*>(
+        RoundUp(reinterpret_cast<uintptr_t>(base), alignment));
+    if (aligned != base) CHECK_EQ(munmap(base, aligned - base), 0);
+    const size_t suffix = (base + request) - (aligned + length);
+    if (suffix > 0) CHECK_EQ(munmap(aligned + length, suffix), 0);
+    if (length >= kHugePageSize) AdviseHugePages(aligned, length);
+    return aligned;
+  }
+
+  bool FreePages(void* address, size_t length) override {
+    CHECK_EQ(munmap(address, length), 0);
+    return true;
+  }
+
+  bool ReleasePages(void* address,
+                    size_t length,
+                    size_t new_length) override {
+    CHECK_LT(new_length, length);
+    CHECK_EQ(munmap(static_cast<char*>(address) + new_length,
+                    length - new_length),
+             0);
+    return true;
+  }
+
+  bool SetPermissions(void* address,
+                      size_t length,
+                      Permission access) override {
+    const int ret = mprotect(address, length, GetProtection(access));
+    if (ret != 0) {
+      CHECK_EQ(errno, ENOMEM);
+      return false;
+    }
+    if (access == kNoAccess) {
+      DiscardSystemPages(address, length);
+    } else if (prefault && access == kReadWrite) {
+      // Fault in freshly committed heap pages now rather than one by one
+      // later. Kernels before 5.14 do not know this and ignore it.
+      madvise(address, length, MADV_POPULATE_WRITE);
+    }
+    return true;
+  }
+
+  bool RecommitPages(void* address,
+                     size_t length,
+                     Permission access) override {
+    return SetPermissions(address, length, access);
+  }
+
+  bool DiscardSystemPages(void* address, size_t length) override {
+    CHECK_EQ(madvise(address, length, MADV_DONTNEED), 0);
+    return true;
+  }
+
+  bool DecommitPages(void* address, size_t length) override {
+    // Replacing the mapping zeroes the memory and drops the huge page advice,
+    // so the latter is given again.
+    void* ret = mmap(address,
+                     length,
+                     PROT_NONE,
+                     MAP_FIXED | MAP_ANONYMOUS | MAP_PRIVATE,
+                     -1,
+                     0);
+    if (ret == MAP_FAILED) {
+      CHECK_EQ(errno, ENOMEM);
+      return false;
+    }
+    CHECK_EQ(ret, address);
+    if (length >= kHugePageSize) AdviseHugePages(address, length);
+    return true;
+  }
+
+ private:
+  const size_t page_size_;
+};
+
+HugePageAllocator* page_allocator = nullptr;
+
+size_t MappingSize(size_t size) {
+  return RoundUp(size, kHugePageSize);
+}
+
+// Reads the process-wide huge page totals, in bytes, from the kernel.
+void ReadHugePageUsage(DataStats* stats) {
+  stats->anon_huge_pages = -1;
+  stats->hugetlb = -1;
+  FILE* file = fopen("/proc/self/smaps_rollup", "re");
+  if (file == nullptr) return;
+  char line[256];
+  while (fgets(line, sizeof(line), file) != nullptr) {
+    unsigned long long kb;  // NOLINT(runtime/int)
+    if (sscanf(line, "AnonHugePages: %llu kB", &kb) == 1) {
+      stats->anon_huge_pages = kb * 1024;
+    } else if (sscanf(line, "Private_Hugetlb: %llu kB", &kb) == 1 ||
+               sscanf(line, "Shared_Hugetlb: %llu kB", &kb) == 1) {
+      stats->hugetlb = (stats->hugetlb < 0 ? 0 : stats->hugetlb) + kb * 1024;
+    }
+  }
+  fclose(file);
+}
+
+}  // anonymous namespace
+
+int EnableForData(bool prefault_pages) {
+  CHECK(!enabled);
+  // Without THP, only a reserved hugetlbfs pool could help, and the V8 heap
+  // cannot use that.
+  FILE* file = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "re");
+  if (file != nullptr) {
+    char mode[128] = "";
+    const bool never = fgets(mode, sizeof(mode), file) != nullptr &&
+                       strstr(mode, "[never]") != nullptr;
+    fclose(file);
+    if (never) return EACCES;
+  }
+  enabled = true;
+  prefault = prefault_pages;
+  page_allocator = new HugePageAllocator();
+  return 0;
+}
+
+bool IsEnabledForData() {
+  return enabled;
+}
+
+void* AllocateData(size_t size) {
+  DCHECK(enabled);
+  DCHECK_GE(size, kMinDataSize);
+  const size_t length = MappingSize(size);
+  const int populate = prefault ? MAP_POPULATE : 0;
+  // hugetlbfs only works if huge pages have been reserved in advance, e.g.
+  // through /proc/sys/vm/nr_hugepages, and fails right away otherwise.
+  void* data = mmap(nullptr,
+                    length,
+                    PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | populate,
+                    -1,
+                    0);
+  if (data == MAP_FAILED) {
+    data = page_allocator->AllocatePages(
+        nullptr, length, kHugePageSize, v8::PageAllocator::kReadWrite);
+    if (data == nullptr) return nullptr;
+    if (prefault) madvise(data, length, MADV_POPULATE_WRITE);
+  }
+  array_buffer_bytes.fetch_add(length, std::memory_order_relaxed);
+  return data;
+}
+
+void FreeData(void* data, size_t size) {
+  DCHECK(enabled);
+  if (data == nullptr) return;
+  const size_t length = MappingSize(size);
+  CHECK_EQ(munmap(data, length), 0);
+  array_buffer_bytes.fetch_sub(length, std::memory_order_relaxed);
+}
+
+v8::PageAllocator* GetDataPageAllocator() {
+  return page_allocator;
+}
+
+bool GetDataStats(DataStats* stats) {
+  if (!enabled) return false;
+  stats->array_buffer_bytes =
+      array_buffer_bytes.load(std::memory_order_relaxed);
+  ReadHugePageUsage(stats);
+  return true;
+}
+
+#else  // defined(__linux__) && !defined(V8_ENABLE_SANDBOX)
+
+// ArrayBuffers have to live inside the V8 sandbox, which only V8's own
+// allocator can provide.
+int EnableForData(bool prefault_pages) {
+  return ENOTSUP;
+}
+
+bool IsEnabledForData() {
+  return false;
+}
+
+void* AllocateData(size_t size) {
+  UNREACHABLE();
+}
+
+void FreeData(void* data, size_t size) {
+  UNREACHABLE();
+}
+
+v8::PageAllocator* GetDataPageAllocator() {
+  return nullptr;
+}
+
+bool GetDataStats(DataStats* stats) {
+  return false;
+}
+
+#endif  // defined(__linux__) && !defined(V8_ENABLE_SANDBOX)
+
+}  // namespace large_pages
+}  // namespace node
@@ -0,0 +1,89 @@
+#ifndef SRC_MPSC_QUEUE_H_
+#define SRC_MPSC_QUEUE_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include <atomic>
+#include <utility>
+
+namespace node {
+
+// An unbounded multi-producer, single-consumer FIFO queue. Push() may be
+// called from any thread and never blocks or takes a lock. Pop() may only be
+// called from one thread at a time, usually the thread that owns the queue.
+//
+// This is Dmitry Vyukov's intrusive MPSC node queue: a producer publishes its
+// node with a single atomic exchange and then links it to its predecessor.
+// Between those two steps the consumer cannot see the node, nor any node
+// pushed after it, so Pop() may report an empty queue while a Push() is still
+// in progress. Producers are expected to wake the consumer after Push()
+// returns, which makes that harmless.
+template <typename T>
+class MPSCQueue {
+ public:
+  MPSCQueue() : head_(&stub_), tail_(&stub_) {}
+
+  ~MPSCQueue() {
+    T value;
+    while (Pop(&value)) {
+    }
+  }
+
+  MPSCQueue(const MPSCQueue&) = delete;
+  MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+  void Push(T value) { PushNode(new Node(std::move(value))); }
+
+  // Moves the oldest element into `value`. Returns false if there is none,
+  // or if the oldest one is still being pushed.
+  bool Pop(T* value) {
+    Node* tail = tail_;
+    Node* next = tail->next.load(std::memory_order_acquire);
+    if (tail == &stub_) {
+      if (next == nullptr) return false;
+      tail_ = next;
+      tail = next;
+      next = next->next.load(std::memory_order_acquire);
+    }
+    if (next == nullptr) {
+      // `tail` is the last node that was linked. Unless a producer has
+      // exchanged the head since, put the stub back behind it so that
+      // `tail` can be handed out without leaving the queue without nodes.
+      if (tail != head_.load(std::memory_order_acquire)) return false;
+      PushNode(&stub_);
+      next = tail->next.load(std::memory_order_acquire);
+      if (next == nullptr) return false;
+    }
+    tail_ = next;
+    *value = std::move(tail->value);
+    delete tail;
+    return true;
+  }
+
+ private:
+  struct Node {
+    Node() = default;
+    explicit Node(T&& value) : value(std::move(value)) {}
+
+    std::atomic<Node*> next{nullptr};
+    T value{};
+  };
+
+  void PushNode(Node* node) {
+    node->next.store(nullptr, std::memory_order_relaxed);
+    Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  // Written by producers.
+  std::atomic<Node*> head_;
+  // Only touched by the consumer.
+  Node* tail_;
+  Node stub_;
+};
+
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_MPSC_QUEUE_H_
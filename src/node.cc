@@ -922,6 +922,16 @@ InitializeOncePerProcessInternal(const std::vector<std::string>& args,
     }
   }
 
+  // This needs to run before the platform is created.
+  if (!(flags & ProcessInitializationFlags::kNoUseLargePages) &&
+      per_process::cli_options->use_largepages_data != "off") {
+    int lp_result = large_pages::EnableForData(
+        per_process::cli_options->use_largepages_data == "prefault");
+    if (lp_result != 0) {
+      result->errors_.emplace_back(node::LargePagesError(lp_result));
+    }
+  }
+
   if (!(flags & ProcessInitializationFlags::kNoPrintHelpOrVersionOutput)) {
     if (per_process::cli_options->print_version) {
       printf("%s\n", NODE_VERSION);
@@ -3,6 +3,7 @@
 #define NAPI_EXPERIMENTAL
 #include "js_native_api_v8.h"
 #include "memory_tracker-inl.h"
+#include "mpsc_queue.h"
 #include "node_api.h"
 #include "node_api_internals.h"
 #include "node_binding.h"
@@ -18,6 +19,7 @@
 #include <atomic>
 #include <cstring>
 #include <memory>
+#include <vector>
 
 node_napi_env__::node_napi_env__(v8::Local<v8::Context> context,
                                  const std::string& module_filename,
@@ -54,26 +56,42 @@ void node_napi_env__::EnqueueFinalizer(v8impl::RefTracker* finalizer) {
   // destructing the env.
   // When the env is being destructed, queued finalizers are drained in the
   // loop of `node_napi_env__::DrainFinalizerQueue`.
-  if (!finalization_scheduled && !destructing) {
-    finalization_scheduled = true;
-    Ref();
-    node_env()->SetImmediate([this](node::Environment* node_env) {
-      finalization_scheduled = false;
-      Unref();
-      DrainFinalizerQueue();
-    });
-  }
+  if (!destructing) ScheduleFinalizerDrain();
+}
+
+void node_napi_env__::ScheduleFinalizerDrain() {
+  if (finalization_scheduled) return;
+  finalization_scheduled = true;
+  Ref();
+  node_env()->SetImmediate([this](node::Environment* node_env) {
+    finalization_scheduled = false;
+    DrainFinalizerQueue(kFinalizerTimeBudget);
+    // Leave the rest to a later iteration of the event loop rather than
+    // stalling it when a GC has collected a very large number of objects.
+    if (!pending_finalizers.empty() && !destructing) ScheduleFinalizerDrain();
+    Unref();
+  });
 }
 
-void node_napi_env__::DrainFinalizerQueue() {
+void node_napi_env__::DrainFinalizerQueue(uint64_t time_budget) {
+  const uint64_t deadline = time_budget == 0 ? 0 : uv_hrtime() + time_budget;
   // As userland code can delete additional references in one finalizer,
   // the list of pending finalizers may be mutated as we execute them, so
   // we keep iterating it until it is empty.
-  while (!pending_finalizers.empty()) {
-    v8impl::RefTracker* ref_tracker = *pending_finalizers.begin();
-    pending_finalizers.erase(ref_tracker);
+  size_t count = 0;
+  while (v8impl::RefTracker* ref_tracker = pending_finalizers.Pop()) {
     ref_tracker->Finalize();
+    if (deadline != 0 && ++count % kFinalizerBatchSize == 0 &&
+        uv_hrtime() >= deadline) {
+      break;
+    }
   }
+  TRACE_COUNTER2(TRACING_CATEGORY_NODE1(napi),
+                 "napi_finalizers",
+                 "pending",
+                 pending_finalizers.size(),
+                 "references",
+                 reference_slab.live());
 }
 
 void node_napi_env__::trigger_fatal_exception(v8::Local<v8::Value> local_err) {
@@ -212,6 +230,8 @@ class ThreadSafeFunction : public node::AsyncResource {
                       resource,
                       *v8::String::Utf8Value(env_->isolate, name)),
         thread_count(thread_count_),
+        queue_size(0),
+        pushing(0),
         is_closing(false),
         dispatch_state(kDispatchIdle),
         context(context_),
@@ -220,6 +240,8 @@ class ThreadSafeFunction : public node::AsyncResource {
         finalize_data(finalize_data_),
         finalize_cb(finalize_cb_),
         call_js_cb(call_js_cb_ == nullptr ? CallJs : call_js_cb_),
+        call_js_batch_cb(nullptr),
+        max_batch_size(1),
         handles_closing(false) {
     ref.Reset(env->isolate, func);
     node::AddEnvironmentCleanupHook(env->isolate, Cleanup, this);
@@ -234,28 +256,31 @@ class ThreadSafeFunction : public node::AsyncResource {
   // These methods can be called from any thread.
 
   napi_status Push(void* data, napi_threadsafe_function_call_mode mode) {
-    node::Mutex::ScopedLock lock(this->mutex);
-
-    while (queue.size() >= max_queue_size && max_queue_size > 0 &&
-           !is_closing) {
-      if (mode == napi_tsfn_nonblocking) {
-        return napi_queue_full;
-      }
-      cond->Wait(lock);
+    // The queue is only drained and deleted once no push is in progress, so
+    // that a push which has not seen is_closing yet cannot race with that.
+    pushing++;
+    auto leave = node::OnScopeLeave([this]() { EndPush(); });
+
+    if (max_queue_size == 0) {
+      queue_size++;
+    } else if (!ReserveSlot(mode)) {
+      return napi_queue_full;
     }
 
     if (is_closing) {
+      queue_size--;
+      node::Mutex::ScopedLock lock(this->mutex);
       if (thread_count == 0) {
         return napi_invalid_arg;
       } else {
         thread_count--;
         return napi_closing;
       }
-    } else {
-      queue.push(data);
-      Send();
-      return napi_ok;
     }
+
+    queue.Push(data);
+    Send();
+    return napi_ok;
   }
 
   napi_status Acquire() {
@@ -283,7 +308,7 @@ class ThreadSafeFunction : public node::AsyncResource {
       if (!is_closing) {
         is_closing = (mode == napi_tsfn_abort);
         if (is_closing && max_queue_size > 0) {
-          cond->Signal(lock);
+          cond->Broadcast(lock);
         }
         Send();
       }
@@ -293,8 +318,24 @@ class ThreadSafeFunction : public node::AsyncResource {
   }
 
   void EmptyQueueAndDelete() {
-    for (; !queue.empty(); queue.pop()) {
-      call_js_cb(nullptr, nullptr, context, queue.front());
+    // is_closing is set by now, so this only waits for pushes that started
+    // before it was. The last of them wakes us up.
+    {
+      node::Mutex::ScopedLock lock(this->mutex);
+      if (pushing.fetch_or(kPushWaiter) != 0) {
+        while (!pushes_done) cond->Wait(lock);
+      }
+    }
+
+    batch.clear();
+    void* data;
+    while (queue.Pop(&data)) batch.push_back(data);
+    if (call_js_batch_cb != nullptr) {
+      if (!batch.empty()) {
+        call_js_batch_cb(nullptr, nullptr, context, batch.data(), batch.size());
+      }
+    } else {
+      for (void* item : batch) call_js_cb(nullptr, nullptr, context, item);
     }
     delete this;
   }
@@ -302,34 +343,17 @@ class ThreadSafeFunction : public node::AsyncResource {
   // These methods must only be called from the loop thread.
 
   napi_status Init() {
-    ThreadSafeFunction* ts_fn = this;
     uv_loop_t* loop = env->node_env()->event_loop();
 
-    if (uv_async_init(loop, &async, AsyncCb) == 0) {
-      if (max_queue_size > 0) {
-        cond = std::make_unique<node::ConditionVariable>();
-      }
-      if (max_queue_size == 0 || cond) {
-        return napi_ok;
-      }
-
-      env->node_env()->CloseHandle(
-          reinterpret_cast<uv_handle_t*>(&async),
-          [](uv_handle_t* handle) -> void {
-            ThreadSafeFunction* ts_fn =
-                node::ContainerOf(&ThreadSafeFunction::async,
-                                  reinterpret_cast<uv_async_t*>(handle));
-            delete ts_fn;
-          });
-
-      // Prevent the thread-safe function from being deleted here, because
-      // the callback above will delete it.
-      ts_fn = nullptr;
+    if (uv_async_init(loop, &async, AsyncCb) != 0) {
+      delete this;
+      return napi_generic_failure;
     }
 
-    delete ts_fn;
-
-    return napi_generic_failure;
+    // The condition variable is also used to wait for pushes in progress
+    // when the function is deleted, so it is needed even without a limit.
+    cond = std::make_unique<node::ConditionVariable>();
+    return napi_ok;
   }
 
   napi_status Unref() {
@@ -344,6 +368,13 @@ class ThreadSafeFunction : public node::AsyncResource {
     return napi_ok;
   }
 
+  void SetBatch(size_t max_batch_size_,
+                node_api_threadsafe_function_call_js_batch cb) {
+    call_js_batch_cb = cb;
+    max_batch_size = cb == nullptr ? 1 : max_batch_size_;
+    batch.reserve(max_batch_size);
+  }
+
   inline void* Context() { return context; }
 
  protected:
@@ -368,42 +399,45 @@ class ThreadSafeFunction : public node::AsyncResource {
     }
   }
 
+  // Takes up to max_batch_size items off the queue and calls into JS for
+  // them. Only the mutex-protected closing logic needs the lock; the queue
+  // itself is lock-free.
   bool DispatchOne() {
-    void* data = nullptr;
-    bool popped_value = false;
-    bool has_more = false;
-
-    {
+    if (is_closing) {
       node::Mutex::ScopedLock lock(this->mutex);
-      if (is_closing) {
-        CloseHandlesAndMaybeDelete();
-      } else {
-        size_t size = queue.size();
-        if (size > 0) {
-          data = queue.front();
-          queue.pop();
-          popped_value = true;
-          if (size == max_queue_size && max_queue_size > 0) {
-            cond->Signal(lock);
-          }
-          size--;
-        }
+      CloseHandlesAndMaybeDelete();
+      return false;
+    }
+
+    batch.clear();
+    void* data;
+    while (batch.size() < max_batch_size && queue.Pop(&data)) {
+      batch.push_back(data);
+    }
+
+    size_t size = queue_size.load();
+    if (!batch.empty()) {
+      size = queue_size.fetch_sub(batch.size()) - batch.size();
+      if (max_queue_size > 0 && size + batch.size() >= max_queue_size) {
+        node::Mutex::ScopedLock lock(this->mutex);
+        cond->Broadcast(lock);
+      }
+    }
 
-        if (size == 0) {
-          if (thread_count == 0) {
-            is_closing = true;
-            if (max_queue_size > 0) {
-              cond->Signal(lock);
-            }
-            CloseHandlesAndMaybeDelete();
-          }
-        } else {
-          has_more = true;
+    if (size == 0) {
+      node::Mutex::ScopedLock lock(this->mutex);
+      // thread_count can only drop to zero after the last push of the last
+      // thread, so no item can arrive anymore.
+      if (thread_count == 0 && queue_size == 0) {
+        is_closing = true;
+        if (max_queue_size > 0) {
+          cond->Broadcast(lock);
         }
+        CloseHandlesAndMaybeDelete();
       }
     }
 
-    if (popped_value) {
+    if (!batch.empty()) {
       v8::HandleScope scope(env->isolate);
       CallbackScope cb_scope(this);
       napi_value js_callback = nullptr;
@@ -412,11 +446,22 @@ class ThreadSafeFunction : public node::AsyncResource {
             v8::Local<v8::Function>::New(env->isolate, ref);
         js_callback = v8impl::JsValueFromV8LocalValue(js_cb);
       }
-      env->CallbackIntoModule<false>(
-          [&](napi_env env) { call_js_cb(env, js_callback, context, data); });
+      if (call_js_batch_cb != nullptr) {
+        env->CallbackIntoModule<false>([&](napi_env env) {
+          call_js_batch_cb(
+              env, js_callback, context, batch.data(), batch.size());
+        });
+      } else {
+        env->CallbackIntoModule<false>([&](napi_env env) {
+          call_js_cb(env, js_callback, context, batch[0]);
+        });
+      }
     }
 
-    return has_more;
+    // Items that were counted but could not be popped yet are still being
+    // pushed, and their producer calls Send() once it is done. So there can
+    // only be more to do right away if the batch was filled.
+    return batch.size() == max_batch_size;
   }
 
   void Finalize() {
@@ -434,7 +479,7 @@ class ThreadSafeFunction : public node::AsyncResource {
       node::Mutex::ScopedLock lock(this->mutex);
       is_closing = true;
       if (max_queue_size > 0) {
-        cond->Signal(lock);
+        cond->Broadcast(lock);
       }
     }
     if (handles_closing) {
@@ -451,6 +496,16 @@ class ThreadSafeFunction : public node::AsyncResource {
         });
   }
 
+  // Ends a push. Once EmptyQueueAndDelete() waits for pushes in progress,
+  // the push that ends last wakes it up, and must not touch this object
+  // after that.
+  void EndPush() {
+    if (pushing.fetch_sub(1) != (kPushWaiter | 1)) return;
+    node::Mutex::ScopedLock lock(this->mutex);
+    pushes_done = true;
+    cond->Broadcast(lock);
+  }
+
   void Send() {
     // Ask currently running Dispatch() to make one more iteration
     unsigned char current_state = dispatch_state.fetch_or(kDispatchPending);
@@ -485,6 +540,27 @@ class ThreadSafeFunction : public node::AsyncResource {
     }
   }
 
+  // Counts a new item against max_queue_size, waiting for room in blocking
+  // mode. Returns false if the queue is full in non-blocking mode. A slot is
+  // also handed out once closing, so that the caller sees is_closing.
+  bool ReserveSlot(napi_threadsafe_function_call_mode mode) {
+    size_t size = queue_size.load(std::memory_order_relaxed);
+    for (;;) {
+      if (size < max_queue_size || is_closing) {
+        if (queue_size.compare_exchange_weak(size, size + 1)) return true;
+        continue;
+      }
+      if (mode == napi_tsfn_nonblocking) {
+        return false;
+      }
+      node::Mutex::ScopedLock lock(this->mutex);
+      while (queue_size >= max_queue_size && !is_closing) {
+        cond->Wait(lock);
+      }
+      size = queue_size.load(std::memory_order_relaxed);
+    }
+  }
+
   static void AsyncCb(uv_async_t* async) {
     ThreadSafeFunction* ts_fn =
         node::ContainerOf(&ThreadSafeFunction::async, async);
@@ -503,13 +579,23 @@ class ThreadSafeFunction : public node::AsyncResource {
 
   static const unsigned int kMaxIterationCount = 1000;
 
+  // Set in pushing once EmptyQueueAndDelete() waits for it to drop to zero.
+  static constexpr size_t kPushWaiter = ~(~size_t{0} >> 1);
+
   // These are variables protected by the mutex.
   node::Mutex mutex;
   std::unique_ptr<node::ConditionVariable> cond;
-  std::queue<void*> queue;
-  uv_async_t async;
   size_t thread_count;
-  bool is_closing;
+  bool pushes_done = false;
+
+  // These are variables accessed from any thread without the mutex.
+  // is_closing is only ever set with the mutex held, so that waiting on
+  // cond cannot miss it.
+  node::MPSCQueue<void*> queue;
+  std::atomic_size_t queue_size;
+  std::atomic_size_t pushing;
+  std::atomic_bool is_closing;
+  uv_async_t async;
   std::atomic_uchar dispatch_state;
 
   // These are variables set once, upon creation, and then never again, which
@@ -523,6 +609,9 @@ class ThreadSafeFunction : public node::AsyncResource {
   void* finalize_data;
   napi_finalize finalize_cb;
   napi_threadsafe_function_call_js call_js_cb;
+  node_api_threadsafe_function_call_js_batch call_js_batch_cb;
+  size_t max_batch_size;
+  std::vector<void*> batch;
   bool handles_closing;
 };
 
@@ -1402,6 +1491,21 @@ napi_ref_threadsafe_function(napi_env env, napi_threadsafe_function func) {
   return reinterpret_cast<v8impl::ThreadSafeFunction*>(func)->Ref();
 }
 
+napi_status NAPI_CDECL
+node_api_set_threadsafe_function_batch(
+    napi_env env,
+    napi_threadsafe_function func,
+    size_t max_batch_size,
+    node_api_threadsafe_function_call_js_batch call_js_batch_cb) {
+  CHECK_ENV(env);
+  CHECK_ARG(env, func);
+  RETURN_STATUS_IF_FALSE(env, max_batch_size > 0, napi_invalid_arg);
+
+  reinterpret_cast<v8impl::ThreadSafeFunction*>(func)->SetBatch(
+      max_batch_size, call_js_batch_cb);
+  return napi_clear_last_error(env);
+}
+
 napi_status NAPI_CDECL node_api_get_module_file_name(napi_env env,
                                                      const char** result) {
   CHECK_ENV(env);
@@ -253,6 +253,18 @@ napi_remove_async_cleanup_hook(napi_async_cleanup_hook_handle remove_handle);
 NAPI_EXTERN napi_status NAPI_CDECL
 node_api_get_module_file_name(napi_env env, const char** result);
 
+#ifndef __wasm32__
+// Makes the loop thread hand up to max_batch_size queued items at a time to
+// call_js_batch_cb, within a single handle scope and callback scope, instead
+// of calling call_js_cb once per item. Passing NULL for call_js_batch_cb
+// restores the per-item behavior.
+NAPI_EXTERN napi_status NAPI_CDECL node_api_set_threadsafe_function_batch(
+    napi_env env,
+    napi_threadsafe_function func,
+    size_t max_batch_size,
+    node_api_threadsafe_function_call_js_batch call_js_batch_cb);
+#endif  // __wasm32__
+
 #endif  // NAPI_EXPERIMENTAL
 
 EXTERN_C_END
@@ -19,7 +19,10 @@ struct node_napi_env__ : public napi_env__ {
   void CallFinalizer(napi_finalize cb, void* data, void* hint);
 
   void EnqueueFinalizer(v8impl::RefTracker* finalizer) override;
-  void DrainFinalizerQueue();
+  void ScheduleFinalizerDrain();
+  // Runs queued finalizers until the queue is empty or, if `time_budget` is
+  // not 0, until roughly that many nanoseconds have passed.
+  void DrainFinalizerQueue(uint64_t time_budget = 0);
 
   void trigger_fatal_exception(v8::Local<v8::Value> local_err);
   template <bool enforceUncaughtExceptionPolicy, typename T>
@@ -32,6 +35,11 @@ struct node_napi_env__ : public napi_env__ {
   }
   inline const char* GetFilename() const { return filename.c_str(); }
 
+  // Finalizers run from the event loop get this much time per iteration;
+  // the clock is checked after every batch of kFinalizerBatchSize of them.
+  static constexpr uint64_t kFinalizerTimeBudget = 1000000;  // 1 ms
+  static constexpr size_t kFinalizerBatchSize = 64;
+
   std::string filename;
   bool destructing = false;
   bool finalization_scheduled = false;
@@ -36,6 +36,15 @@ typedef void(NAPI_CDECL* napi_threadsafe_function_call_js)(
     napi_env env, napi_value js_callback, void* context, void* data);
 #endif  // NAPI_VERSION >= 4
 
+#ifdef NAPI_EXPERIMENTAL
+typedef void(NAPI_CDECL* node_api_threadsafe_function_call_js_batch)(
+    napi_env env,
+    napi_value js_callback,
+    void* context,
+    void** data,
+    size_t count);
+#endif  // NAPI_EXPERIMENTAL
+
 typedef struct {
   uint32_t major;
   uint32_t minor;
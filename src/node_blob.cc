@@ -8,6 +8,7 @@
 #include "node_errors.h"
 #include "node_external_reference.h"
 #include "node_file.h"
+#include "threadpoolwork-inl.h"
 #include "util.h"
 #include "v8.h"
 
@@ -28,6 +29,7 @@ using v8::HandleScope;
 using v8::Int32;
 using v8::Isolate;
 using v8::Local;
+using v8::Number;
 using v8::Object;
 using v8::ObjectTemplate;
 using v8::String;
@@ -106,6 +108,51 @@ void BlobFromFilePath(const FunctionCallbackInfo<Value>& args) {
     args.GetReturnValue().Set(array);
   }
 }
+
+// Writes the extents of a Blob to a file descriptor on the threadpool.
+class WriteToFdWork final : public AsyncResource, public ThreadPoolWork {
+ public:
+  WriteToFdWork(Environment* env,
+                Local<Function> callback,
+                BaseObjectPtr<Blob> blob,
+                std::vector<DataQueue::Extent> extents,
+                uv_file fd)
+      : AsyncResource(
+            env->isolate(), Object::New(env->isolate()), "BLOBWRITETOFD"),
+        ThreadPoolWork(env, "blob_write_to_fd"),
+        callback_(env->isolate(), callback),
+        blob_(std::move(blob)),
+        extents_(std::move(extents)),
+        fd_(fd) {}
+
+  void DoThreadPoolWork() override {
+    status_ = DataQueue::WriteExtents(extents_, fd_, &written_);
+  }
+
+  void AfterThreadPoolWork(int status) override {
+    std::unique_ptr<WriteToFdWork> self(this);
+    Environment* env = this->env();
+    Isolate* isolate = env->isolate();
+    HandleScope handle_scope(isolate);
+    Context::Scope context_scope(env->context());
+    if (status == UV_ECANCELED) return;
+    CHECK_EQ(status, 0);
+    Local<Value> argv[] = {
+        Int32::New(isolate, status_),
+        Number::New(isolate, static_cast<double>(written_)),
+    };
+    MakeCallback(callback_.Get(isolate), arraysize(argv), argv);
+  }
+
+ private:
+  Global<Function> callback_;
+  // Keeps the entries, and with them the BackingStores, alive.
+  BaseObjectPtr<Blob> blob_;
+  std::vector<DataQueue::Extent> extents_;
+  uv_file fd_;
+  int status_ = 0;
+  uint64_t written_ = 0;
+};
 }  // namespace
 
 void Blob::CreatePerIsolateProperties(IsolateData* isolate_data,
@@ -140,6 +187,7 @@ Local<FunctionTemplate> Blob::GetConstructorTemplate(Environment* env) {
         FIXED_ONE_BYTE_STRING(env->isolate(), "Blob"));
     SetProtoMethod(isolate, tmpl, "getReader", GetReader);
     SetProtoMethod(isolate, tmpl, "slice", ToSlice);
+    SetProtoMethod(isolate, tmpl, "writeToFd", WriteToFd);
     env->set_blob_constructor_template(tmpl);
   }
   return tmpl;
@@ -249,6 +297,34 @@ void Blob::ToSlice(const FunctionCallbackInfo<Value>& args) {
     args.GetReturnValue().Set(slice->object());
 }
 
+// writeToFd(fd, callback) writes the whole Blob to `fd` without pulling it
+// through a Reader: file-backed parts are copied by the kernel and in-memory
+// parts are written straight from their BackingStores, see
+// DataQueue::WriteExtents(). `callback(status, bytesWritten)` is called when
+// done. If `fd` is non-blocking and stays full, `status` is UV_EAGAIN and the
+// rest can be written from a slice once `fd` is writable again. Returns false,
+// without calling `callback`, if some of the data can only be obtained
+// through a Reader. The caller must not use `fd` until the callback has run.
+void Blob::WriteToFd(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Blob* blob;
+  ASSIGN_OR_RETURN_UNWRAP(&blob, args.Holder());
+  CHECK(args[0]->IsInt32());
+  CHECK(args[1]->IsFunction());
+
+  std::vector<DataQueue::Extent> extents;
+  if (!blob->data_queue_->GetExtents(&extents))
+    return args.GetReturnValue().Set(false);
+
+  auto* work = new WriteToFdWork(env,
+                                 args[1].As<Function>(),
+                                 BaseObjectPtr<Blob>(blob),
+                                 std::move(extents),
+                                 args[0].As<Int32>()->Value());
+  work->ScheduleWork();
+  args.GetReturnValue().Set(true);
+}
+
 void Blob::MemoryInfo(MemoryTracker* tracker) const {
   tracker->TrackField("data_queue_", data_queue_, "std::shared_ptr<DataQueue>");
 }
@@ -555,6 +631,7 @@ void Blob::RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(Blob::New);
   registry->Register(Blob::GetReader);
   registry->Register(Blob::ToSlice);
+  registry->Register(Blob::WriteToFd);
   registry->Register(Blob::StoreDataObject);
   registry->Register(Blob::GetDataObject);
   registry->Register(Blob::RevokeObjectURL);
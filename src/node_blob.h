@@ -36,6 +36,7 @@ class Blob : public BaseObject {
   static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void GetReader(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void ToSlice(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void WriteToFd(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void StoreDataObject(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void GetDataObject(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void RevokeObjectURL(const v8::FunctionCallbackInfo<v8::Value>& args);
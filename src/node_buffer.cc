@@ -27,10 +27,14 @@
 #include "node_i18n.h"
 #include "node_internals.h"
 
+#include "base64-inl.h"
 #include "env-inl.h"
+#include "json_parser.h"
 #include "simdutf.h"
 #include "string_bytes.h"
 #include "string_search.h"
+#include "string_search_simd.h"
+#include "threadpoolwork-inl.h"
 #include "util-inl.h"
 #include "v8-fast-api-calls.h"
 #include "v8.h"
@@ -52,11 +56,15 @@
 namespace node {
 namespace Buffer {
 
+using v8::Array;
 using v8::ArrayBuffer;
 using v8::ArrayBufferView;
 using v8::BackingStore;
 using v8::Context;
 using v8::EscapableHandleScope;
+using v8::FastApiCallbackOptions;
+using v8::FastApiTypedArray;
+using v8::Function;
 using v8::FunctionCallbackInfo;
 using v8::Global;
 using v8::HandleScope;
@@ -68,13 +76,16 @@ using v8::Local;
 using v8::Maybe;
 using v8::MaybeLocal;
 using v8::Nothing;
+using v8::Null;
 using v8::Number;
 using v8::Object;
 using v8::SharedArrayBuffer;
 using v8::String;
+using v8::TryCatch;
 using v8::Uint32;
 using v8::Uint32Array;
 using v8::Uint8Array;
+using v8::Undefined;
 using v8::Value;
 
 namespace {
@@ -568,6 +579,196 @@ void StringSlice(const FunctionCallbackInfo<Value>& args) {
   args.GetReturnValue().Set(ret);
 }
 
+// Flattens `input` into one byte per character. Returns false if the string
+// contains a character outside of Latin-1.
+bool WriteLatin1(Isolate* isolate,
+                 Local<String> input,
+                 MaybeStackBuffer<char>* out) {
+  out->AllocateSufficientStorage(input->Length());
+  if (input->IsOneByte()) {
+    input->WriteOneByte(isolate,
+                        reinterpret_cast<uint8_t*>(out->out()),
+                        0,
+                        out->length(),
+                        String::NO_NULL_TERMINATION);
+    return true;
+  }
+  String::Value value(isolate, input);
+  for (size_t i = 0; i < out->length(); i++) {
+    if ((*value)[i] > 0xff) return false;
+    (*out)[i] = static_cast<char>((*value)[i]);
+  }
+  return true;
+}
+
+// The encoding step of btoa(), see
+// https://html.spec.whatwg.org/multipage/webappapis.html#dom-btoa
+// Returns the base64 string, or -1 if the input contains a character outside
+// of Latin-1.
+void Btoa(const FunctionCallbackInfo<Value>& args) {
+  CHECK(args[0]->IsString());
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+
+  MaybeStackBuffer<char> input;
+  if (!WriteLatin1(isolate, args[0].As<String>(), &input))
+    return args.GetReturnValue().Set(-1);
+
+  Local<Value> error;
+  Local<Value> ret;
+  if (!StringBytes::Encode(
+           isolate, input.out(), input.length(), BASE64, &error)
+           .ToLocal(&ret)) {
+    CHECK(!error.IsEmpty());
+    isolate->ThrowException(error);
+    return;
+  }
+  args.GetReturnValue().Set(ret);
+}
+
+// The forgiving-base64 decoding step of atob(), see
+// https://infra.spec.whatwg.org/#forgiving-base64-decode
+// Unlike the decoder behind Buffer.from(), this one must reject the input
+// instead of skipping over bad characters. Returns the decoded Latin-1 string,
+// or -1 if the length of the input is invalid and -2 if it contains a
+// character outside of the base64 alphabet.
+void Atob(const FunctionCallbackInfo<Value>& args) {
+  CHECK(args[0]->IsString());
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+
+  MaybeStackBuffer<char> input;
+  if (!WriteLatin1(isolate, args[0].As<String>(), &input))
+    return args.GetReturnValue().Set(-2);
+
+  // Remove ASCII whitespace.
+  size_t length = 0;
+  for (size_t i = 0; i < input.length(); i++) {
+    const char c = input[i];
+    if (c == ' ' || c == '\t' || c == '\n' || c == '\f' || c == '\r')
+      continue;
+    input[length++] = c;
+  }
+
+  if (length % 4 == 0 && length > 0 && input[length - 1] == '=') {
+    length--;
+    if (input[length - 1] == '=') length--;
+  }
+  if (length % 4 == 1)
+    return args.GetReturnValue().Set(-1);
+  // The decoder below stops at trailing padding instead of rejecting it.
+  if (length > 0 && input[length - 1] == '=')
+    return args.GetReturnValue().Set(-2);
+
+  MaybeStackBuffer<char> output(base64_decoded_size_fast(length));
+  size_t written = 0;
+  base64_state state;
+  base64_stream_decode_init(&state, 0);
+  if (!base64_stream_decode(
+          &state, input.out(), length, output.out(), &written)) {
+    return args.GetReturnValue().Set(-2);
+  }
+
+  Local<Value> error;
+  Local<Value> ret;
+  if (!StringBytes::Encode(isolate, output.out(), written, LATIN1, &error)
+           .ToLocal(&ret)) {
+    CHECK(!error.IsEmpty());
+    isolate->ThrowException(error);
+    return;
+  }
+  args.GetReturnValue().Set(ret);
+}
+
+class ParseJSONWork final : public AsyncResource, public ThreadPoolWork {
+ public:
+  ParseJSONWork(Environment* env, Local<Function> callback, std::string source)
+      : AsyncResource(
+            env->isolate(), Object::New(env->isolate()), "PARSEJSON"),
+        ThreadPoolWork(env, "parse_json"),
+        callback_(env->isolate(), callback),
+        source_(std::move(source)) {}
+
+  void DoThreadPoolWork() override { parsed_ = document_.Parse(source_); }
+
+  void AfterThreadPoolWork(int status) override {
+    std::unique_ptr<ParseJSONWork> self(this);
+    Environment* env = this->env();
+    Isolate* isolate = env->isolate();
+    HandleScope handle_scope(isolate);
+    Context::Scope context_scope(env->context());
+    // The work is only cancelled when the environment is torn down.
+    if (status == UV_ECANCELED) return;
+    CHECK_EQ(status, 0);
+
+    Local<Value> argv[] = {Null(isolate), Undefined(isolate)};
+    {
+      TryCatch try_catch(isolate);
+      // On invalid input, json::Parse() throws the same SyntaxError as
+      // JSON.parse().
+      MaybeLocal<Value> value =
+          parsed_ ? document_.ToValue(env->context())
+                  : json::Parse(env->context(), source_);
+      if (!value.ToLocal(&argv[1])) {
+        if (!try_catch.CanContinue()) return;
+        CHECK(try_catch.HasCaught());
+        argv[0] = try_catch.Exception();
+        argv[1] = Undefined(isolate);
+      }
+    }
+    MakeCallback(callback_.Get(isolate), arraysize(argv), argv);
+  }
+
+ private:
+  Global<Function> callback_;
+  std::string source_;
+  json::Document document_;
+  bool parsed_ = false;
+};
+
+// parseJSON(view[, callback]) is JSON.parse(buffer.toString()) without the
+// intermediate string. With a callback, the input is copied and validated
+// on the threadpool, and `callback(err, value)` is called once the JS values
+// have been created on the main thread.
+void ParseJSON(const FunctionCallbackInfo<Value>& args) {
+  CHECK(args[0]->IsArrayBufferView());
+  Environment* env = Environment::GetCurrent(args);
+  ArrayBufferViewContents<char> buffer(args[0]);
+  std::string_view source(buffer.data(), buffer.length());
+
+  if (args[1]->IsFunction()) {
+    auto* work = new ParseJSONWork(
+        env, args[1].As<Function>(), std::string(source));
+    work->ScheduleWork();
+    return;
+  }
+
+  Local<Value> value;
+  if (json::Parse(env->context(), source).ToLocal(&value))
+    args.GetReturnValue().Set(value);
+}
+
+// Clamps the copied range to both buffers and performs the copy. The caller
+// must have checked that `target_start < target_length`,
+// `source_start < source_end` and `source_start <= source_length`.
+inline uint32_t CopyImpl(const char* source_data,
+                         size_t source_length,
+                         char* target_data,
+                         size_t target_length,
+                         size_t target_start,
+                         size_t source_start,
+                         size_t source_end) {
+  if (source_end - source_start > target_length - target_start)
+    source_end = source_start + target_length - target_start;
+
+  uint32_t to_copy = std::min(
+      std::min(source_end - source_start, target_length - target_start),
+      source_length - source_start);
+
+  memmove(target_data + target_start, source_data + source_start, to_copy);
+  return to_copy;
+}
+
 // bytesCopied = copy(buffer, target[, targetStart][, sourceStart][, sourceEnd])
 void Copy(const FunctionCallbackInfo<Value> &args) {
   Environment* env = Environment::GetCurrent(args);
@@ -595,17 +796,54 @@ void Copy(const FunctionCallbackInfo<Value> &args) {
     return THROW_ERR_OUT_OF_RANGE(
         env, "The value of \"sourceStart\" is out of range.");
 
-  if (source_end - source_start > target_length - target_start)
-    source_end = source_start + target_length - target_start;
+  args.GetReturnValue().Set(CopyImpl(source.data(),
+                                     source.length(),
+                                     target_data,
+                                     target_length,
+                                     target_start,
+                                     source_start,
+                                     source_end));
+}
 
-  uint32_t to_copy = std::min(
-      std::min(source_end - source_start, target_length - target_start),
-      source.length() - source_start);
+uint32_t FastCopy(Local<Value> receiver,
+                  const FastApiTypedArray<uint8_t>& source,
+                  const FastApiTypedArray<uint8_t>& target,
+                  int64_t target_start,
+                  int64_t source_start,
+                  int64_t source_end,
+                  FastApiCallbackOptions& options) {
+  // Negative indices are range errors, let the slow path throw them.
+  if (target_start < 0 || source_start < 0 || source_end < 0) {
+    options.fallback = true;
+    return 0;
+  }
 
-  memmove(target_data + target_start, source.data() + source_start, to_copy);
-  args.GetReturnValue().Set(to_copy);
+  if (static_cast<size_t>(target_start) >= target.length() ||
+      source_start >= source_end) {
+    return 0;
+  }
+
+  if (static_cast<size_t>(source_start) > source.length()) {
+    options.fallback = true;
+    return 0;
+  }
+
+  uint8_t* source_data;
+  CHECK(source.getStorageIfAligned(&source_data));
+  uint8_t* target_data;
+  CHECK(target.getStorageIfAligned(&target_data));
+
+  return CopyImpl(reinterpret_cast<const char*>(source_data),
+                  source.length(),
+                  reinterpret_cast<char*>(target_data),
+                  target.length(),
+                  static_cast<size_t>(target_start),
+                  static_cast<size_t>(source_start),
+                  static_cast<size_t>(source_end));
 }
 
+static v8::CFunction fast_copy(v8::CFunction::Make(FastCopy));
+
 
 void Fill(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
@@ -699,6 +937,30 @@ start_fill:
   }
 }
 
+// Only numeric fill values take the fast path, strings and buffers need the
+// encoding-aware slow path above. The encoding is still part of the signature
+// so that it matches the arity of fill(buffer, value, start, end, encoding).
+void FastFill(Local<Value> receiver,
+              const FastApiTypedArray<uint8_t>& buffer,
+              uint32_t value,
+              int64_t start,
+              int64_t end,
+              Local<Value> encoding,
+              FastApiCallbackOptions& options) {
+  // The slow path reports invalid ranges to JS by returning -2, which a void
+  // fast call can not express.
+  if (start < 0 || end < start || static_cast<size_t>(end) > buffer.length()) {
+    options.fallback = true;
+    return;
+  }
+
+  uint8_t* data;
+  CHECK(buffer.getStorageIfAligned(&data));
+  memset(data + start, value & 255, end - start);
+}
+
+static v8::CFunction fast_fill(v8::CFunction::Make(FastFill));
+
 
 template <encoding encoding>
 void StringWrite(const FunctionCallbackInfo<Value>& args) {
@@ -817,6 +1079,44 @@ void CompareOffset(const FunctionCallbackInfo<Value> &args) {
   args.GetReturnValue().Set(val);
 }
 
+int32_t FastCompareOffset(Local<Value> receiver,
+                          const FastApiTypedArray<uint8_t>& source,
+                          const FastApiTypedArray<uint8_t>& target,
+                          int64_t target_start,
+                          int64_t source_start,
+                          int64_t target_end,
+                          int64_t source_end,
+                          FastApiCallbackOptions& options) {
+  // Anything the slow path would throw on, or CHECK, goes back to it.
+  if (target_start < 0 || source_start < 0 ||
+      static_cast<size_t>(source_start) > source.length() ||
+      static_cast<size_t>(target_start) > target.length() ||
+      source_start > source_end || target_start > target_end) {
+    options.fallback = true;
+    return 0;
+  }
+
+  uint8_t* source_data;
+  CHECK(source.getStorageIfAligned(&source_data));
+  uint8_t* target_data;
+  CHECK(target.getStorageIfAligned(&target_data));
+
+  size_t to_cmp =
+      std::min(std::min(static_cast<size_t>(source_end - source_start),
+                        static_cast<size_t>(target_end - target_start)),
+               source.length() - static_cast<size_t>(source_start));
+
+  return normalizeCompareVal(to_cmp > 0 ?
+                               memcmp(source_data + source_start,
+                                      target_data + target_start,
+                                      to_cmp) : 0,
+                             source_end - source_start,
+                             target_end - target_start);
+}
+
+static v8::CFunction fast_compare_offset(
+    v8::CFunction::Make(FastCompareOffset));
+
 void Compare(const FunctionCallbackInfo<Value> &args) {
   Environment* env = Environment::GetCurrent(args);
 
@@ -833,6 +1133,23 @@ void Compare(const FunctionCallbackInfo<Value> &args) {
   args.GetReturnValue().Set(val);
 }
 
+int32_t FastCompare(Local<Value> receiver,
+                    const FastApiTypedArray<uint8_t>& a,
+                    const FastApiTypedArray<uint8_t>& b) {
+  uint8_t* data_a;
+  CHECK(a.getStorageIfAligned(&data_a));
+  uint8_t* data_b;
+  CHECK(b.getStorageIfAligned(&data_b));
+
+  size_t cmp_length = std::min(a.length(), b.length());
+
+  return normalizeCompareVal(cmp_length > 0 ?
+                             memcmp(data_a, data_b, cmp_length) : 0,
+                             a.length(), b.length());
+}
+
+static v8::CFunction fast_compare(v8::CFunction::Make(FastCompare));
+
 
 // Computes the offset for starting an indexOf or lastIndexOf search.
 // Returns either a valid offset in [0...<length - 1>], ie inside the Buffer,
@@ -988,26 +1305,15 @@ void IndexOfString(const FunctionCallbackInfo<Value>& args) {
       result == haystack_length ? -1 : static_cast<int>(result));
 }
 
-void IndexOfBuffer(const FunctionCallbackInfo<Value>& args) {
-  CHECK(args[1]->IsObject());
-  CHECK(args[2]->IsNumber());
-  CHECK(args[3]->IsInt32());
-  CHECK(args[4]->IsBoolean());
-
-  enum encoding enc = static_cast<enum encoding>(args[3].As<Int32>()->Value());
-
-  THROW_AND_RETURN_UNLESS_BUFFER(Environment::GetCurrent(args), args[0]);
-  THROW_AND_RETURN_UNLESS_BUFFER(Environment::GetCurrent(args), args[1]);
-  ArrayBufferViewContents<char> haystack_contents(args[0]);
-  ArrayBufferViewContents<char> needle_contents(args[1]);
-  int64_t offset_i64 = args[2].As<Integer>()->Value();
-  bool is_forward = args[4]->IsTrue();
-
-  const char* haystack = haystack_contents.data();
-  const size_t haystack_length = haystack_contents.length();
-  const char* needle = needle_contents.data();
-  const size_t needle_length = needle_contents.length();
-
+// Searches `needle` in `haystack` starting at `offset_i64`, which may be
+// negative as in Buffer#indexOf(). Returns the byte index of the match, or -1.
+int64_t IndexOfBufferImpl(const char* haystack,
+                          size_t haystack_length,
+                          const char* needle,
+                          size_t needle_length,
+                          int64_t offset_i64,
+                          enum encoding enc,
+                          bool is_forward) {
   int64_t opt_offset = IndexOfOffset(haystack_length,
                                      offset_i64,
                                      needle_length,
@@ -1015,29 +1321,28 @@ void IndexOfBuffer(const FunctionCallbackInfo<Value>& args) {
 
   if (needle_length == 0) {
     // Match String#indexOf() and String#lastIndexOf() behavior.
-    args.GetReturnValue().Set(static_cast<double>(opt_offset));
-    return;
+    return opt_offset;
   }
 
   if (haystack_length == 0) {
-    return args.GetReturnValue().Set(-1);
+    return -1;
   }
 
   if (opt_offset <= -1) {
-    return args.GetReturnValue().Set(-1);
+    return -1;
   }
   size_t offset = static_cast<size_t>(opt_offset);
   CHECK_LT(offset, haystack_length);
   if ((is_forward && needle_length + offset > haystack_length) ||
       needle_length > haystack_length) {
-    return args.GetReturnValue().Set(-1);
+    return -1;
   }
 
   size_t result = haystack_length;
 
   if (enc == UCS2) {
     if (haystack_length < 2 || needle_length < 2) {
-      return args.GetReturnValue().Set(-1);
+      return -1;
     }
     result = SearchString(
         reinterpret_cast<const uint16_t*>(haystack),
@@ -1057,8 +1362,79 @@ void IndexOfBuffer(const FunctionCallbackInfo<Value>& args) {
         is_forward);
   }
 
-  args.GetReturnValue().Set(
-      result == haystack_length ? -1 : static_cast<int>(result));
+  return result == haystack_length ? -1 : static_cast<int64_t>(result);
+}
+
+void IndexOfBuffer(const FunctionCallbackInfo<Value>& args) {
+  CHECK(args[1]->IsObject());
+  CHECK(args[2]->IsNumber());
+  CHECK(args[3]->IsInt32());
+  CHECK(args[4]->IsBoolean());
+
+  enum encoding enc = static_cast<enum encoding>(args[3].As<Int32>()->Value());
+
+  THROW_AND_RETURN_UNLESS_BUFFER(Environment::GetCurrent(args), args[0]);
+  THROW_AND_RETURN_UNLESS_BUFFER(Environment::GetCurrent(args), args[1]);
+  ArrayBufferViewContents<char> haystack_contents(args[0]);
+  ArrayBufferViewContents<char> needle_contents(args[1]);
+  int64_t offset_i64 = args[2].As<Integer>()->Value();
+  bool is_forward = args[4]->IsTrue();
+
+  int64_t result = IndexOfBufferImpl(haystack_contents.data(),
+                                     haystack_contents.length(),
+                                     needle_contents.data(),
+                                     needle_contents.length(),
+                                     offset_i64,
+                                     enc,
+                                     is_forward);
+  args.GetReturnValue().Set(static_cast<double>(result));
+}
+
+double FastIndexOfBuffer(Local<Value> receiver,
+                         const FastApiTypedArray<uint8_t>& haystack,
+                         const FastApiTypedArray<uint8_t>& needle,
+                         int64_t offset_i64,
+                         int32_t enc,
+                         bool is_forward) {
+  uint8_t* haystack_data;
+  CHECK(haystack.getStorageIfAligned(&haystack_data));
+  uint8_t* needle_data;
+  CHECK(needle.getStorageIfAligned(&needle_data));
+
+  return static_cast<double>(
+      IndexOfBufferImpl(reinterpret_cast<const char*>(haystack_data),
+                        haystack.length(),
+                        reinterpret_cast<const char*>(needle_data),
+                        needle.length(),
+                        offset_i64,
+                        static_cast<enum encoding>(enc),
+                        is_forward));
+}
+
+static v8::CFunction fast_index_of_buffer(
+    v8::CFunction::Make(FastIndexOfBuffer));
+
+// Returns the index of the byte `needle` in `buffer`, or -1.
+int64_t IndexOfNumberImpl(const char* buffer,
+                          size_t length,
+                          uint32_t needle,
+                          int64_t offset_i64,
+                          bool is_forward) {
+  int64_t opt_offset = IndexOfOffset(length, offset_i64, 1, is_forward);
+  if (opt_offset <= -1 || length == 0) {
+    return -1;
+  }
+  size_t offset = static_cast<size_t>(opt_offset);
+  CHECK_LT(offset, length);
+
+  const void* ptr;
+  if (is_forward) {
+    ptr = memchr(buffer + offset, needle, length - offset);
+  } else {
+    ptr = node::stringsearch::MemrchrFill(buffer, needle, offset + 1);
+  }
+  const char* ptr_char = static_cast<const char*>(ptr);
+  return ptr ? static_cast<int64_t>(ptr_char - buffer) : -1;
 }
 
 void IndexOfNumber(const FunctionCallbackInfo<Value>& args) {
@@ -1073,23 +1449,84 @@ void IndexOfNumber(const FunctionCallbackInfo<Value>& args) {
   int64_t offset_i64 = args[2].As<Integer>()->Value();
   bool is_forward = args[3]->IsTrue();
 
-  int64_t opt_offset =
-      IndexOfOffset(buffer.length(), offset_i64, 1, is_forward);
-  if (opt_offset <= -1 || buffer.length() == 0) {
+  int64_t result = IndexOfNumberImpl(
+      buffer.data(), buffer.length(), needle, offset_i64, is_forward);
+  args.GetReturnValue().Set(static_cast<double>(result));
+}
+
+double FastIndexOfNumber(Local<Value> receiver,
+                         const FastApiTypedArray<uint8_t>& buffer,
+                         uint32_t needle,
+                         int64_t offset_i64,
+                         bool is_forward) {
+  uint8_t* data;
+  CHECK(buffer.getStorageIfAligned(&data));
+
+  return static_cast<double>(
+      IndexOfNumberImpl(reinterpret_cast<const char*>(data),
+                        buffer.length(),
+                        needle,
+                        offset_i64,
+                        is_forward));
+}
+
+static v8::CFunction fast_index_of_number(
+    v8::CFunction::Make(FastIndexOfNumber));
+
+
+// [index, needleIndex] = indexOfAny(buffer, needles, byteOffset)
+// Finds the first of several delimiters in a single pass over the buffer.
+// Returns -1 when none of the needles occurs at or after byteOffset.
+void IndexOfAny(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  CHECK(args[1]->IsArray());
+  CHECK(args[2]->IsNumber());
+
+  THROW_AND_RETURN_UNLESS_BUFFER(env, args[0]);
+  ArrayBufferViewContents<uint8_t> haystack(args[0]);
+
+  Local<Array> needles = args[1].As<Array>();
+  const size_t needle_count = needles->Length();
+  CHECK_LE(needle_count, stringsearch::kSimdSearchMaxNeedles);
+
+  // Small needles are copied into the stack storage of their contents, which
+  // therefore has to outlive the search.
+  ArrayBufferViewContents<uint8_t>
+      contents[stringsearch::kSimdSearchMaxNeedles];
+  const uint8_t* patterns[stringsearch::kSimdSearchMaxNeedles];
+  size_t pattern_lengths[stringsearch::kSimdSearchMaxNeedles];
+  for (size_t i = 0; i < needle_count; i++) {
+    Local<Value> needle;
+    if (!needles->Get(env->context(), i).ToLocal(&needle)) return;
+    THROW_AND_RETURN_UNLESS_BUFFER(env, needle);
+    contents[i].ReadValue(needle);
+    patterns[i] = contents[i].data();
+    pattern_lengths[i] = contents[i].length();
+  }
+
+  int64_t offset_i64 = args[2].As<Integer>()->Value();
+  int64_t opt_offset = IndexOfOffset(haystack.length(), offset_i64, 1, true);
+  if (opt_offset <= -1 || haystack.length() == 0) {
     return args.GetReturnValue().Set(-1);
   }
-  size_t offset = static_cast<size_t>(opt_offset);
-  CHECK_LT(offset, buffer.length());
 
-  const void* ptr;
-  if (is_forward) {
-    ptr = memchr(buffer.data() + offset, needle, buffer.length() - offset);
-  } else {
-    ptr = node::stringsearch::MemrchrFill(buffer.data(), needle, offset + 1);
+  size_t needle_index = 0;
+  size_t result = stringsearch::SimdSearchAny(haystack.data(),
+                                              haystack.length(),
+                                              patterns,
+                                              pattern_lengths,
+                                              needle_count,
+                                              static_cast<size_t>(opt_offset),
+                                              &needle_index);
+  if (result == haystack.length()) {
+    return args.GetReturnValue().Set(-1);
   }
-  const char* ptr_char = static_cast<const char*>(ptr);
-  args.GetReturnValue().Set(ptr ? static_cast<int>(ptr_char - buffer.data())
-                                : -1);
+
+  Local<Value> ret[] = {
+      Number::New(env->isolate(), static_cast<double>(result)),
+      Integer::NewFromUnsigned(env->isolate(),
+                               static_cast<uint32_t>(needle_index))};
+  args.GetReturnValue().Set(Array::New(env->isolate(), ret, arraysize(ret)));
 }
 
 
@@ -1134,6 +1571,23 @@ static void IsUtf8(const FunctionCallbackInfo<Value>& args) {
   args.GetReturnValue().Set(simdutf::validate_utf8(abv.data(), abv.length()));
 }
 
+static bool FastIsUtf8(Local<Value> receiver,
+                       const FastApiTypedArray<uint8_t>& buffer,
+                       FastApiCallbackOptions& options) {
+  // A detached buffer has a length of zero, let the slow path throw for it.
+  if (buffer.length() == 0) {
+    options.fallback = true;
+    return false;
+  }
+
+  uint8_t* data;
+  CHECK(buffer.getStorageIfAligned(&data));
+  return simdutf::validate_utf8(reinterpret_cast<const char*>(data),
+                         buffer.length());
+}
+
+static v8::CFunction fast_is_utf8(v8::CFunction::Make(FastIsUtf8));
+
 static void IsAscii(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
   CHECK_EQ(args.Length(), 1);
@@ -1149,6 +1603,23 @@ static void IsAscii(const FunctionCallbackInfo<Value>& args) {
   args.GetReturnValue().Set(simdutf::validate_ascii(abv.data(), abv.length()));
 }
 
+static bool FastIsAscii(Local<Value> receiver,
+                       const FastApiTypedArray<uint8_t>& buffer,
+                       FastApiCallbackOptions& options) {
+  // A detached buffer has a length of zero, let the slow path throw for it.
+  if (buffer.length() == 0) {
+    options.fallback = true;
+    return false;
+  }
+
+  uint8_t* data;
+  CHECK(buffer.getStorageIfAligned(&data));
+  return simdutf::validate_ascii(reinterpret_cast<const char*>(data),
+                         buffer.length());
+}
+
+static v8::CFunction fast_is_ascii(v8::CFunction::Make(FastIsAscii));
+
 void SetBufferPrototype(const FunctionCallbackInfo<Value>& args) {
   Realm* realm = Realm::GetCurrent(args);
 
@@ -1271,13 +1742,27 @@ void Initialize(Local<Object> target,
                             "byteLengthUtf8",
                             SlowByteLengthUtf8,
                             &fast_byte_length_utf8);
-  SetMethod(context, target, "copy", Copy);
-  SetMethodNoSideEffect(context, target, "compare", Compare);
-  SetMethodNoSideEffect(context, target, "compareOffset", CompareOffset);
-  SetMethod(context, target, "fill", Fill);
-  SetMethodNoSideEffect(context, target, "indexOfBuffer", IndexOfBuffer);
-  SetMethodNoSideEffect(context, target, "indexOfNumber", IndexOfNumber);
+  SetFastMethod(context, target, "copy", Copy, &fast_copy);
+  SetFastMethodNoSideEffect(
+      context, target, "compare", Compare, &fast_compare);
+  SetFastMethodNoSideEffect(context,
+                            target,
+                            "compareOffset",
+                            CompareOffset,
+                            &fast_compare_offset);
+  SetFastMethod(context, target, "fill", Fill, &fast_fill);
+  SetFastMethodNoSideEffect(context,
+                            target,
+                            "indexOfBuffer",
+                            IndexOfBuffer,
+                            &fast_index_of_buffer);
+  SetFastMethodNoSideEffect(context,
+                            target,
+                            "indexOfNumber",
+                            IndexOfNumber,
+                            &fast_index_of_number);
   SetMethodNoSideEffect(context, target, "indexOfString", IndexOfString);
+  SetMethodNoSideEffect(context, target, "indexOfAny", IndexOfAny);
 
   SetMethod(context, target, "detachArrayBuffer", DetachArrayBuffer);
   SetMethod(context, target, "copyArrayBuffer", CopyArrayBuffer);
@@ -1286,8 +1771,9 @@ void Initialize(Local<Object> target,
   SetMethod(context, target, "swap32", Swap32);
   SetMethod(context, target, "swap64", Swap64);
 
-  SetMethodNoSideEffect(context, target, "isUtf8", IsUtf8);
-  SetMethodNoSideEffect(context, target, "isAscii", IsAscii);
+  SetFastMethodNoSideEffect(context, target, "isUtf8", IsUtf8, &fast_is_utf8);
+  SetFastMethodNoSideEffect(
+      context, target, "isAscii", IsAscii, &fast_is_ascii);
 
   target
       ->Set(context,
@@ -1318,6 +1804,10 @@ void Initialize(Local<Object> target,
   SetMethod(context, target, "ucs2Write", StringWrite<UCS2>);
   SetMethod(context, target, "utf8Write", StringWrite<UTF8>);
 
+  SetMethodNoSideEffect(context, target, "atob", Atob);
+  SetMethodNoSideEffect(context, target, "btoa", Btoa);
+  SetMethod(context, target, "parseJSON", ParseJSON);
+
   SetMethod(context, target, "getZeroFillToggle", GetZeroFillToggle);
 }
 
@@ -1331,19 +1821,36 @@ void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(fast_byte_length_utf8.GetTypeInfo());
   registry->Register(FastByteLengthUtf8);
   registry->Register(Copy);
+  registry->Register(fast_copy.GetTypeInfo());
+  registry->Register(FastCopy);
   registry->Register(Compare);
+  registry->Register(fast_compare.GetTypeInfo());
+  registry->Register(FastCompare);
   registry->Register(CompareOffset);
+  registry->Register(fast_compare_offset.GetTypeInfo());
+  registry->Register(FastCompareOffset);
   registry->Register(Fill);
+  registry->Register(fast_fill.GetTypeInfo());
+  registry->Register(FastFill);
   registry->Register(IndexOfBuffer);
+  registry->Register(fast_index_of_buffer.GetTypeInfo());
+  registry->Register(FastIndexOfBuffer);
   registry->Register(IndexOfNumber);
+  registry->Register(fast_index_of_number.GetTypeInfo());
+  registry->Register(FastIndexOfNumber);
   registry->Register(IndexOfString);
+  registry->Register(IndexOfAny);
 
   registry->Register(Swap16);
   registry->Register(Swap32);
   registry->Register(Swap64);
 
   registry->Register(IsUtf8);
+  registry->Register(fast_is_utf8.GetTypeInfo());
+  registry->Register(FastIsUtf8);
   registry->Register(IsAscii);
+  registry->Register(fast_is_ascii.GetTypeInfo());
+  registry->Register(FastIsAscii);
 
   registry->Register(StringSlice<ASCII>);
   registry->Register(StringSlice<BASE64>);
@@ -1360,6 +1867,9 @@ void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(StringWrite<HEX>);
   registry->Register(StringWrite<UCS2>);
   registry->Register(StringWrite<UTF8>);
+  registry->Register(Atob);
+  registry->Register(Btoa);
+  registry->Register(ParseJSON);
   registry->Register(GetZeroFillToggle);
 
   registry->Register(DetachArrayBuffer);
@@ -28,6 +28,7 @@
 // have been split across multiple headers in src/crypto. This header
 // remains for convenience for any code that still imports it. New
 // code should include the relevant src/crypto headers directly.
+#include "crypto/crypto_aead.h"
 #include "crypto/crypto_aes.h"
 #include "crypto/crypto_bio.h"
 #include "crypto/crypto_cipher.h"
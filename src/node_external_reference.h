@@ -22,6 +22,81 @@ using CFunctionCallbackWithBool = void (*)(v8::Local<v8::Object> receiver,
 using CFunctionCallbackWithStrings =
     bool (*)(v8::Local<v8::Value>, const v8::FastOneByteString& input);
 
+// Fast API signatures of the Buffer bindings in node_buffer.cc.
+using CFunctionBufferCompare =
+    int32_t (*)(v8::Local<v8::Value>,
+                const v8::FastApiTypedArray<uint8_t>&,
+                const v8::FastApiTypedArray<uint8_t>&);
+using CFunctionBufferCompareOffset =
+    int32_t (*)(v8::Local<v8::Value>,
+                const v8::FastApiTypedArray<uint8_t>&,
+                const v8::FastApiTypedArray<uint8_t>&,
+                int64_t,
+                int64_t,
+                int64_t,
+                int64_t,
+                v8::FastApiCallbackOptions&);
+using CFunctionBufferCopy =
+    uint32_t (*)(v8::Local<v8::Value>,
+                 const v8::FastApiTypedArray<uint8_t>&,
+                 const v8::FastApiTypedArray<uint8_t>&,
+                 int64_t,
+                 int64_t,
+                 int64_t,
+                 v8::FastApiCallbackOptions&);
+using CFunctionBufferFill = void (*)(v8::Local<v8::Value>,
+                                     const v8::FastApiTypedArray<uint8_t>&,
+                                     uint32_t,
+                                     int64_t,
+                                     int64_t,
+                                     v8::Local<v8::Value>,
+                                     v8::FastApiCallbackOptions&);
+using CFunctionBufferIndexOfBuffer =
+    double (*)(v8::Local<v8::Value>,
+               const v8::FastApiTypedArray<uint8_t>&,
+               const v8::FastApiTypedArray<uint8_t>&,
+               int64_t,
+               int32_t,
+               bool);
+using CFunctionBufferIndexOfNumber =
+    double (*)(v8::Local<v8::Value>,
+               const v8::FastApiTypedArray<uint8_t>&,
+               uint32_t,
+               int64_t,
+               bool);
+using CFunctionBufferValidate = bool (*)(v8::Local<v8::Value>,
+                                         const v8::FastApiTypedArray<uint8_t>&,
+                                         v8::FastApiCallbackOptions&);
+
+// Fast API signatures of the timer wheel bindings in timers.cc.
+using CFunctionTimerWheelInsert = uint32_t (*)(v8::Local<v8::Object>, double);
+using CFunctionTimerWheelCancel = bool (*)(v8::Local<v8::Object>, uint32_t);
+using CFunctionTimerWheelReschedule = bool (*)(v8::Local<v8::Object>,
+                                               uint32_t,
+                                               double);
+using CFunctionTimerWheelAdvance =
+    uint32_t (*)(v8::Local<v8::Object>,
+                 double,
+                 const v8::FastApiTypedArray<uint32_t>&);
+
+// Fast API signatures of RingChannel in node_ring_channel.cc.
+using CFunctionRingChannelWrite =
+    bool (*)(v8::Local<v8::Object>,
+             const v8::FastApiTypedArray<uint8_t>&,
+             v8::FastApiCallbackOptions&);
+using CFunctionRingChannelRead =
+    uint32_t (*)(v8::Local<v8::Object>,
+                 const v8::FastApiTypedArray<uint8_t>&,
+                 const v8::FastApiTypedArray<uint32_t>&,
+                 v8::FastApiCallbackOptions&);
+
+// Fast API signature of RandomPool in crypto/crypto_random.cc.
+using CFunctionRandomPoolFill = bool (*)(v8::Local<v8::Value>,
+                                         const v8::FastApiTypedArray<uint8_t>&,
+                                         uint32_t,
+                                         uint32_t,
+                                         v8::FastApiCallbackOptions&);
+
 // This class manages the external references from the V8 heap
 // to the C++ addresses in Node.js.
 class ExternalReferenceRegistry {
@@ -35,6 +110,20 @@ class ExternalReferenceRegistry {
   V(CFunctionCallbackWithInt64)                                                \
   V(CFunctionCallbackWithBool)                                                 \
   V(CFunctionCallbackWithStrings)                                              \
+  V(CFunctionBufferCompare)                                                    \
+  V(CFunctionBufferCompareOffset)                                              \
+  V(CFunctionBufferCopy)                                                       \
+  V(CFunctionBufferFill)                                                       \
+  V(CFunctionBufferIndexOfBuffer)                                              \
+  V(CFunctionBufferIndexOfNumber)                                              \
+  V(CFunctionBufferValidate)                                                   \
+  V(CFunctionTimerWheelInsert)                                                 \
+  V(CFunctionTimerWheelCancel)                                                 \
+  V(CFunctionTimerWheelReschedule)                                             \
+  V(CFunctionTimerWheelAdvance)                                                \
+  V(CFunctionRingChannelWrite)                                                 \
+  V(CFunctionRingChannelRead)                                                  \
+  V(CFunctionRandomPoolFill)                                                   \
   V(const v8::CFunctionInfo*)                                                  \
   V(v8::FunctionCallback)                                                      \
   V(v8::AccessorGetterCallback)                                                \
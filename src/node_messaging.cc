@@ -8,31 +8,46 @@
 #include "node_errors.h"
 #include "node_external_reference.h"
 #include "node_process-inl.h"
+#include "node_ring_channel.h"
 #include "util-inl.h"
 
 using node::contextify::ContextifyContext;
 using node::errors::TryCatchScope;
 using v8::Array;
 using v8::ArrayBuffer;
+using v8::ArrayBufferView;
 using v8::BackingStore;
+using v8::BigInt64Array;
+using v8::BigUint64Array;
 using v8::CompiledWasmModule;
 using v8::Context;
+using v8::DataView;
 using v8::EscapableHandleScope;
+using v8::Float32Array;
+using v8::Float64Array;
 using v8::Function;
 using v8::FunctionCallbackInfo;
 using v8::FunctionTemplate;
 using v8::Global;
 using v8::HandleScope;
+using v8::Int16Array;
+using v8::Int32Array;
+using v8::Int8Array;
 using v8::Isolate;
 using v8::Just;
 using v8::Local;
 using v8::Maybe;
 using v8::MaybeLocal;
+using v8::NewStringType;
 using v8::Nothing;
 using v8::Object;
 using v8::SharedArrayBuffer;
 using v8::String;
 using v8::Symbol;
+using v8::Uint16Array;
+using v8::Uint32Array;
+using v8::Uint8Array;
+using v8::Uint8ClampedArray;
 using v8::Value;
 using v8::ValueDeserializer;
 using v8::ValueSerializer;
@@ -74,13 +89,196 @@ Maybe<bool> TransferData::FinalizeTransferWrite(
   return Just(true);
 }
 
+// The ArrayBufferViews that Message::SerializeRaw() copies as they are, and
+// the size of their elements.
+#define RAW_ARRAY_BUFFER_VIEW_TYPES(V)                                         \
+  V(Int8Array, 1)                                                              \
+  V(Uint8Array, 1)                                                             \
+  V(Uint8ClampedArray, 1)                                                      \
+  V(Int16Array, 2)                                                             \
+  V(Uint16Array, 2)                                                            \
+  V(Int32Array, 4)                                                             \
+  V(Uint32Array, 4)                                                            \
+  V(Float32Array, 4)                                                           \
+  V(Float64Array, 8)                                                           \
+  V(BigInt64Array, 8)                                                          \
+  V(BigUint64Array, 8)                                                         \
+  V(DataView, 1)
+
+MessageBufferPool::~MessageBufferPool() {
+  for (size_t i = 0; i < kSizeClassCount; i++) {
+    for (size_t j = 0; j < free_buffer_count_[i]; j++)
+      free(free_buffers_[i][j]);
+  }
+}
+
+char* MessageBufferPool::Allocate(size_t size, size_t* capacity) {
+  size_t size_class = 0;
+  size_t class_size = size_t{1} << kMinSizeClassShift;
+  while (class_size < size && size_class < kSizeClassCount) {
+    class_size <<= 1;
+    size_class++;
+  }
+  if (size_class == kSizeClassCount) {
+    *capacity = size;
+    return UncheckedMalloc(size);
+  }
+
+  *capacity = class_size;
+  {
+    Mutex::ScopedLock lock(mutex_);
+    if (free_buffer_count_[size_class] > 0)
+      return free_buffers_[size_class][--free_buffer_count_[size_class]];
+  }
+  return UncheckedMalloc(class_size);
+}
+
+void MessageBufferPool::Release(char* data, size_t capacity) {
+  size_t size_class = 0;
+  size_t class_size = size_t{1} << kMinSizeClassShift;
+  while (class_size < capacity && size_class < kSizeClassCount) {
+    class_size <<= 1;
+    size_class++;
+  }
+  if (size_class < kSizeClassCount && class_size == capacity) {
+    Mutex::ScopedLock lock(mutex_);
+    if (free_buffer_count_[size_class] < kBuffersPerSizeClass) {
+      free_buffers_[size_class][free_buffer_count_[size_class]++] = data;
+      return;
+    }
+  }
+  free(data);
+}
+
 Message::Message(MallocedBuffer<char>&& buffer)
     : main_message_buf_(std::move(buffer)) {}
 
+Message::~Message() {
+  if (buffer_pool_ && main_message_buf_.data != nullptr)
+    buffer_pool_->Release(main_message_buf_.release(), buffer_capacity_);
+}
+
 bool Message::IsCloseMessage() const {
   return main_message_buf_.data == nullptr;
 }
 
+bool Message::AllocateMainMessageBuffer(size_t size) {
+  char* data;
+  if (buffer_pool_) {
+    data = buffer_pool_->Allocate(size, &buffer_capacity_);
+  } else {
+    // Even an empty string must not look like a close message.
+    data = UncheckedMalloc(std::max<size_t>(size, 1));
+  }
+  if (data == nullptr) return false;
+  main_message_buf_ = MallocedBuffer<char>(data, size);
+  return true;
+}
+
+bool Message::GetViewPayloadType(Local<Value> value, PayloadType* type) {
+#define V(Type, element_size)                                                  \
+  if (value->Is##Type()) {                                                     \
+    *type = PayloadType::k##Type;                                              \
+    return true;                                                               \
+  }
+  RAW_ARRAY_BUFFER_VIEW_TYPES(V)
+#undef V
+  return false;
+}
+
+// Copies strings and ArrayBufferViews into the message as they are. Returns
+// false for anything else, which includes views on only a part of their
+// ArrayBuffer: the ValueSerializer clones the whole ArrayBuffer with them.
+bool Message::SerializeRaw(Isolate* isolate, Local<Value> input) {
+  if (input->IsString()) {
+    Local<String> string = input.As<String>();
+    const size_t length = string->Length();
+    if (string->IsOneByte()) {
+      if (!AllocateMainMessageBuffer(length)) return false;
+      string->WriteOneByte(isolate,
+                           reinterpret_cast<uint8_t*>(main_message_buf_.data),
+                           0,
+                           length,
+                           String::NO_NULL_TERMINATION);
+      payload_type_ = PayloadType::kOneByteString;
+    } else {
+      if (!AllocateMainMessageBuffer(length * sizeof(uint16_t))) return false;
+      string->Write(isolate,
+                    reinterpret_cast<uint16_t*>(main_message_buf_.data),
+                    0,
+                    length,
+                    String::NO_NULL_TERMINATION);
+      payload_type_ = PayloadType::kTwoByteString;
+    }
+    return true;
+  }
+
+  PayloadType type;
+  if (!input->IsArrayBufferView() || !GetViewPayloadType(input, &type))
+    return false;
+  Local<ArrayBufferView> view = input.As<ArrayBufferView>();
+  // Small typed arrays that were never asked for their buffer do not have one
+  // yet, and are always the only view on it.
+  if (view->HasBuffer()) {
+    Local<ArrayBuffer> buffer = view->Buffer();
+    if (buffer->WasDetached() ||
+        view->ByteOffset() != 0 ||
+        view->ByteLength() != buffer->ByteLength()) {
+      return false;
+    }
+    std::shared_ptr<BackingStore> store = buffer->GetBackingStore();
+    if (store->IsShared() || store->IsResizableByUserJavaScript())
+      return false;
+  }
+  const size_t length = view->ByteLength();
+  if (!AllocateMainMessageBuffer(length)) return false;
+  view->CopyContents(main_message_buf_.data, length);
+  payload_type_ = type;
+  return true;
+}
+
+MaybeLocal<Value> Message::DeserializeRaw(Environment* env) {
+  Isolate* isolate = env->isolate();
+  const char* data = main_message_buf_.data;
+  const size_t size = main_message_buf_.size;
+  MaybeLocal<String> string;
+  switch (payload_type_) {
+    case PayloadType::kOneByteString:
+      string = String::NewFromOneByte(isolate,
+                                      reinterpret_cast<const uint8_t*>(data),
+                                      NewStringType::kNormal,
+                                      size);
+      return string.FromMaybe(Local<String>());
+    case PayloadType::kTwoByteString:
+      string = String::NewFromTwoByte(isolate,
+                                      reinterpret_cast<const uint16_t*>(data),
+                                      NewStringType::kNormal,
+                                      size / sizeof(uint16_t));
+      return string.FromMaybe(Local<String>());
+    default:
+      break;
+  }
+
+  Local<ArrayBuffer> buffer;
+  {
+    NoArrayBufferZeroFillScope no_zero_fill_scope(env->isolate_data());
+    std::unique_ptr<BackingStore> store =
+        ArrayBuffer::NewBackingStore(isolate, size);
+    CHECK(store);
+    if (size > 0) memcpy(store->Data(), data, size);
+    buffer = ArrayBuffer::New(isolate, std::move(store));
+  }
+  switch (payload_type_) {
+#define V(Type, element_size)                                                  \
+    case PayloadType::k##Type:                                                 \
+      return Type::New(buffer, 0, size / (element_size));
+    RAW_ARRAY_BUFFER_VIEW_TYPES(V)
+#undef V
+    default:
+      UNREACHABLE();
+  }
+}
+
 namespace {
 
 // This is used to tell V8 how to read transferred host objects, like other
@@ -144,6 +342,9 @@ MaybeLocal<Value> Message::Deserialize(Environment* env,
   Context::Scope context_scope(context);
 
   CHECK(!IsCloseMessage());
+  if (payload_type_ != PayloadType::kValueSerializer)
+    return DeserializeRaw(env);
+
   if (port_list != nullptr && !transferables_.empty()) {
     // Need to create this outside of the EscapableHandleScope, but inside
     // the Context::Scope.
@@ -293,8 +494,11 @@ void ThrowDataCloneException(Local<Context> context, Local<String> message) {
 // DeserializerDelegate understands how to unpack.
 class SerializerDelegate : public ValueSerializer::Delegate {
  public:
-  SerializerDelegate(Environment* env, Local<Context> context, Message* m)
-      : env_(env), context_(context), msg_(m) {}
+  SerializerDelegate(Environment* env,
+                     Local<Context> context,
+                     Message* m,
+                     MessageBufferPool* buffer_pool)
+      : env_(env), context_(context), msg_(m), buffer_pool_(buffer_pool) {}
 
   void ThrowDataCloneError(Local<String> message) override {
     ThrowDataCloneException(context_, message);
@@ -347,6 +551,33 @@ class SerializerDelegate : public ValueSerializer::Delegate {
     return Just(msg_->AddWASMModule(module->GetCompiledModule()));
   }
 
+  void* ReallocateBufferMemory(void* old_buffer,
+                               size_t size,
+                               size_t* actual_size) override {
+    if (buffer_pool_ == nullptr) {
+      return ValueSerializer::Delegate::ReallocateBufferMemory(
+          old_buffer, size, actual_size);
+    }
+    // Start out as large as the previous message, rather than growing the
+    // buffer to that size step by step.
+    if (old_buffer == nullptr)
+      size = std::max(size, buffer_pool_->size_hint());
+    char* buffer = buffer_pool_->Allocate(size, actual_size);
+    if (buffer == nullptr) return nullptr;
+    if (old_buffer != nullptr) {
+      memcpy(buffer, old_buffer, buffer_capacity_);
+      buffer_pool_->Release(static_cast<char*>(old_buffer), buffer_capacity_);
+    }
+    buffer_capacity_ = *actual_size;
+    return buffer;
+  }
+
+  void FreeBufferMemory(void* buffer) override {
+    if (buffer_pool_ == nullptr)
+      return ValueSerializer::Delegate::FreeBufferMemory(buffer);
+    buffer_pool_->Release(static_cast<char*>(buffer), buffer_capacity_);
+  }
+
   Maybe<bool> Finish(Local<Context> context) {
     for (uint32_t i = 0; i < host_objects_.size(); i++) {
       BaseObjectPtr<BaseObject> host_object = std::move(host_objects_[i]);
@@ -422,6 +653,8 @@ class SerializerDelegate : public ValueSerializer::Delegate {
   Environment* env_;
   Local<Context> context_;
   Message* msg_;
+  MessageBufferPool* buffer_pool_;
+  size_t buffer_capacity_ = 0;
   std::vector<Global<SharedArrayBuffer>> seen_shared_array_buffers_;
   std::vector<BaseObjectPtr<BaseObject>> host_objects_;
   size_t first_cloned_object_index_ = SIZE_MAX;
@@ -435,14 +668,19 @@ Maybe<bool> Message::Serialize(Environment* env,
                                Local<Context> context,
                                Local<Value> input,
                                const TransferList& transfer_list_v,
-                               Local<Object> source_port) {
+                               Local<Object> source_port,
+                               std::shared_ptr<MessageBufferPool> buffer_pool) {
   HandleScope handle_scope(env->isolate());
   Context::Scope context_scope(context);
 
   // Verify that we're not silently overwriting an existing message.
   CHECK(main_message_buf_.is_empty());
+  buffer_pool_ = std::move(buffer_pool);
+
+  if (transfer_list_v.length() == 0 && SerializeRaw(env->isolate(), input))
+    return Just(true);
 
-  SerializerDelegate delegate(env, context, this);
+  SerializerDelegate delegate(env, context, this, buffer_pool_.get());
   ValueSerializer serializer(env->isolate(), &delegate);
   delegate.serializer = &serializer;
 
@@ -559,11 +797,16 @@ Maybe<bool> Message::Serialize(Environment* env,
   if (delegate.Finish(context).IsNothing())
     return Nothing<bool>();
 
-  // The serializer gave us a buffer allocated using `malloc()`.
+  // The serializer gave us a buffer allocated using `malloc()`, possibly
+  // by way of `buffer_pool_`.
   std::pair<uint8_t*, size_t> data = serializer.Release();
   CHECK_NOT_NULL(data.first);
   main_message_buf_ =
       MallocedBuffer<char>(reinterpret_cast<char*>(data.first), data.second);
+  if (buffer_pool_) {
+    buffer_capacity_ = delegate.buffer_capacity_;
+    buffer_pool_->set_size_hint(data.second);
+  }
   return Just(true);
 }
 
@@ -882,12 +1125,13 @@ Maybe<bool> MessagePort::PostMessage(Environment* env,
   Local<Object> obj = object(isolate);
 
   std::shared_ptr<Message> msg = std::make_shared<Message>();
+  if (!buffer_pool_) buffer_pool_ = std::make_shared<MessageBufferPool>();
 
   // Per spec, we need to both check if transfer list has the source port, and
   // serialize the input message, even if the MessagePort is closed or detached.
 
   Maybe<bool> serialization_maybe =
-      msg->Serialize(env, context, message_v, transfer_v, obj);
+      msg->Serialize(env, context, message_v, transfer_v, obj, buffer_pool_);
   if (data_ == nullptr) {
     return serialization_maybe;
   }
@@ -1528,6 +1772,8 @@ static void InitMessaging(Local<Object> target,
             SetDeserializerCreateObjectFunction);
   SetMethod(context, target, "broadcastChannel", BroadcastChannel);
 
+  RingChannel::Initialize(env, target);
+
   {
     Local<Function> domexception = GetDOMException(context).ToLocalChecked();
     target
@@ -1551,6 +1797,7 @@ static void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(MessagePort::ReceiveMessage);
   registry->Register(MessagePort::MoveToContext);
   registry->Register(SetDeserializerCreateObjectFunction);
+  RingChannel::RegisterExternalReferences(registry);
 }
 
 }  // anonymous namespace
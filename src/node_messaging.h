@@ -6,6 +6,8 @@
 #include "env.h"
 #include "node_mutex.h"
 #include "v8.h"
+#include <atomic>
+#include <cstdint>
 #include <deque>
 #include <string>
 #include <unordered_map>
@@ -42,6 +44,48 @@ class TransferData : public MemoryRetainer {
       v8::Local<v8::Context> context, v8::ValueSerializer* serializer);
 };
 
+// Recycles the buffers that messages are serialized into. A buffer is taken
+// from the pool on the sending thread and given back on the receiving one once
+// the message is gone, so that a port which keeps sending messages of about
+// the same size stops allocating. Buffers are kept per power-of-two size
+// class, and larger ones are not kept at all.
+class MessageBufferPool {
+ public:
+  MessageBufferPool() = default;
+  ~MessageBufferPool();
+
+  MessageBufferPool(const MessageBufferPool&) = delete;
+  MessageBufferPool& operator=(const MessageBufferPool&) = delete;
+
+  // Returns a buffer of at least `size` bytes, or nullptr if out of memory.
+  // Its actual size is stored in `*capacity` and has to be passed back to
+  // Release(). This may be called from any thread.
+  char* Allocate(size_t size, size_t* capacity);
+  void Release(char* data, size_t capacity);
+
+  // The size of the last message that was serialized using this pool, which
+  // serves as the initial size of the next one, as long as that is a size
+  // that the pool keeps buffers of.
+  size_t size_hint() const {
+    return size_hint_.load(std::memory_order_relaxed);
+  }
+  void set_size_hint(size_t size) {
+    size_hint_.store(std::min(size, kMaxPooledSize), std::memory_order_relaxed);
+  }
+
+ private:
+  static constexpr size_t kMinSizeClassShift = 7;  // 128 bytes
+  static constexpr size_t kSizeClassCount = 8;
+  static constexpr size_t kMaxPooledSize =
+      size_t{1} << (kMinSizeClassShift + kSizeClassCount - 1);  // 16 KiB
+  static constexpr size_t kBuffersPerSizeClass = 8;
+
+  Mutex mutex_;
+  char* free_buffers_[kSizeClassCount][kBuffersPerSizeClass];
+  size_t free_buffer_count_[kSizeClassCount] = {};
+  std::atomic<size_t> size_hint_ {0};
+};
+
 // Represents a single communication message.
 class Message : public MemoryRetainer {
  public:
@@ -49,7 +93,7 @@ class Message : public MemoryRetainer {
   // V8 ValueSerializer API. If `payload` is empty, this message indicates
   // that the receiving message port should close itself.
   explicit Message(MallocedBuffer<char>&& payload = MallocedBuffer<char>());
-  ~Message() = default;
+  ~Message() override;
 
   Message(Message&& other) = default;
   Message& operator=(Message&& other) = default;
@@ -72,12 +116,16 @@ class Message : public MemoryRetainer {
   // deserialization.
   // The source_port parameter, if provided, will make Serialize() throw a
   // "DataCloneError" DOMException if source_port is found in transfer_list.
+  // If buffer_pool is provided, the message is serialized into a buffer from
+  // that pool, which it is returned to when this Message is destroyed.
   v8::Maybe<bool> Serialize(Environment* env,
                             v8::Local<v8::Context> context,
                             v8::Local<v8::Value> input,
                             const TransferList& transfer_list,
                             v8::Local<v8::Object> source_port =
-                                v8::Local<v8::Object>());
+                                v8::Local<v8::Object>(),
+                            std::shared_ptr<MessageBufferPool> buffer_pool =
+                                std::shared_ptr<MessageBufferPool>());
 
   // Internal method of Message that is called when a new SharedArrayBuffer
   // object is encountered in the incoming value's structure.
@@ -106,7 +154,38 @@ class Message : public MemoryRetainer {
   SET_SELF_SIZE(Message)
 
  private:
+  // Strings and typed arrays without a transfer list make up most messages,
+  // and are copied into main_message_buf_ as they are, rather than in the
+  // format of the V8 ValueSerializer API.
+  enum class PayloadType : uint8_t {
+    kValueSerializer,
+    kOneByteString,
+    kTwoByteString,
+    kInt8Array,
+    kUint8Array,
+    kUint8ClampedArray,
+    kInt16Array,
+    kUint16Array,
+    kInt32Array,
+    kUint32Array,
+    kFloat32Array,
+    kFloat64Array,
+    kBigInt64Array,
+    kBigUint64Array,
+    kDataView
+  };
+
+  static bool GetViewPayloadType(v8::Local<v8::Value> value,
+                                 PayloadType* type);
+  bool SerializeRaw(v8::Isolate* isolate, v8::Local<v8::Value> input);
+  v8::MaybeLocal<v8::Value> DeserializeRaw(Environment* env);
+  bool AllocateMainMessageBuffer(size_t size);
+
   MallocedBuffer<char> main_message_buf_;
+  // If set, main_message_buf_ is returned to this pool instead of being freed.
+  std::shared_ptr<MessageBufferPool> buffer_pool_;
+  size_t buffer_capacity_ = 0;
+  PayloadType payload_type_ = PayloadType::kValueSerializer;
   // TODO(addaleax): Make this a std::variant to save storage size in the common
   // case (which is that all of these vectors are empty) once that is available
   // with C++17.
@@ -311,6 +390,8 @@ class MessagePort : public HandleWrap {
   bool receiving_messages_ = false;
   uv_async_t async_;
   v8::Global<v8::Function> emit_message_fn_;
+  // Created by the first PostMessage() call.
+  std::shared_ptr<MessageBufferPool> buffer_pool_;
 
   friend class MessagePortData;
 };
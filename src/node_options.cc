@@ -94,6 +94,11 @@ void PerProcessOptions::CheckOptions(std::vector<std::string>* errors,
       use_largepages != "silent") {
     errors->push_back("invalid value for --use-largepages");
   }
+  if (use_largepages_data != "off" &&
+      use_largepages_data != "on" &&
+      use_largepages_data != "prefault") {
+    errors->push_back("invalid value for --use-largepages-data");
+  }
   per_isolate->CheckOptions(errors, argv);
 }
 
@@ -970,6 +975,13 @@ PerProcessOptionsParser::PerProcessOptionsParser(
             "or 'silent' (map and silently ignore failure)",
             &PerProcessOptions::use_largepages,
             kAllowedInEnvvar);
+  AddOption("--use-largepages-data",
+            "Back large ArrayBuffers and the V8 heap with huge pages where "
+            "the OS supports it. Options are 'off' (the default value), "
+            "'on' (reporting failure to stderr), or 'prefault' (like 'on', "
+            "and fault memory in as soon as it is allocated)",
+            &PerProcessOptions::use_largepages_data,
+            kAllowedInEnvvar);
 
   AddOption("--trace-sigint",
             "enable printing JavaScript stacktrace on SIGINT",
@@ -300,6 +300,7 @@ class PerProcessOptions : public Options {
 
   // TODO(addaleax): Some of these could probably be per-Environment.
   std::string use_largepages = "off";
+  std::string use_largepages_data = "off";
   bool trace_sigint = false;
   std::vector<std::string> cmdline;
 
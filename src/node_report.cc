@@ -3,6 +3,7 @@
 #include "diagnosticfilename-inl.h"
 #include "env-inl.h"
 #include "json_utils.h"
+#include "large_pages/node_large_page.h"
 #include "node_internals.h"
 #include "node_metadata.h"
 #include "node_mutex.h"
@@ -676,6 +677,16 @@ static void PrintResourceUsage(JSONWriter* writer) {
     writer->json_keyvalue("writes", rusage.ru_oublock);
     writer->json_objectend();
   }
+  large_pages::DataStats large_pages;
+  if (large_pages::GetDataStats(&large_pages)) {
+    writer->json_objectstart("largePages");
+    writer->json_keyvalue("arrayBufferBytes", large_pages.array_buffer_bytes);
+    if (large_pages.anon_huge_pages >= 0)
+      writer->json_keyvalue("anonHugePages", large_pages.anon_huge_pages);
+    if (large_pages.hugetlb >= 0)
+      writer->json_keyvalue("hugetlb", large_pages.hugetlb);
+    writer->json_objectend();
+  }
   writer->json_objectend();
 #ifdef RUSAGE_THREAD
   struct rusage stats;
@@ -0,0 +1,666 @@
+#include "node_ring_channel.h"
+
+#include "async_wrap-inl.h"
+#include "env-inl.h"
+#include "memory_tracker-inl.h"
+#include "node_buffer.h"
+#include "node_errors.h"
+#include "node_external_reference.h"
+#include "util-inl.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <new>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <ctime>
+#endif
+
+namespace node {
+
+using v8::BackingStore;
+using v8::Context;
+using v8::FastApiCallbackOptions;
+using v8::FastApiTypedArray;
+using v8::FunctionCallbackInfo;
+using v8::FunctionTemplate;
+using v8::HandleScope;
+using v8::Isolate;
+using v8::Local;
+using v8::Number;
+using v8::Object;
+using v8::ObjectTemplate;
+using v8::SharedArrayBuffer;
+using v8::Uint32;
+using v8::Value;
+
+namespace worker {
+
+namespace {
+
+constexpr size_t kCacheLineSize = 64;
+constexpr uint32_t kMaxCapacity = 1 << 24;
+constexpr uint32_t kMaxSlotSize = 1 << 20;
+constexpr size_t kMaxByteLength = size_t{1} << 30;
+
+// Values of Header::reader_state.
+enum ReaderState : uint32_t {
+  kReaderRunning,
+  kReaderParked,
+  kReaderBlocked,
+};
+
+uint32_t RoundUpToPowerOfTwo(uint32_t value) {
+  uint32_t result = 1;
+  while (result < value) result <<= 1;
+  return result;
+}
+
+// A negative or non-finite timeout from JS means none.
+double ToTimeout(Local<Value> value) {
+  const double timeout = value.As<Number>()->Value();
+  return std::isfinite(timeout) && timeout >= 0 ? timeout : -1;
+}
+
+// The longest that a blocking wait from JS sleeps before it checks whether
+// its Environment is being stopped.
+constexpr double kWaitSliceMs = 50;
+
+// Calls `wait(timeout_ms)` in slices of at most kWaitSliceMs until it returns
+// true or `timeout_ms` expires. Nothing wakes the ring up when the thread is
+// asked to stop, e.g. by worker.terminate() or at process exit, so give up
+// as soon as the Environment is stopping.
+template <typename WaitFn>
+bool WaitInSlices(Environment* env, double timeout_ms, WaitFn wait) {
+  const uint64_t start = uv_hrtime();
+  for (;;) {
+    double slice = kWaitSliceMs;
+    if (timeout_ms >= 0) {
+      const double elapsed = static_cast<double>(uv_hrtime() - start) / 1e6;
+      slice = std::max(std::min(slice, timeout_ms - elapsed), 0.0);
+    }
+    if (wait(slice)) return true;
+    if (env->is_stopping()) return false;
+    if (timeout_ms >= 0 &&
+        static_cast<double>(uv_hrtime() - start) / 1e6 >= timeout_ms) {
+      return false;
+    }
+  }
+}
+
+}  // anonymous namespace
+
+// Writers, the reader and waiters each get their own cache line.
+struct RingBuffer::Header {
+  // The next slot to be claimed by a writer.
+  alignas(kCacheLineSize) std::atomic<uint64_t> head {0};
+  // The next slot to be read. Only the reader touches this.
+  alignas(kCacheLineSize) std::atomic<uint64_t> tail {0};
+  alignas(kCacheLineSize) std::atomic<uint32_t> reader_state {kReaderRunning};
+  // Bumped to wake up a blocked reader.
+  std::atomic<uint32_t> readable_seq {0};
+  alignas(kCacheLineSize) std::atomic<uint32_t> writers_waiting {0};
+  // Bumped to wake up writers that wait for space.
+  std::atomic<uint32_t> writable_seq {0};
+};
+
+struct RingBuffer::Slot {
+  // `index` while free for the writer of record `index`, `index + 1` once
+  // that has been written, `index + capacity` once it has been read.
+  std::atomic<uint64_t> sequence;
+  uint32_t length;
+  // Followed by `slot_size` bytes of data.
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free &&
+                  std::atomic<uint32_t>::is_always_lock_free,
+              "The ring lives in memory that is shared between threads");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+              "Futex words must be plain 32-bit integers");
+
+size_t RingBuffer::SlotStride(uint32_t slot_size) {
+  return RoundUp(sizeof(Slot) + slot_size, alignof(Slot));
+}
+
+char* RingBuffer::SlotData(Slot* slot) {
+  return reinterpret_cast<char*>(slot) + sizeof(*slot);
+}
+
+uint64_t RingBuffer::ByteLength(uint32_t capacity, uint32_t slot_size) {
+  // The memory may not be aligned to a cache line.
+  return uint64_t{kCacheLineSize} + sizeof(Header) +
+         uint64_t{RoundUpToPowerOfTwo(capacity)} * SlotStride(slot_size);
+}
+
+RingBuffer::RingBuffer(void* memory, uint32_t capacity, uint32_t slot_size)
+    : mask_(RoundUpToPowerOfTwo(capacity) - 1),
+      slot_size_(slot_size),
+      stride_(SlotStride(slot_size)) {
+  char* base = reinterpret_cast<char*>(
+      RoundUp(reinterpret_cast<uintptr_t>(memory), kCacheLineSize));
+  header_ = new (base) Header();
+  slots_ = base + sizeof(Header);
+  for (uint64_t i = 0; i <= mask_; i++) {
+    Slot* slot = new (slots_ + i * stride_) Slot();
+    slot->sequence.store(i, std::memory_order_relaxed);
+    slot->length = 0;
+  }
+#ifndef __linux__
+  CHECK_EQ(uv_mutex_init(&wait_mutex_), 0);
+  CHECK_EQ(uv_cond_init(&wait_cond_), 0);
+#endif
+}
+
+RingBuffer::~RingBuffer() {
+#ifndef __linux__
+  uv_cond_destroy(&wait_cond_);
+  uv_mutex_destroy(&wait_mutex_);
+#endif
+}
+
+RingBuffer::Slot* RingBuffer::GetSlot(uint64_t index) const {
+  return reinterpret_cast<Slot*>(slots_ + (index & mask_) * stride_);
+}
+
+bool RingBuffer::IsReadable() const {
+  const uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+  return GetSlot(tail)->sequence.load(std::memory_order_acquire) == tail + 1;
+}
+
+bool RingBuffer::IsWritable() const {
+  const uint64_t head = header_->head.load(std::memory_order_relaxed);
+  const uint64_t sequence =
+      GetSlot(head)->sequence.load(std::memory_order_acquire);
+  return static_cast<int64_t>(sequence - head) >= 0;
+}
+
+bool RingBuffer::Write(const void* data, size_t length, bool* notify_reader) {
+  *notify_reader = false;
+  if (length > slot_size_) return false;
+
+  uint64_t position = header_->head.load(std::memory_order_relaxed);
+  Slot* slot;
+  for (;;) {
+    slot = GetSlot(position);
+    const uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+    const int64_t diff = static_cast<int64_t>(sequence - position);
+    if (diff == 0) {
+      if (header_->head.compare_exchange_weak(
+              position, position + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // The reader has not got to the record that used this slot last.
+      return false;
+    } else {
+      // Another writer got here first.
+      position = header_->head.load(std::memory_order_relaxed);
+    }
+  }
+
+  memcpy(SlotData(slot), data, length);
+  slot->length = static_cast<uint32_t>(length);
+  slot->sequence.store(position + 1, std::memory_order_release);
+
+  // Pairs with the fence in Park(): either the reader sees this record, or
+  // this sees that the reader has parked.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (header_->reader_state.load(std::memory_order_relaxed) !=
+      kReaderRunning) {
+    switch (header_->reader_state.exchange(kReaderRunning,
+                                           std::memory_order_relaxed)) {
+      case kReaderParked:
+        *notify_reader = true;
+        break;
+      case kReaderBlocked:
+        Wake(&header_->readable_seq);
+        break;
+      default:
+        // Another writer is taking care of it.
+        break;
+    }
+  }
+  return true;
+}
+
+bool RingBuffer::WaitWritable(double timeout_ms) {
+  const uint64_t start = uv_hrtime();
+  for (;;) {
+    if (IsWritable()) return true;
+    const uint32_t seq =
+        header_->writable_seq.load(std::memory_order_acquire);
+    header_->writers_waiting.fetch_add(1, std::memory_order_relaxed);
+    // Pairs with the fence in Read().
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool writable = IsWritable();
+    if (!writable) {
+      double remaining = timeout_ms;
+      if (timeout_ms >= 0) {
+        remaining -= static_cast<double>(uv_hrtime() - start) / 1e6;
+        if (remaining <= 0) {
+          header_->writers_waiting.fetch_sub(1, std::memory_order_relaxed);
+          return false;
+        }
+      }
+      Block(&header_->writable_seq, seq, remaining);
+    }
+    header_->writers_waiting.fetch_sub(1, std::memory_order_relaxed);
+    if (writable) return true;
+  }
+}
+
+uint32_t RingBuffer::Read(void* out, uint32_t* lengths, uint32_t max_records) {
+  uint64_t position = header_->tail.load(std::memory_order_relaxed);
+  char* dest = static_cast<char*>(out);
+  uint32_t count = 0;
+  while (count < max_records) {
+    Slot* slot = GetSlot(position);
+    if (slot->sequence.load(std::memory_order_acquire) != position + 1) break;
+    lengths[count] = slot->length;
+    memcpy(dest, SlotData(slot), slot->length);
+    dest += slot_size_;
+    // Hand the slot to the writer of the record one lap later.
+    slot->sequence.store(position + mask_ + 1, std::memory_order_release);
+    position++;
+    count++;
+  }
+  if (count == 0) return 0;
+
+  header_->tail.store(position, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (header_->writers_waiting.load(std::memory_order_relaxed) != 0)
+    Wake(&header_->writable_seq);
+  return count;
+}
+
+bool RingBuffer::Park() {
+  header_->reader_state.store(kReaderParked, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!IsReadable()) return true;
+  header_->reader_state.store(kReaderRunning, std::memory_order_relaxed);
+  return false;
+}
+
+bool RingBuffer::WaitReadable(double timeout_ms) {
+  const uint64_t start = uv_hrtime();
+  for (;;) {
+    const uint32_t seq =
+        header_->readable_seq.load(std::memory_order_acquire);
+    header_->reader_state.store(kReaderBlocked, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (IsReadable()) break;
+    double remaining = timeout_ms;
+    if (timeout_ms >= 0) {
+      remaining -= static_cast<double>(uv_hrtime() - start) / 1e6;
+      if (remaining <= 0) break;
+    }
+    Block(&header_->readable_seq, seq, remaining);
+  }
+  header_->reader_state.store(kReaderRunning, std::memory_order_relaxed);
+  return IsReadable();
+}
+
+void RingBuffer::Block(std::atomic<uint32_t>* word,
+                       uint32_t value,
+                       double timeout_ms) {
+#if defined(__linux__)
+  struct timespec timeout;
+  struct timespec* timeout_ptr = nullptr;
+  if (timeout_ms >= 0) {
+    timeout.tv_sec = static_cast<time_t>(timeout_ms / 1000);
+    timeout.tv_nsec = static_cast<long>(  // NOLINT(runtime/int)
+        std::fmod(timeout_ms, 1000) * 1e6);
+    timeout_ptr = &timeout;
+  }
+  // Timeouts, signals and a changed value all send the caller round its loop
+  // again, so the result does not matter.
+  syscall(SYS_futex,
+          reinterpret_cast<uint32_t*>(word),
+          FUTEX_WAIT_PRIVATE,
+          value,
+          timeout_ptr,
+          nullptr,
+          0);
+#else
+  uv_mutex_lock(&wait_mutex_);
+  if (word->load(std::memory_order_relaxed) == value) {
+    if (timeout_ms < 0) {
+      uv_cond_wait(&wait_cond_, &wait_mutex_);
+    } else {
+      uv_cond_timedwait(
+          &wait_cond_, &wait_mutex_, static_cast<uint64_t>(timeout_ms * 1e6));
+    }
+  }
+  uv_mutex_unlock(&wait_mutex_);
+#endif
+}
+
+void RingBuffer::Wake(std::atomic<uint32_t>* word) {
+  word->fetch_add(1, std::memory_order_release);
+#if defined(__linux__)
+  syscall(SYS_futex,
+          reinterpret_cast<uint32_t*>(word),
+          FUTEX_WAKE_PRIVATE,
+          INT_MAX,
+          nullptr,
+          nullptr,
+          0);
+#else
+  uv_mutex_lock(&wait_mutex_);
+  uv_cond_broadcast(&wait_cond_);
+  uv_mutex_unlock(&wait_mutex_);
+#endif
+}
+
+RingChannel::Shared::Shared(std::shared_ptr<BackingStore> store,
+                            uint32_t capacity,
+                            uint32_t slot_size)
+    : store(std::move(store)),
+      ring(this->store->Data(), capacity, slot_size) {}
+
+RingChannel::RingChannel(Environment* env,
+                         Local<Object> wrap,
+                         std::shared_ptr<Shared> shared)
+    : HandleWrap(env,
+                 wrap,
+                 reinterpret_cast<uv_handle_t*>(&async_),
+                 AsyncWrap::PROVIDER_RINGCHANNEL),
+      shared_(std::move(shared)) {
+  auto onreadable = [](uv_async_t* handle) {
+    RingChannel* channel = ContainerOf(&RingChannel::async_, handle);
+    channel->OnReadable();
+  };
+  CHECK_EQ(uv_async_init(env->event_loop(), &async_, onreadable), 0);
+  // Only a started reader keeps the event loop alive.
+  uv_unref(reinterpret_cast<uv_handle_t*>(&async_));
+}
+
+BaseObjectPtr<RingChannel> RingChannel::Create(
+    Environment* env, std::shared_ptr<Shared> shared) {
+  Local<Object> obj;
+  if (!GetConstructorTemplate(env)
+           ->InstanceTemplate()
+           ->NewInstance(env->context())
+           .ToLocal(&obj)) {
+    return BaseObjectPtr<RingChannel>();
+  }
+  return MakeBaseObject<RingChannel>(env, obj, std::move(shared));
+}
+
+void RingChannel::New(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  CHECK(args.IsConstructCall());
+  CHECK(args[0]->IsUint32());
+  CHECK(args[1]->IsUint32());
+  const uint32_t capacity = args[0].As<Uint32>()->Value();
+  const uint32_t slot_size = args[1].As<Uint32>()->Value();
+  if (capacity == 0 || capacity > kMaxCapacity || slot_size == 0 ||
+      slot_size > kMaxSlotSize ||
+      RingBuffer::ByteLength(capacity, slot_size) > kMaxByteLength) {
+    return THROW_ERR_OUT_OF_RANGE(env, "Invalid ring channel size");
+  }
+
+  std::shared_ptr<BackingStore> store = SharedArrayBuffer::NewBackingStore(
+      env->isolate(),
+      static_cast<size_t>(RingBuffer::ByteLength(capacity, slot_size)));
+  new RingChannel(
+      env,
+      args.This(),
+      std::make_shared<Shared>(std::move(store), capacity, slot_size));
+}
+
+bool RingChannel::ClaimReader() {
+  if (is_reader_) return true;
+  if (IsHandleClosing()) return false;
+  Mutex::ScopedLock lock(shared_->mutex);
+  if (shared_->reader != nullptr) return false;
+  shared_->reader = this;
+  is_reader_ = true;
+  return true;
+}
+
+bool RingChannel::WriteImpl(const uint8_t* data, size_t length) {
+  bool notify_reader;
+  if (!shared_->ring.Write(data, length, &notify_reader)) return false;
+  if (notify_reader) {
+    Mutex::ScopedLock lock(shared_->mutex);
+    if (shared_->reader != nullptr)
+      CHECK_EQ(uv_async_send(&shared_->reader->async_), 0);
+  }
+  return true;
+}
+
+// Returns true if the record was written, or false if the ring is full.
+void RingChannel::SlowWrite(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  RingChannel* channel;
+  ASSIGN_OR_RETURN_UNWRAP(&channel, args.This());
+  CHECK(args[0]->IsArrayBufferView());
+  ArrayBufferViewContents<uint8_t> data(args[0]);
+  if (channel->IsHandleClosing())
+    return THROW_ERR_INVALID_STATE(env, "The channel is closed");
+  const uint32_t slot_size = channel->shared_->ring.slot_size();
+  if (data.length() > slot_size) {
+    return THROW_ERR_OUT_OF_RANGE(
+        env, "Records must not be longer than %u bytes", slot_size);
+  }
+  args.GetReturnValue().Set(channel->WriteImpl(data.data(), data.length()));
+}
+
+bool RingChannel::FastWrite(Local<Object> receiver,
+                            const FastApiTypedArray<uint8_t>& data,
+                            FastApiCallbackOptions& options) {
+  RingChannel* channel = FromJSObject<RingChannel>(receiver);
+  if (channel->IsHandleClosing() ||
+      data.length() > channel->shared_->ring.slot_size()) {
+    options.fallback = true;
+    return false;
+  }
+  uint8_t* ptr;
+  CHECK(data.getStorageIfAligned(&ptr));
+  return channel->WriteImpl(ptr, data.length());
+}
+
+// Returns the number of records read, which is zero only once the reader has
+// parked and `onreadable` will be called when that changes.
+uint32_t RingChannel::ReadImpl(uint8_t* out,
+                               uint32_t* lengths,
+                               uint32_t max_records) {
+  RingBuffer* ring = &shared_->ring;
+  uint32_t count = ring->Read(out, lengths, max_records);
+  if (count == 0 && !ring->Park())
+    count = ring->Read(out, lengths, max_records);
+  return count;
+}
+
+void RingChannel::SlowRead(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  RingChannel* channel;
+  ASSIGN_OR_RETURN_UNWRAP(&channel, args.This());
+  CHECK(args[0]->IsUint8Array());
+  CHECK(args[1]->IsUint32Array());
+  if (!channel->ClaimReader()) {
+    return THROW_ERR_INVALID_STATE(
+        env, "The channel is closed or another one is reading");
+  }
+  const uint32_t slot_size = channel->shared_->ring.slot_size();
+  const size_t max_records = std::min(Buffer::Length(args[0]) / slot_size,
+                                      Buffer::Length(args[1]) / 4);
+  if (max_records == 0) {
+    return THROW_ERR_OUT_OF_RANGE(
+        env, "There must be room for at least one record");
+  }
+  args.GetReturnValue().Set(channel->ReadImpl(
+      reinterpret_cast<uint8_t*>(Buffer::Data(args[0])),
+      reinterpret_cast<uint32_t*>(Buffer::Data(args[1])),
+      static_cast<uint32_t>(std::min<size_t>(max_records, UINT32_MAX))));
+}
+
+uint32_t RingChannel::FastRead(Local<Object> receiver,
+                               const FastApiTypedArray<uint8_t>& out,
+                               const FastApiTypedArray<uint32_t>& lengths,
+                               FastApiCallbackOptions& options) {
+  RingChannel* channel = FromJSObject<RingChannel>(receiver);
+  const size_t max_records =
+      std::min(out.length() / channel->shared_->ring.slot_size(),
+               lengths.length());
+  if (max_records == 0 || !channel->ClaimReader()) {
+    options.fallback = true;
+    return 0;
+  }
+  uint8_t* out_data;
+  uint32_t* lengths_data;
+  CHECK(out.getStorageIfAligned(&out_data));
+  CHECK(lengths.getStorageIfAligned(&lengths_data));
+  return channel->ReadImpl(
+      out_data,
+      lengths_data,
+      static_cast<uint32_t>(std::min<size_t>(max_records, UINT32_MAX)));
+}
+
+// Blocks the thread until there is something to read, like Atomics.wait().
+// Returns false if the timeout, in milliseconds, expired first, or if the
+// thread is being stopped.
+void RingChannel::Wait(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  RingChannel* channel;
+  ASSIGN_OR_RETURN_UNWRAP(&channel, args.This());
+  CHECK(args[0]->IsNumber());
+  if (!channel->ClaimReader()) {
+    return THROW_ERR_INVALID_STATE(
+        env, "The channel is closed or another one is reading");
+  }
+  RingBuffer* ring = &channel->shared_->ring;
+  args.GetReturnValue().Set(
+      WaitInSlices(env, ToTimeout(args[0]), [ring](double timeout_ms) {
+        return ring->WaitReadable(timeout_ms);
+      }));
+}
+
+// Blocks the thread until a record could be written.
+void RingChannel::WaitForSpace(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  RingChannel* channel;
+  ASSIGN_OR_RETURN_UNWRAP(&channel, args.This());
+  CHECK(args[0]->IsNumber());
+  if (channel->IsHandleClosing())
+    return THROW_ERR_INVALID_STATE(env, "The channel is closed");
+  RingBuffer* ring = &channel->shared_->ring;
+  args.GetReturnValue().Set(
+      WaitInSlices(env, ToTimeout(args[0]), [ring](double timeout_ms) {
+        return ring->WaitWritable(timeout_ms);
+      }));
+}
+
+// Makes the channel the reader and keeps the event loop alive until it is
+// closed or unref()ed. `onreadable` is called right away if there is
+// something to read already.
+void RingChannel::Start(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  RingChannel* channel;
+  ASSIGN_OR_RETURN_UNWRAP(&channel, args.This());
+  if (!channel->ClaimReader()) {
+    return THROW_ERR_INVALID_STATE(
+        env, "The channel is closed or another one is reading");
+  }
+  uv_ref(reinterpret_cast<uv_handle_t*>(&channel->async_));
+  if (!channel->shared_->ring.Park())
+    CHECK_EQ(uv_async_send(&channel->async_), 0);
+}
+
+void RingChannel::OnReadable() {
+  if (!is_reader_ || !env()->can_call_into_js()) return;
+  HandleScope handle_scope(env()->isolate());
+  Context::Scope context_scope(env()->context());
+  MakeCallback(env()->onreadable_string(), 0, nullptr);
+}
+
+void RingChannel::Close(Local<Value> close_callback) {
+  if (is_reader_) {
+    // Writers look at `reader` with the mutex held, so they never send to the
+    // handle once it is closing.
+    Mutex::ScopedLock lock(shared_->mutex);
+    shared_->reader = nullptr;
+    is_reader_ = false;
+  }
+  HandleWrap::Close(close_callback);
+}
+
+BaseObject::TransferMode RingChannel::GetTransferMode() const {
+  if (IsHandleClosing()) return TransferMode::kUntransferable;
+  return TransferMode::kCloneable;
+}
+
+std::unique_ptr<TransferData> RingChannel::CloneForMessaging() const {
+  return std::make_unique<RingChannelTransferData>(shared_);
+}
+
+BaseObjectPtr<BaseObject> RingChannel::RingChannelTransferData::Deserialize(
+    Environment* env,
+    Local<Context> context,
+    std::unique_ptr<TransferData> self) {
+  return Create(env, std::move(shared_));
+}
+
+void RingChannel::RingChannelTransferData::MemoryInfo(
+    MemoryTracker* tracker) const {
+  tracker->TrackFieldWithSize("ring", shared_->store->ByteLength());
+}
+
+void RingChannel::MemoryInfo(MemoryTracker* tracker) const {
+  tracker->TrackFieldWithSize("ring", shared_->store->ByteLength());
+}
+
+v8::CFunction RingChannel::fast_write_(v8::CFunction::Make(FastWrite));
+v8::CFunction RingChannel::fast_read_(v8::CFunction::Make(FastRead));
+
+Local<FunctionTemplate> RingChannel::GetConstructorTemplate(Environment* env) {
+  Local<FunctionTemplate> tmpl = env->ring_channel_constructor_template();
+  if (tmpl.IsEmpty()) {
+    Isolate* isolate = env->isolate();
+    tmpl = NewFunctionTemplate(isolate, New);
+    tmpl->SetClassName(FIXED_ONE_BYTE_STRING(isolate, "RingChannel"));
+    tmpl->InstanceTemplate()->SetInternalFieldCount(
+        RingChannel::kInternalFieldCount);
+    tmpl->Inherit(HandleWrap::GetConstructorTemplate(env));
+
+    Local<ObjectTemplate> proto = tmpl->PrototypeTemplate();
+    SetFastMethod(isolate, proto, "write", SlowWrite, &fast_write_);
+    SetFastMethod(isolate, proto, "read", SlowRead, &fast_read_);
+    SetProtoMethod(isolate, tmpl, "wait", Wait);
+    SetProtoMethod(isolate, tmpl, "waitForSpace", WaitForSpace);
+    SetProtoMethod(isolate, tmpl, "start", Start);
+    env->set_ring_channel_constructor_template(tmpl);
+  }
+  return tmpl;
+}
+
+void RingChannel::Initialize(Environment* env, Local<Object> target) {
+  SetConstructorFunction(env->context(),
+                         target,
+                         "RingChannel",
+                         GetConstructorTemplate(env),
+                         SetConstructorFunctionFlag::NONE);
+}
+
+void RingChannel::RegisterExternalReferences(
+    ExternalReferenceRegistry* registry) {
+  registry->Register(New);
+  registry->Register(SlowWrite);
+  registry->Register(FastWrite);
+  registry->Register(fast_write_.GetTypeInfo());
+  registry->Register(SlowRead);
+  registry->Register(FastRead);
+  registry->Register(fast_read_.GetTypeInfo());
+  registry->Register(Wait);
+  registry->Register(WaitForSpace);
+  registry->Register(Start);
+}
+
+}  // namespace worker
+}  // namespace node
@@ -0,0 +1,187 @@
+#ifndef SRC_NODE_RING_CHANNEL_H_
+#define SRC_NODE_RING_CHANNEL_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include "handle_wrap.h"
+#include "node_messaging.h"
+#include "node_mutex.h"
+#include "uv.h"
+#include "v8-fast-api-calls.h"
+#include "v8.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace node {
+
+class ExternalReferenceRegistry;
+
+namespace worker {
+
+// A bounded queue of byte records of up to `slot_size` bytes each, which any
+// number of threads can write to and a single thread reads from. All state
+// lives in the memory passed to the constructor, and none of the operations
+// take a lock, so that records that are written at about the rate they are
+// read never involve the kernel.
+//
+// Each slot carries a sequence number that tells writers whether it is free
+// and the reader whether it has been written, as in Dmitry Vyukov's bounded
+// MPMC queue. When the reader runs out of records it parks itself, and the
+// next writer learns that it has to wake it up. Blocking waits use a futex on
+// Linux and a condition variable elsewhere.
+class RingBuffer {
+ public:
+  // The number of bytes of memory that a ring with these parameters needs.
+  // `capacity` is rounded up to a power of two. This is computed in 64 bits
+  // so that it cannot wrap around on 32-bit platforms.
+  static uint64_t ByteLength(uint32_t capacity, uint32_t slot_size);
+
+  // `memory` must be ByteLength() bytes long and outlive the ring. It is
+  // initialized here. Negative timeouts below mean no timeout.
+  RingBuffer(void* memory, uint32_t capacity, uint32_t slot_size);
+  ~RingBuffer();
+
+  RingBuffer(const RingBuffer&) = delete;
+  RingBuffer& operator=(const RingBuffer&) = delete;
+
+  // Writer side. Returns false if the ring is full or `length` exceeds the
+  // slot size. `*notify_reader` is set if the reader has called Park() since
+  // it last read anything, and has to be told by other means, e.g. through
+  // a uv_async_t. A reader in WaitReadable() is woken up by Write() itself.
+  bool Write(const void* data, size_t length, bool* notify_reader);
+  bool WaitWritable(double timeout_ms);
+
+  // Reader side. Copies up to `max_records` records to `out`, one per
+  // `slot_size` bytes, and their lengths to `lengths`.
+  uint32_t Read(void* out, uint32_t* lengths, uint32_t max_records);
+  // Returns false if there is something to read. Otherwise the reader is
+  // parked until the next Write().
+  bool Park();
+  bool WaitReadable(double timeout_ms);
+
+  uint32_t capacity() const { return mask_ + 1; }
+  uint32_t slot_size() const { return slot_size_; }
+
+ private:
+  struct Header;
+  struct Slot;
+
+  static size_t SlotStride(uint32_t slot_size);
+  static inline char* SlotData(Slot* slot);
+  inline Slot* GetSlot(uint64_t index) const;
+  bool IsReadable() const;
+  bool IsWritable() const;
+  // Waits until `*word` is no longer `value`, or the timeout expires.
+  void Block(std::atomic<uint32_t>* word, uint32_t value, double timeout_ms);
+  void Wake(std::atomic<uint32_t>* word);
+
+  Header* header_;
+  char* slots_;
+  uint32_t mask_;
+  uint32_t slot_size_;
+  size_t stride_;
+#ifndef __linux__
+  uv_mutex_t wait_mutex_;
+  uv_cond_t wait_cond_;
+#endif
+};
+
+// The JS-facing side of a RingBuffer that lives in a SharedArrayBuffer
+// backing store. Channels are cloneable, and all clones refer to the same
+// ring: any of them can write, and the first one to read becomes the reader.
+// When the reader has drained the ring, its `onreadable` method is called
+// from its own event loop once there is more to read.
+class RingChannel : public HandleWrap {
+  struct Shared;
+
+ public:
+  static v8::Local<v8::FunctionTemplate> GetConstructorTemplate(
+      Environment* env);
+  static void Initialize(Environment* env, v8::Local<v8::Object> target);
+  static void RegisterExternalReferences(ExternalReferenceRegistry* registry);
+
+  static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void SlowWrite(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static bool FastWrite(v8::Local<v8::Object> receiver,
+                        const v8::FastApiTypedArray<uint8_t>& data,
+                        v8::FastApiCallbackOptions& options);  // NOLINT
+  static void SlowRead(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static uint32_t FastRead(v8::Local<v8::Object> receiver,
+                           const v8::FastApiTypedArray<uint8_t>& out,
+                           const v8::FastApiTypedArray<uint32_t>& lengths,
+                           v8::FastApiCallbackOptions& options);  // NOLINT
+  static void Wait(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void WaitForSpace(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void Start(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  RingChannel(Environment* env,
+              v8::Local<v8::Object> wrap,
+              std::shared_ptr<Shared> shared);
+
+  void Close(
+      v8::Local<v8::Value> close_callback = v8::Local<v8::Value>()) override;
+
+  TransferMode GetTransferMode() const override;
+  std::unique_ptr<TransferData> CloneForMessaging() const override;
+
+  void MemoryInfo(MemoryTracker* tracker) const override;
+  SET_MEMORY_INFO_NAME(RingChannel)
+  SET_SELF_SIZE(RingChannel)
+
+ private:
+  // What all clones of a channel share.
+  struct Shared {
+    Shared(std::shared_ptr<v8::BackingStore> store,
+           uint32_t capacity,
+           uint32_t slot_size);
+
+    std::shared_ptr<v8::BackingStore> store;
+    RingBuffer ring;
+    // Protects `reader`, so that it is not closed while being woken up.
+    Mutex mutex;
+    RingChannel* reader = nullptr;
+  };
+
+  class RingChannelTransferData : public TransferData {
+   public:
+    explicit RingChannelTransferData(std::shared_ptr<Shared> shared)
+        : shared_(std::move(shared)) {}
+
+    BaseObjectPtr<BaseObject> Deserialize(
+        Environment* env,
+        v8::Local<v8::Context> context,
+        std::unique_ptr<TransferData> self) override;
+
+    void MemoryInfo(MemoryTracker* tracker) const override;
+    SET_MEMORY_INFO_NAME(RingChannelTransferData)
+    SET_SELF_SIZE(RingChannelTransferData)
+
+   private:
+    std::shared_ptr<Shared> shared_;
+  };
+
+  static BaseObjectPtr<RingChannel> Create(Environment* env,
+                                           std::shared_ptr<Shared> shared);
+
+  bool WriteImpl(const uint8_t* data, size_t length);
+  uint32_t ReadImpl(uint8_t* out, uint32_t* lengths, uint32_t max_records);
+  // Makes this channel the reader, unless another one is.
+  bool ClaimReader();
+  void OnReadable();
+
+  std::shared_ptr<Shared> shared_;
+  bool is_reader_ = false;
+  uv_async_t async_;
+
+  static v8::CFunction fast_write_;
+  static v8::CFunction fast_read_;
+};
+
+}  // namespace worker
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_NODE_RING_CHANNEL_H_
@@ -5,14 +5,27 @@
 #include "node_internals.h"
 #include "util-inl.h"
 
+#include <algorithm>
+
 namespace node {
 
 using v8::Array;
 using v8::ArrayBuffer;
+using v8::ArrayBufferView;
+using v8::BackingStore;
+using v8::BigInt64Array;
+using v8::BigUint64Array;
 using v8::Context;
+using v8::DataView;
+using v8::Exception;
+using v8::Float32Array;
+using v8::Float64Array;
 using v8::Function;
 using v8::FunctionCallbackInfo;
 using v8::FunctionTemplate;
+using v8::Int16Array;
+using v8::Int32Array;
+using v8::Int8Array;
 using v8::Integer;
 using v8::Isolate;
 using v8::Just;
@@ -23,6 +36,10 @@ using v8::Nothing;
 using v8::Object;
 using v8::SharedArrayBuffer;
 using v8::String;
+using v8::Uint16Array;
+using v8::Uint32Array;
+using v8::Uint8Array;
+using v8::Uint8ClampedArray;
 using v8::Value;
 using v8::ValueDeserializer;
 using v8::ValueSerializer;
@@ -450,6 +467,295 @@ void DeserializerContext::ReadRawBytes(
   args.GetReturnValue().Set(offset);
 }
 
+namespace {
+
+// The ArrayBufferViews that v8.serialize() writes as host objects, in the
+// order of `arrayBufferViewTypes` in lib/v8.js, which makes up the type index
+// that is written along with their contents. Buffers come last.
+#define SERIALIZED_ARRAY_BUFFER_VIEW_TYPES(V)                                  \
+  V(Int8Array, 1)                                                              \
+  V(Uint8Array, 1)                                                             \
+  V(Uint8ClampedArray, 1)                                                      \
+  V(Int16Array, 2)                                                             \
+  V(Uint16Array, 2)                                                            \
+  V(Int32Array, 4)                                                             \
+  V(Uint32Array, 4)                                                            \
+  V(Float32Array, 4)                                                           \
+  V(Float64Array, 8)                                                           \
+  V(DataView, 1)                                                               \
+  V(BigInt64Array, 8)                                                          \
+  V(BigUint64Array, 8)
+
+enum ArrayBufferViewType : uint32_t {
+#define V(Type, element_size) k##Type,
+  SERIALIZED_ARRAY_BUFFER_VIEW_TYPES(V)
+#undef V
+  kFastBuffer
+};
+
+ArrayBufferViewType GetArrayBufferViewType(Local<Object> view) {
+#define V(Type, element_size)                                                  \
+  if (view->Is##Type()) return k##Type;
+  SERIALIZED_ARRAY_BUFFER_VIEW_TYPES(V)
+#undef V
+  UNREACHABLE();
+}
+
+size_t GetElementSize(uint32_t type) {
+  switch (type) {
+#define V(Type, element_size)                                                  \
+    case k##Type:                                                              \
+      return element_size;
+    SERIALIZED_ARRAY_BUFFER_VIEW_TYPES(V)
+#undef V
+    default:
+      return 1;
+  }
+}
+
+// The size of the previous serialize() and serializeBatch() results on this
+// thread, up to kMaxSizeHint, which the next result starts out with.
+constexpr size_t kMaxSizeHint = 64 * 1024;
+thread_local size_t serialize_size_hint = 0;
+thread_local size_t serialize_batch_size_hint = 0;
+
+// Does what DefaultSerializer in lib/v8.js does, without calling into JS.
+// Values are serialized back to back into memory owned by this delegate: each
+// ValueSerializer is handed the free space after the previous value, so that
+// a batch of values ends up in a single allocation without being copied.
+class OneShotSerializerDelegate : public ValueSerializer::Delegate {
+ public:
+  OneShotSerializerDelegate(Environment* env, size_t* size_hint)
+      : env_(env), size_hint_(size_hint) {}
+
+  ~OneShotSerializerDelegate() override { free(data_); }
+
+  void ThrowDataCloneError(Local<String> message) override {
+    env_->isolate()->ThrowException(Exception::Error(message));
+  }
+
+  Maybe<bool> WriteHostObject(Isolate* isolate, Local<Object> object) override {
+    if (!object->IsArrayBufferView()) {
+      ThrowDataCloneError(String::Concat(
+          isolate,
+          FIXED_ONE_BYTE_STRING(isolate, "Unserializable host object: "),
+          object->GetConstructorName()));
+      return Nothing<bool>();
+    }
+
+    const uint32_t type =
+        object->GetPrototype() == env_->buffer_prototype_object()
+            ? kFastBuffer
+            : GetArrayBufferViewType(object);
+    ArrayBufferViewContents<char> contents(object);
+    serializer->WriteUint32(type);
+    serializer->WriteUint32(static_cast<uint32_t>(contents.length()));
+    serializer->WriteRawBytes(contents.data(), contents.length());
+    return Just(true);
+  }
+
+  void* ReallocateBufferMemory(void* old_buffer,
+                               size_t size,
+                               size_t* actual_size) override {
+    // `old_buffer` is at data_ + size_, which realloc() keeps intact.
+    if (size_ + size > capacity_) {
+      const size_t capacity =
+          std::max({size_ + size, capacity_ * 2, *size_hint_});
+      char* data = UncheckedRealloc(data_, capacity);
+      if (data == nullptr) return nullptr;
+      data_ = data;
+      capacity_ = capacity;
+    }
+    *actual_size = capacity_ - size_;
+    return data_ + size_;
+  }
+
+  void FreeBufferMemory(void* buffer) override {}
+
+  // Appends the v8.serialize() data for `value`.
+  Maybe<bool> Serialize(Local<Context> context, Local<Value> value) {
+    ValueSerializer value_serializer(env_->isolate(), this);
+    serializer = &value_serializer;
+    value_serializer.SetTreatArrayBufferViewsAsHostObjects(true);
+    value_serializer.WriteHeader();
+    if (value_serializer.WriteValue(context, value).IsNothing())
+      return Nothing<bool>();
+    std::pair<uint8_t*, size_t> ret = value_serializer.Release();
+    CHECK_EQ(reinterpret_cast<char*>(ret.first), data_ + size_);
+    size_ += ret.second;
+    return Just(true);
+  }
+
+  // Hands everything serialized so far over to a Buffer.
+  MaybeLocal<Object> ReleaseBuffer() {
+    *size_hint_ = std::min(size_, kMaxSizeHint);
+    // Give back what the last time the memory grew did not end up using.
+    if (capacity_ > size_ * 2) {
+      char* data = UncheckedRealloc(data_, size_);
+      if (data != nullptr) data_ = data;
+    }
+    char* data = data_;
+    data_ = nullptr;
+    capacity_ = 0;
+    return Buffer::New(env_, data, size_);
+  }
+
+  size_t size() const { return size_; }
+
+  ValueSerializer* serializer = nullptr;
+
+ private:
+  Environment* env_;
+  size_t* size_hint_;
+  char* data_ = nullptr;
+  size_t capacity_ = 0;
+  size_t size_ = 0;
+};
+
+// Does what DefaultDeserializer in lib/v8.js does, without calling into JS.
+// Like there, the ArrayBufferViews that are read refer to the memory of the
+// input unless they would be misaligned in it.
+class OneShotDeserializerDelegate : public ValueDeserializer::Delegate {
+ public:
+  OneShotDeserializerDelegate(Environment* env, Local<ArrayBufferView> input)
+      : env_(env),
+        buffer_(input->Buffer()),
+        byte_offset_(input->ByteOffset()),
+        data_(static_cast<const uint8_t*>(buffer_->Data()) + byte_offset_),
+        length_(input->ByteLength()) {}
+
+  MaybeLocal<Object> ReadHostObject(Isolate* isolate) override {
+    uint32_t type;
+    uint32_t byte_length;
+    const void* bytes;
+    if (!deserializer->ReadUint32(&type) || type > kFastBuffer ||
+        !deserializer->ReadUint32(&byte_length) ||
+        !deserializer->ReadRawBytes(byte_length, &bytes)) {
+      env_->ThrowError("ReadHostObject() failed");
+      return MaybeLocal<Object>();
+    }
+
+    const size_t element_size = GetElementSize(type);
+    if (byte_length % element_size != 0) {
+      env_->ThrowRangeError("Invalid typed array length");
+      return MaybeLocal<Object>();
+    }
+
+    Local<ArrayBuffer> buffer = buffer_;
+    size_t offset =
+        byte_offset_ + (static_cast<const uint8_t*>(bytes) - data_);
+    if (offset % element_size != 0) {
+      NoArrayBufferZeroFillScope no_zero_fill_scope(env_->isolate_data());
+      std::unique_ptr<BackingStore> store =
+          ArrayBuffer::NewBackingStore(isolate, byte_length);
+      CHECK(store);
+      memcpy(store->Data(), bytes, byte_length);
+      buffer = ArrayBuffer::New(isolate, std::move(store));
+      offset = 0;
+    }
+
+    switch (type) {
+#define V(Type, element_size)                                                  \
+      case k##Type:                                                            \
+        return Type::New(buffer, offset, byte_length / (element_size));
+      SERIALIZED_ARRAY_BUFFER_VIEW_TYPES(V)
+#undef V
+      case kFastBuffer: {
+        Local<Uint8Array> ui;
+        if (!Buffer::New(env_, buffer, offset, byte_length).ToLocal(&ui))
+          return MaybeLocal<Object>();
+        return ui;
+      }
+    }
+    UNREACHABLE();
+  }
+
+  const uint8_t* data() const { return data_; }
+  size_t length() const { return length_; }
+
+  ValueDeserializer* deserializer = nullptr;
+
+ private:
+  Environment* env_;
+  Local<ArrayBuffer> buffer_;
+  const size_t byte_offset_;
+  const uint8_t* data_;
+  const size_t length_;
+};
+
+// serialize(value) does the same as v8.serialize(value).
+void Serialize(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  OneShotSerializerDelegate delegate(env, &serialize_size_hint);
+  if (delegate.Serialize(env->context(), args[0]).IsNothing()) return;
+
+  Local<Object> buffer;
+  if (delegate.ReleaseBuffer().ToLocal(&buffer))
+    args.GetReturnValue().Set(buffer);
+}
+
+// serializeBatch(values) returns [buffer, offsets], where the bytes between
+// offsets[i] and offsets[i + 1] of the buffer are v8.serialize(values[i]).
+void SerializeBatch(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+  Local<Context> context = env->context();
+
+  if (!args[0]->IsArray()) {
+    return node::THROW_ERR_INVALID_ARG_TYPE(env, "values must be an Array");
+  }
+  Local<Array> values = args[0].As<Array>();
+  const uint32_t count = values->Length();
+
+  Local<ArrayBuffer> offsets_buffer =
+      ArrayBuffer::New(isolate, (static_cast<size_t>(count) + 1) *
+                                    sizeof(double));
+  double* offsets = static_cast<double*>(offsets_buffer->Data());
+  OneShotSerializerDelegate delegate(env, &serialize_batch_size_hint);
+  for (uint32_t i = 0; i < count; i++) {
+    offsets[i] = static_cast<double>(delegate.size());
+    Local<Value> value;
+    if (!values->Get(context, i).ToLocal(&value) ||
+        delegate.Serialize(context, value).IsNothing()) {
+      return;
+    }
+  }
+  offsets[count] = static_cast<double>(delegate.size());
+
+  Local<Object> buffer;
+  if (!delegate.ReleaseBuffer().ToLocal(&buffer)) return;
+  Local<Value> ret[] = {
+    buffer,
+    Float64Array::New(offsets_buffer, 0, static_cast<size_t>(count) + 1)
+  };
+  args.GetReturnValue().Set(Array::New(isolate, ret, arraysize(ret)));
+}
+
+// deserialize(buffer) does the same as v8.deserialize(buffer).
+void Deserialize(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Local<Context> context = env->context();
+
+  if (!args[0]->IsArrayBufferView()) {
+    return node::THROW_ERR_INVALID_ARG_TYPE(
+        env, "buffer must be a TypedArray or a DataView");
+  }
+
+  OneShotDeserializerDelegate delegate(env, args[0].As<ArrayBufferView>());
+  ValueDeserializer deserializer(
+      env->isolate(), delegate.data(), delegate.length(), &delegate);
+  delegate.deserializer = &deserializer;
+
+  Local<Value> value;
+  if (deserializer.ReadHeader(context).IsNothing() ||
+      !deserializer.ReadValue(context).ToLocal(&value)) {
+    return;
+  }
+  args.GetReturnValue().Set(value);
+}
+
+}  // anonymous namespace
+
 void Initialize(Local<Object> target,
                 Local<Value> unused,
                 Local<Context> context,
@@ -509,6 +815,10 @@ void Initialize(Local<Object> target,
   des->SetLength(1);
   des->ReadOnlyPrototype();
   SetConstructorFunction(context, target, "Deserializer", des);
+
+  SetMethod(context, target, "serialize", Serialize);
+  SetMethod(context, target, "serializeBatch", SerializeBatch);
+  SetMethod(context, target, "deserialize", Deserialize);
 }
 
 void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
@@ -533,6 +843,10 @@ void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(DeserializerContext::ReadUint64);
   registry->Register(DeserializerContext::ReadDouble);
   registry->Register(DeserializerContext::ReadRawBytes);
+
+  registry->Register(Serialize);
+  registry->Register(SerializeBatch);
+  registry->Register(Deserialize);
 }
 
 }  // namespace serdes
@@ -4,31 +4,232 @@
 #include "node_errors.h"
 #include "node_external_reference.h"
 #include "node_i18n.h"
+#include "threadpoolwork-inl.h"
 #include "util-inl.h"
 #include "v8-fast-api-calls.h"
 #include "v8.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
+#include <memory>
 #include <numeric>
+#include <optional>
+#include <vector>
 
 namespace node {
 namespace url {
 
+using v8::Array;
+using v8::ArrayBuffer;
+using v8::ArrayBufferView;
+using v8::BackingStore;
 using v8::CFunction;
 using v8::Context;
 using v8::FastOneByteString;
+using v8::Function;
 using v8::FunctionCallbackInfo;
 using v8::FunctionTemplate;
+using v8::Global;
 using v8::HandleScope;
 using v8::Isolate;
 using v8::Local;
+using v8::MaybeLocal;
 using v8::NewStringType;
 using v8::Object;
 using v8::ObjectTemplate;
 using v8::String;
+using v8::Uint32Array;
 using v8::Value;
 
+namespace {
+
+// Writes the offsets of `components` and the scheme type to
+// out[offset, offset + kURLComponentsLength), in the order that
+// lib/internal/url.js expects.
+template <typename T>
+void WriteComponents(T&& out,
+                     size_t offset,
+                     const ada::url_components& components,
+                     const ada::scheme::type type) {
+  out[offset + 0] = components.protocol_end;
+  out[offset + 1] = components.username_end;
+  out[offset + 2] = components.host_start;
+  out[offset + 3] = components.host_end;
+  out[offset + 4] = components.port;
+  out[offset + 5] = components.pathname_start;
+  out[offset + 6] = components.search_start;
+  out[offset + 7] = components.hash_start;
+  out[offset + 8] = type;
+  static_assert(BindingData::kURLComponentsLength == 9,
+                "kURLComponentsLength should be up-to-date");
+}
+
+// A list of URLs that are parsed against the same base in one go, either
+// synchronously or on the threadpool. The inputs either point into the
+// caller's buffer or into `storage_`, so they must not be accessed from
+// another thread unless `Copy()` has been called.
+class URLBatch {
+ public:
+  URLBatch() = default;
+  URLBatch(const URLBatch&) = delete;
+  URLBatch& operator=(const URLBatch&) = delete;
+
+  // Adds each element of `array`, which must be strings. Returns false if an
+  // exception is pending.
+  bool AddArray(Environment* env, Local<Array> array) {
+    const uint32_t length = array->Length();
+    storage_.reserve(length);
+    for (uint32_t i = 0; i < length; i++) {
+      Local<Value> value;
+      if (!array->Get(env->context(), i).ToLocal(&value)) return false;
+      CHECK(value->IsString());
+      storage_.push_back(Utf8Value(env->isolate(), value).ToString());
+    }
+    // `storage_` no longer changes, so views into it stay valid.
+    inputs_.assign(storage_.begin(), storage_.end());
+    return true;
+  }
+
+  // Adds each line of `data`. A trailing newline does not start another
+  // input; a carriage return before the newline is removed by the URL
+  // parser along with other trailing C0 controls.
+  void AddLines(std::string_view data) {
+    while (!data.empty()) {
+      const char* newline =
+          static_cast<const char*>(memchr(data.data(), '\n', data.size()));
+      const size_t length =
+          newline == nullptr ? data.size() : newline - data.data();
+      inputs_.push_back(data.substr(0, length));
+      data.remove_prefix(std::min(length + 1, data.size()));
+    }
+  }
+
+  // Makes the batch own its inputs, so that the caller's buffer may change
+  // while the batch is parsed on another thread.
+  void Copy() {
+    if (!storage_.empty()) return;
+    size_t total = 0;
+    for (std::string_view input : inputs_) total += input.size();
+    std::string copy;
+    copy.reserve(total);
+    for (std::string_view input : inputs_) copy.append(input);
+    storage_.push_back(std::move(copy));
+    std::string_view rest = storage_.back();
+    for (std::string_view& input : inputs_) {
+      const size_t length = input.size();
+      input = rest.substr(0, length);
+      rest.remove_prefix(length);
+    }
+  }
+
+  // Returns false if `base` is not a valid URL, in which case the batch
+  // stays empty and ToJS() returns false.
+  bool SetBase(std::string_view base) {
+    auto out = ada::parse<ada::url_aggregator>(base);
+    if (!out) {
+      valid_base_ = false;
+      return false;
+    }
+    base_ = std::move(out.value());
+    return true;
+  }
+
+  // Allocates the component table. Must be called on the main thread.
+  void Allocate(Isolate* isolate) {
+    components_ = ArrayBuffer::NewBackingStore(
+        isolate,
+        inputs_.size() * BindingData::kURLComponentsLength * sizeof(uint32_t));
+    hrefs_.resize(inputs_.size());
+  }
+
+  // Does not touch V8 and may run on any thread.
+  void Parse() {
+    const ada::url_aggregator* base_pointer =
+        base_.has_value() ? &base_.value() : nullptr;
+    uint32_t* table = static_cast<uint32_t*>(components_->Data());
+    for (size_t i = 0; i < inputs_.size(); i++) {
+      const size_t offset = i * BindingData::kURLComponentsLength;
+      auto out = ada::parse<ada::url_aggregator>(inputs_[i], base_pointer);
+      if (!out) {
+        // A valid href is never empty, so the empty string marks a failure.
+        hrefs_[i].clear();
+        std::fill_n(table + offset, BindingData::kURLComponentsLength, 0);
+        continue;
+      }
+      WriteComponents(table, offset, out->get_components(), out->type);
+      hrefs_[i] = out->get_href();
+    }
+  }
+
+  // Returns `[hrefs, components]`, where `hrefs[i]` is the serialized URL or
+  // `false` if the i-th input could not be parsed, and
+  // `components.subarray(i * 9, i * 9 + 9)` holds its offsets in the layout
+  // of `urlComponents`. Returns false if the base was invalid.
+  MaybeLocal<Value> ToJS(Environment* env) {
+    Isolate* isolate = env->isolate();
+    if (!valid_base_) return v8::False(isolate);
+    Local<Context> context = env->context();
+    std::vector<Local<Value>> hrefs(hrefs_.size());
+    for (size_t i = 0; i < hrefs_.size(); i++) {
+      if (hrefs_[i].empty()) {
+        hrefs[i] = v8::False(isolate);
+      } else if (!ToV8Value(context, hrefs_[i], isolate).ToLocal(&hrefs[i])) {
+        return MaybeLocal<Value>();
+      }
+    }
+    const size_t length = components_->ByteLength() / sizeof(uint32_t);
+    Local<ArrayBuffer> buffer =
+        ArrayBuffer::New(isolate, std::move(components_));
+    Local<Value> result[] = {
+        Array::New(isolate, hrefs.data(), hrefs.size()),
+        Uint32Array::New(buffer, 0, length)};
+    return Array::New(isolate, result, arraysize(result));
+  }
+
+ private:
+  std::vector<std::string> storage_;
+  std::vector<std::string_view> inputs_;
+  std::optional<ada::url_aggregator> base_;
+  bool valid_base_ = true;
+  std::vector<std::string> hrefs_;
+  std::unique_ptr<BackingStore> components_;
+};
+
+class ParseBatchWork final : public AsyncResource, public ThreadPoolWork {
+ public:
+  ParseBatchWork(Environment* env,
+                 Local<Function> callback,
+                 std::unique_ptr<URLBatch> batch)
+      : AsyncResource(
+            env->isolate(), Object::New(env->isolate()), "URLPARSEBATCH"),
+        ThreadPoolWork(env, "url_parse_batch"),
+        callback_(env->isolate(), callback),
+        batch_(std::move(batch)) {}
+
+  void DoThreadPoolWork() override { batch_->Parse(); }
+
+  void AfterThreadPoolWork(int status) override {
+    std::unique_ptr<ParseBatchWork> self(this);
+    Environment* env = this->env();
+    HandleScope handle_scope(env->isolate());
+    Context::Scope context_scope(env->context());
+    // The work is only cancelled when the environment is torn down.
+    if (status == UV_ECANCELED) return;
+    CHECK_EQ(status, 0);
+    Local<Value> result;
+    if (!batch_->ToJS(env).ToLocal(&result)) return;
+    MakeCallback(callback_.Get(env->isolate()), 1, &result);
+  }
+
+ private:
+  Global<Function> callback_;
+  std::unique_ptr<URLBatch> batch_;
+};
+
+}  // anonymous namespace
+
 void BindingData::MemoryInfo(MemoryTracker* tracker) const {
   tracker->TrackField("url_components_buffer", url_components_buffer_);
 }
@@ -234,6 +435,49 @@ void BindingData::Parse(const FunctionCallbackInfo<Value>& args) {
           .ToLocalChecked());
 }
 
+// parseBatch(input, base[, callback]) parses many URLs with a single call
+// into C++. `input` is either an array of strings or an ArrayBufferView of
+// newline-separated UTF-8 URLs, and `base` is a string or undefined. Without a
+// callback, this returns the `[hrefs, components]` pair described in
+// URLBatch::ToJS(). With one, the URLs are parsed on the threadpool and the
+// pair is passed to `callback` instead. If `base` is invalid, the result is
+// false, and it is passed to `callback` asynchronously as well.
+void BindingData::ParseBatch(const FunctionCallbackInfo<Value>& args) {
+  CHECK_GE(args.Length(), 2);
+  CHECK(args[0]->IsArray() || args[0]->IsArrayBufferView());  // input
+  CHECK(args[1]->IsString() || args[1]->IsUndefined());      // base url
+
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+  const bool async = args.Length() > 2 && args[2]->IsFunction();
+
+  auto batch = std::make_unique<URLBatch>();
+  if (args[1]->IsString() &&
+      !batch->SetBase(Utf8Value(isolate, args[1]).ToStringView())) {
+    // With a callback, an invalid base is reported through the callback
+    // too, so that it is always called asynchronously.
+    if (!async) return args.GetReturnValue().Set(false);
+  } else if (args[0]->IsArray()) {
+    if (!batch->AddArray(env, args[0].As<Array>())) return;
+  } else {
+    ArrayBufferViewContents<char> buffer(args[0]);
+    batch->AddLines(std::string_view(buffer.data(), buffer.length()));
+    if (async) batch->Copy();
+  }
+  batch->Allocate(isolate);
+
+  if (async) {
+    auto* work =
+        new ParseBatchWork(env, args[2].As<Function>(), std::move(batch));
+    work->ScheduleWork();
+    return;
+  }
+
+  batch->Parse();
+  Local<Value> result;
+  if (batch->ToJS(env).ToLocal(&result)) args.GetReturnValue().Set(result);
+}
+
 void BindingData::Update(const FunctionCallbackInfo<Value>& args) {
   CHECK(args[0]->IsString());    // href
   CHECK(args[1]->IsNumber());    // action type
@@ -311,17 +555,7 @@ void BindingData::Update(const FunctionCallbackInfo<Value>& args) {
 
 void BindingData::UpdateComponents(const ada::url_components& components,
                                    const ada::scheme::type type) {
-  url_components_buffer_[0] = components.protocol_end;
-  url_components_buffer_[1] = components.username_end;
-  url_components_buffer_[2] = components.host_start;
-  url_components_buffer_[3] = components.host_end;
-  url_components_buffer_[4] = components.port;
-  url_components_buffer_[5] = components.pathname_start;
-  url_components_buffer_[6] = components.search_start;
-  url_components_buffer_[7] = components.hash_start;
-  url_components_buffer_[8] = type;
-  static_assert(kURLComponentsLength == 9,
-                "kURLComponentsLength should be up-to-date");
+  WriteComponents(url_components_buffer_, 0, components, type);
 }
 
 void BindingData::CreatePerIsolateProperties(IsolateData* isolate_data,
@@ -332,6 +566,7 @@ void BindingData::CreatePerIsolateProperties(IsolateData* isolate_data,
   SetMethodNoSideEffect(isolate, target, "domainToUnicode", DomainToUnicode);
   SetMethodNoSideEffect(isolate, target, "format", Format);
   SetMethod(isolate, target, "parse", Parse);
+  SetMethod(isolate, target, "parseBatch", ParseBatch);
   SetMethod(isolate, target, "update", Update);
   SetFastMethodNoSideEffect(
       isolate, target, "canParse", CanParse, &fast_can_parse_);
@@ -351,6 +586,7 @@ void BindingData::RegisterExternalReferences(
   registry->Register(DomainToUnicode);
   registry->Register(Format);
   registry->Register(Parse);
+  registry->Register(ParseBatch);
   registry->Register(Update);
   registry->Register(CanParse);
   registry->Register(FastCanParse);
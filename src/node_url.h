@@ -38,6 +38,10 @@ class BindingData : public SnapshotableObject {
 
   using InternalFieldInfo = InternalFieldInfoBase;
 
+  // Number of entries per URL in the `urlComponents` array and in the
+  // component tables returned by `parseBatch()`.
+  static constexpr size_t kURLComponentsLength = 9;
+
   SERIALIZABLE_OBJECT_METHODS()
   SET_BINDING_ID(url_binding_data)
 
@@ -54,6 +58,7 @@ class BindingData : public SnapshotableObject {
 
   static void Format(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Parse(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void ParseBatch(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Update(const v8::FunctionCallbackInfo<v8::Value>& args);
 
   static void CreatePerIsolateProperties(IsolateData* isolate_data,
@@ -65,7 +70,6 @@ class BindingData : public SnapshotableObject {
   static void RegisterExternalReferences(ExternalReferenceRegistry* registry);
 
  private:
-  static constexpr size_t kURLComponentsLength = 9;
   AliasedUint32Array url_components_buffer_;
 
   void UpdateComponents(const ada::url_components& components,
@@ -6,6 +6,7 @@
 #include <memory>
 
 #include "env-inl.h"
+#include "large_pages/node_large_page.h"
 #include "node.h"
 #include "node_metadata.h"
 #include "node_platform.h"
@@ -100,7 +101,9 @@ struct V8Platform {
       StartTracingAgent();
     }
     // Tracing must be initialized before platform threads are created.
-    platform_ = new NodePlatform(thread_pool_size, controller);
+    platform_ = new NodePlatform(thread_pool_size,
+                                 controller,
+                                 large_pages::GetDataPageAllocator());
     v8::V8::InitializePlatform(platform_);
   }
   // Make sure V8Platform don not call into Libuv threadpool,
@@ -3,6 +3,7 @@
 #include "debug_utils-inl.h"
 #include "memory_tracker-inl.h"
 #include "node_mem-inl.h"
+#include "threadpoolwork-inl.h"
 #include "util-inl.h"
 #include "node.h"
 #include "node_errors.h"
@@ -25,8 +26,37 @@ inline void Debug(const WASI& wasi, Args&&... args) {
     }                                                                          \
   } while (0)
 
+namespace {
+// Enough for the scatter/gather lists that libc and most runtimes emit
+// without touching the heap.
+template <typename T>
+using IovecBuffer = MaybeStackBuffer<T, 16>;
+
+// Translates the guest's iovec array into host iovecs. Only the descriptors
+// need converting (the guest's are two 32-bit words); the buffers they
+// describe are read into and written from in place.
+inline uvwasi_errno_t ReadIovecs(WasmMemory memory,
+                                 uint32_t iovs_ptr,
+                                 uint32_t iovs_len,
+                                 IovecBuffer<uvwasi_iovec_t>* iovs) {
+  iovs->AllocateSufficientStorage(iovs_len);
+  return uvwasi_serdes_readv_iovec_t(
+      memory.data, memory.size, iovs_ptr, iovs->out(), iovs_len);
+}
+
+inline uvwasi_errno_t ReadIovecs(WasmMemory memory,
+                                 uint32_t iovs_ptr,
+                                 uint32_t iovs_len,
+                                 IovecBuffer<uvwasi_ciovec_t>* iovs) {
+  iovs->AllocateSufficientStorage(iovs_len);
+  return uvwasi_serdes_readv_ciovec_t(
+      memory.data, memory.size, iovs_ptr, iovs->out(), iovs_len);
+}
+}  // namespace
+
 using v8::Array;
 using v8::ArrayBuffer;
+using v8::BackingStore;
 using v8::BigInt;
 using v8::CFunction;
 using v8::Context;
@@ -34,11 +64,14 @@ using v8::Exception;
 using v8::FastApiCallbackOptions;
 using v8::FunctionCallbackInfo;
 using v8::FunctionTemplate;
+using v8::Global;
+using v8::HandleScope;
 using v8::Integer;
 using v8::Isolate;
 using v8::Local;
 using v8::MaybeLocal;
 using v8::Object;
+using v8::Promise;
 using v8::Signature;
 using v8::String;
 using v8::Uint32;
@@ -78,7 +111,9 @@ WASI::WASI(Environment* env,
            Local<Object> object,
            uvwasi_options_t* options) : BaseObject(env, object) {
   MakeWeak();
-  alloc_info_ = MakeAllocator();
+  owner_thread_ = uv_thread_self();
+  tracked_alloc_info_ = MakeAllocator();
+  alloc_info_ = {this, UvwasiMalloc, UvwasiFree, UvwasiCalloc, UvwasiRealloc};
   options->allocator = &alloc_info_;
   int err = uvwasi_init(&uvw_, options);
   if (err != UVWASI_ESUCCESS) {
@@ -113,6 +148,50 @@ void WASI::DecreaseAllocatedSize(size_t size) {
   current_uvwasi_memory_ -= size;
 }
 
+bool WASI::IsOwnerThread() const {
+  uv_thread_t self = uv_thread_self();
+  return uv_thread_equal(&self, &owner_thread_) != 0;
+}
+
+// Blocks allocated off the owning thread get a zero size header, which
+// NgLibMemoryManager treats as untracked, so they may be released on either
+// thread. Tracked blocks are only ever freed on the owning thread.
+void* WASI::UvwasiRealloc(void* ptr, size_t size, void* user_data) {
+  WASI* wasi = static_cast<WASI*>(user_data);
+  if (wasi->IsOwnerThread()) {
+    return wasi->tracked_alloc_info_.realloc(
+        ptr, size, wasi->tracked_alloc_info_.mem_user_data);
+  }
+
+  char* original_ptr = nullptr;
+  if (ptr != nullptr) {
+    original_ptr = static_cast<char*>(ptr) - sizeof(size_t);
+    CHECK_EQ(*reinterpret_cast<size_t*>(original_ptr), 0);
+  }
+  if (size > 0) size += sizeof(size_t);
+  char* mem = UncheckedRealloc(original_ptr, size);
+  if (mem == nullptr) return nullptr;
+  *reinterpret_cast<size_t*>(mem) = 0;
+  return mem + sizeof(size_t);
+}
+
+void* WASI::UvwasiMalloc(size_t size, void* user_data) {
+  return UvwasiRealloc(nullptr, size, user_data);
+}
+
+void WASI::UvwasiFree(void* ptr, void* user_data) {
+  if (ptr == nullptr) return;
+  CHECK_NULL(UvwasiRealloc(ptr, 0, user_data));
+}
+
+void* WASI::UvwasiCalloc(size_t nmemb, size_t size, void* user_data) {
+  size_t real_size = MultiplyWithOverflowCheck(nmemb, size);
+  void* mem = UvwasiMalloc(real_size, user_data);
+  if (mem != nullptr)
+    memset(mem, 0, real_size);
+  return mem;
+}
+
 void WASI::New(const FunctionCallbackInfo<Value>& args) {
   CHECK(args.IsConstructCall());
   CHECK_EQ(args.Length(), 4);
@@ -536,6 +615,7 @@ uint32_t WASI::FdAllocate(
 
 uint32_t WASI::FdClose(WASI& wasi, WasmMemory, uint32_t fd) {
   Debug(wasi, "fd_close(%d)\n", fd);
+  if (wasi.async_io_fds_.count(fd) != 0) return UVWASI_EBUSY;
   return uvwasi_fd_close(&wasi.uvw_, fd);
 }
 
@@ -637,17 +717,14 @@ uint32_t WASI::FdPread(WASI& wasi,
   CHECK_BOUNDS_OR_RETURN(
       memory.size, iovs_ptr, iovs_len * UVWASI_SERDES_SIZE_iovec_t);
   CHECK_BOUNDS_OR_RETURN(memory.size, nread_ptr, UVWASI_SERDES_SIZE_size_t);
-  std::vector<uvwasi_iovec_t> iovs(iovs_len);
-  uvwasi_errno_t err;
-
-  err = uvwasi_serdes_readv_iovec_t(
-      memory.data, memory.size, iovs_ptr, iovs.data(), iovs_len);
+  IovecBuffer<uvwasi_iovec_t> iovs;
+  uvwasi_errno_t err = ReadIovecs(memory, iovs_ptr, iovs_len, &iovs);
   if (err != UVWASI_ESUCCESS) {
     return err;
   }
 
   uvwasi_size_t nread;
-  err = uvwasi_fd_pread(&wasi.uvw_, fd, iovs.data(), iovs_len, offset, &nread);
+  err = uvwasi_fd_pread(&wasi.uvw_, fd, iovs.out(), iovs_len, offset, &nread);
   if (err == UVWASI_ESUCCESS)
     uvwasi_serdes_write_size_t(memory.data, nread_ptr, nread);
 
@@ -697,18 +774,15 @@ uint32_t WASI::FdPwrite(WASI& wasi,
   CHECK_BOUNDS_OR_RETURN(
       memory.size, iovs_ptr, iovs_len * UVWASI_SERDES_SIZE_ciovec_t);
   CHECK_BOUNDS_OR_RETURN(memory.size, nwritten_ptr, UVWASI_SERDES_SIZE_size_t);
-  std::vector<uvwasi_ciovec_t> iovs(iovs_len);
-  uvwasi_errno_t err;
-
-  err = uvwasi_serdes_readv_ciovec_t(
-      memory.data, memory.size, iovs_ptr, iovs.data(), iovs_len);
+  IovecBuffer<uvwasi_ciovec_t> iovs;
+  uvwasi_errno_t err = ReadIovecs(memory, iovs_ptr, iovs_len, &iovs);
   if (err != UVWASI_ESUCCESS) {
     return err;
   }
 
   uvwasi_size_t nwritten;
   err = uvwasi_fd_pwrite(
-      &wasi.uvw_, fd, iovs.data(), iovs_len, offset, &nwritten);
+      &wasi.uvw_, fd, iovs.out(), iovs_len, offset, &nwritten);
   if (err == UVWASI_ESUCCESS)
     uvwasi_serdes_write_size_t(memory.data, nwritten_ptr, nwritten);
 
@@ -725,17 +799,14 @@ uint32_t WASI::FdRead(WASI& wasi,
   CHECK_BOUNDS_OR_RETURN(
       memory.size, iovs_ptr, iovs_len * UVWASI_SERDES_SIZE_iovec_t);
   CHECK_BOUNDS_OR_RETURN(memory.size, nread_ptr, UVWASI_SERDES_SIZE_size_t);
-  std::vector<uvwasi_iovec_t> iovs(iovs_len);
-  uvwasi_errno_t err;
-
-  err = uvwasi_serdes_readv_iovec_t(
-      memory.data, memory.size, iovs_ptr, iovs.data(), iovs_len);
+  IovecBuffer<uvwasi_iovec_t> iovs;
+  uvwasi_errno_t err = ReadIovecs(memory, iovs_ptr, iovs_len, &iovs);
   if (err != UVWASI_ESUCCESS) {
     return err;
   }
 
   uvwasi_size_t nread;
-  err = uvwasi_fd_read(&wasi.uvw_, fd, iovs.data(), iovs_len, &nread);
+  err = uvwasi_fd_read(&wasi.uvw_, fd, iovs.out(), iovs_len, &nread);
   if (err == UVWASI_ESUCCESS)
     uvwasi_serdes_write_size_t(memory.data, nread_ptr, nread);
 
@@ -769,6 +840,8 @@ uint32_t WASI::FdReaddir(WASI& wasi,
 
 uint32_t WASI::FdRenumber(WASI& wasi, WasmMemory, uint32_t from, uint32_t to) {
   Debug(wasi, "fd_renumber(%d, %d)\n", from, to);
+  if (wasi.async_io_fds_.count(from) != 0 || wasi.async_io_fds_.count(to) != 0)
+    return UVWASI_EBUSY;
   return uvwasi_fd_renumber(&wasi.uvw_, from, to);
 }
 
@@ -826,17 +899,14 @@ uint32_t WASI::FdWrite(WASI& wasi,
   CHECK_BOUNDS_OR_RETURN(
       memory.size, iovs_ptr, iovs_len * UVWASI_SERDES_SIZE_ciovec_t);
   CHECK_BOUNDS_OR_RETURN(memory.size, nwritten_ptr, UVWASI_SERDES_SIZE_size_t);
-  std::vector<uvwasi_ciovec_t> iovs(iovs_len);
-  uvwasi_errno_t err;
-
-  err = uvwasi_serdes_readv_ciovec_t(
-      memory.data, memory.size, iovs_ptr, iovs.data(), iovs_len);
+  IovecBuffer<uvwasi_ciovec_t> iovs;
+  uvwasi_errno_t err = ReadIovecs(memory, iovs_ptr, iovs_len, &iovs);
   if (err != UVWASI_ESUCCESS) {
     return err;
   }
 
   uvwasi_size_t nwritten;
-  err = uvwasi_fd_write(&wasi.uvw_, fd, iovs.data(), iovs_len, &nwritten);
+  err = uvwasi_fd_write(&wasi.uvw_, fd, iovs.out(), iovs_len, &nwritten);
   if (err == UVWASI_ESUCCESS)
     uvwasi_serdes_write_size_t(memory.data, nwritten_ptr, nwritten);
 
@@ -1183,9 +1253,8 @@ uint32_t WASI::SockRecv(WASI& wasi,
       memory.size, ri_data_ptr, ri_data_len * UVWASI_SERDES_SIZE_iovec_t);
   CHECK_BOUNDS_OR_RETURN(memory.size, ro_datalen_ptr, 4);
   CHECK_BOUNDS_OR_RETURN(memory.size, ro_flags_ptr, 4);
-  std::vector<uvwasi_iovec_t> ri_data(ri_data_len);
-  uvwasi_errno_t err = uvwasi_serdes_readv_iovec_t(
-      memory.data, memory.size, ri_data_ptr, ri_data.data(), ri_data_len);
+  IovecBuffer<uvwasi_iovec_t> ri_data;
+  uvwasi_errno_t err = ReadIovecs(memory, ri_data_ptr, ri_data_len, &ri_data);
   if (err != UVWASI_ESUCCESS) {
     return err;
   }
@@ -1194,7 +1263,7 @@ uint32_t WASI::SockRecv(WASI& wasi,
   uvwasi_roflags_t ro_flags;
   err = uvwasi_sock_recv(&wasi.uvw_,
                          sock,
-                         ri_data.data(),
+                         ri_data.out(),
                          ri_data_len,
                          ri_flags,
                          &ro_datalen,
@@ -1225,16 +1294,15 @@ uint32_t WASI::SockSend(WASI& wasi,
       memory.size, si_data_ptr, si_data_len * UVWASI_SERDES_SIZE_ciovec_t);
   CHECK_BOUNDS_OR_RETURN(
       memory.size, so_datalen_ptr, UVWASI_SERDES_SIZE_size_t);
-  std::vector<uvwasi_ciovec_t> si_data(si_data_len);
-  uvwasi_errno_t err = uvwasi_serdes_readv_ciovec_t(
-      memory.data, memory.size, si_data_ptr, si_data.data(), si_data_len);
+  IovecBuffer<uvwasi_ciovec_t> si_data;
+  uvwasi_errno_t err = ReadIovecs(memory, si_data_ptr, si_data_len, &si_data);
   if (err != UVWASI_ESUCCESS) {
     return err;
   }
 
   uvwasi_size_t so_datalen;
   err = uvwasi_sock_send(
-      &wasi.uvw_, sock, si_data.data(), si_data_len, si_flags, &so_datalen);
+      &wasi.uvw_, sock, si_data.out(), si_data_len, si_flags, &so_datalen);
   if (err == UVWASI_ESUCCESS)
     uvwasi_serdes_write_size_t(memory.data, so_datalen_ptr, so_datalen);
 
@@ -1249,6 +1317,189 @@ uint32_t WASI::SockShutdown(WASI& wasi,
   return uvwasi_sock_shutdown(&wasi.uvw_, sock, how);
 }
 
+// Runs one fd_read, fd_pread, fd_write or fd_pwrite on the threadpool. The
+// iovecs are translated on the main thread and point straight into the
+// instance's memory, whose backing store is kept alive until the call is
+// done so that a memory.grow() in the meantime cannot free it from under us.
+// uvwasi holds the descriptor's lock for the duration of the call, so other
+// calls on the same fd wait for it to finish. The fd is recorded in
+// async_io_fds_ meanwhile, so that fd_close and fd_renumber, which would
+// wait while holding the lock of the whole table, can fail instead.
+class WASI::FdIOWork final : public ThreadPoolWork {
+ public:
+  enum Kind { kRead, kPread, kWrite, kPwrite };
+
+  static void Start(const FunctionCallbackInfo<Value>& args, Kind kind);
+
+  void DoThreadPoolWork() override;
+  void AfterThreadPoolWork(int status) override;
+
+ private:
+  FdIOWork(Environment* env,
+           WASI* wasi,
+           Kind kind,
+           Local<Promise::Resolver> resolver)
+      : ThreadPoolWork(env, "wasi"),
+        wasi_(wasi),
+        uvw_(&wasi->uvw_),
+        kind_(kind),
+        memory_(env->isolate(), PersistentToLocal::Strong(wasi->memory_)),
+        resolver_(env->isolate(), resolver) {}
+
+  bool is_read() const { return kind_ == kRead || kind_ == kPread; }
+
+  uvwasi_errno_t Prepare(const FunctionCallbackInfo<Value>& args);
+  void CopyIntoMovedMemory(char* data) const;
+
+  BaseObjectPtr<WASI> wasi_;
+  uvwasi_t* uvw_;
+  Kind kind_;
+  Global<WasmMemoryObject> memory_;
+  Global<Promise::Resolver> resolver_;
+  std::shared_ptr<BackingStore> backing_store_;
+  uint32_t fd_ = 0;
+  uint64_t offset_ = 0;
+  uint32_t result_ptr_ = 0;
+  IovecBuffer<uvwasi_iovec_t> iovs_;
+  IovecBuffer<uvwasi_ciovec_t> ciovs_;
+  uvwasi_errno_t err_ = UVWASI_ESUCCESS;
+  uvwasi_size_t result_ = 0;
+};
+
+void WASI::FdIOWork::Start(const FunctionCallbackInfo<Value>& args,
+                           Kind kind) {
+  Environment* env = Environment::GetCurrent(args);
+  WASI* wasi;
+  ASSIGN_OR_RETURN_UNWRAP(&wasi, args.This());
+  if (wasi->memory_.IsEmpty()) {
+    THROW_ERR_WASI_NOT_STARTED(env);
+    return;
+  }
+
+  Local<Promise::Resolver> resolver;
+  if (!Promise::Resolver::New(env->context()).ToLocal(&resolver)) return;
+  args.GetReturnValue().Set(resolver->GetPromise());
+
+  auto work = std::unique_ptr<FdIOWork>(
+      new FdIOWork(env, wasi, kind, resolver));
+  uvwasi_errno_t err = work->Prepare(args);
+  if (err == UVWASI_ESUCCESS) {
+    wasi->async_io_fds_.insert(work->fd_);
+    work.release()->ScheduleWork();
+    return;
+  }
+  USE(resolver->Resolve(env->context(),
+                        Integer::NewFromUnsigned(env->isolate(), err)));
+}
+
+uvwasi_errno_t WASI::FdIOWork::Prepare(
+    const FunctionCallbackInfo<Value>& args) {
+  const bool positional = kind_ == kPread || kind_ == kPwrite;
+  const int argc = positional ? 5 : 4;
+  if (args.Length() != argc || !CheckType<uint32_t>(args[0]) ||
+      !CheckType<uint32_t>(args[1]) || !CheckType<uint32_t>(args[2]) ||
+      (positional && !CheckType<uint64_t>(args[3])) ||
+      !CheckType<uint32_t>(args[argc - 1])) {
+    return UVWASI_EINVAL;
+  }
+  fd_ = ConvertType<uint32_t>(args[0]);
+  const uint32_t iovs_ptr = ConvertType<uint32_t>(args[1]);
+  const uint32_t iovs_len = ConvertType<uint32_t>(args[2]);
+  if (positional) offset_ = ConvertType<uint64_t>(args[3]);
+  result_ptr_ = ConvertType<uint32_t>(args[argc - 1]);
+
+  backing_store_ =
+      PersistentToLocal::Strong(memory_)->Buffer()->GetBackingStore();
+  WasmMemory memory{static_cast<char*>(backing_store_->Data()),
+                    backing_store_->ByteLength()};
+  CHECK_NOT_NULL(memory.data);
+
+  Debug(*wasi_,
+        "%s_async(%d, %d, %d, %d)\n",
+        is_read() ? "fd_read" : "fd_write",
+        fd_,
+        iovs_ptr,
+        iovs_len,
+        result_ptr_);
+  CHECK_BOUNDS_OR_RETURN(
+      memory.size, iovs_ptr, iovs_len * UVWASI_SERDES_SIZE_iovec_t);
+  CHECK_BOUNDS_OR_RETURN(memory.size, result_ptr_, UVWASI_SERDES_SIZE_size_t);
+  if (is_read()) return ReadIovecs(memory, iovs_ptr, iovs_len, &iovs_);
+  return ReadIovecs(memory, iovs_ptr, iovs_len, &ciovs_);
+}
+
+void WASI::FdIOWork::DoThreadPoolWork() {
+  switch (kind_) {
+    case kRead:
+      err_ = uvwasi_fd_read(uvw_, fd_, iovs_.out(), iovs_.length(), &result_);
+      break;
+    case kPread:
+      err_ = uvwasi_fd_pread(
+          uvw_, fd_, iovs_.out(), iovs_.length(), offset_, &result_);
+      break;
+    case kWrite:
+      err_ =
+          uvwasi_fd_write(uvw_, fd_, ciovs_.out(), ciovs_.length(), &result_);
+      break;
+    case kPwrite:
+      err_ = uvwasi_fd_pwrite(
+          uvw_, fd_, ciovs_.out(), ciovs_.length(), offset_, &result_);
+      break;
+  }
+}
+
+// If the memory was grown and moved while a read was in flight, the guest
+// can only see the new copy, so carry over what the read stored in the old
+// one. Memories never shrink, so every offset is still in bounds.
+void WASI::FdIOWork::CopyIntoMovedMemory(char* data) const {
+  const char* old_data = static_cast<const char*>(backing_store_->Data());
+  size_t remaining = result_;
+  for (size_t i = 0; i < iovs_.length() && remaining > 0; i++) {
+    const char* buf = static_cast<const char*>(iovs_[i].buf);
+    const size_t length = std::min<size_t>(remaining, iovs_[i].buf_len);
+    memcpy(data + (buf - old_data), buf, length);
+    remaining -= length;
+  }
+}
+
+void WASI::FdIOWork::AfterThreadPoolWork(int status) {
+  std::unique_ptr<FdIOWork> self(this);
+  CHECK(status == 0 || status == UV_ECANCELED);
+  wasi_->async_io_fds_.erase(wasi_->async_io_fds_.find(fd_));
+  Environment* env = this->env();
+  if (!env->can_call_into_js()) return;
+
+  HandleScope handle_scope(env->isolate());
+  Context::Scope context_scope(env->context());
+  uvwasi_errno_t err = status == 0 ? err_ : UVWASI_ECANCELED;
+  if (err == UVWASI_ESUCCESS) {
+    std::shared_ptr<BackingStore> current =
+        PersistentToLocal::Strong(memory_)->Buffer()->GetBackingStore();
+    char* data = static_cast<char*>(current->Data());
+    if (is_read() && data != backing_store_->Data()) CopyIntoMovedMemory(data);
+    uvwasi_serdes_write_size_t(data, result_ptr_, result_);
+  }
+  Local<Promise::Resolver> resolver = resolver_.Get(env->isolate());
+  USE(resolver->Resolve(env->context(),
+                        Integer::NewFromUnsigned(env->isolate(), err)));
+}
+
+void WASI::FdReadAsync(const FunctionCallbackInfo<Value>& args) {
+  FdIOWork::Start(args, FdIOWork::kRead);
+}
+
+void WASI::FdPreadAsync(const FunctionCallbackInfo<Value>& args) {
+  FdIOWork::Start(args, FdIOWork::kPread);
+}
+
+void WASI::FdWriteAsync(const FunctionCallbackInfo<Value>& args) {
+  FdIOWork::Start(args, FdIOWork::kWrite);
+}
+
+void WASI::FdPwriteAsync(const FunctionCallbackInfo<Value>& args) {
+  FdIOWork::Start(args, FdIOWork::kPwrite);
+}
+
 void WASI::_SetMemory(const FunctionCallbackInfo<Value>& args) {
   WASI* wasi;
   ASSIGN_OR_RETURN_UNWRAP(&wasi, args.This());
@@ -1323,6 +1574,10 @@ static void InitializePreview1(Local<Object> target,
   V(SockShutdown, "sock_shutdown")
 #undef V
 
+  SetProtoMethod(isolate, tmpl, "fd_read_async", WASI::FdReadAsync);
+  SetProtoMethod(isolate, tmpl, "fd_pread_async", WASI::FdPreadAsync);
+  SetProtoMethod(isolate, tmpl, "fd_write_async", WASI::FdWriteAsync);
+  SetProtoMethod(isolate, tmpl, "fd_pwrite_async", WASI::FdPwriteAsync);
   SetInstanceMethod(isolate, tmpl, "_setMemory", WASI::_SetMemory);
 
   SetConstructorFunction(context, target, "WASI", tmpl);
@@ -5,9 +5,12 @@
 
 #include "base_object.h"
 #include "node_mem.h"
+#include "uv.h"
 #include "uvwasi.h"
 #include "v8-fast-api-calls.h"
 
+#include <unordered_set>
+
 namespace node {
 namespace wasi {
 
@@ -144,6 +147,18 @@ class WASI : public BaseObject,
       WASI&, WasmMemory, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t);
   static uint32_t SockShutdown(WASI&, WasmMemory, uint32_t, uint32_t);
 
+  // fd_read, fd_pread, fd_write and fd_pwrite, run on the threadpool. They
+  // take the same arguments as the synchronous versions and return a Promise
+  // that resolves to the errno. The guest's buffers are used in place, so the
+  // guest must be suspended (e.g. through JSPI) until the Promise settles.
+  // uvwasi locks the descriptor for the whole call, so synchronous calls on
+  // it block the event loop until the call is done. fd_close and fd_renumber
+  // would also block every other call, and fail with EBUSY instead.
+  static void FdReadAsync(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void FdPreadAsync(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void FdWriteAsync(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void FdPwriteAsync(const v8::FunctionCallbackInfo<v8::Value>& args);
+
   static void _SetMemory(const v8::FunctionCallbackInfo<v8::Value>& args);
 
   // Implementation for mem::NgLibMemoryManager
@@ -168,11 +183,27 @@ class WASI : public BaseObject,
   };
 
  private:
+  class FdIOWork;
+
   ~WASI() override;
+
+  // uvwasi allocates from the threadpool during the async calls above, where
+  // the isolate must not be touched. These forward to the tracking allocator
+  // on the owning thread and hand out untracked blocks elsewhere.
+  static void* UvwasiMalloc(size_t size, void* user_data);
+  static void UvwasiFree(void* ptr, void* user_data);
+  static void* UvwasiCalloc(size_t nmemb, size_t size, void* user_data);
+  static void* UvwasiRealloc(void* ptr, size_t size, void* user_data);
+  bool IsOwnerThread() const;
+
   uvwasi_t uvw_;
   v8::Global<v8::WasmMemoryObject> memory_;
   uvwasi_mem_t alloc_info_;
+  uvwasi_mem_t tracked_alloc_info_;
+  uv_thread_t owner_thread_;
   size_t current_uvwasi_memory_ = 0;
+  // Descriptors with a call from above in flight, once per call.
+  std::unordered_multiset<uint32_t> async_io_fds_;
 };
 
 
@@ -7,8 +7,13 @@
 #include <limits.h>
 #include <stdlib.h>
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
 #include <filesystem>
+#include <functional>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace {
@@ -48,6 +53,65 @@ void FreeRecursivelyNode(
   delete node;
 }
 
+// Remembers the outcome of recent lookups on this thread, since fs calls tend
+// to hit the same few paths over and over. It is two-way set associative:
+// the hash of a path selects a set, and a miss replaces the least recently
+// used of its two entries. Entries are tied to a tree generation, so a tree
+// that changed or was replaced never sees stale results.
+class LookupCache {
+ public:
+  bool Get(uint64_t generation,
+           const std::string_view& path,
+           size_t hash,
+           bool* granted) {
+    Set& set = sets_[hash % kSets];
+    for (size_t way = 0; way < 2; way++) {
+      const Entry& entry = set.entries[way];
+      if (entry.generation == generation && entry.hash == hash &&
+          entry.path == path) {
+        set.lru = 1 - way;
+        *granted = entry.granted;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void Put(uint64_t generation,
+           const std::string_view& path,
+           size_t hash,
+           bool granted) {
+    Set& set = sets_[hash % kSets];
+    Entry& entry = set.entries[set.lru];
+    set.lru = 1 - set.lru;
+    entry.generation = generation;
+    entry.hash = hash;
+    entry.path.assign(path.data(), path.size());
+    entry.granted = granted;
+  }
+
+ private:
+  static constexpr size_t kSets = 32;
+
+  struct Entry {
+    uint64_t generation = 0;  // Generations start at 1.
+    size_t hash = 0;
+    std::string path;
+    bool granted = false;
+  };
+
+  struct Set {
+    Entry entries[2];
+    size_t lru = 0;
+  };
+
+  std::array<Set, kSets> sets_;
+};
+
+thread_local LookupCache lookup_cache;
+
+std::atomic<uint64_t> next_tree_generation{1};
+
 bool is_tree_granted(node::permission::FSPermission::RadixTree* granted_tree,
                      const std::string_view& param) {
 #ifdef _WIN32
@@ -118,42 +182,139 @@ bool FSPermission::is_granted(PermissionScope perm,
   }
 }
 
-FSPermission::RadixTree::RadixTree() : root_node_(new Node("")) {}
+FSPermission::RadixTree::RadixTree() : root_node_(new Node("")) {
+  Compile();
+}
 
 FSPermission::RadixTree::~RadixTree() {
   FreeRecursivelyNode(root_node_);
 }
 
-bool FSPermission::RadixTree::Lookup(const std::string_view& s,
-                                     bool when_empty_return = false) {
-  FSPermission::RadixTree::Node* current_node = root_node_;
-  if (current_node->children.size() == 0) {
-    return when_empty_return;
+void FSPermission::RadixTree::Compile() {
+  nodes_.clear();
+  prefixes_.clear();
+  std::vector<const Node*> queue = {root_node_};
+  nodes_.push_back(FlatNode{});
+  for (size_t i = 0; i < queue.size(); i++) {
+    const Node* node = queue[i];
+    // Entries with a null child are left behind by lookups of the label in
+    // the map; they are not real children.
+    std::vector<std::pair<char, const Node*>> children;
+    for (const auto& child : node->children) {
+      if (child.second != nullptr) children.emplace_back(child);
+    }
+    std::sort(children.begin(), children.end(), [](auto a, auto b) {
+      return static_cast<unsigned char>(a.first) <
+             static_cast<unsigned char>(b.first);
+    });
+
+    FlatNode& flat = nodes_[i];
+    flat.prefix_offset = prefixes_.size();
+    flat.prefix_length = node->prefix.length();
+    flat.literal_length =
+        std::min(node->prefix.find('*'), node->prefix.length());
+    flat.first_child = queue.size();
+    flat.child_count = children.size();
+    flat.is_end_node = children.empty() || children[0].first == '\0';
+    flat.has_wildcard = node->wildcard_child != nullptr;
+    prefixes_ += node->prefix;
+
+    for (const auto& child : children) {
+      queue.push_back(child.second);
+      nodes_.push_back(FlatNode{});
+      nodes_.back().label = child.first;
+    }
+  }
+  generation_ = next_tree_generation++;
+}
+
+const FSPermission::RadixTree::FlatNode* FSPermission::RadixTree::NextNode(
+    const FlatNode& node, const std::string_view& path, size_t idx) const {
+  const size_t path_len = path.length();
+  if (idx >= path_len) {
+    return nullptr;
   }
 
-  unsigned int parent_node_prefix_len = current_node->prefix.length();
-  const std::string path(s);
-  auto path_len = path.length();
+  const FlatNode* first = nodes_.data() + node.first_child;
+  const FlatNode* last = first + node.child_count;
+  const unsigned char label = path[idx];
+  const FlatNode* child =
+      std::lower_bound(first, last, label, [](const FlatNode& n, auto l) {
+        return static_cast<unsigned char>(n.label) < l;
+      });
+  if (child == last || static_cast<unsigned char>(child->label) != label) {
+    return nullptr;
+  }
+
+  // match prefix
+  const char* prefix = prefixes_.data() + child->prefix_offset;
+  const size_t prefix_len = child->prefix_length;
+  // Everything up to the first '*' or the end of the path is a plain
+  // comparison.
+  size_t i = std::min<size_t>(child->literal_length, path_len - idx);
+  if (memcmp(path.data() + idx, prefix, i) != 0) {
+    return nullptr;
+  }
+  idx += i;
+  for (; i < path_len; ++i) {
+    if (i >= prefix_len || prefix[i] == '*') {
+      return child;
+    }
+
+    // Handle optional trailing
+    // path = /home/subdirectory
+    // child = subdirectory/*
+    if (idx >= path_len && prefix[i] == node::kPathSeparator) {
+      continue;
+    }
+
+    const char c = idx < path_len ? path[idx] : '\0';
+    idx++;
+    if (c != prefix[i]) {
+      return nullptr;
+    }
+  }
+  return child;
+}
+
+bool FSPermission::RadixTree::Walk(const std::string_view& path) const {
+  const FlatNode* current_node = &nodes_[0];
+  size_t parent_node_prefix_len = current_node->prefix_length;
+  const size_t path_len = path.length();
 
   while (true) {
-    if (parent_node_prefix_len == path_len && current_node->IsEndNode()) {
+    if (parent_node_prefix_len == path_len && current_node->is_end_node) {
       return true;
     }
 
-    auto node = current_node->NextNode(path, parent_node_prefix_len);
-    if (node == nullptr) {
+    current_node = NextNode(*current_node, path, parent_node_prefix_len);
+    if (current_node == nullptr) {
       return false;
     }
 
-    current_node = node;
-    parent_node_prefix_len += current_node->prefix.length();
-    if (current_node->wildcard_child != nullptr &&
+    parent_node_prefix_len += current_node->prefix_length;
+    if (current_node->has_wildcard && parent_node_prefix_len >= 2 &&
         path_len >= (parent_node_prefix_len - 2 /* slash* */)) {
       return true;
     }
   }
 }
 
+bool FSPermission::RadixTree::Lookup(const std::string_view& s,
+                                     bool when_empty_return = false) {
+  if (nodes_[0].child_count == 0) {
+    return when_empty_return;
+  }
+
+  const size_t hash = std::hash<std::string_view>()(s);
+  bool granted;
+  if (!lookup_cache.Get(generation_, s, hash, &granted)) {
+    granted = Walk(s);
+    lookup_cache.Put(generation_, s, hash, granted);
+  }
+  return granted;
+}
+
 void FSPermission::RadixTree::Insert(const std::string& path) {
   FSPermission::RadixTree::Node* current_node = root_node_;
 
@@ -174,6 +335,7 @@ void FSPermission::RadixTree::Insert(const std::string& path) {
       parent_node_prefix_len = i;
     }
   }
+  Compile();
 }
 
 }  // namespace permission
@@ -5,11 +5,17 @@
 
 #include "v8.h"
 
+#include <cstdint>
+#include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 #include "permission/permission_base.h"
 #include "util.h"
 
+// Forward declare test fixture for `friend` declaration.
+class RadixTreeTest;
+
 namespace node {
 
 namespace permission {
@@ -126,7 +132,37 @@ class FSPermission final : public PermissionBase {
     bool Lookup(const std::string_view& s, bool when_empty_return);
 
    private:
+    friend class ::RadixTreeTest;
+
+    // Lookups do not walk the Node tree above, which is only used while
+    // inserting. Every Insert() compiles it into a flat, read-only copy:
+    // the nodes are stored breadth-first in one array, so the children of a
+    // node are consecutive and sorted by label, and all prefixes live in
+    // one string.
+    struct FlatNode {
+      uint32_t prefix_offset;
+      uint32_t prefix_length;
+      // Number of prefix characters before the first '*', which can be
+      // compared with a single memcmp().
+      uint32_t literal_length;
+      uint32_t first_child;
+      uint32_t child_count;
+      char label;
+      bool is_end_node;
+      bool has_wildcard;
+    };
+
+    void Compile();
+    const FlatNode* NextNode(const FlatNode& node,
+                             const std::string_view& path,
+                             size_t idx) const;
+    bool Walk(const std::string_view& path) const;
+
     Node* root_node_;
+    std::vector<FlatNode> nodes_;
+    std::string prefixes_;
+    // Identifies this version of the tree in the per-thread lookup cache.
+    uint64_t generation_ = 0;
   };
 
  private:
@@ -26,12 +26,21 @@
 #include "string_bytes.h"
 #include "util-inl.h"
 
+#include <algorithm>
 #include <cstring>
 
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 
 namespace node {
 
 using v8::Array;
+using v8::ArrayBuffer;
+using v8::ArrayBufferView;
 using v8::Context;
 using v8::EscapableHandleScope;
 using v8::FunctionCallbackInfo;
@@ -50,45 +59,85 @@ using v8::Object;
 using v8::String;
 using v8::Value;
 
-void SyncProcessOutputBuffer::OnAlloc(size_t suggested_size,
-                                      uv_buf_t* buf) const {
-  if (used() == kBufferSize)
+SyncProcessOutputBuffer::~SyncProcessOutputBuffer() {
+  if (!external_)
+    free(data_);
+}
+
+
+void SyncProcessOutputBuffer::SetExternal(char* data, size_t capacity) {
+  CHECK(!external_);
+  CHECK_EQ(used_, 0);
+  free(data_);
+  data_ = data;
+  capacity_ = capacity;
+  external_ = true;
+}
+
+
+void SyncProcessOutputBuffer::OnAlloc(uv_buf_t* buf) {
+  if (available() == 0 && !external_) {
+    // Doubling keeps the number of reallocations logarithmic, and realloc()
+    // can usually remap large blocks rather than copy them.
+    const size_t capacity = std::max(kChunkSize, capacity_ * 2);
+    char* data = UncheckedRealloc(data_, capacity);
+    if (data != nullptr) {
+      data_ = data;
+      capacity_ = capacity;
+    }
+  }
+
+  // A zero-length buffer makes libuv report UV_ENOBUFS.
+  const size_t length = std::min(available(), kChunkSize);
+  if (length == 0)
     *buf = uv_buf_init(nullptr, 0);
   else
-    *buf = uv_buf_init(data_ + used(), available());
+    *buf = uv_buf_init(data_ + used_, static_cast<unsigned int>(length));
 }
 
 
 void SyncProcessOutputBuffer::OnRead(const uv_buf_t* buf, size_t nread) {
   // If we hand out the same chunk twice, this should catch it.
   CHECK_EQ(buf->base, data_ + used());
-  used_ += static_cast<unsigned int>(nread);
+  CHECK_LE(nread, available());
+  used_ += nread;
 }
 
 
-size_t SyncProcessOutputBuffer::Copy(char* dest) const {
-  memcpy(dest, data_, used());
-  return used();
+char* SyncProcessOutputBuffer::Release() {
+  CHECK(!external_);
+  char* data = data_;
+  if (used_ < capacity_) {
+    // Give back the slack from the last doubling. If that fails, hand out
+    // the larger block as it is.
+    char* shrunk = UncheckedRealloc(data_, used_);
+    if (shrunk != nullptr || used_ == 0)
+      data = shrunk;
+  }
+  data_ = nullptr;
+  capacity_ = 0;
+  used_ = 0;
+  return data;
 }
 
 
-unsigned int SyncProcessOutputBuffer::available() const {
-  return sizeof data_ - used();
+void SyncProcessOutputBuffer::Clear() {
+  used_ = 0;
 }
 
 
-unsigned int SyncProcessOutputBuffer::used() const {
-  return used_;
+const char* SyncProcessOutputBuffer::data() const {
+  return data_;
 }
 
 
-SyncProcessOutputBuffer* SyncProcessOutputBuffer::next() const {
-  return next_;
+size_t SyncProcessOutputBuffer::available() const {
+  return capacity_ - used_;
 }
 
 
-void SyncProcessOutputBuffer::set_next(SyncProcessOutputBuffer* next) {
-  next_ = next;
+size_t SyncProcessOutputBuffer::used() const {
+  return used_;
 }
 
 
@@ -101,8 +150,15 @@ SyncProcessStdioPipe::SyncProcessStdioPipe(SyncProcessRunner* process_handler,
       writable_(writable),
       input_buffer_(input_buffer),
 
-      first_output_buffer_(nullptr),
-      last_output_buffer_(nullptr),
+      output_byte_offset_(0),
+      output_fd_(-1),
+      discard_output_(false),
+
+#ifdef __linux__
+      splice_poll_(),
+      splice_pipe_{-1, -1},
+      splice_started_(false),
+#endif
 
       uv_pipe_(),
       write_req_(),
@@ -115,14 +171,6 @@ SyncProcessStdioPipe::SyncProcessStdioPipe(SyncProcessRunner* process_handler,
 
 SyncProcessStdioPipe::~SyncProcessStdioPipe() {
   CHECK(lifecycle_ == kUninitialized || lifecycle_ == kClosed);
-
-  SyncProcessOutputBuffer* buf;
-  SyncProcessOutputBuffer* next;
-
-  for (buf = first_output_buffer_; buf != nullptr; buf = next) {
-    next = buf->next();
-    delete buf;
-  }
 }
 
 
@@ -166,6 +214,13 @@ int SyncProcessStdioPipe::Start() {
   }
 
   if (writable()) {
+#ifdef __linux__
+    if (output_fd_ >= 0 && !readable()) {
+      int r = StartSplice();
+      if (r != UV_ENOTSUP)
+        return r;
+    }
+#endif
     int r = uv_read_start(uv_stream(), AllocCallback, ReadCallback);
     if (r < 0)
       return r;
@@ -178,17 +233,58 @@ int SyncProcessStdioPipe::Start() {
 void SyncProcessStdioPipe::Close() {
   CHECK(lifecycle_ == kInitialized || lifecycle_ == kStarted);
 
+#ifdef __linux__
+  // The poll handle watches the pipe's fd, so it has to go first.
+  if (splice_started_) {
+    uv_close(reinterpret_cast<uv_handle_t*>(&splice_poll_), nullptr);
+    uv_fs_t req;
+    for (int fd : splice_pipe_) {
+      uv_fs_close(nullptr, &req, fd, nullptr);
+      uv_fs_req_cleanup(&req);
+    }
+    splice_started_ = false;
+  }
+#endif
+
   uv_close(uv_handle(), CloseCallback);
 
   lifecycle_ = kClosing;
 }
 
 
-Local<Object> SyncProcessStdioPipe::GetOutputAsBuffer(Environment* env) const {
-  size_t length = OutputLength();
-  Local<Object> js_buffer = Buffer::New(env, length).ToLocalChecked();
-  CopyOutput(Buffer::Data(js_buffer));
-  return js_buffer;
+void SyncProcessStdioPipe::SetOutputFD(int fd) {
+  CHECK(writable());
+  CHECK_GE(fd, 0);
+  output_fd_ = fd;
+}
+
+
+void SyncProcessStdioPipe::SetOutputBuffer(Isolate* isolate,
+                                           Local<ArrayBufferView> view) {
+  CHECK(writable());
+  Local<ArrayBuffer> ab = view->Buffer();
+  output_array_buffer_.Reset(isolate, ab);
+  output_byte_offset_ = view->ByteOffset();
+  output_buffer_.SetExternal(
+      static_cast<char*>(ab->Data()) + output_byte_offset_,
+      view->ByteLength());
+}
+
+
+Local<Value> SyncProcessStdioPipe::GetOutput(Environment* env) {
+  if (output_fd_ >= 0)
+    return Null(env->isolate());
+
+  if (!output_array_buffer_.IsEmpty()) {
+    return Buffer::New(env,
+                       output_array_buffer_.Get(env->isolate()),
+                       output_byte_offset_,
+                       output_buffer_.used()).ToLocalChecked();
+  }
+
+  // The collected output becomes the Buffer's backing store as it is.
+  size_t length = output_buffer_.used();
+  return Buffer::New(env, output_buffer_.Release(), length).ToLocalChecked();
 }
 
 
@@ -231,23 +327,21 @@ uv_handle_t* SyncProcessStdioPipe::uv_handle() const {
 }
 
 
-size_t SyncProcessStdioPipe::OutputLength() const {
-  SyncProcessOutputBuffer* buf;
-  size_t size = 0;
-
-  for (buf = first_output_buffer_; buf != nullptr; buf = buf->next())
-    size += buf->used();
-
-  return size;
-}
-
-
-void SyncProcessStdioPipe::CopyOutput(char* dest) const {
-  SyncProcessOutputBuffer* buf;
-  size_t offset = 0;
-
-  for (buf = first_output_buffer_; buf != nullptr; buf = buf->next())
-    offset += buf->Copy(dest + offset);
+void SyncProcessStdioPipe::WriteOutput(const char* data, size_t length) {
+  while (length > 0 && !discard_output_) {
+    uv_fs_t req;
+    uv_buf_t buf = uv_buf_init(const_cast<char*>(data),
+                               static_cast<unsigned int>(length));
+    int r = uv_fs_write(nullptr, &req, output_fd_, &buf, 1, -1, nullptr);
+    uv_fs_req_cleanup(&req);
+    if (r < 0) {
+      SetError(r);
+      discard_output_ = true;
+    } else {
+      data += r;
+      length -= r;
+    }
+  }
 }
 
 
@@ -257,19 +351,9 @@ void SyncProcessStdioPipe::OnAlloc(size_t suggested_size, uv_buf_t* buf) {
   // SyncProcessOutputBuffer::OnRead that would fail if this assumption was
   // ever violated.
 
-  if (last_output_buffer_ == nullptr) {
-    // Allocate the first capture buffer.
-    first_output_buffer_ = new SyncProcessOutputBuffer();
-    last_output_buffer_ = first_output_buffer_;
-
-  } else if (last_output_buffer_->available() == 0) {
-    // The current capture buffer is full so get us a new one.
-    SyncProcessOutputBuffer* buf = new SyncProcessOutputBuffer();
-    last_output_buffer_->set_next(buf);
-    last_output_buffer_ = buf;
-  }
-
-  last_output_buffer_->OnAlloc(suggested_size, buf);
+  // Output that is written elsewhere is cleared after every read, so it only
+  // ever needs the first chunk.
+  output_buffer_.OnAlloc(buf);
 }
 
 
@@ -277,13 +361,22 @@ void SyncProcessStdioPipe::OnRead(const uv_buf_t* buf, ssize_t nread) {
   if (nread == UV_EOF) {
     // Libuv implicitly stops reading on EOF.
 
+  } else if (nread == UV_ENOBUFS) {
+    // Either the caller's buffer is full or growing ours failed.
+    process_handler_->OnOutputBufferFull();
+
   } else if (nread < 0) {
     SetError(static_cast<int>(nread));
     // At some point libuv should really implicitly stop reading on error.
     uv_read_stop(uv_stream());
 
+  } else if (output_fd_ >= 0) {
+    output_buffer_.OnRead(buf, nread);
+    WriteOutput(output_buffer_.data(), output_buffer_.used());
+    output_buffer_.Clear();
+
   } else {
-    last_output_buffer_->OnRead(buf, nread);
+    output_buffer_.OnRead(buf, nread);
     process_handler_->IncrementBufferSizeAndCheckOverflow(nread);
   }
 }
@@ -359,6 +452,117 @@ void SyncProcessStdioPipe::CloseCallback(uv_handle_t* handle) {
 }
 
 
+#ifdef __linux__
+// splice(2) needs a pipe on one side, and libuv gives the child a socket, so
+// the data goes socket -> splice_pipe_ -> file. Returns UV_ENOTSUP when the
+// target is not a regular file, in which case the caller reads normally.
+int SyncProcessStdioPipe::StartSplice() {
+  struct stat st;
+  if (fstat(output_fd_, &st) != 0 || !S_ISREG(st.st_mode))
+    return UV_ENOTSUP;
+
+  uv_os_fd_t fd;
+  int r = uv_fileno(uv_handle(), &fd);
+  if (r < 0)
+    return r;
+
+  if (pipe2(splice_pipe_, O_CLOEXEC | O_NONBLOCK) != 0)
+    return UV_ENOTSUP;
+
+  r = uv_poll_init(uv_handle()->loop, &splice_poll_, fd);
+  if (r < 0) {
+    uv_fs_t req;
+    for (int& pipe_fd : splice_pipe_) {
+      uv_fs_close(nullptr, &req, pipe_fd, nullptr);
+      uv_fs_req_cleanup(&req);
+      pipe_fd = -1;
+    }
+    return UV_ENOTSUP;
+  }
+  splice_poll_.data = this;
+  splice_started_ = true;
+
+  return uv_poll_start(&splice_poll_, UV_READABLE, SpliceCallback);
+}
+
+
+void SyncProcessStdioPipe::OnSpliceReadable(int status) {
+  if (status < 0) {
+    SetError(status);
+    uv_poll_stop(&splice_poll_);
+    return;
+  }
+
+  static const size_t kSpliceSize = 1 << 20;
+  uv_os_fd_t fd;
+  CHECK_EQ(uv_fileno(reinterpret_cast<uv_handle_t*>(&splice_poll_), &fd), 0);
+  for (;;) {
+    ssize_t n;
+    if (discard_output_) {
+      // Keep draining the child's output after a failed write, as the
+      // read-based path does.
+      char scratch[16384];
+      n = read(fd, scratch, sizeof(scratch));
+    } else {
+      n = splice(fd, nullptr, splice_pipe_[1], nullptr, kSpliceSize,
+                 SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    }
+
+    if (n == 0) {
+      // EOF.
+      uv_poll_stop(&splice_poll_);
+      return;
+    }
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      if (errno != EAGAIN) {
+        SetError(uv_translate_sys_error(errno));
+        uv_poll_stop(&splice_poll_);
+      }
+      return;
+    }
+    if (discard_output_)
+      continue;
+
+    // Move everything on to the file so that the intermediate pipe is empty
+    // again before the next read. If the file system does not support
+    // splice(2) the data is copied out of the pipe instead.
+    while (n > 0) {
+      ssize_t m = splice(splice_pipe_[0], nullptr, output_fd_, nullptr, n,
+                         SPLICE_F_MOVE);
+      if (m > 0) {
+        n -= m;
+        continue;
+      }
+      if (m < 0 && errno == EINTR)
+        continue;
+
+      char chunk[16384];
+      ssize_t k = read(splice_pipe_[0], chunk,
+                       std::min<size_t>(n, sizeof(chunk)));
+      if (k <= 0) {
+        SetError(k < 0 ? uv_translate_sys_error(errno) : UV_EIO);
+        discard_output_ = true;
+        break;
+      }
+      WriteOutput(chunk, k);
+      n -= k;
+    }
+  }
+}
+
+
+void SyncProcessStdioPipe::SpliceCallback(uv_poll_t* handle,
+                                          int status,
+                                          int events) {
+  SyncProcessStdioPipe* self =
+      reinterpret_cast<SyncProcessStdioPipe*>(handle->data);
+  self->OnSpliceReadable(status);
+}
+#endif
+
+
 void SyncProcessRunner::Initialize(Local<Object> target,
                                    Local<Value> unused,
                                    Local<Context> context,
@@ -640,6 +844,12 @@ void SyncProcessRunner::IncrementBufferSizeAndCheckOverflow(ssize_t length) {
 }
 
 
+void SyncProcessRunner::OnOutputBufferFull() {
+  SetError(UV_ENOBUFS);
+  Kill();
+}
+
+
 void SyncProcessRunner::OnExit(int64_t exit_status, int term_signal) {
   if (exit_status < 0)
     return SetError(static_cast<int>(exit_status));
@@ -735,7 +945,7 @@ Local<Array> SyncProcessRunner::BuildOutputArray() {
   for (uint32_t i = 0; i < stdio_pipes_.size(); i++) {
     SyncProcessStdioPipe* h = stdio_pipes_[i].get();
     if (h != nullptr && h->writable())
-      js_output[i] = h->GetOutputAsBuffer(env());
+      js_output[i] = h->GetOutput(env());
     else
       js_output[i] = Null(env()->isolate());
   }
@@ -924,7 +1134,31 @@ int SyncProcessRunner::ParseStdioOption(int child_fd,
       }
     }
 
-    return AddStdioPipe(child_fd, readable, writable, buf);
+    int r = AddStdioPipe(child_fd, readable, writable, buf);
+    if (r < 0 || !writable)
+      return r;
+
+    // The output may go straight to a file descriptor or into a buffer that
+    // the caller provides, instead of being collected by us.
+    Local<Value> output_fd =
+        js_stdio_option->Get(context, env()->output_fd_string())
+            .ToLocalChecked();
+    Local<Value> output_buffer =
+        js_stdio_option->Get(context, env()->output_buffer_string())
+            .ToLocalChecked();
+    if (IsSet(output_fd) && IsSet(output_buffer))
+      return UV_EINVAL;
+    if (IsSet(output_fd)) {
+      if (!output_fd->IsInt32() || output_fd.As<Int32>()->Value() < 0)
+        return UV_EINVAL;
+      stdio_pipes_[child_fd]->SetOutputFD(output_fd.As<Int32>()->Value());
+    } else if (IsSet(output_buffer)) {
+      if (!output_buffer->IsArrayBufferView())
+        return UV_EINVAL;
+      stdio_pipes_[child_fd]->SetOutputBuffer(
+          isolate, output_buffer.As<ArrayBufferView>());
+    }
+    return 0;
 
   } else if (js_type->StrictEquals(env()->inherit_string()) ||
              js_type->StrictEquals(env()->fd_string())) {
@@ -37,29 +37,41 @@ class SyncProcessStdioPipe;
 class SyncProcessRunner;
 
 
+// Collects the output of one stdio pipe in a single contiguous block, so that
+// it can be handed to JS as it is instead of being concatenated at the end.
+// The block is either grown on demand, or provided by the caller, in which
+// case it never grows and running out of space is reported as UV_ENOBUFS.
 class SyncProcessOutputBuffer {
-  static const unsigned int kBufferSize = 65536;
+  // Also the most that is read at once, so that output is still checked
+  // against maxBuffer every 64 KB, as it was with fixed-size chunks.
+  static const size_t kChunkSize = 65536;
 
  public:
   inline SyncProcessOutputBuffer() = default;
+  inline ~SyncProcessOutputBuffer();
 
-  inline void OnAlloc(size_t suggested_size, uv_buf_t* buf) const;
-  inline void OnRead(const uv_buf_t* buf, size_t nread);
+  SyncProcessOutputBuffer(const SyncProcessOutputBuffer&) = delete;
+  SyncProcessOutputBuffer& operator=(const SyncProcessOutputBuffer&) = delete;
 
-  inline size_t Copy(char* dest) const;
+  inline void SetExternal(char* data, size_t capacity);
 
-  inline unsigned int available() const;
-  inline unsigned int used() const;
+  inline void OnAlloc(uv_buf_t* buf);
+  inline void OnRead(const uv_buf_t* buf, size_t nread);
 
-  inline SyncProcessOutputBuffer* next() const;
-  inline void set_next(SyncProcessOutputBuffer* next);
+  // Hands the block over to the caller, who must free() it.
+  inline char* Release();
+  // Forgets the contents but keeps the block around for reuse.
+  inline void Clear();
 
- private:
-  // Use unsigned int because that's what `uv_buf_init` takes.
-  mutable char data_[kBufferSize];
-  unsigned int used_ = 0;
+  inline const char* data() const;
+  inline size_t available() const;
+  inline size_t used() const;
 
-  SyncProcessOutputBuffer* next_ = nullptr;
+ private:
+  char* data_ = nullptr;
+  size_t capacity_ = 0;
+  size_t used_ = 0;
+  bool external_ = false;
 };
 
 
@@ -83,7 +95,13 @@ class SyncProcessStdioPipe {
   int Start();
   void Close();
 
-  v8::Local<v8::Object> GetOutputAsBuffer(Environment* env) const;
+  // Instead of collecting the output, write it to `fd` as it arrives.
+  void SetOutputFD(int fd);
+  // Collect the output in `view` rather than in memory allocated by us.
+  void SetOutputBuffer(v8::Isolate* isolate,
+                       v8::Local<v8::ArrayBufferView> view);
+
+  v8::Local<v8::Value> GetOutput(Environment* env);
 
   inline bool readable() const;
   inline bool writable() const;
@@ -94,8 +112,7 @@ class SyncProcessStdioPipe {
   inline uv_handle_t* uv_handle() const;
 
  private:
-  inline size_t OutputLength() const;
-  inline void CopyOutput(char* dest) const;
+  inline void WriteOutput(const char* data, size_t length);
 
   inline void OnAlloc(size_t suggested_size, uv_buf_t* buf);
   inline void OnRead(const uv_buf_t* buf, ssize_t nread);
@@ -115,14 +132,33 @@ class SyncProcessStdioPipe {
   static void ShutdownCallback(uv_shutdown_t* req, int result);
   static void CloseCallback(uv_handle_t* handle);
 
+#ifdef __linux__
+  int StartSplice();
+  void OnSpliceReadable(int status);
+  static void SpliceCallback(uv_poll_t* handle, int status, int events);
+#endif
+
   SyncProcessRunner* process_handler_;
 
   bool readable_;
   bool writable_;
   uv_buf_t input_buffer_;
 
-  SyncProcessOutputBuffer* first_output_buffer_;
-  SyncProcessOutputBuffer* last_output_buffer_;
+  SyncProcessOutputBuffer output_buffer_;
+  v8::Global<v8::ArrayBuffer> output_array_buffer_;
+  size_t output_byte_offset_;
+  int output_fd_;
+  // Set once writing to `output_fd_` failed; the rest is read and dropped so
+  // that the child does not block on a full pipe.
+  bool discard_output_;
+
+#ifdef __linux__
+  // When the output goes to a regular file it is moved there with splice(2)
+  // through `splice_pipe_`, without passing through user space.
+  uv_poll_t splice_poll_;
+  int splice_pipe_[2];
+  bool splice_started_;
+#endif
 
   mutable uv_pipe_t uv_pipe_;
   uv_write_t write_req_;
@@ -163,6 +199,7 @@ class SyncProcessRunner {
 
   void Kill();
   void IncrementBufferSizeAndCheckOverflow(ssize_t length);
+  void OnOutputBufferFull();
 
   void OnExit(int64_t exit_status, int term_signal);
   void OnKillTimerTimeout();
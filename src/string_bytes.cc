@@ -23,6 +23,7 @@
 
 #include "base64-inl.h"
 #include "env-inl.h"
+#include "hex_simd.h"
 #include "node_buffer.h"
 #include "node_errors.h"
 #include "simdutf.h"
@@ -198,6 +199,45 @@ MaybeLocal<Value> ExternTwoByteString::NewSimpleFromCopy(Isolate* isolate,
   return str.ToLocalChecked();
 }
 
+// Decodes valid UTF-8 into a new external string. Text that only contains
+// code points up to U+00FF is stored as one-byte Latin-1, everything else
+// as UTF-16.
+MaybeLocal<Value> ExternValidUtf8(Isolate* isolate,
+                                  const char* data,
+                                  size_t length,
+                                  Local<Value>* error) {
+  // In valid UTF-8, only the lead bytes 0xC2 and 0xC3 encode code points
+  // above U+007F that still fit into Latin-1.
+  const uint8_t* src = reinterpret_cast<const uint8_t*>(data);
+  if (std::all_of(src, src + length, [](uint8_t c) { return c < 0xc4; })) {
+    char* dst = node::UncheckedMalloc(length);
+    if (dst == nullptr) {
+      *error = node::ERR_MEMORY_ALLOCATION_FAILED(isolate);
+      return MaybeLocal<Value>();
+    }
+    size_t written = 0;
+    for (size_t i = 0; i < length; i++) {
+      uint8_t c = src[i];
+      if (c >= 0x80) c = ((c & 0x1f) << 6) | (src[++i] & 0x3f);
+      dst[written++] = static_cast<char>(c);
+    }
+    // Give back the space of the dropped lead bytes.
+    char* shrunk = node::Realloc(dst, written);
+    return ExternOneByteString::New(isolate, shrunk, written, error);
+  }
+
+  const size_t utf16_length = simdutf::utf16_length_from_utf8(data, length);
+  uint16_t* dst = node::UncheckedMalloc<uint16_t>(utf16_length);
+  if (dst == nullptr) {
+    *error = node::ERR_MEMORY_ALLOCATION_FAILED(isolate);
+    return MaybeLocal<Value>();
+  }
+  const size_t written = simdutf::convert_valid_utf8_to_utf16(
+      data, length, reinterpret_cast<char16_t*>(dst));
+  CHECK_EQ(written, utf16_length);
+  return ExternTwoByteString::New(isolate, dst, written, error);
+}
+
 }  // anonymous namespace
 
 // supports regular and URL-safe base64
@@ -249,8 +289,12 @@ static size_t hex_decode(char* buf,
                          size_t len,
                          const TypeName* src,
                          const size_t srcLen) {
-  size_t i;
-  for (i = 0; i < len && i * 2 + 1 < srcLen; ++i) {
+  size_t i = 0;
+  if constexpr (sizeof(TypeName) == 1) {
+    i = hex::DecodeBlocks(
+        reinterpret_cast<const uint8_t*>(src), std::min(len, srcLen / 2), buf);
+  }
+  for (; i < len && i * 2 + 1 < srcLen; ++i) {
     unsigned a = unhex(static_cast<uint8_t>(src[i * 2 + 0]));
     unsigned b = unhex(static_cast<uint8_t>(src[i * 2 + 1]));
     if (!~a || !~b)
@@ -351,6 +395,17 @@ size_t StringBytes::Write(Isolate* isolate,
       if (str->IsExternalOneByte()) {
         auto ext = str->GetExternalOneByteStringResource();
         nbytes = base64_decode(buf, buflen, ext->data(), ext->length());
+      } else if (str->IsOneByte()) {
+        // Base64 strings are nearly always one-byte strings. Flattening them
+        // to one byte per character halves the copy and lets the vectorized
+        // decoder read the characters directly.
+        MaybeStackBuffer<char> value(str->Length());
+        str->WriteOneByte(isolate,
+                          reinterpret_cast<uint8_t*>(value.out()),
+                          0,
+                          value.length(),
+                          flags);
+        nbytes = base64_decode(buf, buflen, value.out(), value.length());
       } else {
         String::Value value(isolate, str);
         nbytes = base64_decode(buf, buflen, *value, value.length());
@@ -361,6 +416,14 @@ size_t StringBytes::Write(Isolate* isolate,
       if (str->IsExternalOneByte()) {
         auto ext = str->GetExternalOneByteStringResource();
         nbytes = hex_decode(buf, buflen, ext->data(), ext->length());
+      } else if (str->IsOneByte()) {
+        MaybeStackBuffer<char> value(str->Length());
+        str->WriteOneByte(isolate,
+                          reinterpret_cast<uint8_t*>(value.out()),
+                          0,
+                          value.length(),
+                          flags);
+        nbytes = hex_decode(buf, buflen, value.out(), value.length());
       } else {
         String::Value value(isolate, str);
         nbytes = hex_decode(buf, buflen, *value, value.length());
@@ -528,7 +591,9 @@ size_t StringBytes::hex_encode(
       "not enough space provided for hex encode");
 
   dlen = slen * 2;
-  for (uint32_t i = 0, k = 0; k < dlen; i += 1, k += 2) {
+  const size_t done =
+      hex::EncodeBlocks(reinterpret_cast<const uint8_t*>(src), slen, dst);
+  for (size_t i = done, k = done * 2; k < dlen; i += 1, k += 2) {
     static const char hex[] = "0123456789abcdef";
     uint8_t val = static_cast<uint8_t>(src[i]);
     dst[k + 0] = hex[val >> 4];
@@ -594,6 +659,17 @@ MaybeLocal<Value> StringBytes::Encode(Isolate* isolate,
 
     case UTF8:
       {
+        if (buflen >= EXTERN_APEX) {
+          // Like the other encodings, keep large results out of the V8 heap.
+          // Invalid input needs U+FFFD replacements and is left to V8.
+          if (simdutf::validate_ascii(buf, buflen)) {
+            return ExternOneByteString::NewFromCopy(
+                isolate, buf, buflen, error);
+          }
+          if (simdutf::validate_utf8(buf, buflen)) {
+            return ExternValidUtf8(isolate, buf, buflen, error);
+          }
+        }
         val = String::NewFromUtf8(isolate,
                                   buf,
                                   v8::NewStringType::kNormal,
@@ -638,6 +714,16 @@ MaybeLocal<Value> StringBytes::Encode(Isolate* isolate,
 
     case HEX: {
       size_t dlen = buflen * 2;
+      MaybeStackBuffer<char> stack_dst;
+      if (dlen <= stack_dst.capacity()) {
+        // V8 has no API to fill in a new string in place, so short strings
+        // such as digests and trace ids are encoded on the stack and copied
+        // into the heap by V8, saving the malloc() and free() of the
+        // external string path.
+        hex_encode(buf, buflen, stack_dst.out(), dlen);
+        return ExternOneByteString::NewFromCopy(
+            isolate, stack_dst.out(), dlen, error);
+      }
       char* dst = node::UncheckedMalloc(dlen);
       if (dst == nullptr) {
         *error = node::ERR_MEMORY_ALLOCATION_FAILED(isolate);
@@ -7,6 +7,7 @@
 
 #if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
 
+#include "string_search_simd.h"
 #include "util.h"
 
 #include <cstring>
@@ -598,6 +599,18 @@ size_t SearchString(const Char* haystack,
                     size_t start_index,
                     bool is_forward) {
   if (haystack_length < needle_length) return haystack_length;
+  // Short needles are best served by the vectorized search, except for
+  // single bytes, for which memchr() and memrchr() are just as fast.
+  if (stringsearch::kHasSimdSearch &&
+      needle_length <= stringsearch::kSimdSearchMaxNeedleLength &&
+      (sizeof(Char) > 1 || needle_length > 1)) {
+    return stringsearch::SimdSearch(haystack,
+                                    haystack_length,
+                                    needle,
+                                    needle_length,
+                                    start_index,
+                                    is_forward);
+  }
   // To do a reverse search (lastIndexOf instead of indexOf) without redundant
   // code, create two vectors that are reversed views into the input strings.
   // For example, v_needle[0] would return the *last* character of the needle.
@@ -0,0 +1,610 @@
+#include "string_search_simd.h"
+#include "util.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(NODE_SIMD_X64)
+#include <immintrin.h>
+#elif defined(NODE_SIMD_ARM64)
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace node {
+namespace stringsearch {
+
+namespace {
+
+inline int CountTrailingZeros(uint64_t mask) {
+  DCHECK_NE(mask, 0);
+#if defined(_MSC_VER) && !defined(__clang__)
+  unsigned long index;  // NOLINT(runtime/int)
+  _BitScanForward64(&index, mask);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctzll(mask);
+#endif
+}
+
+inline int HighestSetBit(uint64_t mask) {
+  DCHECK_NE(mask, 0);
+#if defined(_MSC_VER) && !defined(__clang__)
+  unsigned long index;  // NOLINT(runtime/int)
+  _BitScanReverse64(&index, mask);
+  return static_cast<int>(index);
+#else
+  return 63 - __builtin_clzll(mask);
+#endif
+}
+
+// The first and the last character of a candidate are already known to
+// match, only the inner part of the pattern remains to be compared.
+template <typename Char>
+NODE_SIMD_INLINE bool MatchesInner(const Char* candidate,
+                                   const Char* pattern,
+                                   size_t pattern_length) {
+  return pattern_length <= 2 ||
+         memcmp(candidate + 1,
+                pattern + 1,
+                (pattern_length - 2) * sizeof(Char)) == 0;
+}
+
+// The kernels below are parameterized over an `Ops` class that provides
+//
+//   kLanes      the number of characters compared per vector,
+//   kMaskShift  log2 of the number of mask bits per character,
+//   MatchPair() the mask of lanes `i` where `p[i] == a && q[i] == b`,
+//   MatchAny()  the mask of lanes `i` where `p[i]` is one of `chars`,
+//
+// with exactly one bit set per matching lane. Vector values never leave the
+// Ops methods, so the kernels themselves need no target attribute and get
+// inlined into the target-specific entry points further down.
+
+template <typename Ops, typename Char>
+NODE_SIMD_INLINE size_t ForwardSearch(const Char* subject,
+                                      size_t subject_length,
+                                      const Char* pattern,
+                                      size_t pattern_length,
+                                      size_t start_index) {
+  const size_t last = pattern_length - 1;
+  const Char first_char = pattern[0];
+  const Char last_char = pattern[last];
+  const size_t max_index = subject_length - pattern_length;
+
+  size_t i = start_index;
+  // Both loads of a block have to stay inside the subject.
+  for (; i <= max_index && max_index - i >= Ops::kLanes - 1;
+       i += Ops::kLanes) {
+    uint64_t mask =
+        Ops::MatchPair(subject + i, subject + i + last, first_char, last_char);
+    while (mask != 0) {
+      size_t pos = i + (CountTrailingZeros(mask) >> Ops::kMaskShift);
+      if (MatchesInner(subject + pos, pattern, pattern_length)) return pos;
+      mask &= mask - 1;
+    }
+  }
+
+  for (; i <= max_index; i++) {
+    if (subject[i] == first_char && subject[i + last] == last_char &&
+        MatchesInner(subject + i, pattern, pattern_length)) {
+      return i;
+    }
+  }
+  return subject_length;
+}
+
+template <typename Ops, typename Char>
+NODE_SIMD_INLINE size_t BackwardSearch(const Char* subject,
+                                       size_t subject_length,
+                                       const Char* pattern,
+                                       size_t pattern_length,
+                                       size_t start_index) {
+  const size_t last = pattern_length - 1;
+  const Char first_char = pattern[0];
+  const Char last_char = pattern[last];
+  const size_t max_index = subject_length - pattern_length;
+
+  // One past the highest candidate position that is left to check.
+  size_t end = std::min(start_index, max_index) + 1;
+  while (end >= Ops::kLanes) {
+    const size_t i = end - Ops::kLanes;
+    uint64_t mask =
+        Ops::MatchPair(subject + i, subject + i + last, first_char, last_char);
+    while (mask != 0) {
+      const int bit = HighestSetBit(mask);
+      size_t pos = i + (bit >> Ops::kMaskShift);
+      if (MatchesInner(subject + pos, pattern, pattern_length)) return pos;
+      mask &= ~(uint64_t{1} << bit);
+    }
+    end = i;
+  }
+
+  while (end > 0) {
+    end--;
+    if (subject[end] == first_char && subject[end + last] == last_char &&
+        MatchesInner(subject + end, pattern, pattern_length)) {
+      return end;
+    }
+  }
+  return subject_length;
+}
+
+// Compact description of the non-empty patterns of a SimdSearchAny() call.
+struct PatternSet {
+  uint8_t first_chars[kSimdSearchMaxNeedles];
+  const uint8_t* patterns[kSimdSearchMaxNeedles];
+  size_t lengths[kSimdSearchMaxNeedles];
+  size_t indices[kSimdSearchMaxNeedles];
+  size_t count = 0;
+
+  PatternSet(const uint8_t* const* all_patterns,
+             const size_t* all_lengths,
+             size_t all_count) {
+    CHECK_LE(all_count, kSimdSearchMaxNeedles);
+    for (size_t k = 0; k < all_count; k++) {
+      if (all_lengths[k] == 0) continue;
+      first_chars[count] = all_patterns[k][0];
+      patterns[count] = all_patterns[k];
+      lengths[count] = all_lengths[k];
+      indices[count] = k;
+      count++;
+    }
+  }
+
+  // Patterns are kept in their original order, so the first hit is the one
+  // with the lowest index.
+  NODE_SIMD_INLINE bool MatchAt(const uint8_t* subject,
+                                size_t subject_length,
+                                size_t pos,
+                                size_t* pattern_index) const {
+    for (size_t k = 0; k < count; k++) {
+      if (subject[pos] == first_chars[k] &&
+          lengths[k] <= subject_length - pos &&
+          memcmp(subject + pos, patterns[k], lengths[k]) == 0) {
+        *pattern_index = indices[k];
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+template <typename Ops>
+NODE_SIMD_INLINE size_t ForwardSearchAny(const uint8_t* subject,
+                                         size_t subject_length,
+                                         const PatternSet& set,
+                                         size_t start_index,
+                                         size_t* pattern_index) {
+  if (set.count == 0) return subject_length;
+
+  size_t i = start_index;
+  for (; i < subject_length && subject_length - i >= Ops::kLanes;
+       i += Ops::kLanes) {
+    uint64_t mask = Ops::MatchAny(subject + i, set.first_chars, set.count);
+    while (mask != 0) {
+      size_t pos = i + (CountTrailingZeros(mask) >> Ops::kMaskShift);
+      if (set.MatchAt(subject, subject_length, pos, pattern_index)) return pos;
+      mask &= mask - 1;
+    }
+  }
+
+  for (; i < subject_length; i++) {
+    if (set.MatchAt(subject, subject_length, i, pattern_index)) return i;
+  }
+  return subject_length;
+}
+
+// Portable version of the Ops interface, one lane at a time. Used on
+// architectures without a vectorized implementation.
+template <typename Char>
+struct ScalarOps {
+  static constexpr size_t kLanes = 1;
+  static constexpr int kMaskShift = 0;
+
+  static uint64_t MatchPair(const Char* p, const Char* q, Char a, Char b) {
+    return p[0] == a && q[0] == b;
+  }
+
+  static uint64_t MatchAny(const Char* p, const Char* chars, size_t count) {
+    return std::find(chars, chars + count, p[0]) != chars + count;
+  }
+};
+
+#if defined(NODE_SIMD_X64)
+
+template <typename Char>
+struct SSE2Ops;
+
+template <>
+struct SSE2Ops<uint8_t> {
+  static constexpr size_t kLanes = 16;
+  static constexpr int kMaskShift = 0;
+
+  static NODE_SIMD_INLINE uint64_t MatchPair(const uint8_t* p,
+                                             const uint8_t* q,
+                                             uint8_t a,
+                                             uint8_t b) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q));
+    __m128i eq = _mm_and_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(a)),
+                               _mm_cmpeq_epi8(y, _mm_set1_epi8(b)));
+    return static_cast<uint32_t>(_mm_movemask_epi8(eq));
+  }
+
+  static NODE_SIMD_INLINE uint64_t MatchAny(const uint8_t* p,
+                                            const uint8_t* chars,
+                                            size_t count) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i eq = _mm_setzero_si128();
+    for (size_t k = 0; k < count; k++)
+      eq = _mm_or_si128(eq, _mm_cmpeq_epi8(x, _mm_set1_epi8(chars[k])));
+    return static_cast<uint32_t>(_mm_movemask_epi8(eq));
+  }
+};
+
+template <>
+struct SSE2Ops<uint16_t> {
+  static constexpr size_t kLanes = 8;
+  static constexpr int kMaskShift = 1;
+
+  static NODE_SIMD_INLINE uint64_t MatchPair(const uint16_t* p,
+                                             const uint16_t* q,
+                                             uint16_t a,
+                                             uint16_t b) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q));
+    __m128i eq = _mm_and_si128(_mm_cmpeq_epi16(x, _mm_set1_epi16(a)),
+                               _mm_cmpeq_epi16(y, _mm_set1_epi16(b)));
+    // Both mask bits of a matching 16-bit lane are set, keep the lower one.
+    return static_cast<uint32_t>(_mm_movemask_epi8(eq)) & 0x5555;
+  }
+};
+
+template <typename Char>
+struct AVX2Ops;
+
+template <>
+struct AVX2Ops<uint8_t> {
+  static constexpr size_t kLanes = 32;
+  static constexpr int kMaskShift = 0;
+
+  NODE_TARGET_AVX2 static inline uint64_t MatchPair(const uint8_t* p,
+                                                    const uint8_t* q,
+                                                    uint8_t a,
+                                                    uint8_t b) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(q));
+    __m256i eq = _mm256_and_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(a)),
+                                  _mm256_cmpeq_epi8(y, _mm256_set1_epi8(b)));
+    return static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+  }
+
+  NODE_TARGET_AVX2 static inline uint64_t MatchAny(const uint8_t* p,
+                                                   const uint8_t* chars,
+                                                   size_t count) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i eq = _mm256_setzero_si256();
+    for (size_t k = 0; k < count; k++) {
+      eq = _mm256_or_si256(eq,
+                           _mm256_cmpeq_epi8(x, _mm256_set1_epi8(chars[k])));
+    }
+    return static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+  }
+};
+
+template <>
+struct AVX2Ops<uint16_t> {
+  static constexpr size_t kLanes = 16;
+  static constexpr int kMaskShift = 1;
+
+  NODE_TARGET_AVX2 static inline uint64_t MatchPair(const uint16_t* p,
+                                                    const uint16_t* q,
+                                                    uint16_t a,
+                                                    uint16_t b) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(q));
+    __m256i eq =
+        _mm256_and_si256(_mm256_cmpeq_epi16(x, _mm256_set1_epi16(a)),
+                         _mm256_cmpeq_epi16(y, _mm256_set1_epi16(b)));
+    return static_cast<uint32_t>(_mm256_movemask_epi8(eq)) & 0x55555555;
+  }
+};
+
+template <typename Char>
+size_t SearchSSE2(const Char* subject,
+                  size_t subject_length,
+                  const Char* pattern,
+                  size_t pattern_length,
+                  size_t start_index,
+                  bool is_forward) {
+  using Ops = SSE2Ops<Char>;
+  return is_forward ? ForwardSearch<Ops>(subject,
+                                         subject_length,
+                                         pattern,
+                                         pattern_length,
+                                         start_index)
+                    : BackwardSearch<Ops>(subject,
+                                          subject_length,
+                                          pattern,
+                                          pattern_length,
+                                          start_index);
+}
+
+template <typename Char>
+NODE_TARGET_AVX2 size_t SearchAVX2(const Char* subject,
+                                   size_t subject_length,
+                                   const Char* pattern,
+                                   size_t pattern_length,
+                                   size_t start_index,
+                                   bool is_forward) {
+  using Ops = AVX2Ops<Char>;
+  return is_forward ? ForwardSearch<Ops>(subject,
+                                         subject_length,
+                                         pattern,
+                                         pattern_length,
+                                         start_index)
+                    : BackwardSearch<Ops>(subject,
+                                          subject_length,
+                                          pattern,
+                                          pattern_length,
+                                          start_index);
+}
+
+size_t SearchAnySSE2(const uint8_t* subject,
+                     size_t subject_length,
+                     const PatternSet& set,
+                     size_t start_index,
+                     size_t* pattern_index) {
+  return ForwardSearchAny<SSE2Ops<uint8_t>>(
+      subject, subject_length, set, start_index, pattern_index);
+}
+
+NODE_TARGET_AVX2 size_t SearchAnyAVX2(const uint8_t* subject,
+                                      size_t subject_length,
+                                      const PatternSet& set,
+                                      size_t start_index,
+                                      size_t* pattern_index) {
+  return ForwardSearchAny<AVX2Ops<uint8_t>>(
+      subject, subject_length, set, start_index, pattern_index);
+}
+
+#elif defined(NODE_SIMD_ARM64)
+
+// NEON has no movemask, narrowing the comparison result by shifting each
+// 16-bit lane right by four yields a 64-bit mask with four bits per byte.
+NODE_SIMD_INLINE uint64_t NarrowMask(uint8x16_t eq) {
+  uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(eq), 4);
+  return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0);
+}
+
+template <typename Char>
+struct NEONOps;
+
+template <>
+struct NEONOps<uint8_t> {
+  static constexpr size_t kLanes = 16;
+  static constexpr int kMaskShift = 2;
+
+  static NODE_SIMD_INLINE uint64_t MatchPair(const uint8_t* p,
+                                             const uint8_t* q,
+                                             uint8_t a,
+                                             uint8_t b) {
+    uint8x16_t eq = vandq_u8(vceqq_u8(vld1q_u8(p), vdupq_n_u8(a)),
+                             vceqq_u8(vld1q_u8(q), vdupq_n_u8(b)));
+    return NarrowMask(eq) & 0x8888888888888888;
+  }
+
+  static NODE_SIMD_INLINE uint64_t MatchAny(const uint8_t* p,
+                                            const uint8_t* chars,
+                                            size_t count) {
+    uint8x16_t x = vld1q_u8(p);
+    uint8x16_t eq = vdupq_n_u8(0);
+    for (size_t k = 0; k < count; k++)
+      eq = vorrq_u8(eq, vceqq_u8(x, vdupq_n_u8(chars[k])));
+    return NarrowMask(eq) & 0x8888888888888888;
+  }
+};
+
+template <>
+struct NEONOps<uint16_t> {
+  static constexpr size_t kLanes = 8;
+  static constexpr int kMaskShift = 3;
+
+  static NODE_SIMD_INLINE uint64_t MatchPair(const uint16_t* p,
+                                             const uint16_t* q,
+                                             uint16_t a,
+                                             uint16_t b) {
+    uint16x8_t eq = vandq_u16(vceqq_u16(vld1q_u16(p), vdupq_n_u16(a)),
+                              vceqq_u16(vld1q_u16(q), vdupq_n_u16(b)));
+    return NarrowMask(vreinterpretq_u8_u16(eq)) & 0x8080808080808080;
+  }
+};
+
+template <typename Char>
+size_t SearchNEON(const Char* subject,
+                  size_t subject_length,
+                  const Char* pattern,
+                  size_t pattern_length,
+                  size_t start_index,
+                  bool is_forward) {
+  using Ops = NEONOps<Char>;
+  return is_forward ? ForwardSearch<Ops>(subject,
+                                         subject_length,
+                                         pattern,
+                                         pattern_length,
+                                         start_index)
+                    : BackwardSearch<Ops>(subject,
+                                          subject_length,
+                                          pattern,
+                                          pattern_length,
+                                          start_index);
+}
+
+size_t SearchAnyNEON(const uint8_t* subject,
+                     size_t subject_length,
+                     const PatternSet& set,
+                     size_t start_index,
+                     size_t* pattern_index) {
+  return ForwardSearchAny<NEONOps<uint8_t>>(
+      subject, subject_length, set, start_index, pattern_index);
+}
+
+#endif  // defined(NODE_SIMD_ARM64)
+
+template <typename Char>
+size_t SearchScalar(const Char* subject,
+                    size_t subject_length,
+                    const Char* pattern,
+                    size_t pattern_length,
+                    size_t start_index,
+                    bool is_forward) {
+  using Ops = ScalarOps<Char>;
+  return is_forward ? ForwardSearch<Ops>(subject,
+                                         subject_length,
+                                         pattern,
+                                         pattern_length,
+                                         start_index)
+                    : BackwardSearch<Ops>(subject,
+                                          subject_length,
+                                          pattern,
+                                          pattern_length,
+                                          start_index);
+}
+
+enum class Implementation { kScalar, kSSE2, kAVX2, kNEON };
+
+Implementation GetImplementation() {
+  static const Implementation implementation = []() {
+#if defined(NODE_SIMD_X64)
+    return cpu_features::HasAVX2() ? Implementation::kAVX2
+                                   : Implementation::kSSE2;
+#elif defined(NODE_SIMD_ARM64)
+    return Implementation::kNEON;
+#else
+    return Implementation::kScalar;
+#endif
+  }();
+  return implementation;
+}
+
+template <typename Char>
+size_t Search(const Char* subject,
+              size_t subject_length,
+              const Char* pattern,
+              size_t pattern_length,
+              size_t start_index,
+              bool is_forward) {
+  CHECK_GT(pattern_length, 0);
+  CHECK_LE(pattern_length, subject_length);
+  switch (GetImplementation()) {
+#if defined(NODE_SIMD_X64)
+    case Implementation::kAVX2:
+      return SearchAVX2(subject,
+                        subject_length,
+                        pattern,
+                        pattern_length,
+                        start_index,
+                        is_forward);
+    case Implementation::kSSE2:
+      return SearchSSE2(subject,
+                        subject_length,
+                        pattern,
+                        pattern_length,
+                        start_index,
+                        is_forward);
+#elif defined(NODE_SIMD_ARM64)
+    case Implementation::kNEON:
+      return SearchNEON(subject,
+                        subject_length,
+                        pattern,
+                        pattern_length,
+                        start_index,
+                        is_forward);
+#endif
+    default:
+      return SearchScalar(subject,
+                          subject_length,
+                          pattern,
+                          pattern_length,
+                          start_index,
+                          is_forward);
+  }
+}
+
+}  // anonymous namespace
+
+size_t SimdSearch(const uint8_t* subject,
+                  size_t subject_length,
+                  const uint8_t* pattern,
+                  size_t pattern_length,
+                  size_t start_index,
+                  bool is_forward) {
+  return Search(subject,
+                subject_length,
+                pattern,
+                pattern_length,
+                start_index,
+                is_forward);
+}
+
+size_t SimdSearch(const uint16_t* subject,
+                  size_t subject_length,
+                  const uint16_t* pattern,
+                  size_t pattern_length,
+                  size_t start_index,
+                  bool is_forward) {
+  return Search(subject,
+                subject_length,
+                pattern,
+                pattern_length,
+                start_index,
+                is_forward);
+}
+
+size_t SimdSearchAny(const uint8_t* subject,
+                     size_t subject_length,
+                     const uint8_t* const* patterns,
+                     const size_t* pattern_lengths,
+                     size_t pattern_count,
+                     size_t start_index,
+                     size_t* pattern_index) {
+  PatternSet set(patterns, pattern_lengths, pattern_count);
+  switch (GetImplementation()) {
+#if defined(NODE_SIMD_X64)
+    case Implementation::kAVX2:
+      return SearchAnyAVX2(
+          subject, subject_length, set, start_index, pattern_index);
+    case Implementation::kSSE2:
+      return SearchAnySSE2(
+          subject, subject_length, set, start_index, pattern_index);
+#elif defined(NODE_SIMD_ARM64)
+    case Implementation::kNEON:
+      return SearchAnyNEON(
+          subject, subject_length, set, start_index, pattern_index);
+#endif
+    default:
+      return ForwardSearchAny<ScalarOps<uint8_t>>(
+          subject, subject_length, set, start_index, pattern_index);
+  }
+}
+
+const char* SimdSearchImplementation() {
+  switch (GetImplementation()) {
+    case Implementation::kAVX2:
+      return "avx2";
+    case Implementation::kSSE2:
+      return "sse2";
+    case Implementation::kNEON:
+      return "neon";
+    case Implementation::kScalar:
+      return "scalar";
+  }
+  UNREACHABLE();
+}
+
+}  // namespace stringsearch
+}  // namespace node
@@ -0,0 +1,76 @@
+#ifndef SRC_STRING_SEARCH_SIMD_H_
+#define SRC_STRING_SEARCH_SIMD_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include "cpu_features.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace node {
+namespace stringsearch {
+
+// Vectorized substring search for short needles. Candidate positions are
+// found by comparing a whole vector of the subject against the first and the
+// last character of the needle at once, and only the candidates are then
+// verified with memcmp(). This beats the Boyer-Moore variants in
+// string_search.h for short needles since it needs no per-call tables, and
+// it falls behind them for long needles whose skip tables pay off.
+//
+// The implementation (AVX2 or SSE2 on x86-64, NEON on arm64) is picked on
+// first use. Other architectures only get a scalar version and should keep
+// using StringSearch, see kHasSimdSearch.
+
+#if defined(NODE_SIMD_X64) || defined(NODE_SIMD_ARM64)
+constexpr bool kHasSimdSearch = true;
+#else
+constexpr bool kHasSimdSearch = false;
+#endif
+
+// Needles longer than this are left to StringSearch.
+constexpr size_t kSimdSearchMaxNeedleLength = 32;
+
+// Upper bound for the needle count of SimdSearchAny().
+constexpr size_t kSimdSearchMaxNeedles = 16;
+
+// Returns the position of the first match at or after `start_index` or, if
+// `is_forward` is false, of the last match at or before `start_index`.
+// Returns `subject_length` if there is no match. `pattern_length` must be
+// in [1, subject_length].
+size_t SimdSearch(const uint8_t* subject,
+                  size_t subject_length,
+                  const uint8_t* pattern,
+                  size_t pattern_length,
+                  size_t start_index,
+                  bool is_forward);
+size_t SimdSearch(const uint16_t* subject,
+                  size_t subject_length,
+                  const uint16_t* pattern,
+                  size_t pattern_length,
+                  size_t start_index,
+                  bool is_forward);
+
+// Searches for several patterns in a single forward pass, e.g. for the
+// delimiters of a record format. Returns the position of the first match at
+// or after `start_index` and stores the index of the matching pattern in
+// `*pattern_index`; when several patterns match at the same position the one
+// with the lowest index wins. Returns `subject_length` if none matches.
+// Empty patterns are ignored.
+size_t SimdSearchAny(const uint8_t* subject,
+                     size_t subject_length,
+                     const uint8_t* const* patterns,
+                     const size_t* pattern_lengths,
+                     size_t pattern_count,
+                     size_t start_index,
+                     size_t* pattern_index);
+
+// Name of the selected implementation, for tests and diagnostics.
+const char* SimdSearchImplementation();
+
+}  // namespace stringsearch
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_STRING_SEARCH_SIMD_H_
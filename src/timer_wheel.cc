@@ -0,0 +1,218 @@
+#include "timer_wheel.h"
+#include "util.h"
+
+#include <algorithm>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace node {
+namespace timers {
+
+namespace {
+
+inline int CountTrailingZeros(uint64_t mask) {
+  DCHECK_NE(mask, 0);
+#if defined(_MSC_VER) && !defined(__clang__)
+  unsigned long index;  // NOLINT(runtime/int)
+  _BitScanForward64(&index, mask);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctzll(mask);
+#endif
+}
+
+}  // anonymous namespace
+
+// A timer on level n goes into the bucket that ends at the first multiple of
+// 8^n at or after its expiry time; that bucket is emptied once the clock
+// reaches that multiple. The 64 buckets of a level cover consecutive
+// multiples, so a bucket number only has to be unique modulo 64 as long as
+// the delay is under 64 bucket widths. Insertions use a level on which the
+// delay is under 62 widths, which leaves room for rounding the start up.
+
+TimerWheel::TimerWheel() = default;
+
+TimerWheel::Entry* TimerWheel::Find(uint32_t id) {
+  const uint32_t index = id & kIndexMask;
+  if (index >= entries_.size()) return nullptr;
+  Entry* entry = &entries_[index];
+  if (entry->bucket == kFree || entry->generation != id >> kIndexBits)
+    return nullptr;
+  return entry;
+}
+
+uint32_t TimerWheel::Insert(uint64_t expiry) {
+  uint32_t index = free_list_;
+  if (index != kNil) {
+    free_list_ = entries_[index].next;
+  } else {
+    // The last index is left out so that no id equals kInvalidId.
+    if (entries_.size() >= kIndexMask) return kInvalidId;
+    index = static_cast<uint32_t>(entries_.size());
+    entries_.push_back(Entry{0, kNil, kNil, kFree, 0});
+  }
+  Entry& entry = entries_[index];
+  entry.expiry = expiry;
+  Link(index);
+  return index | (uint32_t{entry.generation} << kIndexBits);
+}
+
+bool TimerWheel::Cancel(uint32_t id) {
+  Entry* entry = Find(id);
+  if (entry == nullptr) return false;
+  const uint32_t index = id & kIndexMask;
+  Unlink(index);
+  Release(index);
+  return true;
+}
+
+bool TimerWheel::Reschedule(uint32_t id, uint64_t expiry) {
+  Entry* entry = Find(id);
+  if (entry == nullptr) return false;
+  const uint32_t index = id & kIndexMask;
+  Unlink(index);
+  entry->expiry = expiry;
+  Link(index);
+  return true;
+}
+
+void TimerWheel::Link(uint32_t index) {
+  constexpr uint64_t kRange = kSlots - 2;
+  uint64_t expiry = std::max(entries_[index].expiry, clock_);
+  const uint64_t delta = expiry - clock_;
+  int level = 0;
+  while (level < kLevels - 1 && delta >= kRange << Shift(level)) level++;
+  // Timers past the top level are parked at its far end. Advance() puts
+  // them back once they get there.
+  const int shift = Shift(level);
+  if (delta >= kRange << shift) expiry = clock_ + (kRange << shift);
+  const uint64_t slot =
+      ((expiry + (uint64_t{1} << shift) - 1) >> shift) & (kSlots - 1);
+  Append(level * kSlots + slot, index);
+  occupied_[level] |= uint64_t{1} << slot;
+  size_++;
+}
+
+void TimerWheel::Append(uint16_t bucket, uint32_t index) {
+  List& list = buckets_[bucket];
+  Entry& entry = entries_[index];
+  entry.bucket = bucket;
+  entry.prev = list.tail;
+  entry.next = kNil;
+  if (list.tail == kNil)
+    list.head = index;
+  else
+    entries_[list.tail].next = index;
+  list.tail = index;
+}
+
+void TimerWheel::Unlink(uint32_t index) {
+  Entry& entry = entries_[index];
+  List& list = buckets_[entry.bucket];
+  if (entry.prev == kNil)
+    list.head = entry.next;
+  else
+    entries_[entry.prev].next = entry.next;
+  if (entry.next == kNil)
+    list.tail = entry.prev;
+  else
+    entries_[entry.next].prev = entry.prev;
+  if (entry.bucket == kExpiredList) return;
+  if (list.head == kNil) {
+    occupied_[entry.bucket / kSlots] &=
+        ~(uint64_t{1} << (entry.bucket % kSlots));
+  }
+  size_--;
+}
+
+void TimerWheel::Release(uint32_t index) {
+  Entry& entry = entries_[index];
+  entry.bucket = kFree;
+  entry.generation++;
+  entry.next = free_list_;
+  free_list_ = index;
+}
+
+void TimerWheel::Collect() {
+  uint64_t tick = clock_;
+  for (int level = 0; level < kLevels; level++) {
+    const uint64_t slot = tick & (kSlots - 1);
+    if (occupied_[level] & (uint64_t{1} << slot)) {
+      List& list = buckets_[level * kSlots + slot];
+      for (uint32_t index = list.head; index != kNil;
+           index = entries_[index].next) {
+        due_.push_back(index);
+        size_--;
+      }
+      list = List();
+      occupied_[level] &= ~(uint64_t{1} << slot);
+    }
+    // The next level only has a bucket ending here if the clock is also a
+    // multiple of its width.
+    if (tick & ((1 << kLevelShift) - 1)) break;
+    tick >>= kLevelShift;
+  }
+}
+
+void TimerWheel::Advance(uint64_t now) {
+  while (size_ > 0) {
+    const uint64_t next = NextExpiry();
+    if (next > now) break;
+    clock_ = next;
+    due_.clear();
+    Collect();
+    clock_ = next + 1;
+    std::stable_sort(due_.begin(), due_.end(), [&](uint32_t a, uint32_t b) {
+      return entries_[a].expiry < entries_[b].expiry;
+    });
+    for (uint32_t index : due_) {
+      if (entries_[index].expiry > next)
+        Link(index);
+      else
+        Append(kExpiredList, index);
+    }
+  }
+  if (clock_ <= now) clock_ = now + 1;
+}
+
+size_t TimerWheel::TakeExpired(uint32_t* out, size_t max) {
+  List& expired = buckets_[kExpiredList];
+  size_t count = 0;
+  while (count < max && expired.head != kNil) {
+    const uint32_t index = expired.head;
+    Entry& entry = entries_[index];
+    out[count++] = index | (uint32_t{entry.generation} << kIndexBits);
+    Unlink(index);
+    Release(index);
+  }
+  return count;
+}
+
+uint64_t TimerWheel::NextExpiry() const {
+  uint64_t next = kNoExpiry;
+  for (int level = 0; level < kLevels; level++) {
+    const uint64_t bits = occupied_[level];
+    if (bits == 0) continue;
+    const int shift = Shift(level);
+    // Occupied buckets lie within 64 buckets of the first one that has not
+    // been emptied yet, so the first set bit at or after it (wrapping
+    // around) is the earliest.
+    const uint64_t first = (clock_ + (uint64_t{1} << shift) - 1) >> shift;
+    const int pos = static_cast<int>(first & (kSlots - 1));
+    const uint64_t rotated =
+        pos == 0 ? bits : (bits >> pos) | (bits << (kSlots - pos));
+    const uint64_t end = (first + CountTrailingZeros(rotated)) << shift;
+    next = std::min(next, end);
+  }
+  return next;
+}
+
+size_t TimerWheel::memory_size() const {
+  return entries_.capacity() * sizeof(Entry) +
+         due_.capacity() * sizeof(uint32_t);
+}
+
+}  // namespace timers
+}  // namespace node
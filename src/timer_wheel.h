@@ -0,0 +1,108 @@
+#ifndef SRC_TIMER_WHEEL_H_
+#define SRC_TIMER_WHEEL_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace node {
+namespace timers {
+
+// A hierarchical timing wheel for large numbers of coarse timers, such as
+// per-socket idle timeouts that are nearly always refreshed or cancelled
+// before they fire. Insert(), Cancel() and Reschedule() are O(1) and do not
+// allocate once the entry table has grown to the working set.
+//
+// The wheel has kLevels levels of kSlots buckets. Buckets on level n are
+// 8^n ms wide, so a timer is rounded up to the end of its bucket and may fire
+// up to about an eighth of its delay late, but never early. Timers are never
+// cascaded to finer levels; the cost of that coarseness is what keeps
+// Advance() cheap. Times are milliseconds on the caller's monotonic clock.
+class TimerWheel {
+ public:
+  // Never returned by Insert() for a live timer.
+  static constexpr uint32_t kInvalidId = 0xffffffff;
+  static constexpr uint64_t kNoExpiry = UINT64_MAX;
+
+  TimerWheel();
+  TimerWheel(const TimerWheel&) = delete;
+  TimerWheel& operator=(const TimerWheel&) = delete;
+
+  // Returns kInvalidId if the wheel is full.
+  uint32_t Insert(uint64_t expiry);
+  // Both return false if `id` has already been cancelled or handed out by
+  // TakeExpired().
+  bool Cancel(uint32_t id);
+  bool Reschedule(uint32_t id, uint64_t expiry);
+
+  // Moves every timer that is due at `now` to the expired list. Timers that
+  // become due in the same bucket are queued in order of expiry time. They
+  // can still be cancelled or rescheduled until they are taken.
+  void Advance(uint64_t now);
+  // Removes up to `max` timers from the front of the expired list and writes
+  // their ids to `out`. Returns the number written.
+  size_t TakeExpired(uint32_t* out, size_t max);
+
+  // The earliest time at which Advance() will expire a timer, or kNoExpiry.
+  // Timers that have already expired but not been taken are not included.
+  uint64_t NextExpiry() const;
+
+  size_t size() const { return size_; }
+  size_t memory_size() const;
+
+ private:
+  static constexpr int kLevels = 8;
+  static constexpr int kSlotBits = 6;
+  static constexpr int kSlots = 1 << kSlotBits;
+  static constexpr int kLevelShift = 3;
+  static constexpr uint32_t kIndexBits = 24;
+  static constexpr uint32_t kIndexMask = (1 << kIndexBits) - 1;
+  // Ends every list.
+  static constexpr uint32_t kNil = 0xffffffff;
+  // Bucket numbers past the wheel itself.
+  static constexpr uint16_t kExpiredList = kLevels * kSlots;
+  static constexpr uint16_t kFree = kExpiredList + 1;
+
+  struct Entry {
+    uint64_t expiry;
+    uint32_t prev;
+    uint32_t next;
+    uint16_t bucket;
+    uint8_t generation;
+  };
+
+  struct List {
+    uint32_t head = kNil;
+    uint32_t tail = kNil;
+  };
+
+  static int Shift(int level) { return level * kLevelShift; }
+  Entry* Find(uint32_t id);
+  void Link(uint32_t index);
+  void Append(uint16_t bucket, uint32_t index);
+  void Unlink(uint32_t index);
+  // Puts an unlinked entry on the free list and invalidates its id.
+  void Release(uint32_t index);
+  // Empties the buckets that are due at `clock_` into `due_`.
+  void Collect();
+
+  std::vector<Entry> entries_;
+  uint32_t free_list_ = kNil;
+  List buckets_[kExpiredList + 1];
+  // One bit per non-empty bucket.
+  uint64_t occupied_[kLevels] = {};
+  // No bucket before this time is occupied.
+  uint64_t clock_ = 0;
+  // Timers in the wheel, i.e. not counting the expired list.
+  size_t size_ = 0;
+  std::vector<uint32_t> due_;
+};
+
+}  // namespace timers
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_TIMER_WHEEL_H_
@@ -1,15 +1,20 @@
 #include "timers.h"
 #include "env-inl.h"
+#include "memory_tracker-inl.h"
+#include "node_buffer.h"
 #include "node_external_reference.h"
 #include "util-inl.h"
 #include "v8.h"
 
+#include <cmath>
 #include <cstdint>
 
 namespace node {
 namespace timers {
 
+using v8::Boolean;
 using v8::Context;
+using v8::FastApiTypedArray;
 using v8::Function;
 using v8::FunctionCallbackInfo;
 using v8::FunctionTemplate;
@@ -18,8 +23,21 @@ using v8::Local;
 using v8::Number;
 using v8::Object;
 using v8::ObjectTemplate;
+using v8::Uint32;
 using v8::Value;
 
+namespace {
+
+// Times come from JS as numbers of milliseconds. Anything before the start of
+// the clock is already due, and anything past 2^53 is as good as never.
+uint64_t ToWheelTime(double ms) {
+  if (!(ms > 0)) return 0;
+  if (ms >= 9007199254740992.0) return uint64_t{1} << 53;
+  return static_cast<uint64_t>(ms);
+}
+
+}  // anonymous namespace
+
 void BindingData::SetupTimers(const FunctionCallbackInfo<Value>& args) {
   CHECK(args[0]->IsFunction());
   CHECK(args[1]->IsFunction());
@@ -84,11 +102,112 @@ void BindingData::ToggleImmediateRefImpl(BindingData* data, bool ref) {
   data->env()->ToggleImmediateRef(ref);
 }
 
+void BindingData::SlowTimerWheelInsert(
+    const FunctionCallbackInfo<Value>& args) {
+  CHECK(args[0]->IsNumber());
+  BindingData* data = Realm::GetBindingData<BindingData>(args);
+  const double expiry = args[0].As<Number>()->Value();
+  args.GetReturnValue().Set(
+      data->timer_wheel_.Insert(ToWheelTime(std::ceil(expiry))));
+}
+
+uint32_t BindingData::FastTimerWheelInsert(Local<Object> receiver,
+                                           double expiry) {
+  BindingData* data = FromJSObject<BindingData>(receiver);
+  return data->timer_wheel_.Insert(ToWheelTime(std::ceil(expiry)));
+}
+
+void BindingData::SlowTimerWheelCancel(
+    const FunctionCallbackInfo<Value>& args) {
+  CHECK(args[0]->IsUint32());
+  BindingData* data = Realm::GetBindingData<BindingData>(args);
+  const uint32_t id = args[0].As<Uint32>()->Value();
+  args.GetReturnValue().Set(data->timer_wheel_.Cancel(id));
+}
+
+bool BindingData::FastTimerWheelCancel(Local<Object> receiver, uint32_t id) {
+  return FromJSObject<BindingData>(receiver)->timer_wheel_.Cancel(id);
+}
+
+void BindingData::SlowTimerWheelReschedule(
+    const FunctionCallbackInfo<Value>& args) {
+  CHECK(args[0]->IsUint32());
+  CHECK(args[1]->IsNumber());
+  BindingData* data = Realm::GetBindingData<BindingData>(args);
+  const uint32_t id = args[0].As<Uint32>()->Value();
+  const double expiry = args[1].As<Number>()->Value();
+  args.GetReturnValue().Set(
+      data->timer_wheel_.Reschedule(id, ToWheelTime(std::ceil(expiry))));
+}
+
+bool BindingData::FastTimerWheelReschedule(Local<Object> receiver,
+                                           uint32_t id,
+                                           double expiry) {
+  BindingData* data = FromJSObject<BindingData>(receiver);
+  return data->timer_wheel_.Reschedule(id, ToWheelTime(std::ceil(expiry)));
+}
+
+void BindingData::SlowTimerWheelAdvance(
+    const FunctionCallbackInfo<Value>& args) {
+  CHECK(args[0]->IsNumber());
+  CHECK(args[1]->IsUint32Array());
+  BindingData* data = Realm::GetBindingData<BindingData>(args);
+  uint32_t* expired = reinterpret_cast<uint32_t*>(Buffer::Data(args[1]));
+  const size_t max = Buffer::Length(args[1]) / sizeof(uint32_t);
+  args.GetReturnValue().Set(data->TimerWheelAdvanceImpl(
+      args[0].As<Number>()->Value(), expired, max));
+}
+
+uint32_t BindingData::FastTimerWheelAdvance(
+    Local<Object> receiver,
+    double now,
+    const FastApiTypedArray<uint32_t>& expired) {
+  uint32_t* data;
+  CHECK(expired.getStorageIfAligned(&data));
+  return FromJSObject<BindingData>(receiver)->TimerWheelAdvanceImpl(
+      now, data, expired.length());
+}
+
+// Returns the number of ids written to `expired`. If that is all of it, more
+// timers may be waiting and JS should call again with the same `now`.
+uint32_t BindingData::TimerWheelAdvanceImpl(double now,
+                                            uint32_t* expired,
+                                            size_t max) {
+  timer_wheel_.Advance(ToWheelTime(now));
+  return static_cast<uint32_t>(timer_wheel_.TakeExpired(expired, max));
+}
+
+void BindingData::SlowTimerWheelNextExpiry(
+    const FunctionCallbackInfo<Value>& args) {
+  BindingData* data = Realm::GetBindingData<BindingData>(args);
+  args.GetReturnValue().Set(
+      Number::New(args.GetIsolate(), data->TimerWheelNextExpiryImpl()));
+}
+
+double BindingData::FastTimerWheelNextExpiry(Local<Object> receiver) {
+  return FromJSObject<BindingData>(receiver)->TimerWheelNextExpiryImpl();
+}
+
+// -1 if the wheel is empty.
+double BindingData::TimerWheelNextExpiryImpl() const {
+  const uint64_t next = timer_wheel_.NextExpiry();
+  if (next == TimerWheel::kNoExpiry) return -1;
+  return static_cast<double>(next);
+}
+
 BindingData::BindingData(Realm* realm, Local<Object> object)
     : SnapshotableObject(realm, object, type_int) {}
 
+void BindingData::MemoryInfo(MemoryTracker* tracker) const {
+  tracker->TrackFieldWithSize("timer_wheel", timer_wheel_.memory_size());
+}
+
 bool BindingData::PrepareForSerialization(Local<Context> context,
                                           v8::SnapshotCreator* creator) {
+  // The timer wheel is not serialized, so the deserialized binding starts with
+  // an empty one. Timers cannot be carried over anyway: their deadlines are on
+  // the libuv clock of this process, so the wheel must be empty by now.
+  CHECK_EQ(timer_wheel_.size(), 0);
   // Return true because we need to maintain the reference to the binding from
   // JS land.
   return true;
@@ -121,6 +240,16 @@ v8::CFunction BindingData::fast_toggle_timer_ref_(
     v8::CFunction::Make(FastToggleTimerRef));
 v8::CFunction BindingData::fast_toggle_immediate_ref_(
     v8::CFunction::Make(FastToggleImmediateRef));
+v8::CFunction BindingData::fast_timer_wheel_insert_(
+    v8::CFunction::Make(FastTimerWheelInsert));
+v8::CFunction BindingData::fast_timer_wheel_cancel_(
+    v8::CFunction::Make(FastTimerWheelCancel));
+v8::CFunction BindingData::fast_timer_wheel_reschedule_(
+    v8::CFunction::Make(FastTimerWheelReschedule));
+v8::CFunction BindingData::fast_timer_wheel_advance_(
+    v8::CFunction::Make(FastTimerWheelAdvance));
+v8::CFunction BindingData::fast_timer_wheel_next_expiry_(
+    v8::CFunction::Make(FastTimerWheelNextExpiry));
 
 void BindingData::CreatePerIsolateProperties(IsolateData* isolate_data,
                                              Local<FunctionTemplate> ctor) {
@@ -145,6 +274,31 @@ void BindingData::CreatePerIsolateProperties(IsolateData* isolate_data,
                 "toggleImmediateRef",
                 SlowToggleImmediateRef,
                 &fast_toggle_immediate_ref_);
+  SetFastMethod(isolate,
+                target,
+                "timerWheelInsert",
+                SlowTimerWheelInsert,
+                &fast_timer_wheel_insert_);
+  SetFastMethod(isolate,
+                target,
+                "timerWheelCancel",
+                SlowTimerWheelCancel,
+                &fast_timer_wheel_cancel_);
+  SetFastMethod(isolate,
+                target,
+                "timerWheelReschedule",
+                SlowTimerWheelReschedule,
+                &fast_timer_wheel_reschedule_);
+  SetFastMethod(isolate,
+                target,
+                "timerWheelAdvance",
+                SlowTimerWheelAdvance,
+                &fast_timer_wheel_advance_);
+  SetFastMethod(isolate,
+                target,
+                "timerWheelNextExpiry",
+                SlowTimerWheelNextExpiry,
+                &fast_timer_wheel_next_expiry_);
 }
 
 void BindingData::CreatePerContextProperties(Local<Object> target,
@@ -190,6 +344,26 @@ void BindingData::RegisterTimerExternalReferences(
   registry->Register(SlowToggleImmediateRef);
   registry->Register(FastToggleImmediateRef);
   registry->Register(fast_toggle_immediate_ref_.GetTypeInfo());
+
+  registry->Register(SlowTimerWheelInsert);
+  registry->Register(FastTimerWheelInsert);
+  registry->Register(fast_timer_wheel_insert_.GetTypeInfo());
+
+  registry->Register(SlowTimerWheelCancel);
+  registry->Register(FastTimerWheelCancel);
+  registry->Register(fast_timer_wheel_cancel_.GetTypeInfo());
+
+  registry->Register(SlowTimerWheelReschedule);
+  registry->Register(FastTimerWheelReschedule);
+  registry->Register(fast_timer_wheel_reschedule_.GetTypeInfo());
+
+  registry->Register(SlowTimerWheelAdvance);
+  registry->Register(FastTimerWheelAdvance);
+  registry->Register(fast_timer_wheel_advance_.GetTypeInfo());
+
+  registry->Register(SlowTimerWheelNextExpiry);
+  registry->Register(FastTimerWheelNextExpiry);
+  registry->Register(fast_timer_wheel_next_expiry_.GetTypeInfo());
 }
 
 }  // namespace timers
@@ -5,6 +5,8 @@
 
 #include <cinttypes>
 #include "node_snapshotable.h"
+#include "timer_wheel.h"
+#include "v8-fast-api-calls.h"
 
 namespace node {
 class ExternalReferenceRegistry;
@@ -19,7 +21,7 @@ class BindingData : public SnapshotableObject {
   SET_BINDING_ID(timers_binding_data)
   SERIALIZABLE_OBJECT_METHODS()
 
-  SET_NO_MEMORY_INFO()
+  void MemoryInfo(MemoryTracker* tracker) const override;
   SET_SELF_SIZE(BindingData)
   SET_MEMORY_INFO_NAME(BindingData)
 
@@ -45,6 +47,40 @@ class BindingData : public SnapshotableObject {
   static void FastToggleImmediateRef(v8::Local<v8::Object> receiver, bool ref);
   static void ToggleImmediateRefImpl(BindingData* data, bool ref);
 
+  // The timer wheel is an alternative to the JS timer lists for timers that
+  // are long and usually cancelled, e.g. socket timeouts. Times are in the
+  // getLibuvNow() clock. JS owns the callbacks and looks them up by the ids
+  // that timerWheelAdvance() writes to its Uint32Array; it also has to make
+  // sure scheduleTimer() runs processTimers() by timerWheelNextExpiry().
+  static void SlowTimerWheelInsert(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
+  static uint32_t FastTimerWheelInsert(v8::Local<v8::Object> receiver,
+                                       double expiry);
+
+  static void SlowTimerWheelCancel(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
+  static bool FastTimerWheelCancel(v8::Local<v8::Object> receiver,
+                                   uint32_t id);
+
+  static void SlowTimerWheelReschedule(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
+  static bool FastTimerWheelReschedule(v8::Local<v8::Object> receiver,
+                                       uint32_t id,
+                                       double expiry);
+
+  static void SlowTimerWheelAdvance(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
+  static uint32_t FastTimerWheelAdvance(
+      v8::Local<v8::Object> receiver,
+      double now,
+      const v8::FastApiTypedArray<uint32_t>& expired);
+  uint32_t TimerWheelAdvanceImpl(double now, uint32_t* expired, size_t max);
+
+  static void SlowTimerWheelNextExpiry(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
+  static double FastTimerWheelNextExpiry(v8::Local<v8::Object> receiver);
+  double TimerWheelNextExpiryImpl() const;
+
   static void CreatePerIsolateProperties(IsolateData* isolate_data,
                                          v8::Local<v8::FunctionTemplate> ctor);
   static void CreatePerContextProperties(v8::Local<v8::Object> target,
@@ -55,10 +91,18 @@ class BindingData : public SnapshotableObject {
       ExternalReferenceRegistry* registry);
 
  private:
+  // Not part of the snapshot; see PrepareForSerialization().
+  TimerWheel timer_wheel_;
+
   static v8::CFunction fast_get_libuv_now_;
   static v8::CFunction fast_schedule_timers_;
   static v8::CFunction fast_toggle_timer_ref_;
   static v8::CFunction fast_toggle_immediate_ref_;
+  static v8::CFunction fast_timer_wheel_insert_;
+  static v8::CFunction fast_timer_wheel_cancel_;
+  static v8::CFunction fast_timer_wheel_reschedule_;
+  static v8::CFunction fast_timer_wheel_advance_;
+  static v8::CFunction fast_timer_wheel_next_expiry_;
 };
 
 }  // namespace timers
@@ -2,6 +2,7 @@
 
 #include <cstddef>
 #include <cstring>
+#include <string>
 
 #include "gtest/gtest.h"
 
@@ -140,3 +141,93 @@ TEST(Base64Test, Decode) {
        "dCBjdXBpZGF0YXQgbm9uIHByb2lkZW50LCBzdW50IGluIGN1bHBhIHF1aSBvZmZpY2lh\n"
        "IGRlc2VydW50IG1vbGxpdCBhbmltIGlkIGVzdCBsYWJvcnVtLg", text);
 }
+
+namespace {
+
+std::string MakeBytes(size_t length, uint32_t seed) {
+  std::string bytes(length, '\0');
+  for (size_t i = 0; i < length; i++) {
+    seed = seed * 1103515245 + 12345;
+    bytes[i] = static_cast<char>(seed >> 16);
+  }
+  return bytes;
+}
+
+std::string Encode(const std::string& bytes, node::Base64Mode mode) {
+  std::string encoded(node::base64_encoded_size(bytes.size(), mode), '\0');
+  base64_encode(bytes.data(), bytes.size(), &encoded[0], encoded.size(), mode);
+  return encoded;
+}
+
+// Decodes `encoded` into a buffer with guard bytes past `dstlen` and checks
+// that nothing past the reported length was touched.
+template <typename TypeName>
+std::string Decode(const std::basic_string<TypeName>& encoded,
+                   size_t dstlen) {
+  std::string buffer(dstlen + 64, '\xaa');
+  const size_t written =
+      base64_decode(&buffer[0], dstlen, encoded.data(), encoded.size());
+  EXPECT_LE(written, dstlen);
+  EXPECT_EQ(std::string(buffer.size() - written, '\xaa'),
+            buffer.substr(written));
+  return buffer.substr(0, written);
+}
+
+}  // anonymous namespace
+
+// Inputs that are long enough for the vectorized codec.
+TEST(Base64Test, LongInputs) {
+  for (size_t length : {0, 47, 48, 100, 767, 768, 769, 1000, 3000}) {
+    const std::string bytes = MakeBytes(length, static_cast<uint32_t>(length));
+    const std::string normal = Encode(bytes, node::Base64Mode::NORMAL);
+    const std::string url = Encode(bytes, node::Base64Mode::URL);
+
+    // The URL-safe encoding only differs in the alphabet and the padding.
+    std::string expected_url = normal;
+    for (char& c : expected_url) {
+      if (c == '+') c = '-';
+      if (c == '/') c = '_';
+    }
+    expected_url.erase(expected_url.find_last_not_of('=') + 1);
+    EXPECT_EQ(expected_url, url);
+
+    EXPECT_EQ(bytes, Decode(normal, length));
+    EXPECT_EQ(bytes, Decode(url, length));
+
+    // Mixed alphabets, as accepted by the scalar decoder.
+    std::string mixed = normal.substr(0, normal.size() / 2) +
+                        url.substr(normal.size() / 2);
+    EXPECT_EQ(bytes, Decode(mixed, length));
+
+    // Line breaks and two-byte strings.
+    std::string wrapped;
+    std::u16string wide;
+    for (size_t i = 0; i < normal.size(); i++) {
+      if (i > 0 && i % 76 == 0) wrapped += "\r\n";
+      wrapped += normal[i];
+      wide += static_cast<char16_t>(normal[i]);
+    }
+    EXPECT_EQ(bytes, Decode(wrapped, length));
+    EXPECT_EQ(bytes, Decode(std::u16string(wide), length));
+
+    // Destinations that are too short.
+    EXPECT_EQ(bytes.substr(0, length / 2), Decode(normal, length / 2));
+    EXPECT_EQ(bytes.substr(0, length / 2), Decode(url, length / 2));
+  }
+}
+
+// Decoding stops at padding in the middle of the input. The vectorized codec
+// must not leave garbage behind when it bails out on such input.
+TEST(Base64Test, LongInputsWithEarlyPadding) {
+  const std::string bytes = MakeBytes(2000, 42);
+  const std::string encoded = Encode(bytes, node::Base64Mode::NORMAL);
+  for (size_t cut : {60, 64, 100, 1020, 1024, 1030}) {
+    const std::string input = encoded.substr(0, cut) + "==" + encoded;
+    EXPECT_EQ(bytes.substr(0, cut * 3 / 4), Decode(input, bytes.size()));
+  }
+
+  // Characters outside of the alphabet are skipped.
+  std::string junk = encoded;
+  junk.insert(900, "!*#");
+  EXPECT_EQ(bytes, Decode(junk, bytes.size()));
+}
@@ -0,0 +1,110 @@
+#include "callback_queue-inl.h"
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using node::CallbackQueue;
+namespace CallbackFlags = node::CallbackFlags;
+
+using IntQueue = CallbackQueue<void, std::vector<int>*>;
+
+TEST(CallbackQueueTest, RunsInOrder) {
+  IntQueue queue;
+  std::vector<int> calls;
+  EXPECT_FALSE(queue.Shift());
+  EXPECT_TRUE(queue.idle());
+
+  // Enough callbacks to span several slabs, some of them large.
+  for (int round = 0; round < 3; round++) {
+    for (int n = 0; n < 1000; n++) {
+      if (n % 100 == 0) {
+        std::array<char, 8192> big{};
+        big[0] = static_cast<char>(n % 128);
+        queue.Push([n, big](std::vector<int>* calls) {
+          calls->push_back(big[0] == n % 128 ? n : -1);
+        }, CallbackFlags::kRefed);
+      } else {
+        queue.Push([n](std::vector<int>* calls) { calls->push_back(n); },
+                   n % 2 ? CallbackFlags::kRefed : CallbackFlags::kUnrefed);
+      }
+    }
+    EXPECT_EQ(1000u, queue.size());
+    calls.clear();
+    int n = 0;
+    while (auto head = queue.Shift()) {
+      EXPECT_EQ(n % 2 || n % 100 == 0 ? CallbackFlags::kRefed
+                                      : CallbackFlags::kUnrefed,
+                head->flags());
+      head->Call(&calls);
+      n++;
+    }
+    EXPECT_EQ(1000u, calls.size());
+    for (int i = 0; i < 1000; i++) EXPECT_EQ(i, calls[i]);
+    EXPECT_TRUE(queue.idle());
+  }
+}
+
+TEST(CallbackQueueTest, CallbacksOutliveLaterOnes) {
+  IntQueue queue;
+  std::vector<int> calls;
+  auto counter = std::make_shared<int>(0);
+  for (int n = 0; n < 500; n++) {
+    queue.Push([counter](std::vector<int>*) { (*counter)++; },
+               CallbackFlags::kRefed);
+  }
+  EXPECT_EQ(501, counter.use_count());
+
+  // Hold on to the first callback while the rest are run and destroyed, as
+  // happens when a callback drains the queue re-entrantly.
+  IntQueue::CallbackPointer first = queue.Shift();
+  while (auto head = queue.Shift()) head->Call(&calls);
+  for (int n = 0; n < 500; n++) {
+    queue.Push([counter](std::vector<int>*) {}, CallbackFlags::kRefed);
+    queue.Shift().reset();
+  }
+  EXPECT_EQ(0u, queue.size());
+  EXPECT_FALSE(queue.idle());
+  EXPECT_EQ(2, counter.use_count());
+  first->Call(&calls);
+  first.reset();
+  EXPECT_TRUE(queue.idle());
+  EXPECT_EQ(1, counter.use_count());
+  EXPECT_EQ(500, *counter);
+}
+
+TEST(CallbackQueueTest, Swap) {
+  IntQueue producer;
+  IntQueue consumer;
+  std::vector<int> calls;
+  for (int round = 0; round < 3; round++) {
+    for (int n = 0; n < 10; n++)
+      producer.Push([n](std::vector<int>* calls) { calls->push_back(n); },
+                    CallbackFlags::kRefed);
+    ASSERT_TRUE(consumer.idle());
+    consumer.Swap(&producer);
+    EXPECT_EQ(0u, producer.size());
+    EXPECT_EQ(10u, consumer.size());
+    producer.Push([](std::vector<int>* calls) { calls->push_back(-1); },
+                  CallbackFlags::kRefed);
+    calls.clear();
+    while (auto head = consumer.Shift()) head->Call(&calls);
+    EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}), calls);
+    producer.Shift()->Call(&calls);
+    EXPECT_EQ(-1, calls.back());
+  }
+}
+
+TEST(CallbackQueueTest, DestructorFreesPendingCallbacks) {
+  auto counter = std::make_shared<int>(0);
+  {
+    IntQueue queue;
+    for (int n = 0; n < 100; n++)
+      queue.Push([counter](std::vector<int>*) {}, CallbackFlags::kRefed);
+    queue.Shift().reset();
+    EXPECT_EQ(100, counter.use_count());
+  }
+  EXPECT_EQ(1, counter.use_count());
+}
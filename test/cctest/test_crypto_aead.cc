@@ -0,0 +1,270 @@
+#include "crypto/crypto_aead.h"
+#include "crypto/crypto_keys.h"
+#include "crypto/crypto_util.h"
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+using node::crypto::AEADBatchCipher;
+using node::crypto::AEADBatchConfig;
+using node::crypto::ByteSource;
+using node::crypto::KeyObjectData;
+using node::crypto::kWebCryptoCipherDecrypt;
+using node::crypto::kWebCryptoCipherEncrypt;
+
+namespace {
+
+// Known answers from the GCM specification (McGrew and Viega, test cases 1
+// to 6) and from RFC 8439, section 2.8.2.
+constexpr const char* kGCMKey = "feffe9928665731c6d6a8f9467308308";
+constexpr const char* kGCMPlaintext =
+    "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+    "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39";
+constexpr const char* kGCMAdditionalData =
+    "feedfacedeadbeeffeedfacedeadbeefabaddad2";
+
+struct Vector {
+  std::string nonce;
+  std::string additional_data;
+  std::string input;
+  std::string output;
+  std::string tag;
+};
+
+const std::vector<Vector> kGCMVectors = {
+    // Test case 4, a 96-bit nonce.
+    {"cafebabefacedbaddecaf888",
+     kGCMAdditionalData,
+     kGCMPlaintext,
+     "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+     "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091",
+     "5bc94fbc3221a5db94fae95ae7121a47"},
+    // Test case 5, a 64-bit nonce.
+    {"cafebabefacedbad",
+     kGCMAdditionalData,
+     kGCMPlaintext,
+     "61353b4c2806934a777ff51fa22a4755699b2a714fcdc6f83766e5f97b6c7423"
+     "73806900e49f24b22b097544d4896b424989b5e1ebac0f07c23f4598",
+     "3612d2e79e3b0785561be14aaca2fccb"},
+    // Test case 6, a 480-bit nonce.
+    {"9313225df88406e555909c5aff5269aa6a7a9538534f7da1e4c303d2a318a728"
+     "c3c0c95156809539fcf0e2429a6b525416aedbf5a0de6a57a637b39b",
+     kGCMAdditionalData,
+     kGCMPlaintext,
+     "8ce24998625615b603a033aca13fb894be9112a5c3a211a8ba262a3cca7e2ca7"
+     "01e4a9a4fba43c90ccdcb281d48c7c6fd62875d2aca417034c34aee5",
+     "619cc5aefffe0bfa462af43c1699d050"},
+    // Test case 4 again, so that the nonce length changes back.
+    {"cafebabefacedbaddecaf888",
+     kGCMAdditionalData,
+     kGCMPlaintext,
+     "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+     "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091",
+     "5bc94fbc3221a5db94fae95ae7121a47"},
+};
+
+// Test cases 1 and 2 use an all-zero key, test case 1 has neither additional
+// data nor plaintext.
+const std::vector<Vector> kGCMZeroKeyVectors = {
+    {"000000000000000000000000", "", "", "",
+     "58e2fccefa7e3061367f1d57a4e7455a"},
+    {"000000000000000000000000", "",
+     "00000000000000000000000000000000",
+     "0388dace60b6a392f328c2b971b2fe78",
+     "ab6e47d42cec13bdf53a67b21257bddf"},
+};
+
+constexpr const char* kChaChaKey =
+    "808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f";
+
+std::string ToHex(const std::string& bytes) {
+  static const char digits[] = "0123456789abcdef";
+  std::string hex;
+  for (unsigned char c : bytes) {
+    hex += digits[c >> 4];
+    hex += digits[c & 15];
+  }
+  return hex;
+}
+
+std::string FromHex(const std::string& hex) {
+  std::string bytes;
+  for (size_t i = 0; i < hex.size(); i += 2)
+    bytes += static_cast<char>(std::stoi(hex.substr(i, 2), nullptr, 16));
+  return bytes;
+}
+
+ByteSource Copy(const std::string& bytes) {
+  ByteSource::Builder out(bytes.size());
+  if (!bytes.empty()) memcpy(out.data<char>(), bytes.data(), bytes.size());
+  return std::move(out).release();
+}
+
+struct Record {
+  std::string nonce;
+  std::string additional_data;
+  std::string input;
+};
+
+// Packs |records| the same way AEADBatchJob::New does.
+AEADBatchConfig MakeConfig(const EVP_CIPHER* cipher,
+                           const std::string& key,
+                           bool encrypt,
+                           unsigned int tag_length,
+                           const std::vector<Record>& records) {
+  AEADBatchConfig config;
+  config.mode = node::crypto::kCryptoJobSync;
+  config.cipher_mode =
+      encrypt ? kWebCryptoCipherEncrypt : kWebCryptoCipherDecrypt;
+  config.cipher = cipher;
+  config.key = KeyObjectData::CreateSecret(Copy(key));
+  config.tag_length = tag_length;
+  config.output_length = 0;
+
+  std::string data;
+  for (const Record& record : records) {
+    const size_t offset = data.size();
+    config.records.push_back({
+        offset,
+        record.nonce.size(),
+        offset + record.nonce.size(),
+        record.additional_data.size(),
+        offset + record.nonce.size() + record.additional_data.size(),
+        record.input.size(),
+    });
+    data += record.nonce + record.additional_data + record.input;
+    config.output_length += encrypt ? record.input.size() + tag_length
+                                    : record.input.size() - tag_length;
+  }
+  config.data = Copy(data);
+  return config;
+}
+
+std::vector<Record> EncryptRecords(const std::vector<Vector>& vectors) {
+  std::vector<Record> records;
+  for (const Vector& v : vectors) {
+    records.push_back(
+        {FromHex(v.nonce), FromHex(v.additional_data), FromHex(v.input)});
+  }
+  return records;
+}
+
+std::vector<Record> DecryptRecords(const std::vector<Vector>& vectors,
+                                   unsigned int tag_length) {
+  std::vector<Record> records;
+  for (const Vector& v : vectors) {
+    const std::string input =
+        FromHex(v.output) + FromHex(v.tag).substr(0, tag_length);
+    records.push_back({FromHex(v.nonce), FromHex(v.additional_data), input});
+  }
+  return records;
+}
+
+std::string RunBatch(const AEADBatchConfig& config, bool* ok) {
+  ByteSource out;
+  *ok = AEADBatchCipher(config, &out);
+  return *ok ? std::string(out.data<char>(), out.size()) : std::string();
+}
+
+// Checks that encrypting |vectors| as one batch gives each ciphertext followed
+// by the first |tag_length| bytes of its tag, and that decrypting that gives
+// the plaintexts back.
+void ExpectBatch(const EVP_CIPHER* cipher,
+                 const std::string& key,
+                 const std::vector<Vector>& vectors,
+                 unsigned int tag_length) {
+  std::string expected_ciphertext;
+  std::string expected_plaintext;
+  for (const Vector& v : vectors) {
+    expected_ciphertext += v.output + v.tag.substr(0, tag_length * 2);
+    expected_plaintext += v.input;
+  }
+
+  bool ok;
+  std::string ciphertext = RunBatch(
+      MakeConfig(cipher, key, true, tag_length, EncryptRecords(vectors)), &ok);
+  ASSERT_TRUE(ok);
+  EXPECT_EQ(expected_ciphertext, ToHex(ciphertext));
+
+  std::string plaintext = RunBatch(
+      MakeConfig(
+          cipher, key, false, tag_length, DecryptRecords(vectors, tag_length)),
+      &ok);
+  ASSERT_TRUE(ok);
+  EXPECT_EQ(expected_plaintext, ToHex(plaintext));
+}
+
+}  // anonymous namespace
+
+TEST(AEADBatchTest, AESGCMKnownAnswers) {
+  for (unsigned int tag_length : {16u, 12u, 8u, 4u}) {
+    ExpectBatch(EVP_aes_128_gcm(), FromHex(kGCMKey), kGCMVectors, tag_length);
+  }
+}
+
+TEST(AEADBatchTest, AESGCMEmptyAdditionalDataAndPlaintext) {
+  ExpectBatch(EVP_aes_128_gcm(),
+              std::string(16, '\0'),
+              kGCMZeroKeyVectors,
+              16);
+}
+
+TEST(AEADBatchTest, ChaCha20Poly1305KnownAnswers) {
+  const Vector rfc8439 = {
+      "070000004041424344454647",
+      "50515253c0c1c2c3c4c5c6c7",
+      ToHex("Ladies and Gentlemen of the class of '99: If I could offer you "
+            "only one tip for the future, sunscreen would be it."),
+      "d31a8d34648e60db7b86afbc53ef7ec2a4aded51296e08fea9e2b5a736ee62d6"
+      "3dbea45e8ca9671282fafb69da92728b1a71de0a9e060b2905d6a5b67ecd3b36"
+      "92ddbd7f2d778b8c9803aee328091b58fab324e4fad675945585808b4831d7bc"
+      "3ff4def08e4b7a9de576d26586cec64b6116",
+      "1ae10b594f09e26a7e902ecbd0600691"};
+  for (unsigned int tag_length : {16u, 8u}) {
+    ExpectBatch(EVP_chacha20_poly1305(),
+                FromHex(kChaChaKey),
+                {rfc8439, rfc8439},
+                tag_length);
+  }
+}
+
+TEST(AEADBatchTest, ChaCha20Poly1305EmptyPlaintextRoundTrips) {
+  const std::string key = FromHex(kChaChaKey);
+  const std::vector<Record> records = {
+      {std::string(12, '\1'), "", ""},
+      {std::string(12, '\2'), "additional data", ""},
+  };
+  bool ok;
+  std::string ciphertext = RunBatch(
+      MakeConfig(EVP_chacha20_poly1305(), key, true, 16, records), &ok);
+  ASSERT_TRUE(ok);
+  ASSERT_EQ(32u, ciphertext.size());
+
+  std::vector<Record> decrypt = records;
+  decrypt[0].input = ciphertext.substr(0, 16);
+  decrypt[1].input = ciphertext.substr(16);
+  std::string plaintext = RunBatch(
+      MakeConfig(EVP_chacha20_poly1305(), key, false, 16, decrypt), &ok);
+  EXPECT_TRUE(ok);
+  EXPECT_EQ("", plaintext);
+}
+
+TEST(AEADBatchTest, TamperedRecordFailsTheBatch) {
+  const std::string key = FromHex(kGCMKey);
+  for (size_t byte : {0u, 59u, 60u, 75u}) {
+    std::vector<Record> records = DecryptRecords(kGCMVectors, 16);
+    // Flip a bit in the ciphertext or in the tag of one record in the middle.
+    records[1].input[byte] ^= 1;
+    bool ok;
+    RunBatch(MakeConfig(EVP_aes_128_gcm(), key, false, 16, records), &ok);
+    EXPECT_FALSE(ok) << "byte " << byte;
+  }
+
+  std::vector<Record> records = DecryptRecords(kGCMVectors, 16);
+  records[2].additional_data[0] ^= 1;
+  bool ok;
+  RunBatch(MakeConfig(EVP_aes_128_gcm(), key, false, 16, records), &ok);
+  EXPECT_FALSE(ok);
+}
@@ -0,0 +1,160 @@
+#include "crypto/crypto_random.h"
+#include "env-inl.h"
+#include "gtest/gtest.h"
+#include "node_realm-inl.h"
+#include "node_test_fixture.h"
+
+#include <algorithm>
+#include <vector>
+
+using node::crypto::RandomPool;
+
+class RandomPoolTest : public EnvironmentTestFixture {
+ protected:
+  static constexpr size_t kBufferSize = RandomPool::kBufferSize;
+  static constexpr size_t kRefillThreshold = RandomPool::kRefillThreshold;
+  static constexpr size_t kMaxPooledSize = RandomPool::kMaxPooledSize;
+
+  static size_t Offset(RandomPool* pool) { return pool->offset_; }
+  static const unsigned char* Buffer(RandomPool* pool) {
+    return pool->buffer_.get();
+  }
+  static const unsigned char* Spare(RandomPool* pool) {
+    return pool->spare_.get();
+  }
+  static bool IsRefilling(RandomPool* pool) {
+    return pool->refill_ != nullptr;
+  }
+  // What the pool sees in a child process after fork().
+  static void PretendToBeForked(RandomPool* pool) {
+    pool->fork_generation_--;
+  }
+
+  static bool IsZero(const unsigned char* data, size_t size) {
+    return std::all_of(data, data + size, [](unsigned char c) {
+      return c == 0;
+    });
+  }
+
+  // Takes |size| bytes from the pool and checks that they are wiped from it.
+  static void Take(RandomPool* pool, size_t size) {
+    std::vector<unsigned char> out(size);
+    ASSERT_TRUE(pool->Fill(out.data(), size));
+    ASSERT_NE(nullptr, Buffer(pool));
+    ASSERT_GE(Offset(pool), size);
+    EXPECT_TRUE(IsZero(Buffer(pool) + Offset(pool) - size, size));
+  }
+
+  // Takes from the pool until a refill has been started.
+  static void TakeUntilRefill(RandomPool* pool) {
+    while (!IsRefilling(pool)) {
+      Take(pool, kMaxPooledSize);
+      ASSERT_LE(Offset(pool), kBufferSize);
+    }
+    EXPECT_LT(kBufferSize - Offset(pool), kRefillThreshold);
+  }
+
+  static void RunLoop() { uv_run(&current_loop, UV_RUN_DEFAULT); }
+};
+
+TEST_F(RandomPoolTest, CreatedOnce) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+  v8::Context::Scope context_scope(env.context());
+
+  RandomPool* pool = RandomPool::Get((*env)->principal_realm());
+  ASSERT_NE(nullptr, pool);
+  EXPECT_EQ(pool, RandomPool::Get((*env)->principal_realm()));
+}
+
+TEST_F(RandomPoolTest, EmptyAndLargeRequestsBypassThePool) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+  v8::Context::Scope context_scope(env.context());
+  RandomPool* pool = RandomPool::Get((*env)->principal_realm());
+
+  // Before anything has been pooled, there is no buffer to take from.
+  EXPECT_TRUE(pool->Fill(nullptr, 0));
+  EXPECT_EQ(nullptr, Buffer(pool));
+
+  std::vector<unsigned char> out(kMaxPooledSize + 1);
+  EXPECT_TRUE(pool->Fill(out.data(), out.size()));
+  EXPECT_FALSE(IsZero(out.data(), out.size()));
+  EXPECT_EQ(nullptr, Buffer(pool));
+  EXPECT_FALSE(IsRefilling(pool));
+
+  Take(pool, 16);
+  EXPECT_TRUE(pool->Fill(out.data(), 0));
+  EXPECT_EQ(16u, Offset(pool));
+}
+
+TEST_F(RandomPoolTest, SwapsInTheSpare) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+  v8::Context::Scope context_scope(env.context());
+  RandomPool* pool = RandomPool::Get((*env)->principal_realm());
+
+  // The first request fills the buffer synchronously.
+  Take(pool, kMaxPooledSize);
+  EXPECT_EQ(kMaxPooledSize, Offset(pool));
+  EXPECT_FALSE(IsRefilling(pool));
+
+  // Crossing the threshold fills the spare on the threadpool.
+  TakeUntilRefill(pool);
+  EXPECT_EQ(nullptr, Spare(pool));
+  RunLoop();
+  EXPECT_FALSE(IsRefilling(pool));
+  const unsigned char* spare = Spare(pool);
+  ASSERT_NE(nullptr, spare);
+
+  // Once the buffer runs out, the spare takes its place.
+  while (kBufferSize - Offset(pool) >= kMaxPooledSize)
+    Take(pool, kMaxPooledSize);
+  Take(pool, kMaxPooledSize);
+  EXPECT_EQ(spare, Buffer(pool));
+  EXPECT_EQ(kMaxPooledSize, Offset(pool));
+  EXPECT_EQ(nullptr, Spare(pool));
+}
+
+TEST_F(RandomPoolTest, RefillsSynchronouslyWithoutSpare) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+  v8::Context::Scope context_scope(env.context());
+  RandomPool* pool = RandomPool::Get((*env)->principal_realm());
+
+  // Run out of the buffer before the refill has come back.
+  TakeUntilRefill(pool);
+  while (kBufferSize - Offset(pool) >= kMaxPooledSize)
+    Take(pool, kMaxPooledSize);
+  Take(pool, kMaxPooledSize);
+  EXPECT_EQ(kMaxPooledSize, Offset(pool));
+  EXPECT_EQ(nullptr, Spare(pool));
+  EXPECT_TRUE(IsRefilling(pool));
+
+  // The refill that was in flight still becomes the spare.
+  RunLoop();
+  EXPECT_NE(nullptr, Spare(pool));
+}
+
+TEST_F(RandomPoolTest, DiscardedAfterFork) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+  v8::Context::Scope context_scope(env.context());
+  RandomPool* pool = RandomPool::Get((*env)->principal_realm());
+
+  TakeUntilRefill(pool);
+  RunLoop();
+  ASSERT_NE(nullptr, Spare(pool));
+
+  // Neither the rest of the buffer nor the spare is used after a fork.
+  PretendToBeForked(pool);
+  Take(pool, 16);
+  EXPECT_EQ(16u, Offset(pool));
+  EXPECT_EQ(nullptr, Spare(pool));
+  EXPECT_FALSE(IsRefilling(pool));
+}
@@ -4,7 +4,9 @@
 #include <util-inl.h>
 #include <v8.h>
 #include <memory>
+#include <string>
 #include <vector>
+#include "node_test_fixture.h"
 
 using node::DataQueue;
 using v8::ArrayBuffer;
@@ -658,3 +660,224 @@ TEST(DataQueue, DataQueueEntry) {
   CHECK(!pullIsPending);
   CHECK_EQ(status, node::bob::STATUS_CONTINUE);
 }
+
+TEST(DataQueue, Extents) {
+  char buffer1[] = "hello world";
+  char buffer2[] = "what fun this is";
+  size_t len1 = strlen(buffer1);
+  size_t len2 = strlen(buffer2);
+
+  std::shared_ptr<BackingStore> store1 = ArrayBuffer::NewBackingStore(
+      &buffer1, len1, [](void*, size_t, void*) {}, nullptr);
+
+  std::shared_ptr<BackingStore> store2 = ArrayBuffer::NewBackingStore(
+      &buffer2, len2, [](void*, size_t, void*) {}, nullptr);
+
+  std::vector<std::unique_ptr<DataQueue::Entry>> inner_list;
+  inner_list.push_back(
+      DataQueue::CreateInMemoryEntryFromBackingStore(store2, 5, 3));
+  std::shared_ptr<DataQueue> inner =
+      DataQueue::CreateIdempotent(std::move(inner_list));
+
+  std::vector<std::unique_ptr<DataQueue::Entry>> list;
+  list.push_back(
+      DataQueue::CreateInMemoryEntryFromBackingStore(store1, 0, len1));
+  list.push_back(DataQueue::CreateInMemoryEntryFromBackingStore(store2, 0, 0));
+  list.push_back(DataQueue::CreateDataQueueEntry(inner));
+  std::shared_ptr<DataQueue> data_queue =
+      DataQueue::CreateIdempotent(std::move(list));
+  CHECK_NOT_NULL(data_queue);
+
+  // Empty entries are skipped and nested queues are flattened. The extents
+  // refer to the original stores without copying.
+  std::vector<DataQueue::Extent> extents;
+  CHECK(data_queue->GetExtents(&extents));
+  CHECK_EQ(extents.size(), 2);
+  CHECK_EQ(extents[0].store, store1);
+  CHECK_EQ(extents[0].offset, 0);
+  CHECK_EQ(extents[0].length, len1);
+  CHECK_EQ(extents[1].store, store2);
+  CHECK_EQ(extents[1].offset, 5);
+  CHECK_EQ(extents[1].length, 3);
+
+  uv_file fds[2];
+  CHECK_EQ(uv_pipe(fds, 0, 0), 0);
+  uint64_t written = 0;
+  CHECK_EQ(DataQueue::WriteExtents(extents, fds[1], &written), 0);
+  CHECK_EQ(written, len1 + 3);
+
+  char out[32] = {};
+  uv_buf_t buf = uv_buf_init(out, sizeof(out));
+  uv_fs_t req;
+  CHECK_EQ(uv_fs_read(nullptr, &req, fds[0], &buf, 1, -1, nullptr),
+           static_cast<int>(written));
+  uv_fs_req_cleanup(&req);
+  CHECK_EQ(memcmp(out, "hello worldfun", written), 0);
+  uv_fs_close(nullptr, &req, fds[0], nullptr);
+  uv_fs_req_cleanup(&req);
+  uv_fs_close(nullptr, &req, fds[1], nullptr);
+  uv_fs_req_cleanup(&req);
+
+  // Non-idempotent queues can only be read through a Reader.
+  std::shared_ptr<DataQueue> data_queue2 = DataQueue::Create();
+  CHECK(data_queue2
+            ->append(DataQueue::CreateInMemoryEntryFromBackingStore(
+                store1, 0, len1))
+            .value());
+  std::vector<DataQueue::Extent> extents2;
+  CHECK(!data_queue2->GetExtents(&extents2));
+}
+
+#ifndef _WIN32
+TEST(DataQueue, WriteExtentsToFullPipe) {
+  // More than a pipe holds, with nobody reading it.
+  const size_t length = 4 * 1024 * 1024;
+  std::shared_ptr<BackingStore> store =
+      ArrayBuffer::NewBackingStore(nullptr, length);
+  std::vector<std::unique_ptr<DataQueue::Entry>> list;
+  list.push_back(
+      DataQueue::CreateInMemoryEntryFromBackingStore(store, 0, length));
+  std::shared_ptr<DataQueue> data_queue =
+      DataQueue::CreateIdempotent(std::move(list));
+  std::vector<DataQueue::Extent> extents;
+  CHECK(data_queue->GetExtents(&extents));
+
+  // The wait for the pipe to drain is bounded, and the caller learns how
+  // much got through.
+  uv_file fds[2];
+  CHECK_EQ(uv_pipe(fds, UV_NONBLOCK_PIPE, UV_NONBLOCK_PIPE), 0);
+  uint64_t written = 0;
+  CHECK_EQ(DataQueue::WriteExtents(extents, fds[1], &written), UV_EAGAIN);
+  CHECK_GT(written, 0);
+  CHECK_LT(written, length);
+
+  uv_fs_t req;
+  uv_fs_close(nullptr, &req, fds[0], nullptr);
+  uv_fs_req_cleanup(&req);
+  uv_fs_close(nullptr, &req, fds[1], nullptr);
+  uv_fs_req_cleanup(&req);
+}
+#endif  // _WIN32
+
+class DataQueueFdEntryTest : public EnvironmentTestFixture {};
+
+TEST_F(DataQueueFdEntryTest, ReadAhead) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+
+  char tmpdir[1024];
+  size_t tmpdir_size = sizeof(tmpdir);
+  CHECK_EQ(uv_os_tmpdir(tmpdir, &tmpdir_size), 0);
+  const std::string pattern = std::string(tmpdir) + "/dataqueue-XXXXXX";
+
+  // Large enough for several reads to be in flight at once and for them to
+  // grow past the initial 64 KiB, but not to time the reader; that is what
+  // benchmark/blob/file-read.js is for.
+  constexpr size_t kSize = 2 * 1024 * 1024 + 12345;
+  std::vector<char> contents(kSize);
+  for (size_t n = 0; n < kSize; n++)
+    contents[n] = static_cast<char>(n * 131 + (n >> 16));
+
+  uv_fs_t req;
+  const uv_file file = uv_fs_mkstemp(nullptr, &req, pattern.c_str(), nullptr);
+  CHECK_GE(file, 0);
+  const std::string path = req.path;
+  uv_fs_req_cleanup(&req);
+  uv_buf_t buf = uv_buf_init(contents.data(), kSize);
+  CHECK_EQ(uv_fs_write(nullptr, &req, file, &buf, 1, 0, nullptr),
+           static_cast<int>(kSize));
+  uv_fs_req_cleanup(&req);
+  uv_fs_close(nullptr, &req, file, nullptr);
+  uv_fs_req_cleanup(&req);
+
+  std::vector<std::unique_ptr<DataQueue::Entry>> list;
+  list.push_back(DataQueue::CreateFdEntry(
+      *env, v8::String::NewFromUtf8(isolate_, path.c_str()).ToLocalChecked()));
+  CHECK_NOT_NULL(list[0]);
+  std::shared_ptr<DataQueue> data_queue =
+      DataQueue::CreateIdempotent(std::move(list));
+  CHECK_NOT_NULL(data_queue);
+  CHECK_EQ(data_queue->size().value(), kSize);
+
+  // Read the whole file twice, through two readers of the idempotent queue.
+  for (int pass = 0; pass < 2; pass++) {
+    std::shared_ptr<DataQueue::Reader> reader = data_queue->get_reader();
+    CHECK_NOT_NULL(reader);
+
+    // The reads complete in any order, but their data has to come out in
+    // file order, and then end exactly at the end of the file.
+    size_t offset = 0;
+    bool ended = false;
+    while (!ended) {
+      bool waitingForPull = true;
+      reader->Pull(
+          [&](int status, const DataQueue::Vec* vecs, size_t count, auto done) {
+            waitingForPull = false;
+            if (status == node::bob::STATUS_EOS) {
+              ended = true;
+              return;
+            }
+            CHECK_EQ(status, node::bob::STATUS_CONTINUE);
+            CHECK_GT(count, 0);
+            for (size_t n = 0; n < count; n++) {
+              CHECK_GT(vecs[n].len, 0);
+              CHECK_LE(offset + vecs[n].len, kSize);
+              CHECK_EQ(
+                  memcmp(vecs[n].base, contents.data() + offset, vecs[n].len),
+                  0);
+              offset += vecs[n].len;
+            }
+            std::move(done)(0);
+          },
+          node::bob::OPTIONS_END,
+          nullptr,
+          0,
+          node::bob::kMaxCountHint);
+      while (waitingForPull) uv_run(&current_loop, UV_RUN_ONCE);
+    }
+    CHECK_EQ(offset, kSize);
+
+    // Pulling again after the end still reports the end.
+    bool waitingForPull = true;
+    reader->Pull(
+        [&](int status, const DataQueue::Vec* vecs, size_t count, auto done) {
+          waitingForPull = false;
+          CHECK_EQ(status, node::bob::STATUS_EOS);
+          CHECK_EQ(count, 0);
+        },
+        node::bob::OPTIONS_END,
+        nullptr,
+        0,
+        node::bob::kMaxCountHint);
+    while (waitingForPull) uv_run(&current_loop, UV_RUN_ONCE);
+  }
+
+  // A file that changed after the entry was created is no longer readable.
+  const uv_file writer =
+      uv_fs_open(nullptr, &req, path.c_str(), O_WRONLY, 0, nullptr);
+  CHECK_GE(writer, 0);
+  uv_fs_req_cleanup(&req);
+  buf = uv_buf_init(contents.data(), 1);
+  CHECK_EQ(uv_fs_write(nullptr, &req, writer, &buf, 1, kSize, nullptr), 1);
+  uv_fs_req_cleanup(&req);
+  uv_fs_close(nullptr, &req, writer, nullptr);
+  uv_fs_req_cleanup(&req);
+
+  std::shared_ptr<DataQueue::Reader> reader = data_queue->get_reader();
+  bool waitingForPull = true;
+  int status = reader->Pull(
+      [&](int status, const DataQueue::Vec* vecs, size_t count, auto done) {
+        waitingForPull = false;
+        CHECK_EQ(status, UV_EINVAL);
+      },
+      node::bob::OPTIONS_END,
+      nullptr,
+      0,
+      node::bob::kMaxCountHint);
+  CHECK(!waitingForPull);
+  CHECK_EQ(status, UV_EINVAL);
+
+  uv_fs_unlink(nullptr, &req, path.c_str(), nullptr);
+  uv_fs_req_cleanup(&req);
+}
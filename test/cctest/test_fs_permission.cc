@@ -0,0 +1,197 @@
+#include "gtest/gtest.h"
+#include "permission/fs_permission.h"
+
+#include <future>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using node::arraysize;
+using node::kPathSeparator;
+using node::permission::FSPermission;
+
+class RadixTreeTest : public ::testing::Test {
+ protected:
+  using RadixTree = FSPermission::RadixTree;
+  using Node = RadixTree::Node;
+
+  // The lookup as it was before the tree was compiled into flat nodes, which
+  // walks the Node tree directly.
+  static bool ReferenceLookup(RadixTree* tree, const std::string& path) {
+    Node* current_node = tree->root_node_;
+    if (current_node->children.size() == 0) {
+      return false;
+    }
+
+    unsigned int parent_node_prefix_len = current_node->prefix.length();
+    auto path_len = path.length();
+
+    while (true) {
+      if (parent_node_prefix_len == path_len && current_node->IsEndNode()) {
+        return true;
+      }
+
+      auto node = current_node->NextNode(path, parent_node_prefix_len);
+      if (node == nullptr) {
+        return false;
+      }
+
+      current_node = node;
+      parent_node_prefix_len += current_node->prefix.length();
+      if (current_node->wildcard_child != nullptr &&
+          path_len >= (parent_node_prefix_len - 2 /* slash* */)) {
+        return true;
+      }
+    }
+  }
+
+  static std::string Path(std::initializer_list<const char*> segments) {
+    std::string path;
+    for (const char* segment : segments) {
+      path += kPathSeparator;
+      path += segment;
+    }
+    return path;
+  }
+};
+
+TEST_F(RadixTreeTest, MatchesReferenceOnWildcardsAndSeparators) {
+  const std::string sep(1, kPathSeparator);
+  const std::vector<std::string> grants = {
+      Path({"home", "user", "*"}),
+      Path({"home", "user", "file.js"}),
+      Path({"tmp"}) + sep + "*",
+      Path({"slower*"}),
+      Path({"slown*"}),
+      Path({"slow*"}),
+      Path({"var", "log"}),
+      Path({"var", "lib", "a*"}),
+  };
+  const std::vector<std::string> paths = {
+      "",
+      sep,
+      Path({"home"}),
+      Path({"home", "user"}),
+      Path({"home", "user"}) + sep,
+      Path({"home", "user", "a", "b"}),
+      Path({"home", "use"}),
+      Path({"home", "user2"}),
+      Path({"home", "user", "file.js"}),
+      Path({"home", "user", "file.jsx"}),
+      Path({"tmp"}),
+      Path({"tmp"}) + sep,
+      Path({"tmpfile"}),
+      Path({"slow"}),
+      Path({"slower"}),
+      Path({"slowest"}),
+      Path({"slown", "x"}),
+      Path({"slo"}),
+      Path({"var", "log"}),
+      Path({"var", "log"}) + sep,
+      Path({"var", "log", "syslog"}),
+      Path({"var", "lo"}),
+      Path({"var", "lib", "a"}),
+      Path({"var", "lib", "abc", "d"}),
+      Path({"var", "lib", "b"}),
+  };
+
+  RadixTree tree;
+  for (const std::string& grant : grants) {
+    tree.Insert(grant);
+    for (const std::string& path : paths) {
+      // The second lookup is answered by the cache.
+      const bool expected = ReferenceLookup(&tree, path);
+      EXPECT_EQ(expected, tree.Lookup(path)) << grant << " " << path;
+      EXPECT_EQ(expected, tree.Lookup(path)) << grant << " " << path;
+    }
+  }
+}
+
+TEST_F(RadixTreeTest, MatchesReferenceOnRandomTrees) {
+  static const char* const kSegments[] = {"a", "b", "ab", "ba", "aab"};
+  std::mt19937 rng(42);
+  auto pick = [&](size_t n) {
+    return std::uniform_int_distribution<size_t>(0, n - 1)(rng);
+  };
+  auto random_path = [&]() {
+    std::string path;
+    for (size_t n = pick(4); n > 0; n--) {
+      path += kPathSeparator;
+      path += kSegments[pick(arraysize(kSegments))];
+    }
+    return path;
+  };
+
+  for (int round = 0; round < 200; round++) {
+    RadixTree tree;
+    for (size_t n = 1 + pick(8); n > 0; n--) {
+      std::string grant = random_path();
+      switch (pick(3)) {
+        case 0:
+          grant += kPathSeparator;
+          grant += '*';
+          break;
+        case 1:
+          grant += '*';
+          break;
+      }
+      if (grant.empty()) continue;
+      tree.Insert(grant);
+    }
+    // Enough lookups to evict entries from the cache over and over.
+    for (int i = 0; i < 500; i++) {
+      std::string path = random_path();
+      if (pick(4) == 0) path += kPathSeparator;
+      const bool expected = ReferenceLookup(&tree, path);
+      ASSERT_EQ(expected, tree.Lookup(path)) << "round " << round << " "
+                                             << path;
+    }
+  }
+}
+
+TEST_F(RadixTreeTest, CacheIsInvalidatedByGrants) {
+  const std::string file = Path({"b", "file"});
+
+  RadixTree tree;
+  tree.Insert(Path({"a", "*"}));
+  EXPECT_FALSE(tree.Lookup(file));
+  tree.Insert(Path({"b", "*"}));
+  EXPECT_TRUE(tree.Lookup(file));
+
+  // Trees never share entries, even if one takes the place of another.
+  {
+    RadixTree other;
+    other.Insert(Path({"a", "*"}));
+    EXPECT_FALSE(other.Lookup(file));
+  }
+  RadixTree replacement;
+  replacement.Insert(Path({"b", "*"}));
+  EXPECT_TRUE(replacement.Lookup(file));
+  EXPECT_TRUE(tree.Lookup(file));
+}
+
+TEST_F(RadixTreeTest, CacheIsInvalidatedOnOtherThreads) {
+  const std::string file = Path({"b", "file"});
+  RadixTree tree;
+  tree.Insert(Path({"a", "*"}));
+
+  // The other thread caches a denial, then looks again after the grant.
+  std::promise<void> looked_up;
+  std::promise<void> granted;
+  bool before = true;
+  bool after = false;
+  std::thread thread([&]() {
+    before = tree.Lookup(file);
+    looked_up.set_value();
+    granted.get_future().wait();
+    after = tree.Lookup(file);
+  });
+  looked_up.get_future().wait();
+  tree.Insert(Path({"b", "*"}));
+  granted.set_value();
+  thread.join();
+
+  EXPECT_FALSE(before);
+  EXPECT_TRUE(after);
+}
@@ -0,0 +1,103 @@
+#include "hex_simd.h"
+
+#include <cctype>
+#include <cstdint>
+#include <string>
+
+#include "gtest/gtest.h"
+
+using node::hex::DecodeBlocks;
+using node::hex::EncodeBlocks;
+using node::hex::SimdImplementation;
+
+namespace {
+
+std::string MakeBytes(size_t length) {
+  std::string bytes(length, '\0');
+  for (size_t i = 0; i < length; i++)
+    bytes[i] = static_cast<char>(i * 37 + (i >> 8));
+  return bytes;
+}
+
+std::string ReferenceEncode(const std::string& bytes) {
+  static const char digits[] = "0123456789abcdef";
+  std::string hex;
+  for (char c : bytes) {
+    hex += digits[static_cast<uint8_t>(c) >> 4];
+    hex += digits[static_cast<uint8_t>(c) & 15];
+  }
+  return hex;
+}
+
+const uint8_t* Data(const std::string& str) {
+  return reinterpret_cast<const uint8_t*>(str.data());
+}
+
+}  // anonymous namespace
+
+TEST(HexSimdTest, Encode) {
+  for (size_t length : {0, 1, 15, 16, 17, 31, 32, 33, 64, 100, 1000}) {
+    const std::string bytes = MakeBytes(length);
+    const std::string expected = ReferenceEncode(bytes);
+    std::string hex(2 * length + 1, '!');
+    const size_t done = EncodeBlocks(Data(bytes), length, &hex[0]);
+    EXPECT_LE(done, length);
+    EXPECT_EQ(expected.substr(0, 2 * done), hex.substr(0, 2 * done))
+        << SimdImplementation() << " length=" << length;
+    // Nothing is written past the encoded blocks.
+    EXPECT_EQ(std::string(2 * (length - done) + 1, '!'), hex.substr(2 * done))
+        << SimdImplementation() << " length=" << length;
+  }
+}
+
+TEST(HexSimdTest, Decode) {
+  for (size_t length : {0, 1, 15, 16, 17, 31, 32, 33, 64, 100, 1000}) {
+    const std::string bytes = MakeBytes(length);
+    std::string hex = ReferenceEncode(bytes);
+    for (bool upper : {false, true}) {
+      if (upper) {
+        for (char& c : hex) c = toupper(c);
+      }
+      std::string out(length, '!');
+      const size_t done = DecodeBlocks(Data(hex), length, &out[0]);
+      EXPECT_LE(done, length);
+      EXPECT_EQ(bytes.substr(0, done), out.substr(0, done))
+          << SimdImplementation() << " length=" << length;
+      EXPECT_EQ(std::string(length - done, '!'), out.substr(done));
+      if (SimdImplementation() != std::string("scalar")) {
+        EXPECT_GE(done, length / 32 * 32);
+      }
+    }
+  }
+}
+
+TEST(HexSimdTest, DecodeStopsAtInvalidDigits) {
+  const std::string bytes = MakeBytes(256);
+  const std::string hex = ReferenceEncode(bytes);
+  // Characters right next to the valid ranges.
+  for (char bad : {'/', ':', '@', 'G', '`', 'g', '\x10', '\x80', '\xb0'}) {
+    for (size_t pos : {0, 1, 31, 32, 63, 64, 100, 511}) {
+      std::string input = hex;
+      input[pos] = bad;
+      std::string out(bytes.size(), '!');
+      const size_t done = DecodeBlocks(Data(input), bytes.size(), &out[0]);
+      // Decoding stops before the block that holds the bad character and
+      // leaves the rest of the output alone.
+      EXPECT_LE(done, pos / 2) << SimdImplementation() << " pos=" << pos;
+      EXPECT_EQ(bytes.substr(0, done), out.substr(0, done));
+      EXPECT_EQ(std::string(bytes.size() - done, '!'), out.substr(done));
+    }
+  }
+}
+
+TEST(HexSimdTest, DecodeRespectsMaxBytes) {
+  const std::string bytes = MakeBytes(200);
+  const std::string hex = ReferenceEncode(bytes);
+  for (size_t max_bytes : {0, 15, 16, 33, 100}) {
+    std::string out(bytes.size(), '!');
+    const size_t done = DecodeBlocks(Data(hex), max_bytes, &out[0]);
+    EXPECT_LE(done, max_bytes);
+    EXPECT_EQ(bytes.substr(0, done), out.substr(0, done));
+    EXPECT_EQ(std::string(bytes.size() - done, '!'), out.substr(done));
+  }
+}
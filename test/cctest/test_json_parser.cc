@@ -0,0 +1,155 @@
+#include "json_parser.h"
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "node_test_fixture.h"
+
+using node::json::Document;
+using Node = node::json::Document::Node;
+
+namespace {
+
+std::vector<Node::Type> Types(const Document& document) {
+  std::vector<Node::Type> types;
+  for (const Node& node : document.nodes()) types.push_back(node.type);
+  return types;
+}
+
+}  // anonymous namespace
+
+TEST(JSONDocumentTest, Structure) {
+  Document document;
+  ASSERT_TRUE(document.Parse(
+      " {\"a\": [1, true, false, null, \"x\"], \"b\": {}, \"c\": [[]]}\n"));
+  EXPECT_EQ(std::vector<Node::Type>({Node::kObject,
+                                     Node::kString,
+                                     Node::kArray,
+                                     Node::kNumber,
+                                     Node::kTrue,
+                                     Node::kFalse,
+                                     Node::kNull,
+                                     Node::kString,
+                                     Node::kString,
+                                     Node::kObject,
+                                     Node::kString,
+                                     Node::kArray,
+                                     Node::kArray}),
+            Types(document));
+  const std::vector<Node>& nodes = document.nodes();
+  EXPECT_EQ(3u, nodes[0].length);
+  EXPECT_EQ(5u, nodes[2].length);
+  EXPECT_EQ(0u, nodes[9].length);
+  EXPECT_EQ(1u, nodes[11].length);
+  EXPECT_EQ(0u, nodes[12].length);
+}
+
+TEST(JSONDocumentTest, Strings) {
+  Document document;
+  ASSERT_TRUE(document.Parse(
+      "[\"plain ascii that is longer than a word\", \"caf\xc3\xa9\", "
+      "\"a\\\"b\\\\c\\u00e9\", \"\"]"));
+  const std::vector<Node>& nodes = document.nodes();
+  ASSERT_EQ(5u, nodes.size());
+  EXPECT_EQ(Node::kAscii, nodes[1].flags);
+  EXPECT_EQ(38u, nodes[1].length);
+  EXPECT_EQ(Node::kNone, nodes[2].flags);
+  EXPECT_EQ(5u, nodes[2].length);
+  EXPECT_EQ(Node::kAscii | Node::kEscaped, nodes[3].flags);
+  EXPECT_EQ(Node::kAscii, nodes[4].flags);
+  EXPECT_EQ(0u, nodes[4].length);
+}
+
+TEST(JSONDocumentTest, Numbers) {
+  Document document;
+  ASSERT_TRUE(document.Parse(
+      "[0, -0, 42, -17, 1.5, 0.1, 12.34e2, 1E-3, 123456789012345, "
+      "1234567890123456789, 1e400, 0.1e-30]"));
+  const std::vector<Node>& nodes = document.nodes();
+  ASSERT_EQ(13u, nodes.size());
+  const double exact[] = {0, -0.0, 42, -17, 1.5, 0.1, 1234, 0.001,
+                          123456789012345};
+  for (size_t i = 0; i < sizeof(exact) / sizeof(exact[0]); i++) {
+    const Node& node = nodes[i + 1];
+    if (!(node.flags & Node::kExact)) continue;  // No fast path available.
+    EXPECT_EQ(exact[i], node.number) << i;
+    EXPECT_EQ(std::signbit(exact[i]), std::signbit(node.number)) << i;
+  }
+  // Too many digits or too large an exponent for the fast path; these are
+  // converted from the source text instead.
+  for (size_t i = 10; i < 13; i++) {
+    EXPECT_EQ(Node::kNone, nodes[i].flags) << i;
+  }
+  EXPECT_EQ(19u, nodes[10].length);
+}
+
+TEST(JSONDocumentTest, Invalid) {
+  for (const char* source : {"",
+                             " ",
+                             "[",
+                             "]",
+                             "{",
+                             "[1,]",
+                             "[1 2]",
+                             "{\"a\"}",
+                             "{\"a\":}",
+                             "{\"a\":1,}",
+                             "{a:1}",
+                             "{\"a\":1]",
+                             "[1}",
+                             "01",
+                             "-",
+                             "1.",
+                             ".5",
+                             "1e",
+                             "+1",
+                             "tru",
+                             "nul",
+                             "\"abc",
+                             "\"\\x\"",
+                             "\"\\u12g4\"",
+                             "\"\\u12\"",
+                             "\"a\tb\"",
+                             "1 2",
+                             "\xef\xbb\xbf{}",
+                             "{} x"}) {
+    Document document;
+    EXPECT_FALSE(document.Parse(source)) << source;
+  }
+}
+
+class JSONParseTest : public NodeTestFixture {};
+
+TEST_F(JSONParseTest, MatchesJSONParse) {
+  const v8::HandleScope handle_scope(isolate_);
+  v8::Local<v8::Context> context = v8::Context::New(isolate_);
+  v8::Context::Scope context_scope(context);
+
+  for (const char* source :
+       {"{\"a\":[1,-0.5,1e300,12345678901234567890,true,false,null],"
+        "\"b\":{\"c\":\"caf\xc3\xa9\",\"d\":\"\\ud83d\\ude00\\n\\\"\"},"
+        "\"0\":1,\"__proto__\":2,\"a\":3}",
+        "[{\"id\":1,\"tag\":\"x\"},{\"id\":2,\"tag\":\"y\"}]",
+        "\"\xf0\x9f\x98\x80 \\u0000\"",
+        "\"bad \xff\xfe utf-8 \\t\"",
+        "  -0  "}) {
+    v8::Local<v8::Value> expected;
+    v8::Local<v8::Value> actual;
+    ASSERT_TRUE(v8::JSON::Parse(context,
+                                v8::String::NewFromUtf8(isolate_, source)
+                                    .ToLocalChecked())
+                    .ToLocal(&expected));
+    ASSERT_TRUE(node::json::Parse(context, source).ToLocal(&actual));
+    v8::String::Utf8Value expected_json(
+        isolate_, v8::JSON::Stringify(context, expected).ToLocalChecked());
+    v8::String::Utf8Value actual_json(
+        isolate_, v8::JSON::Stringify(context, actual).ToLocalChecked());
+    EXPECT_STREQ(*expected_json, *actual_json) << source;
+  }
+
+  v8::TryCatch try_catch(isolate_);
+  EXPECT_TRUE(node::json::Parse(context, "{\"a\":1,}").IsEmpty());
+  EXPECT_TRUE(try_catch.HasCaught());
+}
@@ -0,0 +1,141 @@
+#include "gtest/gtest.h"
+#include "large_pages/node_large_page.h"
+#include "node_internals.h"
+#include "node_test_fixture.h"
+
+#include <sstream>
+#include <string>
+
+using node::ArrayBufferAllocator;
+using node::Environment;
+using node::NodeArrayBufferAllocator;
+using node::large_pages::kMinDataSize;
+using v8::Local;
+using v8::Value;
+
+class LargePagesDataTest : public EnvironmentTestFixture {
+ protected:
+  void SetUp() override {
+    EnvironmentTestFixture::SetUp();
+    // This can only be turned on once per process, and stays on for the
+    // tests that run after these.
+    static const int status = node::large_pages::EnableForData(false);
+    if (status != 0) GTEST_SKIP() << node::LargePagesError(status);
+    allocator_ = ArrayBufferAllocator::Create();
+  }
+
+  NodeArrayBufferAllocator* allocator() {
+    return static_cast<NodeArrayBufferAllocator*>(allocator_.get());
+  }
+
+  static uint64_t ArrayBufferBytes() {
+    node::large_pages::DataStats stats;
+    EXPECT_TRUE(node::large_pages::GetDataStats(&stats));
+    return stats.array_buffer_bytes;
+  }
+
+  // Every byte depends on its position, so that data that ends up at the
+  // wrong offset is noticed.
+  static void Fill(void* data, size_t size) {
+    for (size_t i = 0; i < size; i++)
+      static_cast<uint8_t*>(data)[i] = i % 251;
+  }
+
+  static bool IsFilled(const void* data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+      if (static_cast<const uint8_t*>(data)[i] != i % 251) return false;
+    }
+    return true;
+  }
+
+  static bool IsZero(const void* data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+      if (static_cast<const uint8_t*>(data)[i] != 0) return false;
+    }
+    return true;
+  }
+
+  static std::string Report() {
+    std::ostringstream oss;
+    node::GetNodeReport(static_cast<Environment*>(nullptr),
+                        "FooMessage",
+                        "BarTrigger",
+                        Local<Value>(),
+                        oss);
+    return oss.str();
+  }
+
+ private:
+  std::unique_ptr<ArrayBufferAllocator> allocator_;
+};
+
+TEST_F(LargePagesDataTest, LargeAllocationsAreZeroFilled) {
+  const uint64_t before = ArrayBufferBytes();
+  for (bool uninitialized : {false, true}) {
+    void* data = uninitialized
+                     ? allocator()->AllocateUninitialized(kMinDataSize)
+                     : allocator()->Allocate(kMinDataSize);
+    ASSERT_NE(nullptr, data);
+    EXPECT_TRUE(IsZero(data, kMinDataSize));
+    EXPECT_EQ(before + kMinDataSize, ArrayBufferBytes());
+    allocator()->Free(data, kMinDataSize);
+    EXPECT_EQ(before, ArrayBufferBytes());
+  }
+}
+
+TEST_F(LargePagesDataTest, ReallocateAcrossTheThreshold) {
+  const size_t kSmall = kMinDataSize - 1;
+  const size_t kLarge = kMinDataSize + 1;
+  const uint64_t before = ArrayBufferBytes();
+
+  void* data = allocator()->Allocate(kSmall);
+  ASSERT_NE(nullptr, data);
+  Fill(data, kSmall);
+  EXPECT_EQ(before, ArrayBufferBytes());
+
+  // Up onto huge pages, which are mapped in multiples of 2 MiB.
+  data = allocator()->Reallocate(data, kSmall, kLarge);
+  ASSERT_NE(nullptr, data);
+  EXPECT_TRUE(IsFilled(data, kSmall));
+  EXPECT_EQ(before + 2 * kMinDataSize, ArrayBufferBytes());
+  EXPECT_EQ(kLarge, allocator()->total_mem_usage());
+  Fill(data, kLarge);
+
+  // Between two huge page mappings.
+  data = allocator()->Reallocate(data, kLarge, kMinDataSize);
+  ASSERT_NE(nullptr, data);
+  EXPECT_TRUE(IsFilled(data, kMinDataSize));
+  EXPECT_EQ(before + kMinDataSize, ArrayBufferBytes());
+  EXPECT_EQ(kMinDataSize, allocator()->total_mem_usage());
+
+  // And back down to the regular allocator.
+  data = allocator()->Reallocate(data, kMinDataSize, kSmall);
+  ASSERT_NE(nullptr, data);
+  EXPECT_TRUE(IsFilled(data, kSmall));
+  EXPECT_EQ(before, ArrayBufferBytes());
+  EXPECT_EQ(kSmall, allocator()->total_mem_usage());
+  allocator()->Free(data, kSmall);
+
+  // Shrinking to nothing frees the mapping.
+  data = allocator()->Allocate(kLarge);
+  ASSERT_NE(nullptr, data);
+  EXPECT_EQ(nullptr, allocator()->Reallocate(data, kLarge, 0));
+  EXPECT_EQ(before, ArrayBufferBytes());
+  EXPECT_EQ(0u, allocator()->total_mem_usage());
+}
+
+TEST_F(LargePagesDataTest, ReportShowsArrayBufferBytes) {
+  void* data = allocator()->Allocate(kMinDataSize);
+  ASSERT_NE(nullptr, data);
+  std::string report = Report();
+  EXPECT_NE(report.find("\"largePages\": {"), std::string::npos);
+  EXPECT_NE(report.find("\"arrayBufferBytes\": " +
+                        std::to_string(ArrayBufferBytes())),
+            std::string::npos);
+
+  allocator()->Free(data, kMinDataSize);
+  report = Report();
+  EXPECT_NE(report.find("\"arrayBufferBytes\": " +
+                        std::to_string(ArrayBufferBytes())),
+            std::string::npos);
+}
@@ -0,0 +1,77 @@
+#include "mpsc_queue.h"
+
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using node::MPSCQueue;
+
+TEST(MPSCQueueTest, SingleThread) {
+  MPSCQueue<int> queue;
+  int value = -1;
+  EXPECT_FALSE(queue.Pop(&value));
+
+  for (int round = 0; round < 3; round++) {
+    for (int n = 0; n < 100; n++) queue.Push(n);
+    for (int n = 0; n < 100; n++) {
+      ASSERT_TRUE(queue.Pop(&value));
+      EXPECT_EQ(n, value);
+    }
+    EXPECT_FALSE(queue.Pop(&value));
+  }
+
+  // Alternating pushes and pops go through the stub node every time.
+  for (int n = 0; n < 10; n++) {
+    queue.Push(n);
+    ASSERT_TRUE(queue.Pop(&value));
+    EXPECT_EQ(n, value);
+    EXPECT_FALSE(queue.Pop(&value));
+  }
+}
+
+TEST(MPSCQueueTest, MoveOnlyValuesAreFreed) {
+  MPSCQueue<std::unique_ptr<int>> queue;
+  queue.Push(std::make_unique<int>(1));
+  queue.Push(std::make_unique<int>(2));
+  std::unique_ptr<int> value;
+  ASSERT_TRUE(queue.Pop(&value));
+  EXPECT_EQ(1, *value);
+  // The remaining element is released by the destructor.
+}
+
+TEST(MPSCQueueTest, MultipleProducers) {
+  constexpr uint64_t kProducers = 4;
+  constexpr uint64_t kPerProducer = 100000;
+  MPSCQueue<uint64_t> queue;
+
+  std::vector<std::thread> producers;
+  for (uint64_t id = 0; id < kProducers; id++) {
+    producers.emplace_back([&queue, id]() {
+      for (uint64_t n = 0; n < kPerProducer; n++)
+        queue.Push(id * kPerProducer + n);
+    });
+  }
+
+  // Elements of one producer come out in the order they were pushed.
+  std::vector<uint64_t> next(kProducers, 0);
+  uint64_t received = 0;
+  while (received < kProducers * kPerProducer) {
+    uint64_t value;
+    if (!queue.Pop(&value)) {
+      std::this_thread::yield();
+      continue;
+    }
+    const uint64_t id = value / kPerProducer;
+    ASSERT_LT(id, kProducers);
+    ASSERT_EQ(next[id], value % kPerProducer);
+    next[id]++;
+    received++;
+  }
+
+  for (std::thread& producer : producers) producer.join();
+  uint64_t value;
+  EXPECT_FALSE(queue.Pop(&value));
+}
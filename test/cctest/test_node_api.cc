@@ -40,3 +40,62 @@ TEST_F(NodeApiTest, CreateNodeApiEnv) {
   node_napi_env internal_env = reinterpret_cast<node_napi_env>(addon_env);
   EXPECT_EQ(internal_env->node_env(), env);
 }
+
+TEST_F(NodeApiTest, BatchedFinalizers) {
+  const v8::HandleScope handle_scope(isolate_);
+  Argv argv;
+
+  Env test_env{handle_scope, argv};
+
+  node::Environment* env = *test_env;
+  node::LoadEnvironment(env, "");
+
+  napi_addon_register_func init = [](napi_env env, napi_value exports) {
+    addon_env = env;
+    return exports;
+  };
+  Local<Object> module_obj = Object::New(isolate_);
+  Local<Object> exports_obj = Object::New(isolate_);
+  napi_module_register_by_symbol(
+      exports_obj, module_obj, env->context(), init, NAPI_VERSION);
+  ASSERT_NE(addon_env, nullptr);
+  node_napi_env internal_env = reinterpret_cast<node_napi_env>(addon_env);
+
+  constexpr size_t kCount = 10000;
+  static size_t finalized = 0;
+  const size_t live_before = internal_env->reference_slab.live();
+  {
+    const v8::HandleScope inner_scope(isolate_);
+    for (size_t i = 0; i < kCount; i++) {
+      napi_value object;
+      ASSERT_EQ(napi_create_object(addon_env, &object), napi_ok);
+      ASSERT_EQ(napi_add_finalizer(
+                    addon_env,
+                    object,
+                    nullptr,
+                    [](napi_env env, void* data, void* hint) { finalized++; },
+                    nullptr,
+                    nullptr),
+                napi_ok);
+    }
+  }
+  EXPECT_EQ(internal_env->reference_slab.live(), live_before + kCount);
+
+  // The GC only queues the finalizers.
+  isolate_->LowMemoryNotification();
+  EXPECT_EQ(finalized, 0u);
+  EXPECT_EQ(internal_env->pending_finalizers.size(), kCount);
+
+  // With a budget, they run in batches.
+  internal_env->DrainFinalizerQueue(1);
+  EXPECT_EQ(finalized, node_napi_env__::kFinalizerBatchSize);
+  EXPECT_EQ(internal_env->pending_finalizers.size(),
+            kCount - node_napi_env__::kFinalizerBatchSize);
+
+  // The event loop keeps draining until the queue is empty.
+  for (int i = 0; i < 1000 && !internal_env->pending_finalizers.empty(); i++)
+    uv_run(&current_loop, UV_RUN_NOWAIT);
+  EXPECT_EQ(finalized, kCount);
+  EXPECT_TRUE(internal_env->pending_finalizers.empty());
+  EXPECT_EQ(internal_env->reference_slab.live(), live_before);
+}
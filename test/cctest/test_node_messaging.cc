@@ -0,0 +1,138 @@
+#include "env-inl.h"
+#include "gtest/gtest.h"
+#include "node_messaging.h"
+#include "node_test_fixture.h"
+
+#include <cstring>
+#include <memory>
+
+using node::Environment;
+using node::worker::Message;
+using node::worker::MessageBufferPool;
+using node::worker::TransferList;
+using v8::ArrayBuffer;
+using v8::Context;
+using v8::Float64Array;
+using v8::HandleScope;
+using v8::Local;
+using v8::Object;
+using v8::String;
+using v8::Uint8Array;
+using v8::Value;
+
+class MessagingTest : public EnvironmentTestFixture {};
+
+namespace {
+
+Local<Value> RoundTrip(Environment* env,
+                       Local<Context> context,
+                       Local<Value> value,
+                       std::shared_ptr<MessageBufferPool> pool) {
+  Message message;
+  TransferList transfer_list;
+  EXPECT_TRUE(message
+                  .Serialize(env,
+                             context,
+                             value,
+                             transfer_list,
+                             Local<Object>(),
+                             std::move(pool))
+                  .FromJust());
+  EXPECT_FALSE(message.IsCloseMessage());
+  return message.Deserialize(env, context).ToLocalChecked();
+}
+
+}  // anonymous namespace
+
+TEST(MessageBufferPoolTest, ReusesBuffersOfTheSameSizeClass) {
+  MessageBufferPool pool;
+  size_t capacity;
+  char* small = pool.Allocate(100, &capacity);
+  ASSERT_NE(nullptr, small);
+  EXPECT_EQ(128u, capacity);
+  pool.Release(small, capacity);
+  EXPECT_EQ(small, pool.Allocate(128, &capacity));
+  EXPECT_EQ(128u, capacity);
+  pool.Release(small, capacity);
+
+  // Buffers above the largest size class are not rounded up or kept.
+  char* large = pool.Allocate(20000, &capacity);
+  ASSERT_NE(nullptr, large);
+  EXPECT_EQ(20000u, capacity);
+  pool.Release(large, capacity);
+}
+
+TEST_F(MessagingTest, RoundTripsStrings) {
+  const HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env_{handle_scope, argv};
+  Environment* env = *env_;
+  Local<Context> context = env->context();
+  auto pool = std::make_shared<MessageBufferPool>();
+
+  const uint16_t two_byte[] = {0x61, 0xe9, 0x4e2d, 0};
+  Local<Value> strings[] = {
+      String::Empty(isolate_),
+      String::NewFromUtf8Literal(isolate_, "hello"),
+      String::NewFromTwoByte(isolate_, two_byte).ToLocalChecked(),
+  };
+  for (Local<Value> string : strings) {
+    for (auto buffer_pool : {pool, std::shared_ptr<MessageBufferPool>()}) {
+      Local<Value> copy = RoundTrip(env, context, string, buffer_pool);
+      ASSERT_TRUE(copy->IsString());
+      EXPECT_TRUE(copy->StrictEquals(string));
+    }
+  }
+}
+
+TEST_F(MessagingTest, RoundTripsTypedArrays) {
+  const HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env_{handle_scope, argv};
+  Environment* env = *env_;
+  Local<Context> context = env->context();
+  auto pool = std::make_shared<MessageBufferPool>();
+
+  Local<ArrayBuffer> buffer = ArrayBuffer::New(isolate_, 4096);
+  for (size_t i = 0; i < 4096; i++)
+    static_cast<uint8_t*>(buffer->Data())[i] = i & 0xff;
+
+  Local<Value> copy =
+      RoundTrip(env, context, Float64Array::New(buffer, 0, 512), pool);
+  ASSERT_TRUE(copy->IsFloat64Array());
+  EXPECT_EQ(512u, copy.As<Float64Array>()->Length());
+  EXPECT_EQ(0, memcmp(buffer->Data(),
+                      copy.As<Float64Array>()->Buffer()->Data(),
+                      4096));
+
+  // A view on part of its buffer is cloned along with the whole buffer.
+  copy = RoundTrip(env, context, Uint8Array::New(buffer, 16, 32), pool);
+  ASSERT_TRUE(copy->IsUint8Array());
+  EXPECT_EQ(16u, copy.As<Uint8Array>()->ByteOffset());
+  EXPECT_EQ(32u, copy.As<Uint8Array>()->ByteLength());
+  EXPECT_EQ(4096u, copy.As<Uint8Array>()->Buffer()->ByteLength());
+}
+
+TEST_F(MessagingTest, RoundTripsObjects) {
+  const HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env_{handle_scope, argv};
+  Environment* env = *env_;
+  Local<Context> context = env->context();
+  auto pool = std::make_shared<MessageBufferPool>();
+
+  Local<Object> object = Object::New(isolate_);
+  Local<String> key = String::NewFromUtf8Literal(isolate_, "key");
+  Local<String> value = String::NewFromUtf8Literal(isolate_, "value");
+  ASSERT_TRUE(object->Set(context, key, value).FromJust());
+  // The second message starts out in a buffer the size of the first one.
+  for (int i = 0; i < 2; i++) {
+    Local<Value> copy = RoundTrip(env, context, object, pool);
+    ASSERT_TRUE(copy->IsObject());
+    EXPECT_TRUE(copy.As<Object>()
+                    ->Get(context, key)
+                    .ToLocalChecked()
+                    ->StrictEquals(value));
+  }
+  EXPECT_GT(pool->size_hint(), 0u);
+}
@@ -0,0 +1,147 @@
+#include "node_ring_channel.h"
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using node::worker::RingBuffer;
+
+namespace {
+
+struct Ring {
+  Ring(uint32_t capacity, uint32_t slot_size)
+      : memory(RingBuffer::ByteLength(capacity, slot_size)),
+        ring(memory.data(), capacity, slot_size) {}
+
+  std::vector<char> memory;
+  RingBuffer ring;
+};
+
+bool WriteInt(RingBuffer* ring, uint32_t value, bool* notify_reader) {
+  return ring->Write(&value, sizeof(value), notify_reader);
+}
+
+}  // anonymous namespace
+
+TEST(RingBufferTest, ReadsInOrder) {
+  Ring r(5, 16);
+  RingBuffer* ring = &r.ring;
+  EXPECT_EQ(8u, ring->capacity());
+  bool notify;
+  uint32_t out[8 * 4];
+  uint32_t lengths[8];
+  uint32_t next = 0;
+  for (uint32_t lap = 0; lap < 5; lap++) {
+    uint32_t written = 0;
+    while (WriteInt(ring, next + written, &notify)) written++;
+    EXPECT_EQ(8u, written);
+    EXPECT_FALSE(notify);
+    // Read in two batches, so that the slots are reused out of step.
+    for (uint32_t max : {3u, 8u}) {
+      const uint32_t count = ring->Read(out, lengths, max);
+      EXPECT_EQ(max == 3 ? 3u : 5u, count);
+      for (uint32_t i = 0; i < count; i++) {
+        EXPECT_EQ(sizeof(uint32_t), lengths[i]);
+        EXPECT_EQ(next++, out[i * 4]);
+      }
+    }
+    EXPECT_EQ(0u, ring->Read(out, lengths, 8));
+  }
+}
+
+TEST(RingBufferTest, ByteLengthDoesNotWrapAround) {
+  // The largest ring that RingChannel accepts before checking its length,
+  // 2^24 slots of 1 MiB, needs more than 2^32 bytes.
+  const uint64_t length = RingBuffer::ByteLength(1 << 24, 1 << 20);
+  EXPECT_GT(length, uint64_t{1} << 44);
+  EXPECT_LT(length, uint64_t{1} << 45);
+}
+
+TEST(RingBufferTest, RejectsLongRecords) {
+  Ring r(4, 8);
+  bool notify;
+  char data[9] = "12345678";
+  EXPECT_FALSE(r.ring.Write(data, 9, &notify));
+  EXPECT_TRUE(r.ring.Write(data, 8, &notify));
+  EXPECT_TRUE(r.ring.Write(data, 0, &notify));
+  char out[16];
+  uint32_t lengths[2];
+  EXPECT_EQ(2u, r.ring.Read(out, lengths, 2));
+  EXPECT_EQ(8u, lengths[0]);
+  EXPECT_EQ(0, memcmp(out, data, 8));
+  EXPECT_EQ(0u, lengths[1]);
+}
+
+TEST(RingBufferTest, ParkedReaderIsNotifiedOnce) {
+  Ring r(4, 4);
+  RingBuffer* ring = &r.ring;
+  bool notify;
+  EXPECT_TRUE(ring->Park());
+  EXPECT_TRUE(WriteInt(ring, 1, &notify));
+  EXPECT_TRUE(notify);
+  EXPECT_TRUE(WriteInt(ring, 2, &notify));
+  EXPECT_FALSE(notify);
+  // There is something to read, so the reader does not stay parked.
+  EXPECT_FALSE(ring->Park());
+  EXPECT_TRUE(WriteInt(ring, 3, &notify));
+  EXPECT_FALSE(notify);
+}
+
+TEST(RingBufferTest, WaitsTimeOut) {
+  Ring r(2, 4);
+  RingBuffer* ring = &r.ring;
+  bool notify;
+  EXPECT_FALSE(ring->WaitReadable(5));
+  EXPECT_TRUE(WriteInt(ring, 1, &notify));
+  EXPECT_FALSE(notify);
+  EXPECT_TRUE(ring->WaitReadable(5));
+  EXPECT_TRUE(WriteInt(ring, 2, &notify));
+  EXPECT_FALSE(ring->WaitWritable(5));
+  uint32_t out[1];
+  uint32_t lengths[1];
+  EXPECT_EQ(1u, ring->Read(out, lengths, 1));
+  EXPECT_TRUE(ring->WaitWritable(5));
+}
+
+TEST(RingBufferTest, ManyWritersOneReader) {
+  constexpr uint32_t kWriters = 4;
+  constexpr uint32_t kRecordsPerWriter = 100000;
+  Ring r(64, 8);
+  RingBuffer* ring = &r.ring;
+
+  std::vector<std::thread> writers;
+  for (uint32_t writer = 0; writer < kWriters; writer++) {
+    writers.emplace_back([ring, writer]() {
+      for (uint32_t n = 0; n < kRecordsPerWriter; n++) {
+        const uint32_t record[2] = {writer, n};
+        bool notify;
+        while (!ring->Write(record, sizeof(record), &notify))
+          ring->WaitWritable(-1);
+      }
+    });
+  }
+
+  std::vector<uint32_t> expected(kWriters, 0);
+  uint32_t out[16 * 2];
+  uint32_t lengths[16];
+  uint32_t total = 0;
+  while (total < kWriters * kRecordsPerWriter) {
+    const uint32_t count = ring->Read(out, lengths, 16);
+    if (count == 0) {
+      ring->WaitReadable(-1);
+      continue;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+      ASSERT_EQ(8u, lengths[i]);
+      const uint32_t writer = out[i * 2];
+      ASSERT_LT(writer, kWriters);
+      // Each writer's records arrive in the order it wrote them.
+      ASSERT_EQ(expected[writer]++, out[i * 2 + 1]);
+    }
+    total += count;
+  }
+  for (std::thread& writer : writers) writer.join();
+  for (uint32_t count : expected) EXPECT_EQ(kRecordsPerWriter, count);
+}
@@ -0,0 +1,164 @@
+#include "string_search.h"
+#include "string_search_simd.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using node::stringsearch::SimdSearch;
+using node::stringsearch::SimdSearchAny;
+using node::stringsearch::SimdSearchImplementation;
+
+namespace {
+
+// Straightforward reference implementation with the same contract as
+// SimdSearch().
+template <typename Char>
+size_t NaiveSearch(const std::vector<Char>& subject,
+                   const std::vector<Char>& pattern,
+                   size_t start_index,
+                   bool is_forward) {
+  const size_t n = subject.size();
+  const size_t m = pattern.size();
+  auto matches_at = [&](size_t pos) {
+    return memcmp(&subject[pos], &pattern[0], m * sizeof(Char)) == 0;
+  };
+  if (is_forward) {
+    for (size_t pos = start_index; pos + m <= n; pos++) {
+      if (matches_at(pos)) return pos;
+    }
+  } else {
+    for (size_t pos = std::min(start_index, n - m) + 1; pos-- > 0;) {
+      if (matches_at(pos)) return pos;
+    }
+  }
+  return n;
+}
+
+// Deterministic pseudo-random characters from a tiny alphabet, so that
+// partial matches are frequent.
+template <typename Char>
+std::vector<Char> MakeSubject(size_t length, uint32_t seed, Char base) {
+  std::vector<Char> subject(length);
+  for (size_t i = 0; i < length; i++) {
+    seed = seed * 1103515245 + 12345;
+    subject[i] = static_cast<Char>(base + ((seed >> 16) % 3));
+  }
+  return subject;
+}
+
+template <typename Char>
+void CheckAgainstNaiveSearch(Char base) {
+  for (size_t length : {1, 2, 7, 15, 16, 17, 31, 32, 33, 64, 100, 257}) {
+    const std::vector<Char> subject =
+        MakeSubject<Char>(length, static_cast<uint32_t>(length), base);
+    for (size_t m = 1; m <= std::min<size_t>(length, 12); m++) {
+      for (size_t from : {size_t{0}, length / 3, length - m}) {
+        std::vector<Char> pattern(subject.begin() + from,
+                                  subject.begin() + from + m);
+        for (size_t start = 0; start <= length + 1; start += 5) {
+          for (bool is_forward : {true, false}) {
+            EXPECT_EQ(NaiveSearch(subject, pattern, start, is_forward),
+                      SimdSearch(subject.data(),
+                                 subject.size(),
+                                 pattern.data(),
+                                 pattern.size(),
+                                 start,
+                                 is_forward))
+                << SimdSearchImplementation() << " length=" << length
+                << " m=" << m << " start=" << start
+                << " forward=" << is_forward;
+          }
+        }
+      }
+    }
+  }
+}
+
+}  // anonymous namespace
+
+TEST(StringSearchSimdTest, OneByteMatchesNaiveSearch) {
+  CheckAgainstNaiveSearch<uint8_t>('a');
+}
+
+TEST(StringSearchSimdTest, TwoByteMatchesNaiveSearch) {
+  // Use characters whose low bytes collide with the pattern characters to
+  // catch lanes that only compare half of a code unit.
+  CheckAgainstNaiveSearch<uint16_t>(0x2161);
+}
+
+TEST(StringSearchSimdTest, SearchStringMatchesStdString) {
+  const std::string haystack =
+      "GET /index.html HTTP/1.1\r\nHost: example.com\r\n"
+      "Accept: */*\r\nUser-Agent: cctest\r\n\r\nbody\r\n\r\n";
+  const uint8_t* subject = reinterpret_cast<const uint8_t*>(haystack.data());
+  // Covers both the vectorized search and the Boyer-Moore fallback for the
+  // needles longer than kSimdSearchMaxNeedleLength.
+  for (const char* needle : {"\r\n\r\n",
+                             "Host",
+                             "cctest",
+                             "missing",
+                             "\n",
+                             "HTTP/1.1\r\nHost: example.com\r\nAccept: */*"}) {
+    const size_t m = strlen(needle);
+    const uint8_t* pattern = reinterpret_cast<const uint8_t*>(needle);
+    for (size_t start = 0; start <= haystack.size(); start += 7) {
+      size_t expected = haystack.find(needle, start);
+      EXPECT_EQ(expected == std::string::npos ? haystack.size() : expected,
+                node::SearchString(
+                    subject, haystack.size(), pattern, m, start, true))
+          << needle << " " << start;
+      expected = haystack.rfind(needle, start);
+      EXPECT_EQ(expected == std::string::npos ? haystack.size() : expected,
+                node::SearchString(
+                    subject, haystack.size(), pattern, m, start, false))
+          << needle << " " << start;
+    }
+  }
+}
+
+TEST(StringSearchSimdTest, SearchAny) {
+  const std::string haystack =
+      std::string(40, 'x') + "a,b;c\r\nd" + std::string(40, 'y') + "\r\n";
+  const uint8_t* subject = reinterpret_cast<const uint8_t*>(haystack.data());
+  const char* needles[] = {"\r\n", ";", ",", ""};
+  const uint8_t* patterns[4];
+  size_t lengths[4];
+  for (size_t k = 0; k < 4; k++) {
+    patterns[k] = reinterpret_cast<const uint8_t*>(needles[k]);
+    lengths[k] = strlen(needles[k]);
+  }
+
+  std::vector<std::pair<size_t, size_t>> found;
+  size_t pos = 0;
+  size_t index = 0;
+  while ((pos = SimdSearchAny(subject,
+                              haystack.size(),
+                              patterns,
+                              lengths,
+                              4,
+                              pos,
+                              &index)) != haystack.size()) {
+    found.emplace_back(pos, index);
+    pos += lengths[index];
+  }
+
+  std::vector<std::pair<size_t, size_t>> expected = {
+      {41, 2}, {43, 1}, {45, 0}, {88, 0}};
+  EXPECT_EQ(expected, found);
+
+  // A pattern that runs past the end of the subject never matches.
+  const uint8_t* tail[] = {reinterpret_cast<const uint8_t*>("\r\n\r\n")};
+  size_t tail_length[] = {4};
+  EXPECT_EQ(haystack.size(),
+            SimdSearchAny(subject,
+                          haystack.size(),
+                          tail,
+                          tail_length,
+                          1,
+                          80,
+                          &index));
+}
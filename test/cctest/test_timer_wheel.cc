@@ -0,0 +1,112 @@
+#include "timer_wheel.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using node::timers::TimerWheel;
+
+namespace {
+
+std::vector<uint32_t> TakeAll(TimerWheel* wheel) {
+  std::vector<uint32_t> ids;
+  uint32_t out[3];
+  size_t count;
+  while ((count = wheel->TakeExpired(out, 3)) > 0)
+    ids.insert(ids.end(), out, out + count);
+  return ids;
+}
+
+}  // anonymous namespace
+
+TEST(TimerWheelTest, ShortTimersAreExact) {
+  TimerWheel wheel;
+  const uint32_t a = wheel.Insert(10);
+  const uint32_t b = wheel.Insert(5);
+  const uint32_t c = wheel.Insert(10);
+  EXPECT_EQ(3u, wheel.size());
+  EXPECT_EQ(5u, wheel.NextExpiry());
+
+  wheel.Advance(4);
+  EXPECT_TRUE(TakeAll(&wheel).empty());
+  wheel.Advance(9);
+  EXPECT_EQ(std::vector<uint32_t>({b}), TakeAll(&wheel));
+  wheel.Advance(10);
+  EXPECT_EQ(std::vector<uint32_t>({a, c}), TakeAll(&wheel));
+  EXPECT_EQ(0u, wheel.size());
+  EXPECT_EQ(TimerWheel::kNoExpiry, wheel.NextExpiry());
+}
+
+TEST(TimerWheelTest, LongTimersNeverFireEarly) {
+  for (uint64_t delay : {61, 62, 100, 1000, 5000, 60000, 3600000, 86400000}) {
+    TimerWheel wheel;
+    wheel.Advance(12345);
+    const uint64_t expiry = 12345 + delay;
+    const uint32_t id = wheel.Insert(expiry);
+    // Jump straight to the last millisecond before the deadline.
+    wheel.Advance(expiry - 1);
+    EXPECT_TRUE(TakeAll(&wheel).empty()) << delay;
+    uint64_t now = expiry - 1;
+    while (wheel.size() > 0) {
+      now = wheel.NextExpiry();
+      ASSERT_GE(now, expiry) << delay;
+      wheel.Advance(now);
+    }
+    EXPECT_EQ(std::vector<uint32_t>({id}), TakeAll(&wheel)) << delay;
+    // Buckets are at most about an eighth of the delay wide.
+    EXPECT_LE(now - expiry, delay / 7) << delay;
+  }
+}
+
+TEST(TimerWheelTest, CancelAndReschedule) {
+  TimerWheel wheel;
+  const uint32_t a = wheel.Insert(2000);
+  const uint32_t b = wheel.Insert(2000);
+  EXPECT_TRUE(wheel.Cancel(a));
+  EXPECT_FALSE(wheel.Cancel(a));
+  EXPECT_FALSE(wheel.Reschedule(a, 10));
+  EXPECT_TRUE(wheel.Reschedule(b, 10));
+  EXPECT_EQ(1u, wheel.size());
+
+  wheel.Advance(10);
+  // Expired timers can still be cancelled until they are taken.
+  const uint32_t c = wheel.Insert(10);
+  wheel.Advance(11);
+  EXPECT_TRUE(wheel.Cancel(b));
+  EXPECT_EQ(std::vector<uint32_t>({c}), TakeAll(&wheel));
+  EXPECT_FALSE(wheel.Cancel(c));
+
+  // Freed entries are reused with a new id.
+  const uint32_t d = wheel.Insert(100);
+  EXPECT_NE(a, d);
+  EXPECT_NE(b, d);
+  EXPECT_NE(c, d);
+  EXPECT_FALSE(wheel.Cancel(a));
+  EXPECT_TRUE(wheel.Cancel(d));
+}
+
+TEST(TimerWheelTest, ManyTimers) {
+  TimerWheel wheel;
+  std::vector<uint32_t> ids;
+  for (uint64_t n = 0; n < 100000; n++) ids.push_back(wheel.Insert(n * 37));
+  for (size_t n = 0; n < ids.size(); n += 2) EXPECT_TRUE(wheel.Cancel(ids[n]));
+  EXPECT_EQ(50000u, wheel.size());
+
+  size_t fired = 0;
+  uint64_t last_expiry = 0;
+  for (uint64_t now = 0; wheel.size() > 0; now += 1000) {
+    wheel.Advance(now);
+    for (uint32_t id : TakeAll(&wheel)) {
+      // Ids are handed out in insertion order here, as that is the order of
+      // their expiry times.
+      ASSERT_EQ(ids[2 * fired + 1], id);
+      const uint64_t expiry = (2 * fired + 1) * 37;
+      ASSERT_LE(expiry, now);
+      ASSERT_GE(expiry, last_expiry);
+      last_expiry = expiry;
+      fired++;
+    }
+  }
+  EXPECT_EQ(50000u, fired);
+}
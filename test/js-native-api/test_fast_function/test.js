@@ -0,0 +1,59 @@
+'use strict';
+// Flags: --allow-natives-syntax
+
+const common = require('../../common');
+const assert = require('assert');
+
+const binding = require(`./build/${common.buildType}/test_fast_function`);
+
+assert.strictEqual(binding.scale.name, 'scale');
+
+function scale(array, factor, round) {
+  return binding.scale(array, factor, round);
+}
+
+// The regular callback and the fast callback must agree, whichever one the
+// engine picks for a given call.
+function check(factor, round) {
+  const array = new Float64Array([1.5, 2.5, -3.25]);
+  const expected = array.map((x) => {
+    const y = x * factor;
+    return round ? Math.trunc(y) : y;
+  });
+  const sum = scale(array, factor, round);
+  assert.deepStrictEqual(array, expected);
+  assert.strictEqual(sum, expected.reduce((a, b) => a + b, 0));
+}
+
+check(2, false);
+eval('%PrepareFunctionForOptimization(scale)');
+check(2, true);
+eval('%OptimizeFunctionOnNextCall(scale)');
+const before = binding.getFastCalls();
+check(3, false);
+check(0.5, true);
+
+// Once optimized, the calls take the fast path.
+const calls = binding.getFastCalls();
+assert(calls > before, `${calls} fast calls, expected more than ${before}`);
+
+// The fast callback declines negative factors.
+check(-1, false);
+assert.strictEqual(binding.getFastCalls(), calls);
+
+// Anything but a Float64Array is left to the regular callback.
+assert.throws(() => scale(new Float32Array(3), 1, false), {
+  message: /Expects a Float64Array/,
+});
+assert.strictEqual(scale(new Float64Array(0), 1, false), 0);
+
+assert.deepStrictEqual(binding.testCreateFastFunctionParameters(), {
+  cbIsNull: 'Invalid argument',
+  fastCbIsNull: 'Invalid argument',
+  argTypesIsNull: 'Invalid argument',
+  tooManyArgs: 'Invalid argument',
+  voidArg: 'Invalid argument',
+  arrayReturn: 'Invalid argument',
+  resultIsNull: 'Invalid argument',
+  maxArgs: 'napi_ok',
+});
@@ -0,0 +1,143 @@
+#define NAPI_EXPERIMENTAL
+#include <js_native_api.h>
+#include "../common.h"
+
+static uint32_t fast_calls = 0;
+
+// scale(array, factor, round) multiplies every element of the Float64Array in
+// place and returns the sum of the results.
+static double Scale(double* data, size_t length, double factor, bool round) {
+  double sum = 0;
+  for (size_t i = 0; i < length; i++) {
+    data[i] *= factor;
+    if (round) data[i] = (double)(int64_t)data[i];
+    sum += data[i];
+  }
+  return sum;
+}
+
+static napi_value TestScale(napi_env env, napi_callback_info info) {
+  size_t argc = 3;
+  napi_value args[3];
+  NODE_API_CALL(env, napi_get_cb_info(env, info, &argc, args, NULL, NULL));
+  NODE_API_ASSERT(env, argc == 3, "Wrong number of arguments");
+
+  napi_typedarray_type type;
+  size_t length;
+  void* data;
+  NODE_API_CALL(env, napi_get_typedarray_info(
+      env, args[0], &type, &length, &data, NULL, NULL));
+  NODE_API_ASSERT(env, type == napi_float64_array,
+      "Wrong type of argument. Expects a Float64Array.");
+  double factor;
+  NODE_API_CALL(env, napi_get_value_double(env, args[1], &factor));
+  bool round;
+  NODE_API_CALL(env, napi_get_value_bool(env, args[2], &round));
+
+  napi_value result;
+  NODE_API_CALL(env,
+      napi_create_double(env, Scale(data, length, factor, round), &result));
+  return result;
+}
+
+static bool FastScale(void* data,
+                      const node_api_fast_value* args,
+                      size_t argc,
+                      node_api_fast_value* result) {
+  if (argc != 3 || data != &fast_calls) return false;
+  // Leave negative factors to the regular callback.
+  if (args[1].number < 0) return false;
+  fast_calls++;
+  result->number = Scale(args[0].array.data,
+                         args[0].array.length,
+                         args[1].number,
+                         args[2].boolean);
+  return true;
+}
+
+static napi_value GetFastCalls(napi_env env, napi_callback_info info) {
+  napi_value result;
+  NODE_API_CALL(env, napi_create_uint32(env, fast_calls, &result));
+  return result;
+}
+
+static bool FastNoop(void* data,
+                     const node_api_fast_value* args,
+                     size_t argc,
+                     node_api_fast_value* result) {
+  return true;
+}
+
+static napi_value TestCreateFastFunctionParameters(napi_env env,
+                                                   napi_callback_info info) {
+  napi_value return_value, result;
+  NODE_API_CALL(env, napi_create_object(env, &return_value));
+
+  const node_api_fast_type number_args[] = {
+      node_api_fast_number, node_api_fast_number,
+      node_api_fast_number, node_api_fast_number};
+  const node_api_fast_type void_arg[] = {node_api_fast_void};
+
+  add_returned_status(env, "cbIsNull", return_value, "Invalid argument",
+      napi_invalid_arg,
+      node_api_create_fast_function(env, NULL, 0, NULL, FastNoop,
+          node_api_fast_void, NULL, 0, NULL, &result));
+
+  add_returned_status(env, "fastCbIsNull", return_value, "Invalid argument",
+      napi_invalid_arg,
+      node_api_create_fast_function(env, NULL, 0, GetFastCalls, NULL,
+          node_api_fast_void, NULL, 0, NULL, &result));
+
+  add_returned_status(env, "argTypesIsNull", return_value, "Invalid argument",
+      napi_invalid_arg,
+      node_api_create_fast_function(env, NULL, 0, GetFastCalls, FastNoop,
+          node_api_fast_void, NULL, 1, NULL, &result));
+
+  add_returned_status(env, "tooManyArgs", return_value, "Invalid argument",
+      napi_invalid_arg,
+      node_api_create_fast_function(env, NULL, 0, GetFastCalls, FastNoop,
+          node_api_fast_void, number_args, 4, NULL, &result));
+
+  add_returned_status(env, "voidArg", return_value, "Invalid argument",
+      napi_invalid_arg,
+      node_api_create_fast_function(env, NULL, 0, GetFastCalls, FastNoop,
+          node_api_fast_void, void_arg, 1, NULL, &result));
+
+  add_returned_status(env, "arrayReturn", return_value, "Invalid argument",
+      napi_invalid_arg,
+      node_api_create_fast_function(env, NULL, 0, GetFastCalls, FastNoop,
+          node_api_fast_uint8_array, NULL, 0, NULL, &result));
+
+  add_returned_status(env, "resultIsNull", return_value, "Invalid argument",
+      napi_invalid_arg,
+      node_api_create_fast_function(env, NULL, 0, GetFastCalls, FastNoop,
+          node_api_fast_void, NULL, 0, NULL, NULL));
+
+  add_returned_status(env, "maxArgs", return_value, "napi_ok", napi_ok,
+      node_api_create_fast_function(env, NULL, 0, GetFastCalls, FastNoop,
+          node_api_fast_void, number_args, 3, NULL, &result));
+
+  return return_value;
+}
+
+EXTERN_C_START
+napi_value Init(napi_env env, napi_value exports) {
+  const node_api_fast_type scale_args[] = {
+      node_api_fast_float64_array, node_api_fast_number, node_api_fast_boolean};
+  napi_value scale;
+  NODE_API_CALL(env, node_api_create_fast_function(
+      env, "scale", NAPI_AUTO_LENGTH, TestScale, FastScale,
+      node_api_fast_number, scale_args, 3, &fast_calls, &scale));
+  NODE_API_CALL(env, napi_set_named_property(env, exports, "scale", scale));
+
+  napi_property_descriptor descriptors[] = {
+    DECLARE_NODE_API_PROPERTY("getFastCalls", GetFastCalls),
+    DECLARE_NODE_API_PROPERTY("testCreateFastFunctionParameters",
+                              TestCreateFastFunctionParameters),
+  };
+  NODE_API_CALL(env, napi_define_properties(
+      env, exports, sizeof(descriptors) / sizeof(*descriptors), descriptors));
+
+  return exports;
+}
+EXTERN_C_END
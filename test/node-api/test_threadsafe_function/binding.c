@@ -3,12 +3,14 @@
 // future libuv may introduce API changes which may render it non-ABI-stable,
 // which, in turn, may affect the ABI stability of the project despite its use
 // of N-API.
+#define NAPI_EXPERIMENTAL
 #include <uv.h>
 #include <node_api.h>
 #include "../../js-native-api/common.h"
 
 #define ARRAY_LENGTH 10000
 #define MAX_QUEUE_SIZE 2
+#define BATCH_SIZE 64
 
 static uv_thread_t uv_threads[2];
 static napi_threadsafe_function ts_fn;
@@ -129,6 +131,26 @@ static void call_js(napi_env env, napi_value cb, void* hint, void* data) {
   }
 }
 
+// Getting the data into JS in batches, as an array per call
+static void call_js_batch(napi_env env, napi_value cb, void* hint,
+    void** data, size_t count) {
+  if (!(env == NULL || cb == NULL)) {
+    napi_value argv, value, undefined;
+    size_t index;
+    NODE_API_CALL_RETURN_VOID(env,
+        napi_create_array_with_length(env, count, &argv));
+    for (index = 0; index < count; index++) {
+      NODE_API_CALL_RETURN_VOID(env,
+          napi_create_int32(env, *(int*)data[index], &value));
+      NODE_API_CALL_RETURN_VOID(env,
+          napi_set_element(env, argv, index, value));
+    }
+    NODE_API_CALL_RETURN_VOID(env, napi_get_undefined(env, &undefined));
+    NODE_API_CALL_RETURN_VOID(env, napi_call_function(env, undefined, cb, 1, &argv,
+        NULL));
+  }
+}
+
 static napi_ref alt_ref;
 // Getting the data into JS with the alternative reference
 static void call_ref(napi_env env, napi_value _, void* hint, void* data) {
@@ -190,6 +212,7 @@ static void join_the_threads(napi_env env, void *data, void *hint) {
 static napi_value StartThreadInternal(napi_env env,
                                       napi_callback_info info,
                                       napi_threadsafe_function_call_js cb,
+                                      node_api_threadsafe_function_call_js_batch batch_cb,
                                       bool block_on_full,
                                       bool alt_ref_js_cb) {
 
@@ -222,6 +245,10 @@ static napi_value StartThreadInternal(napi_env env,
                                                      &ts_info,
                                                      cb,
                                                      &ts_fn));
+  if (batch_cb != NULL) {
+    NODE_API_CALL(env, node_api_set_threadsafe_function_batch(env, ts_fn,
+        BATCH_SIZE, batch_cb));
+  }
   bool abort;
   NODE_API_CALL(env, napi_get_value_bool(env, argv[1], &abort));
   ts_info.abort = abort ? napi_tsfn_abort : napi_tsfn_release;
@@ -249,26 +276,31 @@ static napi_value Release(napi_env env, napi_callback_info info) {
 
 // Startup
 static napi_value StartThread(napi_env env, napi_callback_info info) {
-  return StartThreadInternal(env, info, call_js,
+  return StartThreadInternal(env, info, call_js, NULL,
     /** block_on_full */true, /** alt_ref_js_cb */false);
 }
 
 static napi_value StartThreadNonblocking(napi_env env,
                                          napi_callback_info info) {
-  return StartThreadInternal(env, info, call_js,
+  return StartThreadInternal(env, info, call_js, NULL,
     /** block_on_full */false, /** alt_ref_js_cb */false);
 }
 
 static napi_value StartThreadNoNative(napi_env env, napi_callback_info info) {
-  return StartThreadInternal(env, info, NULL,
+  return StartThreadInternal(env, info, NULL, NULL,
     /** block_on_full */true, /** alt_ref_js_cb */false);
 }
 
 static napi_value StartThreadNoJsFunc(napi_env env, napi_callback_info info) {
-  return StartThreadInternal(env, info, call_ref,
+  return StartThreadInternal(env, info, call_ref, NULL,
     /** block_on_full */true, /** alt_ref_js_cb */true);
 }
 
+static napi_value StartThreadBatched(napi_env env, napi_callback_info info) {
+  return StartThreadInternal(env, info, call_js, call_js_batch,
+    /** block_on_full */true, /** alt_ref_js_cb */false);
+}
+
 // Testing calling into JavaScript
 static void ThreadSafeFunctionFinalize(napi_env env,
                               void* finalize_data,
@@ -304,9 +336,10 @@ static napi_value Init(napi_env env, napi_value exports) {
   for (index = 0; index < ARRAY_LENGTH; index++) {
     ints[index] = index;
   }
-  napi_value js_array_length, js_max_queue_size;
+  napi_value js_array_length, js_max_queue_size, js_batch_size;
   napi_create_uint32(env, ARRAY_LENGTH, &js_array_length);
   napi_create_uint32(env, MAX_QUEUE_SIZE, &js_max_queue_size);
+  napi_create_uint32(env, BATCH_SIZE, &js_batch_size);
 
   napi_property_descriptor properties[] = {
     {
@@ -329,10 +362,21 @@ static napi_value Init(napi_env env, napi_value exports) {
       napi_enumerable,
       NULL
     },
+    {
+      "BATCH_SIZE",
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      js_batch_size,
+      napi_enumerable,
+      NULL
+    },
     DECLARE_NODE_API_PROPERTY("StartThread", StartThread),
     DECLARE_NODE_API_PROPERTY("StartThreadNoNative", StartThreadNoNative),
     DECLARE_NODE_API_PROPERTY("StartThreadNonblocking", StartThreadNonblocking),
     DECLARE_NODE_API_PROPERTY("StartThreadNoJsFunc", StartThreadNoJsFunc),
+    DECLARE_NODE_API_PROPERTY("StartThreadBatched", StartThreadBatched),
     DECLARE_NODE_API_PROPERTY("StopThread", StopThread),
     DECLARE_NODE_API_PROPERTY("Unref", Unref),
     DECLARE_NODE_API_PROPERTY("Release", Release),
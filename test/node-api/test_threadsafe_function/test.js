@@ -41,7 +41,13 @@ function testWithJSMarshaller({
   return new Promise((resolve) => {
     const array = [];
     binding[threadStarter](function testCallback(value) {
-      array.push(value);
+      if (Array.isArray(value)) {
+        // The batched marshaller passes all values of a batch at once.
+        assert(value.length > 0 && value.length <= binding.BATCH_SIZE);
+        array.push(...value);
+      } else {
+        array.push(value);
+      }
       if (array.length === quitAfter) {
         setImmediate(() => {
           binding.StopThread(common.mustCall(() => {
@@ -132,6 +138,24 @@ new Promise(function testWithoutJSMarshaller(resolve) {
 }))
 .then((result) => assert.deepStrictEqual(result, expectedArray))
 
+// Start the thread in blocking mode with batched dispatch, and assert that all
+// values are passed in order. Quit after it's done.
+.then(() => testWithJSMarshaller({
+  threadStarter: 'StartThreadBatched',
+  maxQueueSize: binding.MAX_QUEUE_SIZE,
+  quitAfter: binding.ARRAY_LENGTH,
+}))
+.then((result) => assert.deepStrictEqual(result, expectedArray))
+
+// Start the thread in blocking mode with batched dispatch and an infinite
+// queue, and assert that all values are passed in order. Quit after it's done.
+.then(() => testWithJSMarshaller({
+  threadStarter: 'StartThreadBatched',
+  maxQueueSize: 0,
+  quitAfter: binding.ARRAY_LENGTH,
+}))
+.then((result) => assert.deepStrictEqual(result, expectedArray))
+
 // Start the thread in blocking mode, and assert that all values are passed.
 // Quit early, but let the thread finish.
 .then(() => testWithJSMarshaller({
@@ -0,0 +1,144 @@
+// Flags: --expose-internals
+'use strict';
+
+// Tests the atob() and btoa() bindings of the buffer binding against the
+// forgiving-base64 steps of the Infra Standard. They return -1 for an input
+// of invalid length and -2 for a character outside of the base64 alphabet
+// (atob), or -1 for a character outside of Latin-1 (btoa).
+
+require('../common');
+const assert = require('assert');
+const { internalBinding } = require('internal/test/binding');
+const { atob, btoa } = internalBinding('buffer');
+
+const kAlphabet =
+  'ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/';
+const kInvalidLength = -1;
+const kInvalidCharacter = -2;
+
+function encode(string) {
+  let out = '';
+  for (let i = 0; i < string.length; i += 3) {
+    const group = [...string.slice(i, i + 3)].map((c) => c.charCodeAt(0));
+    const bits = (group[0] << 16) | ((group[1] ?? 0) << 8) | (group[2] ?? 0);
+    for (let j = 0; j < 4; j++) {
+      out += j <= group.length ?
+        kAlphabet[(bits >> (18 - 6 * j)) & 0x3F] : '=';
+    }
+  }
+  return out;
+}
+
+// https://infra.spec.whatwg.org/#forgiving-base64-decode
+function decode(input) {
+  input = input.replace(/[\t\n\f\r ]/g, '');
+  if (input.length % 4 === 0) input = input.replace(/==?$/, '');
+  if (input.length % 4 === 1) return kInvalidLength;
+  let out = '';
+  let bits = 0;
+  let count = 0;
+  for (const c of input) {
+    const value = kAlphabet.indexOf(c);
+    if (value === -1) return kInvalidCharacter;
+    bits = (bits << 6) | value;
+    count += 6;
+    if (count >= 8) {
+      count -= 8;
+      out += String.fromCharCode((bits >> count) & 0xFF);
+    }
+  }
+  return out;
+}
+
+function checkAtob(input) {
+  assert.strictEqual(atob(input), decode(input), JSON.stringify(input));
+}
+
+// Padding, no padding, and bits left over in the last character, which are
+// ignored.
+for (const input of ['', 'YQ==', 'YQ', 'YWI=', 'YWI', 'YWJj', 'YR==', 'YWJ=',
+                     'YR', 'YWJ']) {
+  checkAtob(input);
+}
+assert.strictEqual(atob('YQ'), 'a');
+assert.strictEqual(atob('YR=='), 'a');
+
+// Embedded ASCII whitespace, which is removed before anything else. Other
+// whitespace is not.
+for (const input of [' YQ==', 'YQ== ', 'Y Q = =', '\tY\nW\fJ\rj',
+                     'YW Jj\n', '   ', 'YQ\n=\n=', '\vYQ==', '\u00A0YQ==',
+                     'YQ==\u0085']) {
+  checkAtob(input);
+}
+assert.strictEqual(atob('\tY\nW\fJ\rj'), 'abc');
+assert.strictEqual(atob('\vYQ'), kInvalidCharacter);
+
+// A length of 1 mod 4 once whitespace and padding are removed.
+for (const input of ['Y', 'YWJjZ', 'YQ===', '=', 'Y ', ' Y\n', '\xE9', '\0',
+                     'YQ==\0', 'YWJjZGVmZ']) {
+  checkAtob(input);
+  assert.strictEqual(atob(input), kInvalidLength, input);
+}
+
+// Characters outside of the alphabet, including padding that is in the wrong
+// place, too long or on an input of the wrong length.
+for (const input of ['YQ=', 'Y===', '====', '==', ' Y = ', 'YWJjZ===',
+                     'YQ==YQ==', 'Y=Q=', 'YQ-_', 'YQ.=', '\0YQ=', 'YWJ\xFF',
+                     'YW%j']) {
+  checkAtob(input);
+  assert.strictEqual(atob(input), kInvalidCharacter, input);
+}
+// Outside of Latin-1, whatever the length.
+for (const input of ['YQĀ=', '€', 'YWJj\u{1F600}', '\ud800YWJ'])
+  assert(atob(input) < 0, input);
+
+// btoa() takes one byte per character, including characters above U+007F,
+// and the result decodes back to the input.
+{
+  const latin1 = Array.from({ length: 256 }, (_, i) => String.fromCharCode(i))
+    .join('');
+  for (const input of ['', 'a', 'ab', 'abc', 'abcd', '\0', '\xFF\xFE',
+                       latin1, latin1.repeat(17)]) {
+    const encoded = btoa(input);
+    assert.strictEqual(encoded, encode(input));
+    assert.strictEqual(atob(encoded), input);
+  }
+  // A string that V8 stores with two bytes per character, but that only
+  // holds Latin-1.
+  const twoByte = ('Ā' + latin1).slice(1);
+  assert.strictEqual(btoa(twoByte), encode(latin1));
+}
+
+// btoa() rejects characters above U+00FF, wherever they are.
+for (const input of ['Ā', 'abcĀ', '€abc', 'ab\u{1F600}cd',
+                     '\ud800', 'a'.repeat(1000) + '\uFFFF'])
+  assert.strictEqual(btoa(input), -1, JSON.stringify(input));
+
+// Inputs long enough for the vectorized decoder, which works on blocks, with
+// a bad character or whitespace in different blocks.
+{
+  let seed = 1;
+  const random = (n) => {
+    seed = (seed * 1103515245 + 12345) % 2147483648;
+    return seed % n;
+  };
+  for (const length of [1, 2, 3, 47, 48, 49, 767, 768, 769, 3071, 3072,
+                        3073]) {
+    const data = Array.from({ length }, () => String.fromCharCode(random(256)))
+      .join('');
+    const encoded = encode(data);
+    assert.strictEqual(btoa(data), encoded);
+    assert.strictEqual(atob(encoded), data);
+    assert.strictEqual(atob(encoded.replace(/=+$/, '')), data);
+
+    for (const at of [0, encoded.length >> 1, encoded.length - 3]) {
+      const spaced = encoded.slice(0, at) + ' \n' + encoded.slice(at);
+      assert.strictEqual(atob(spaced), data);
+      const bad = encoded.slice(0, at) + '*' + encoded.slice(at + 1);
+      checkAtob(bad);
+      assert.strictEqual(atob(bad), kInvalidCharacter);
+    }
+    const urlSafe = encoded.replace(/\+/g, '-').replace(/\//g, '_');
+    checkAtob(urlSafe);
+  }
+}
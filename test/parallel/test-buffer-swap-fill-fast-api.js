@@ -0,0 +1,72 @@
+// Flags: --allow-natives-syntax
+'use strict';
+
+// Buffer#swap16/32/64 only call into the binding from 128 bytes on, and
+// Buffer#fill calls into it for every value. Run both on either side of that
+// threshold, before and after the callers are optimized, so that the slow
+// and the fast binding paths are both taken.
+
+require('../common');
+const assert = require('assert');
+
+function referenceSwap(buf, size) {
+  const out = Buffer.alloc(buf.length);
+  for (let i = 0; i < buf.length; i += size) {
+    for (let j = 0; j < size; j++)
+      out[i + j] = buf[i + size - 1 - j];
+  }
+  return out;
+}
+
+function swap16(buf) { return buf.swap16(); }
+function swap32(buf) { return buf.swap32(); }
+function swap64(buf) { return buf.swap64(); }
+
+for (const [swap, size] of [[swap16, 2], [swap32, 4], [swap64, 8]]) {
+  %PrepareFunctionForOptimization(swap);
+  for (const length of [64, 120, 128, 136, 1024]) {
+    const original = Buffer.alloc(length);
+    for (let i = 0; i < length; i++) original[i] = i & 255;
+    const expected = referenceSwap(original, size);
+
+    for (let round = 0; round < 3; round++) {
+      const buf = Buffer.from(original);
+      // The return value is the buffer itself, on every path.
+      assert.strictEqual(swap(buf), buf);
+      assert.deepStrictEqual(buf, expected);
+      assert.strictEqual(swap(buf), buf);
+      assert.deepStrictEqual(buf, original);
+      %OptimizeFunctionOnNextCall(swap);
+    }
+  }
+}
+
+function fill(buf, value, start, end, encoding) {
+  return buf.fill(value, start, end, encoding);
+}
+
+%PrepareFunctionForOptimization(fill);
+for (let round = 0; round < 3; round++) {
+  for (const length of [64, 128, 256]) {
+    const buf = Buffer.alloc(length);
+    assert.strictEqual(fill(buf, 0x41, 10, length - 10), buf);
+    for (let i = 0; i < length; i++)
+      assert.strictEqual(buf[i], i >= 10 && i < length - 10 ? 0x41 : 0);
+
+    // Only the low byte of a number is used.
+    assert.strictEqual(fill(buf, 0x142, 0, length), buf);
+    assert.deepStrictEqual(buf, Buffer.alloc(length, 0x42));
+
+    // Strings and buffers are not numbers and take the slow path, even
+    // from optimized code.
+    fill(buf, 'ab', 0, length, 'latin1');
+    assert.deepStrictEqual(buf, Buffer.alloc(length, 'ab', 'latin1'));
+    fill(buf, Buffer.from([1, 2, 3]), 0, length);
+    assert.deepStrictEqual(buf, Buffer.alloc(length, Buffer.from([1, 2, 3])));
+
+    assert.throws(() => fill(buf, 0, 0, length + 1), {
+      code: 'ERR_OUT_OF_RANGE',
+    });
+  }
+  %OptimizeFunctionOnNextCall(fill);
+}
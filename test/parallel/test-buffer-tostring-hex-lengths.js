@@ -0,0 +1,25 @@
+'use strict';
+
+// Hex strings up to 1 KiB are encoded on the stack, and longer ones into an
+// external string or a heap copy of one. Check the lengths around each switch.
+
+require('../common');
+const assert = require('assert');
+
+function reference(buffer) {
+  let hex = '';
+  for (const byte of buffer) hex += byte.toString(16).padStart(2, '0');
+  return hex;
+}
+
+const EXTERN_APEX = 0xFBEE9;
+
+for (const length of [0, 1, 16, 32, 511, 512, 513, 4096,
+                      EXTERN_APEX / 2 - 1, (EXTERN_APEX + 1) / 2]) {
+  const buffer = Buffer.alloc(Math.floor(length));
+  for (let i = 0; i < buffer.length; i++) buffer[i] = (i * 7) % 256;
+  const hex = buffer.toString('hex');
+  assert.strictEqual(hex.length, 2 * buffer.length);
+  assert.strictEqual(hex, reference(buffer));
+  assert.deepStrictEqual(Buffer.from(hex, 'hex'), buffer);
+}
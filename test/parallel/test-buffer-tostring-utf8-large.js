@@ -0,0 +1,95 @@
+'use strict';
+
+// UTF-8 of EXTERN_APEX bytes or more is decoded into an external string
+// when it is valid, as one-byte Latin-1 if it can be, and left to V8 when
+// it is not. Check the lengths around the switch and the malformed input
+// that has to take the V8 path.
+
+require('../common');
+const assert = require('assert');
+
+const EXTERN_APEX = 0xFBEE9;
+
+// Returns `head + 'a'.repeat(n) + tail` as UTF-8 of exactly `length` bytes,
+// along with the string it decodes to. `tail` may be raw bytes.
+function make(length, head, tail, decodedTail = tail) {
+  const start = Buffer.from(head);
+  const end = Buffer.from(tail);
+  const padding = length - start.length - end.length;
+  const buffer = Buffer.concat([start, Buffer.alloc(padding, 'a'), end]);
+  assert.strictEqual(buffer.length, length);
+  return [buffer, head + 'a'.repeat(padding) + decodedTail];
+}
+
+const cases = [
+  // ASCII, and Latin-1 right up to the last code point and lead byte.
+  ['', ''],
+  ['é', 'é'],
+  ['\u0080', 'ÿ'],
+  // The first code point that needs two bytes per character, at the end so
+  // that the Latin-1 scan only fails on the last lead byte.
+  ['é', 'Ā'],
+  ['', '€'],
+  ['\u{1F600}', '\u{1F600}'],
+  // Malformed input: a stray byte, truncated sequences, an overlong form,
+  // a surrogate and a Latin-1 lead byte that is cut off at the very end.
+  ['é', [0xFF], '\uFFFD'],
+  ['', [0x80], '\uFFFD'],
+  ['é', [0xC3], '\uFFFD'],
+  ['€', [0xE2, 0x82], '\uFFFD'],
+  ['\u{1F600}', [0xF0, 0x9F, 0x98], '\uFFFD'],
+  ['é', [0xC0, 0x80], '\uFFFD\uFFFD'],
+  ['', [0xED, 0xA0, 0x80], '\uFFFD\uFFFD\uFFFD'],
+];
+
+for (const length of [EXTERN_APEX - 1, EXTERN_APEX, EXTERN_APEX + 1]) {
+  for (const [head, tail, decodedTail] of cases) {
+    const [buffer, expected] = make(length, head, tail, decodedTail);
+    assert.strictEqual(buffer.toString('utf8'), expected);
+    assert.strictEqual(buffer.toString('utf8', Buffer.byteLength(head)),
+                       expected.slice(head.length));
+    assert.strictEqual(buffer.utf8Slice(0, length), expected);
+  }
+}
+
+// Text made only of multi-byte characters, so that the one-byte and two-byte
+// outputs are much shorter than the input.
+for (const char of ['é', '€', '\u{1F600}']) {
+  const count = Math.ceil(EXTERN_APEX / Buffer.byteLength(char)) + 1;
+  const expected = char.repeat(count);
+  const buffer = Buffer.from(expected);
+  assert.strictEqual(buffer.toString(), expected);
+  // Starting or ending in the middle of a character.
+  assert.strictEqual(buffer.toString('utf8', 1),
+                     '\uFFFD'.repeat(Buffer.byteLength(char) - 1) +
+                     char.repeat(count - 1));
+  assert.strictEqual(buffer.toString('utf8', 0, buffer.length - 1),
+                     char.repeat(count - 1) + '\uFFFD');
+}
+
+// Whether the result is stored outside of the V8 heap depends on its length
+// in characters, so check decoded lengths around EXTERN_APEX as well. Valid
+// results round-trip, one-byte and two-byte alike.
+for (const char of ['a', 'é', 'ÿ', 'Ā', '€', '\u{1F600}']) {
+  for (const count of [EXTERN_APEX - 1, EXTERN_APEX, EXTERN_APEX + 1]) {
+    const expected = char.repeat(count);
+    const buffer = Buffer.from(expected);
+    const string = buffer.toString();
+    assert.strictEqual(string.length, expected.length);
+    assert.strictEqual(string, expected);
+    assert.strictEqual(Buffer.byteLength(string), buffer.length);
+    assert.deepStrictEqual(Buffer.from(string), buffer);
+    assert.strictEqual(string.codePointAt(string.length - char.length),
+                       char.codePointAt(0));
+  }
+}
+
+// Invalid input of the same sizes decodes like the small inputs above, and
+// does not round-trip.
+{
+  const [buffer, expected] = make(EXTERN_APEX * 2, 'é', [0xFF], '\uFFFD');
+  const string = buffer.toString();
+  assert.strictEqual(string, expected);
+  assert.strictEqual(Buffer.byteLength(string), buffer.length + 2);
+  assert.notDeepStrictEqual(Buffer.from(string), buffer);
+}
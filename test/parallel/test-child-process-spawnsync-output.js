@@ -0,0 +1,138 @@
+// Flags: --expose-internals
+'use strict';
+
+// Tests where the spawn_sync binding puts the output of a pipe: collected
+// into one growing block, read into a caller's buffer with outputBuffer, or
+// written to a descriptor with outputFd, which on Linux is spliced into
+// regular files.
+
+const common = require('../common');
+const assert = require('assert');
+const fs = require('fs');
+const path = require('path');
+const tmpdir = require('../common/tmpdir');
+const { internalBinding } = require('internal/test/binding');
+const { spawn } = internalBinding('spawn_sync');
+const { UV_EBADF, UV_EINVAL, UV_ENOBUFS } = internalBinding('uv');
+
+// Every byte depends on its position, so that lost, repeated or reordered
+// chunks are noticed.
+function expected(length) {
+  const buffer = Buffer.alloc(length);
+  for (let i = 0; i < length; i++) buffer[i] = i % 251;
+  return buffer;
+}
+
+function run(length, stdout, options = {}) {
+  const script = `
+    const buffer = Buffer.alloc(${length});
+    for (let i = 0; i < ${length}; i++) buffer[i] = i % 251;
+    require('fs').writeSync(1, buffer);`;
+  return spawn({
+    file: process.execPath,
+    args: [process.execPath, '-e', script],
+    stdio: [
+      { type: 'ignore' },
+      { type: 'pipe', readable: false, writable: true, ...stdout },
+      { type: 'inherit', fd: 2 },
+    ],
+    ...options,
+  });
+}
+
+tmpdir.refresh();
+
+// Output is collected across several reallocations of the block.
+for (const length of [0, 1, 65536, 65537, 1024 * 1024 + 1]) {
+  const { error, status, output } = run(length, {});
+  assert.strictEqual(error, undefined);
+  assert.strictEqual(status, 0);
+  assert.deepStrictEqual(output[1], expected(length));
+}
+
+// Overflowing maxBuffer reports ENOBUFS. The output is checked after every
+// read of at most 64 KB, so it does not go past the limit by more than that.
+{
+  const maxBuffer = 1000;
+  const { error, output } = run(1024 * 1024, {}, { maxBuffer });
+  assert.strictEqual(error, UV_ENOBUFS);
+  assert(output[1].length > maxBuffer);
+  assert(output[1].length <= maxBuffer + 65536);
+  assert.deepStrictEqual(output[1], expected(output[1].length));
+}
+
+// With outputBuffer the output is read into the caller's memory, and the
+// result is a view of the filled part of it.
+{
+  const memory = new ArrayBuffer(256 * 1024);
+  const view = new Uint8Array(memory, 16, 200 * 1024);
+  const { error, status, output } = run(150 * 1024, { outputBuffer: view });
+  assert.strictEqual(error, undefined);
+  assert.strictEqual(status, 0);
+  assert.strictEqual(output[1].buffer, memory);
+  assert.strictEqual(output[1].byteOffset, 16);
+  assert.deepStrictEqual(output[1], expected(150 * 1024));
+}
+
+// Running out of room in it is reported as ENOBUFS, like maxBuffer.
+{
+  const view = Buffer.alloc(1000);
+  const { error, output } = run(64 * 1024, { outputBuffer: view });
+  assert.strictEqual(error, UV_ENOBUFS);
+  assert.strictEqual(output[1].buffer, view.buffer);
+  assert.deepStrictEqual(output[1], expected(1000));
+}
+
+// With outputFd the output goes to the descriptor, starting at its current
+// position, and its slot in the result is null.
+{
+  const file = path.join(tmpdir.path, 'spawnsync-output');
+  const fd = fs.openSync(file, 'w');
+  fs.writeSync(fd, 'head');
+  const length = 4 * 1024 * 1024 + 1;
+  const { error, status, output } = run(length, { outputFd: fd });
+  fs.closeSync(fd);
+  assert.strictEqual(error, undefined);
+  assert.strictEqual(status, 0);
+  assert.strictEqual(output[1], null);
+  assert.deepStrictEqual(
+    fs.readFileSync(file),
+    Buffer.concat([Buffer.from('head'), expected(length)]));
+}
+
+// Descriptors that are not regular files are written to after each read.
+if (!common.isWindows) {
+  const fd = fs.openSync('/dev/null', 'w');
+  const { error, status, output } = run(1024 * 1024, { outputFd: fd });
+  fs.closeSync(fd);
+  assert.strictEqual(error, undefined);
+  assert.strictEqual(status, 0);
+  assert.strictEqual(output[1], null);
+}
+
+// If writing fails, the error is reported, and the rest of the output is
+// still drained so that the child can exit.
+if (!common.isWindows) {
+  const file = path.join(tmpdir.path, 'spawnsync-readonly');
+  fs.writeFileSync(file, '');
+  const fd = fs.openSync(file, 'r');
+  const { error, status, output } = run(1024 * 1024, { outputFd: fd });
+  fs.closeSync(fd);
+  assert.strictEqual(error, UV_EBADF);
+  assert.strictEqual(status, 0);
+  assert.strictEqual(output[1], null);
+  assert.strictEqual(fs.statSync(file).size, 0);
+}
+
+// The two are mutually exclusive, and outputFd has to be a descriptor.
+for (const stdout of [
+  { outputFd: 1, outputBuffer: Buffer.alloc(1) },
+  { outputFd: -1 },
+  { outputFd: 1.5 },
+  { outputBuffer: new ArrayBuffer(1) },
+]) {
+  const { error, status, output } = run(1, stdout);
+  assert.strictEqual(error, UV_EINVAL);
+  assert.strictEqual(status, null);
+  assert.strictEqual(output, null);
+}
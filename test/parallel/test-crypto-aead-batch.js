@@ -0,0 +1,262 @@
+// Flags: --expose-internals
+'use strict';
+
+// Tests AEADBatchJob of the crypto binding, which encrypts or decrypts a list
+// of [nonce, additionalData, data] records with one key, against
+// crypto.createCipheriv() and crypto.createDecipheriv().
+
+const common = require('../common');
+if (!common.hasCrypto)
+  common.skip('missing crypto');
+
+const assert = require('assert');
+const crypto = require('crypto');
+const { internalBinding } = require('internal/test/binding');
+const {
+  AEADBatchJob,
+  KeyObjectHandle,
+  kCryptoJobAsync,
+  kCryptoJobSync,
+  kKeyTypeSecret,
+  kWebCryptoCipherEncrypt,
+  kWebCryptoCipherDecrypt,
+  kAEADBatch_AES_128_GCM,
+  kAEADBatch_AES_256_GCM,
+  kAEADBatch_CHACHA20_POLY1305,
+} = internalBinding('crypto');
+
+const variants = [
+  [kAEADBatch_AES_128_GCM, 'aes-128-gcm', 16],
+  [kAEADBatch_AES_256_GCM, 'aes-256-gcm', 32],
+  [kAEADBatch_CHACHA20_POLY1305, 'chacha20-poly1305', 32],
+];
+
+function keyHandle(key) {
+  const handle = new KeyObjectHandle();
+  handle.init(kKeyTypeSecret, key);
+  return handle;
+}
+
+function runSync(...args) {
+  const [err, result] = new AEADBatchJob(kCryptoJobSync, ...args).run();
+  return { err, result };
+}
+
+function runAsync(...args) {
+  return new Promise((resolve) => {
+    const job = new AEADBatchJob(kCryptoJobAsync, ...args);
+    job.ondone = common.mustCall((err, result) => resolve({ err, result }));
+    job.run();
+  });
+}
+
+function encrypt(algorithm, key, tagLength, [nonce, additionalData, data]) {
+  const cipher = crypto.createCipheriv(algorithm, key, nonce,
+                                       { authTagLength: tagLength });
+  if (additionalData !== undefined) cipher.setAAD(additionalData);
+  return Buffer.concat([cipher.update(data), cipher.final(),
+                        cipher.getAuthTag()]);
+}
+
+function decrypt(algorithm, key, tagLength, [nonce, additionalData, data]) {
+  const decipher = crypto.createDecipheriv(algorithm, key, nonce,
+                                           { authTagLength: tagLength });
+  const length = data.length - tagLength;
+  decipher.setAuthTag(data.subarray(length));
+  if (additionalData !== undefined) decipher.setAAD(additionalData);
+  return Buffer.concat([decipher.update(data.subarray(0, length)),
+                        decipher.final()]);
+}
+
+function makeRecords(algorithm, count) {
+  const nonceLength = algorithm === 'chacha20-poly1305' ? [12] : [12, 1, 64];
+  return Array.from({ length: count }, (_, i) => [
+    crypto.randomBytes(nonceLength[i % nonceLength.length]),
+    i % 3 === 0 ? undefined : crypto.randomBytes(i * 7),
+    crypto.randomBytes((i * 37) % 200),
+  ]);
+}
+
+async function checkRoundTrip(run) {
+  for (const [variant, algorithm, keyLength] of variants) {
+    const key = crypto.randomBytes(keyLength);
+    const handle = keyHandle(key);
+    for (const tagLength of [4, 8, 12, 16]) {
+      for (const count of [0, 1, 10]) {
+        const records = makeRecords(algorithm, count);
+        const expected = records.map(
+          (record) => encrypt(algorithm, key, tagLength, record));
+
+        const encrypted = await run(kWebCryptoCipherEncrypt, handle, variant,
+                                    tagLength, records);
+        assert.strictEqual(encrypted.err, undefined);
+        assert(encrypted.result instanceof ArrayBuffer);
+        assert.deepStrictEqual(Buffer.from(encrypted.result),
+                               Buffer.concat(expected));
+
+        const sealed = records.map(([nonce, additionalData], i) =>
+          [nonce, additionalData, expected[i]]);
+        const decrypted = await run(kWebCryptoCipherDecrypt, handle, variant,
+                                    tagLength, sealed);
+        assert.strictEqual(decrypted.err, undefined);
+        assert.deepStrictEqual(
+          Buffer.from(decrypted.result),
+          Buffer.concat(sealed.map(
+            (record) => decrypt(algorithm, key, tagLength, record))));
+        assert.deepStrictEqual(Buffer.from(decrypted.result),
+                               Buffer.concat(records.map((r) => r[2])));
+
+        // One record that does not authenticate fails the whole batch.
+        if (count > 0) {
+          const tampered = sealed.map(([n, a, d]) => [n, a, Buffer.from(d)]);
+          tampered[count - 1][2][0] ^= 1;
+          const failed = await run(kWebCryptoCipherDecrypt, handle, variant,
+                                   tagLength, tampered);
+          assert(failed.err instanceof Error);
+          assert.strictEqual(failed.result, undefined);
+        }
+      }
+    }
+  }
+}
+
+// Arguments that are rejected when the job is constructed, in either mode.
+function checkArguments(mode) {
+  const create = (...args) => new AEADBatchJob(mode, ...args);
+  const aes = keyHandle(crypto.randomBytes(16));
+  const chacha = keyHandle(crypto.randomBytes(32));
+  const record = [crypto.randomBytes(12), undefined, Buffer.from('data')];
+
+  // Tag lengths.
+  for (const tagLength of [0, 1, 5, 11, 17, 32]) {
+    assert.throws(() => create(kWebCryptoCipherEncrypt, aes,
+                               kAEADBatch_AES_128_GCM, tagLength, [record]),
+                  { code: 'ERR_CRYPTO_INVALID_TAG_LENGTH' });
+  }
+  for (const tagLength of [0, 17]) {
+    assert.throws(() => create(kWebCryptoCipherEncrypt, chacha,
+                               kAEADBatch_CHACHA20_POLY1305, tagLength,
+                               [record]),
+                  { code: 'ERR_CRYPTO_INVALID_TAG_LENGTH' });
+  }
+  create(kWebCryptoCipherEncrypt, chacha, kAEADBatch_CHACHA20_POLY1305, 1,
+         [record]);
+
+  // Key lengths that do not match the variant.
+  for (const [variant, handle] of [[kAEADBatch_AES_256_GCM, aes],
+                                   [kAEADBatch_AES_128_GCM, chacha],
+                                   [kAEADBatch_CHACHA20_POLY1305, aes]]) {
+    assert.throws(() => create(kWebCryptoCipherEncrypt, handle, variant, 16,
+                               [record]),
+                  { code: 'ERR_CRYPTO_INVALID_KEYLEN' });
+  }
+  assert.throws(() => create(kWebCryptoCipherEncrypt, aes, 100, 16, [record]),
+                { code: 'ERR_CRYPTO_UNKNOWN_CIPHER' });
+
+  // ChaCha20-Poly1305 only takes 12-byte nonces, and AES-GCM any but an
+  // empty one. Only the bad record is at fault.
+  for (const length of [0, 8, 11, 13, 16]) {
+    const bad = [Buffer.alloc(length), undefined, Buffer.from('data')];
+    assert.throws(() => create(kWebCryptoCipherEncrypt, chacha,
+                               kAEADBatch_CHACHA20_POLY1305, 16,
+                               [record, bad]),
+                  { code: 'ERR_CRYPTO_INVALID_IV' });
+  }
+  assert.throws(() => create(kWebCryptoCipherEncrypt, aes,
+                             kAEADBatch_AES_128_GCM, 16,
+                             [[Buffer.alloc(0), undefined, Buffer.alloc(1)]]),
+                { code: 'ERR_CRYPTO_INVALID_IV' });
+
+  // Decrypt input shorter than the tag. Exactly as long is an empty message.
+  for (const tagLength of [4, 16]) {
+    for (const length of [0, tagLength - 1]) {
+      const short = [record[0], undefined, Buffer.alloc(length)];
+      assert.throws(() => create(kWebCryptoCipherDecrypt, aes,
+                                 kAEADBatch_AES_128_GCM, tagLength,
+                                 [short]),
+                    { code: 'ERR_CRYPTO_INVALID_AUTH_TAG' });
+    }
+    create(kWebCryptoCipherDecrypt, aes, kAEADBatch_AES_128_GCM, tagLength,
+           [[record[0], undefined, Buffer.alloc(tagLength)]]);
+  }
+
+  // Records of the wrong shape.
+  for (const records of [[null], ['record'], [[record[0], undefined]],
+                         [[record[0], 'ad', record[2]]],
+                         [[record[0], undefined, 'data']],
+                         [['nonce', undefined, record[2]]]]) {
+    assert.throws(() => create(kWebCryptoCipherEncrypt, aes,
+                               kAEADBatch_AES_128_GCM, 16, records),
+                  { code: 'ERR_INVALID_ARG_TYPE' });
+  }
+
+  // Errors thrown by getters are passed on.
+  const throwing = [];
+  Object.defineProperty(throwing, 0, { get() { throw new Error('boom'); } });
+  assert.throws(() => create(kWebCryptoCipherEncrypt, aes,
+                             kAEADBatch_AES_128_GCM, 16, throwing),
+                { message: 'boom' });
+}
+
+// A getter that runs while the records are fetched and detaches the buffers
+// of a record that has already been fetched. All records are fetched before
+// any of them is measured, so the detached buffers count as empty.
+async function checkDetach(run) {
+  const key = crypto.randomBytes(16);
+  const handle = keyHandle(key);
+  const nonce = crypto.randomBytes(12);
+  const detach = (view) => structuredClone(view.buffer,
+                                           { transfer: [view.buffer] });
+
+  // A detached input is encrypted as an empty message.
+  {
+    const data = new Uint8Array(64).fill(1);
+    const later = [nonce, undefined, Buffer.from('later')];
+    const records = [[nonce, undefined, data]];
+    Object.defineProperty(records, 1, {
+      get() {
+        detach(data);
+        return later;
+      },
+    });
+    const { err, result } = await run(kWebCryptoCipherEncrypt, handle,
+                                      kAEADBatch_AES_128_GCM, 16, records);
+    assert.strictEqual(data.byteLength, 0);
+    assert.strictEqual(err, undefined);
+    assert.deepStrictEqual(
+      Buffer.from(result),
+      Buffer.concat([
+        encrypt('aes-128-gcm', key, 16, [nonce, undefined, Buffer.alloc(0)]),
+        encrypt('aes-128-gcm', key, 16, later),
+      ]));
+  }
+
+  // A detached nonce, and a detached input that is now shorter than the tag,
+  // are rejected.
+  for (const [mode, index, code] of [
+    [kWebCryptoCipherEncrypt, 0, 'ERR_CRYPTO_INVALID_IV'],
+    [kWebCryptoCipherDecrypt, 2, 'ERR_CRYPTO_INVALID_AUTH_TAG'],
+  ]) {
+    const record = [new Uint8Array(12), undefined, new Uint8Array(32)];
+    const fields = [...record];
+    Object.defineProperty(fields, 2, {
+      get() {
+        detach(record[index]);
+        return record[2];
+      },
+    });
+    assert.throws(() => new AEADBatchJob(kCryptoJobSync, mode, handle,
+                                         kAEADBatch_AES_128_GCM, 16,
+                                         [fields]),
+                  { code });
+  }
+}
+
+(async () => {
+  checkArguments(kCryptoJobSync);
+  checkArguments(kCryptoJobAsync);
+  await checkRoundTrip(runSync);
+  await checkRoundTrip(runAsync);
+  await checkDetach(runSync);
+  await checkDetach(runAsync);
+})().then(common.mustCall());
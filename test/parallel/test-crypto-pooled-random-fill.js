@@ -0,0 +1,102 @@
+// Flags: --expose-internals --allow-natives-syntax
+'use strict';
+
+// Tests pooledRandomFill(buffer, offset, size) of the crypto binding, which
+// serves small requests from a per-environment cache of CSPRNG output, on
+// its slow path (which also creates the pool on first use) and on its fast
+// path.
+
+const common = require('../common');
+if (!common.hasCrypto)
+  common.skip('missing crypto');
+
+const assert = require('assert');
+const { internalBinding } = require('internal/test/binding');
+const binding = internalBinding('crypto');
+const { pooledRandomFill } = binding;
+
+const kMarker = 0xAA;
+const kMaxPooledSize = 256;
+const kBufferSize = 16 * 1024;
+
+// Fills `size` bytes at `offset` of a marked buffer, checks that nothing
+// outside of that range was written, and returns the filled bytes.
+function fillMarked(fill, length, offset, size) {
+  const buffer = Buffer.alloc(length, kMarker);
+  assert.strictEqual(fill(buffer, offset, size), true);
+  for (let i = 0; i < length; i++) {
+    if (i < offset || i >= offset + size)
+      assert.strictEqual(buffer[i], kMarker, `byte ${i} was written`);
+  }
+  return buffer.subarray(offset, offset + size);
+}
+
+// Random output of 16 bytes or more is never all the same byte, and never
+// repeats.
+const seen = new Set();
+function checkRandom(bytes) {
+  if (bytes.length < 16) return;
+  assert(bytes.some((byte) => byte !== bytes[0]), bytes.toString('hex'));
+  const hex = bytes.toString('hex');
+  assert(!seen.has(hex), `${hex} was returned twice`);
+  seen.add(hex);
+}
+
+// The first call creates the pool. It is a plain call without a receiver,
+// as after destructuring.
+checkRandom(fillMarked(pooledRandomFill, 64, 0, 64));
+
+// It can also be called as a method.
+checkRandom(fillMarked((...args) => binding.pooledRandomFill(...args),
+                       64, 8, 32));
+
+// Offsets and sizes, including empty requests at either end and requests
+// that are too large for the pool and go to the CSPRNG directly.
+for (const [length, offset, size] of [
+  [64, 0, 0], [64, 64, 0], [64, 63, 1], [64, 0, 16], [64, 16, 32],
+  [300, 1, kMaxPooledSize], [300, 0, kMaxPooledSize + 1],
+  [4096, 100, 3000], [kBufferSize + 10, 5, kBufferSize],
+]) {
+  checkRandom(fillMarked(pooledRandomFill, length, offset, size));
+}
+
+// Any kind of buffer.
+for (const make of [
+  (n) => new Uint8Array(n),
+  (n) => new ArrayBuffer(n),
+  (n) => new DataView(new ArrayBuffer(n)),
+  (n) => new Uint32Array(n / 4),
+]) {
+  const target = make(64);
+  assert.strictEqual(pooledRandomFill(target, 16, 32), true);
+  const bytes = Buffer.from(target.buffer ?? target);
+  assert(bytes.subarray(0, 16).every((byte) => byte === 0));
+  assert(bytes.subarray(48).every((byte) => byte === 0));
+  checkRandom(bytes.subarray(16, 48));
+}
+
+// Enough requests to use up several pool buffers, so that the buffers
+// refilled on the threadpool and synchronously are both handed out. Let the
+// event loop run in between, so that the refills can finish.
+function drain(fill, rounds) {
+  for (let i = 0; i < 2 * kBufferSize / 128; i++) {
+    checkRandom(fillMarked(fill, 160, i % 32, 128));
+  }
+  if (rounds > 1) setImmediate(drain, fill, rounds - 1);
+}
+drain(pooledRandomFill, 4);
+
+// The fast path, once the caller is optimized.
+function fill(buffer, offset, size) {
+  return pooledRandomFill(buffer, offset, size);
+}
+%PrepareFunctionForOptimization(fill);
+for (let round = 0; round < 3; round++) {
+  for (const [offset, size] of [[0, 0], [0, 32], [7, 64], [1, 128],
+                                [0, kMaxPooledSize],
+                                [3, kMaxPooledSize + 1]]) {
+    checkRandom(fillMarked(fill, 300, offset, size));
+  }
+  %OptimizeFunctionOnNextCall(fill);
+}
+drain(fill, 2);
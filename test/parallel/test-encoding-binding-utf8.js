@@ -0,0 +1,218 @@
+// Flags: --expose-internals
+'use strict';
+
+// Tests the one-shot decodeUTF8() and the streaming UTF8Decoder of the
+// encoding binding against the UTF-8 decoder of the Encoding Standard, on
+// malformed input, across chunk boundaries and around the lengths where the
+// implementation switches strategies.
+
+require('../common');
+const assert = require('assert');
+const { internalBinding } = require('internal/test/binding');
+const { decodeUTF8, UTF8Decoder } = internalBinding('encoding_binding');
+
+const kFlush = 0x1;
+const kFatal = 0x2;
+const kIgnoreBOM = 0x4;
+
+// https://encoding.spec.whatwg.org/#utf-8-decoder
+function reference(bytes, ignoreBOM) {
+  let out = '';
+  let codePoint = 0;
+  let needed = 0;
+  let seen = 0;
+  let lower = 0x80;
+  let upper = 0xBF;
+  for (let i = 0; i < bytes.length;) {
+    const byte = bytes[i];
+    if (needed === 0) {
+      i++;
+      if (byte <= 0x7F) {
+        out += String.fromCharCode(byte);
+      } else if (byte >= 0xC2 && byte <= 0xDF) {
+        needed = 1;
+        codePoint = byte & 0x1F;
+      } else if (byte >= 0xE0 && byte <= 0xEF) {
+        if (byte === 0xE0) lower = 0xA0;
+        if (byte === 0xED) upper = 0x9F;
+        needed = 2;
+        codePoint = byte & 0xF;
+      } else if (byte >= 0xF0 && byte <= 0xF4) {
+        if (byte === 0xF0) lower = 0x90;
+        if (byte === 0xF4) upper = 0x8F;
+        needed = 3;
+        codePoint = byte & 0x7;
+      } else {
+        out += '\uFFFD';
+      }
+      continue;
+    }
+    if (byte < lower || byte > upper) {
+      // The byte is looked at again as the start of a new sequence.
+      codePoint = needed = seen = 0;
+      lower = 0x80;
+      upper = 0xBF;
+      out += '\uFFFD';
+      continue;
+    }
+    lower = 0x80;
+    upper = 0xBF;
+    codePoint = (codePoint << 6) | (byte & 0x3F);
+    seen++;
+    i++;
+    if (seen === needed) {
+      out += String.fromCodePoint(codePoint);
+      codePoint = needed = seen = 0;
+    }
+  }
+  if (needed !== 0) out += '\uFFFD';
+  if (!ignoreBOM && out.charCodeAt(0) === 0xFEFF) out = out.slice(1);
+  return out;
+}
+
+function isValid(bytes) {
+  return Buffer.from(reference(bytes, true)).equals(bytes);
+}
+
+function decodeChunks(chunks, flags) {
+  const decoder = new UTF8Decoder(flags);
+  let out = '';
+  chunks.forEach((chunk, i) => {
+    out += decoder.decode(chunk, i === chunks.length - 1 ? kFlush : 0);
+  });
+  return out;
+}
+
+// All the ways of cutting `bytes` in two, and into single bytes.
+function* chunkings(bytes) {
+  for (let i = 0; i <= bytes.length; i++)
+    yield [bytes.subarray(0, i), bytes.subarray(i)];
+  yield Array.from(bytes, (_, i) => bytes.subarray(i, i + 1));
+}
+
+const kInvalidData = { code: 'ERR_ENCODING_INVALID_ENCODED_DATA' };
+
+function check(bytes) {
+  for (const ignoreBOM of [false, true]) {
+    const expected = reference(bytes, ignoreBOM);
+    const flags = ignoreBOM ? kIgnoreBOM : 0;
+    assert.strictEqual(decodeUTF8(bytes, ignoreBOM, false), expected);
+    for (const chunks of chunkings(bytes))
+      assert.strictEqual(decodeChunks(chunks, flags), expected);
+
+    if (isValid(bytes)) {
+      assert.strictEqual(decodeUTF8(bytes, ignoreBOM, true), expected);
+      assert.strictEqual(decodeChunks([bytes], flags | kFatal), expected);
+    } else {
+      assert.throws(() => decodeUTF8(bytes, ignoreBOM, true), kInvalidData);
+      for (const chunks of chunkings(bytes)) {
+        assert.throws(() => decodeChunks(chunks, flags | kFatal),
+                      kInvalidData);
+      }
+    }
+  }
+}
+
+// Malformed input.
+[
+  // Lone and excess continuation bytes.
+  [0x80], [0xBF], [0x41, 0x80, 0x42], [0xC3, 0xA9, 0xA9],
+  // Lead bytes that never start a sequence.
+  [0xC0, 0x80], [0xC1, 0xBF], [0xF5, 0x80, 0x80, 0x80], [0xFF], [0xFE],
+  // Overlong forms, surrogates and code points above U+10FFFF, which the
+  // second byte already rules out.
+  [0xE0, 0x80, 0x80], [0xE0, 0x9F, 0xBF], [0xF0, 0x80, 0x80, 0x80],
+  [0xF0, 0x8F, 0xBF, 0xBF], [0xED, 0xA0, 0x80], [0xED, 0xBF, 0xBF],
+  [0xF4, 0x90, 0x80, 0x80],
+  // Truncated sequences, at the end and followed by more text.
+  [0xC3], [0xE2, 0x82], [0xF0, 0x9F, 0x98], [0xE2, 0x82, 0x41],
+  [0xF0, 0x9F, 0x41, 0x42], [0xF0, 0x9F, 0x98, 0xE2, 0x82, 0xAC],
+  // Byte order marks, broken ones and ones that follow an error.
+  [0xEF, 0xBB, 0xBF], [0xEF, 0xBB, 0xBF, 0xEF, 0xBB, 0xBF, 0x41],
+  [0xEF, 0xBB], [0xEF, 0xBB, 0x41], [0x80, 0xEF, 0xBB, 0xBF],
+  [0xEF, 0xBB, 0xBF, 0x80],
+].forEach((bytes) => check(Buffer.from(bytes)));
+
+// Random mixes of valid sequences of every length and stray bytes.
+{
+  let seed = 1;
+  const random = (n) => {
+    seed = (seed * 1103515245 + 12345) % 2147483648;
+    return seed % n;
+  };
+  const pieces = [
+    [0x41], [0xC3, 0xA9], [0xE2, 0x82, 0xAC], [0xF0, 0x9F, 0x98, 0x80],
+    [0xEF, 0xBB, 0xBF], [0x80], [0xC3], [0xE2, 0x82], [0xF0, 0x9F, 0x98],
+    [0xED, 0xA0], [0xF4, 0x90], [0xFF],
+  ];
+  for (let i = 0; i < 300; i++) {
+    const bytes = [];
+    for (let n = random(12); n > 0; n--)
+      bytes.push(...pieces[random(pieces.length)]);
+    check(Buffer.from(bytes));
+  }
+}
+
+// Lengths around the vector sizes of the validators and around the stack
+// buffer of the transcoder, with and without an error at the very end.
+for (const length of [15, 16, 17, 31, 32, 33, 63, 64, 65, 1023, 1024, 1025]) {
+  for (const char of ['a', 'é', '€', '\u{1F600}']) {
+    const valid = Buffer.from(char.repeat(length));
+    const invalid = Buffer.concat([valid, Buffer.from([0xC3])]);
+    for (const bytes of [valid, invalid]) {
+      const expected = reference(bytes, false);
+      assert.strictEqual(decodeUTF8(bytes, false, false), expected);
+      const middle = bytes.length >> 1;
+      assert.strictEqual(
+        decodeChunks([bytes.subarray(0, middle), bytes.subarray(middle)], 0),
+        expected);
+    }
+    assert.throws(() => decodeUTF8(invalid, false, true), kInvalidData);
+  }
+}
+
+// Any kind of buffer is accepted.
+{
+  const bytes = new Uint8Array([0xE2, 0x82, 0xAC, 0x41]);
+  for (const input of [bytes, bytes.buffer, new DataView(bytes.buffer)]) {
+    assert.strictEqual(decodeUTF8(input, false, false), '€A');
+    assert.strictEqual(new UTF8Decoder(0).decode(input, kFlush), '€A');
+  }
+  const shared = new Uint8Array(new SharedArrayBuffer(4));
+  shared.set(bytes);
+  assert.strictEqual(decodeUTF8(shared.buffer, false, false), '€A');
+
+  assert.throws(() => decodeUTF8('€', false, false),
+                { code: 'ERR_INVALID_ARG_TYPE' });
+  assert.throws(() => new UTF8Decoder(0).decode('€', kFlush),
+                { code: 'ERR_INVALID_ARG_TYPE' });
+}
+
+// The state carried between chunks.
+{
+  const decoder = new UTF8Decoder(0);
+  // A byte order mark only counts at the start of the stream.
+  assert.strictEqual(decoder.decode(Buffer.from([0xEF]), 0), '');
+  assert.strictEqual(decoder.decode(Buffer.from([0xBB]), 0), '');
+  assert.strictEqual(decoder.decode(Buffer.from([0xBF, 0x41]), 0), 'A');
+  assert.strictEqual(decoder.decode(Buffer.from([0xEF, 0xBB, 0xBF]), kFlush),
+                     '\uFEFF');
+  // A flush starts a new stream.
+  assert.strictEqual(
+    decoder.decode(Buffer.from([0xEF, 0xBB, 0xBF, 0x41]), kFlush), 'A');
+
+  // An empty chunk keeps the pending code point, and reset() drops it.
+  assert.strictEqual(decoder.decode(Buffer.from([0xE2, 0x82]), 0), '');
+  assert.strictEqual(decoder.decode(Buffer.alloc(0), 0), '');
+  assert.strictEqual(decoder.decode(Buffer.from([0xAC]), 0), '€');
+  assert.strictEqual(decoder.decode(Buffer.from([0xE2, 0x82]), 0), '');
+  decoder.reset();
+  assert.strictEqual(decoder.decode(Buffer.from([0x41]), kFlush), 'A');
+
+  // In fatal mode, an error ends the stream.
+  const fatal = new UTF8Decoder(kFatal);
+  assert.strictEqual(fatal.decode(Buffer.from([0xE2, 0x82]), 0), '');
+  assert.throws(() => fatal.decode(Buffer.from([0x41]), 0), kInvalidData);
+  assert.strictEqual(
+    fatal.decode(Buffer.from([0xE2, 0x82, 0xAC]), kFlush), '€');
+}
@@ -0,0 +1,225 @@
+// Flags: --expose-internals --allow-natives-syntax
+'use strict';
+
+// Tests the timer wheel of the timers binding: timerWheelInsert(),
+// timerWheelCancel(), timerWheelReschedule(), timerWheelAdvance() and
+// timerWheelNextExpiry(). Every check runs before and after the callers are
+// optimized, so that the slow and the fast binding paths are both taken.
+
+require('../common');
+const assert = require('assert');
+const { internalBinding } = require('internal/test/binding');
+const binding = internalBinding('timers');
+
+function insert(expiry) {
+  return binding.timerWheelInsert(expiry);
+}
+function cancel(id) {
+  return binding.timerWheelCancel(id);
+}
+function reschedule(id, expiry) {
+  return binding.timerWheelReschedule(id, expiry);
+}
+function advanceOnce(now, expired) {
+  return binding.timerWheelAdvance(now, expired);
+}
+function nextExpiry() {
+  return binding.timerWheelNextExpiry();
+}
+const callers = [insert, cancel, reschedule, advanceOnce, nextExpiry];
+
+// The clock of the wheel only moves forward. `now` is the time it was last
+// advanced to; timers are scheduled relative to it.
+let now = binding.getLibuvNow();
+
+// Advances the wheel to `to` and returns the ids of the timers that expired,
+// taking them `size` at a time.
+function advance(to, size = 64) {
+  const expired = new Uint32Array(size);
+  const ids = [];
+  let count;
+  do {
+    count = advanceOnce(to, expired);
+    assert(count <= size);
+    ids.push(...expired.subarray(0, count));
+  } while (count === size);
+  now = to;
+  return ids;
+}
+
+function checkEmpty() {
+  assert.strictEqual(nextExpiry(), -1);
+  assert.deepStrictEqual(advance(now + 1e6), []);
+}
+
+function checkBasics() {
+  const id = insert(now + 10);
+  assert.strictEqual(typeof id, 'number');
+  assert.strictEqual(id >>> 0, id);
+  assert.strictEqual(nextExpiry(), now + 10);
+  assert.deepStrictEqual(advance(now + 9), []);
+  assert.strictEqual(nextExpiry(), now + 1);
+  assert.deepStrictEqual(advance(now + 1), [id]);
+  assert.strictEqual(nextExpiry(), -1);
+
+  // Fractions of a millisecond are rounded up, never down.
+  const fraction = insert(now + 10.2);
+  assert.strictEqual(nextExpiry(), now + 11);
+  assert.deepStrictEqual(advance(now + 10), []);
+  assert.deepStrictEqual(advance(now + 1), [fraction]);
+
+  // Timers that are already due, or that have no meaningful deadline, expire
+  // on the next advance past the current time.
+  const due = [now, now - 1, 0, -1, -Infinity, NaN].map(insert);
+  assert.strictEqual(nextExpiry(), now + 1);
+  assert.deepStrictEqual(advance(now), []);
+  assert.deepStrictEqual(new Set(advance(now + 1)), new Set(due));
+
+  // Deadlines far in the future, up to and past 2^53, are kept and can be
+  // cancelled.
+  const far = [now + 2 ** 32, 2 ** 53 - 1, 2 ** 53, 2 ** 60, Infinity]
+    .map(insert);
+  const next = nextExpiry();
+  assert(next > now + 1e6, `${next}`);
+  assert.deepStrictEqual(advance(now + 1e6), []);
+  for (const id of far) assert.strictEqual(cancel(id), true);
+  checkEmpty();
+}
+
+function checkStaleIds() {
+  const id = insert(now + 50);
+  assert.strictEqual(cancel(id), true);
+  assert.strictEqual(cancel(id), false);
+  assert.strictEqual(reschedule(id, now + 10), false);
+  assert.strictEqual(nextExpiry(), -1);
+
+  // The slot is reused with a new id, which the old one does not match.
+  const reused = insert(now + 50);
+  assert.notStrictEqual(reused, id);
+  assert.strictEqual(cancel(id), false);
+  assert.deepStrictEqual(advance(now + 50), [reused]);
+
+  // Ids that have been handed out by timerWheelAdvance() are stale too.
+  assert.strictEqual(cancel(reused), false);
+  assert.strictEqual(reschedule(reused, now + 10), false);
+
+  // Ids that were never handed out.
+  for (const bogus of [0xffffffff, 0xffffff, 0xfeffffff])
+    assert.strictEqual(cancel(bogus), false);
+  checkEmpty();
+}
+
+function checkReschedule() {
+  const a = insert(now + 50);
+  const b = insert(now + 50);
+  // Later, earlier, and into the past.
+  assert.strictEqual(reschedule(a, now + 5000), true);
+  assert.strictEqual(nextExpiry(), now + 50);
+  assert.strictEqual(reschedule(b, now + 20), true);
+  assert.strictEqual(nextExpiry(), now + 20);
+  assert.deepStrictEqual(advance(now + 20), [b]);
+  assert.strictEqual(reschedule(a, now - 10), true);
+  assert.deepStrictEqual(advance(now + 1), [a]);
+  checkEmpty();
+}
+
+// Timers that are due at once are handed out in order of expiry, however
+// small the array that takes them. Those that have expired but have not been
+// taken yet can still be cancelled or rescheduled.
+function checkExpiredList() {
+  const ids = [];
+  for (let i = 0; i < 10; i++) ids.push(insert(now + 10));
+  const expired = new Uint32Array(4);
+  assert.strictEqual(advanceOnce(now + 10, expired), 4);
+  assert.deepStrictEqual([...expired], ids.slice(0, 4));
+  assert.strictEqual(cancel(ids[4]), true);
+  assert.strictEqual(reschedule(ids[5], now + 20), true);
+  assert.strictEqual(advanceOnce(now + 10, expired), 4);
+  assert.deepStrictEqual([...expired], ids.slice(6, 10));
+  assert.strictEqual(advanceOnce(now + 10, expired), 0);
+  now += 10;
+  assert.deepStrictEqual(advance(now + 10, 1), [ids[5]]);
+
+  // Timers far enough out share a bucket wider than a millisecond, and are
+  // sorted when it empties.
+  const expiries = [1007, 1001, 1006, 1000, 1003, 1003, 1002];
+  const byExpiry = expiries.map((delay) => [now + delay, insert(now + delay)])
+    .sort((x, y) => x[0] - y[0]).map(([, id]) => id);
+  assert.deepStrictEqual(advance(now + 2000, 3), byExpiry);
+  checkEmpty();
+}
+
+// Random schedules, checked against a list of the live timers: every timer
+// expires exactly once, never early, and at most about an eighth of its
+// delay late.
+function checkRandom(seed) {
+  const random = (n) => {
+    seed = (seed * 1103515245 + 12345) % 2147483648;
+    return seed % n;
+  };
+  const delay = () => [10, 1000, 100000, 10000000][random(4)] * random(1000) /
+    1000;
+  const live = new Map();
+  const schedule = (id, expiry) => {
+    live.set(id, { expiry: Math.ceil(expiry), start: now + 1 });
+  };
+
+  for (let i = 0; i < 2000; i++) {
+    const expiry = now + delay();
+    schedule(insert(expiry), expiry);
+  }
+  while (live.size > 0) {
+    // Change some of the timers between turns, as users of the wheel would.
+    const ids = [...live.keys()];
+    for (let i = random(8); i > 0; i--) {
+      const id = ids[random(ids.length)];
+      if (!live.has(id)) continue;
+      const op = random(3);
+      if (op === 0) {
+        assert.strictEqual(cancel(id), true);
+        live.delete(id);
+      } else if (op === 1) {
+        const expiry = now + delay();
+        assert.strictEqual(reschedule(id, expiry), true);
+        schedule(id, expiry);
+      } else {
+        const expiry = now + delay();
+        schedule(insert(expiry), expiry);
+      }
+    }
+    const next = nextExpiry();
+    if (live.size === 0) {
+      assert.strictEqual(next, -1);
+      break;
+    }
+    assert(next > now, `${next} <= ${now}`);
+    let previous = -Infinity;
+    for (const id of advance(next, 1 + random(100))) {
+      const timer = live.get(id);
+      assert(timer, `${id} expired twice or was cancelled`);
+      live.delete(id);
+      assert(timer.expiry <= next, `${id} expired early`);
+      assert(timer.expiry >= previous, `${id} expired out of order`);
+      // Deadlines before the clock count from the clock.
+      const late = next - Math.max(timer.expiry, timer.start);
+      assert(late <= (timer.expiry - timer.start) / 7.75 || late === 0,
+             `${id} expired ${late} ms late`);
+      previous = timer.expiry;
+    }
+  }
+  checkEmpty();
+}
+
+// Start the clock of the wheel.
+advance(now);
+
+for (const caller of callers) %PrepareFunctionForOptimization(caller);
+for (let round = 0; round < 3; round++) {
+  checkEmpty();
+  checkBasics();
+  checkStaleIds();
+  checkReschedule();
+  checkExpiredList();
+  checkRandom(round + 1);
+  for (const caller of callers) %OptimizeFunctionOnNextCall(caller);
+}
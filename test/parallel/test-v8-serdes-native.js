@@ -0,0 +1,160 @@
+// Flags: --expose-internals
+'use strict';
+
+// Tests the one-shot serialize(), serializeBatch() and deserialize() of the
+// serdes binding against v8.serialize() and v8.deserialize().
+
+require('../common');
+const assert = require('assert');
+const v8 = require('v8');
+const { internalBinding } = require('internal/test/binding');
+const { serialize, serializeBatch, deserialize } = internalBinding('serdes');
+
+// Places `bytes` at `offset` in a new ArrayBuffer.
+function at(offset, bytes) {
+  const copy = new Uint8Array(offset + bytes.length);
+  copy.set(bytes, offset);
+  return Buffer.from(copy.buffer, offset, bytes.length);
+}
+
+const views = [
+  Buffer.from('hello'),
+  Buffer.alloc(0),
+  new Int8Array([-1, 2, -3]),
+  new Uint8Array([1, 2, 3]),
+  new Uint8ClampedArray([0, 128, 255]),
+  new Int16Array([-1, 2, -3]),
+  new Uint16Array([1, 2, 3]),
+  new Int32Array([-1, 2, -3]),
+  new Uint32Array([1, 2, 3]),
+  new Float32Array([0.5, -1.5, 1e30]),
+  new Float64Array([0.1, -Infinity, 2 ** 60]),
+  new DataView(new Uint8Array([1, 2, 3, 4]).buffer, 1, 2),
+  new BigInt64Array([-1n, 2n ** 62n]),
+  new BigUint64Array([1n, 2n ** 64n - 1n]),
+  new Float64Array(0),
+  // Only the viewed part of the memory is written.
+  new Uint16Array(new ArrayBuffer(16), 4, 3),
+];
+
+const values = [
+  ...views,
+  undefined,
+  null,
+  42,
+  'string',
+  12345678901234567890n,
+  [1, 'two', { three: 3 }],
+  new Map([['key', new Set([1, 2])]]),
+  { body: Buffer.from('body'), meta: { tags: ['a', 'b'] }, views },
+];
+
+// The output is byte for byte what v8.serialize() writes, and either side can
+// read what the other wrote.
+for (const value of values) {
+  const serialized = serialize(value);
+  assert(Buffer.isBuffer(serialized));
+  assert.deepStrictEqual(serialized, v8.serialize(value));
+  assert.deepStrictEqual(v8.deserialize(serialized), value);
+  assert.deepStrictEqual(deserialize(serialized), value);
+}
+
+// Buffers stay Buffers, other views keep their type.
+for (const view of views) {
+  const result = deserialize(serialize(view));
+  assert.strictEqual(Object.getPrototypeOf(result),
+                     Object.getPrototypeOf(view));
+}
+
+// Deserialized views refer to the memory of the input where they are
+// aligned in it, and are copied where they are not.
+{
+  const view = new Float64Array([1, 2, 3]);
+  const serialized = v8.serialize(view);
+  const contents = serialized.indexOf(Buffer.from(view.buffer));
+  assert.notStrictEqual(contents, -1);
+
+  const aligned = at(8 - contents % 8, serialized);
+  let result = deserialize(aligned);
+  assert.deepStrictEqual(result, view);
+  assert.strictEqual(result.buffer, aligned.buffer);
+  assert.strictEqual(result.byteOffset, aligned.byteOffset + contents);
+
+  const misaligned = at(9 - contents % 8, serialized);
+  result = deserialize(misaligned);
+  assert.deepStrictEqual(result, view);
+  assert.notStrictEqual(result.buffer, misaligned.buffer);
+
+  // Bytes are never misaligned.
+  const bytes = Buffer.from('bytes');
+  const input = at(1, v8.serialize(bytes));
+  assert.strictEqual(deserialize(input).buffer, input.buffer);
+}
+
+// Every entry of a batch is v8.serialize() of its value, and can be
+// deserialized on its own.
+{
+  const [buffer, offsets] = serializeBatch(values);
+  assert(Buffer.isBuffer(buffer));
+  assert(offsets instanceof Float64Array);
+  assert.strictEqual(offsets.length, values.length + 1);
+  assert.strictEqual(offsets[0], 0);
+  assert.strictEqual(offsets[values.length], buffer.length);
+  values.forEach((value, i) => {
+    const entry = buffer.subarray(offsets[i], offsets[i + 1]);
+    assert.deepStrictEqual(entry, v8.serialize(value));
+    assert.deepStrictEqual(deserialize(entry), value);
+    assert.deepStrictEqual(v8.deserialize(entry), value);
+  });
+
+  const [empty, emptyOffsets] = serializeBatch([]);
+  assert.strictEqual(empty.length, 0);
+  assert.deepStrictEqual(emptyOffsets, new Float64Array([0]));
+}
+
+// An error partway through a batch is thrown, and nothing is returned.
+{
+  assert.throws(() => serializeBatch([1, () => {}, 2]),
+                /could not be cloned/);
+  assert.throws(() => serializeBatch([1, new WeakMap()]),
+                /could not be cloned/);
+
+  const batch = [1, 2, 3];
+  Object.defineProperty(batch, 1, {
+    get() { throw new Error('boom'); },
+  });
+  assert.throws(() => serializeBatch(batch), { message: 'boom' });
+
+  // The next batch is not affected.
+  const [buffer, offsets] = serializeBatch([1, 2]);
+  assert.deepStrictEqual(buffer.subarray(offsets[1], offsets[2]),
+                         v8.serialize(2));
+}
+
+// Arguments of the wrong type are rejected.
+assert.throws(() => serializeBatch('values'),
+              { code: 'ERR_INVALID_ARG_TYPE' });
+assert.throws(() => deserialize(new ArrayBuffer(4)),
+              { code: 'ERR_INVALID_ARG_TYPE' });
+
+// Malformed host objects are rejected. The header is followed by the host
+// object tag, then the view type and its byte length.
+{
+  const header = v8.serialize(0).subarray(0, 2);
+  const hostObject = (...bytes) => Buffer.from([...header, 0x5c, ...bytes]);
+  const int32Array = 5;
+
+  // An unknown view type.
+  assert.throws(() => deserialize(hostObject(13, 0)),
+                /ReadHostObject\(\) failed/);
+  // Fewer bytes than the byte length says.
+  assert.throws(() => deserialize(hostObject(int32Array, 8, 1, 2, 3)),
+                /ReadHostObject\(\) failed/);
+  // A byte length that is not a multiple of the element size.
+  assert.throws(() => deserialize(hostObject(int32Array, 3, 1, 2, 3)),
+                { name: 'RangeError', message: 'Invalid typed array length' });
+
+  const truncated = v8.serialize(new Float64Array([1, 2]));
+  assert.throws(() => deserialize(truncated.subarray(0, truncated.length - 1)),
+                /ReadHostObject\(\) failed/);
+}
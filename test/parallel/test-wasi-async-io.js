@@ -0,0 +1,128 @@
+// Flags: --expose-internals --expose-gc
+'use strict';
+
+// Tests fd_read_async, fd_pread_async, fd_write_async and fd_pwrite_async on
+// the WASI binding. They run uvwasi on the threadpool, where it allocates
+// through the WASI allocator off the owning thread, and use the guest's
+// buffers in place in its memory.
+
+const common = require('../common');
+const assert = require('assert');
+const fs = require('fs');
+const path = require('path');
+const tmpdir = require('../common/tmpdir');
+const { internalBinding } = require('internal/test/binding');
+const { WASI } = internalBinding('wasi');
+
+const kESUCCESS = 0;
+const kEBADF = 8;
+const kEBUSY = 10;
+const kEINVAL = 28;
+const kEOVERFLOW = 61;
+
+const kIovecs = 0;
+const kResult = 64;
+const kData = 128;
+
+tmpdir.refresh();
+const file = path.join(tmpdir.path, 'wasi-async-io');
+fs.writeFileSync(file, 'hello world');
+
+// The file is the guest's descriptor 0.
+const fd = 0;
+let wasi = new WASI([], [], [], [fs.openSync(file, 'r+'), 1, 2]);
+const memory = new WebAssembly.Memory({ initial: 1 });
+wasi._setMemory(memory);
+
+// Lays out one iovec per length, with their buffers back to back at kData.
+function setIovecs(...lengths) {
+  const view = new DataView(memory.buffer);
+  let ptr = kData;
+  lengths.forEach((length, i) => {
+    view.setUint32(kIovecs + i * 8, ptr, true);
+    view.setUint32(kIovecs + i * 8 + 4, length, true);
+    ptr += length;
+  });
+  return lengths.length;
+}
+
+function setData(string) {
+  Buffer.from(memory.buffer).write(string, kData, 'latin1');
+}
+
+function getData(length) {
+  return Buffer.from(memory.buffer, kData, length).toString('latin1');
+}
+
+function getResult() {
+  return new DataView(memory.buffer).getUint32(kResult, true);
+}
+
+(async () => {
+  // Both halves of a write end up in the file, at the given offset.
+  setData('HELLO');
+  let iovs = setIovecs(3, 2);
+  assert.strictEqual(
+    await wasi.fd_pwrite_async(fd, kIovecs, iovs, 0n, kResult), kESUCCESS);
+  assert.strictEqual(getResult(), 5);
+  assert.strictEqual(fs.readFileSync(file, 'latin1'), 'HELLO world');
+
+  iovs = setIovecs(2, 3);
+  assert.strictEqual(
+    await wasi.fd_pread_async(fd, kIovecs, iovs, 6n, kResult), kESUCCESS);
+  assert.strictEqual(getResult(), 5);
+  assert.strictEqual(getData(5), 'world');
+
+  // The positional calls do not move the file position.
+  setData('abc');
+  iovs = setIovecs(3);
+  assert.strictEqual(
+    await wasi.fd_write_async(fd, kIovecs, iovs, kResult), kESUCCESS);
+  assert.strictEqual(getResult(), 3);
+  assert.strictEqual(fs.readFileSync(file, 'latin1'), 'abcLO world');
+
+  iovs = setIovecs(4, 28);
+  assert.strictEqual(
+    await wasi.fd_read_async(fd, kIovecs, iovs, kResult), kESUCCESS);
+  assert.strictEqual(getResult(), 8);
+  assert.strictEqual(getData(8), 'LO world');
+
+  // A read that completes after the memory has grown is stored in the
+  // memory the guest sees now, even if growing it moved it.
+  const before = memory.buffer;
+  setData('.....');
+  iovs = setIovecs(5);
+  const read = wasi.fd_pread_async(fd, kIovecs, iovs, 6n, kResult);
+  memory.grow(1);
+  assert.strictEqual(before.byteLength, 0);
+  assert.strictEqual(await read, kESUCCESS);
+  assert.strictEqual(memory.buffer.byteLength, 2 * 65536);
+  assert.strictEqual(getResult(), 5);
+  assert.strictEqual(getData(5), 'world');
+
+  // While a call is in flight, closing or renumbering its descriptor would
+  // block on uvwasi's lock, so it fails instead.
+  const pending = wasi.fd_pread_async(fd, kIovecs, iovs, 0n, kResult);
+  assert.strictEqual(wasi.fd_close(fd), kEBUSY);
+  assert.strictEqual(wasi.fd_renumber(fd, 1), kEBUSY);
+  assert.strictEqual(wasi.fd_renumber(1, fd), kEBUSY);
+  assert.strictEqual(await pending, kESUCCESS);
+
+  // Errors are reported through the Promise, too.
+  assert.strictEqual(
+    await wasi.fd_read_async(42, kIovecs, iovs, kResult), kEBADF);
+  assert.strictEqual(
+    await wasi.fd_read_async(fd, 2 * 65536, 1, kResult), kEOVERFLOW);
+  assert.strictEqual(
+    await wasi.fd_write_async(fd, kIovecs, iovs, 2 * 65536), kEOVERFLOW);
+  assert.strictEqual(
+    await wasi.fd_pread_async(fd, kIovecs, iovs, 0, kResult), kEINVAL);
+  assert.strictEqual(await wasi.fd_write_async(fd, kIovecs), kEINVAL);
+
+  assert.strictEqual(wasi.fd_close(fd), kESUCCESS);
+
+  // Blocks allocated on the threadpool are not accounted for, so the WASI
+  // instance is destroyed with its tracked memory at zero.
+  wasi = null;
+  globalThis.gc();
+})().then(common.mustCall());
@@ -0,0 +1,181 @@
+// Flags: --expose-internals
+'use strict';
+
+// Tests RingChannel of the messaging binding, a bounded queue of records in
+// shared memory whose clones can be passed to workers: records written by a
+// worker and read on the main thread through onreadable, closing either end,
+// records that do not fit, and stopping a worker that is blocked in wait()
+// or waitForSpace().
+
+const common = require('../common');
+const assert = require('assert');
+const {
+  MessageChannel, Worker, isMainThread, parentPort, workerData,
+} = require('worker_threads');
+const { internalBinding } = require('internal/test/binding');
+const { RingChannel } = internalBinding('messaging');
+
+const kCapacity = 8;
+const kSlotSize = 16;
+const kRecords = 200;
+const kClosed = { code: 'ERR_INVALID_STATE' };
+const kOutOfRange = { code: 'ERR_OUT_OF_RANGE' };
+
+// Records of every length from 0 to kSlotSize.
+function record(i) {
+  return Buffer.alloc(i % (kSlotSize + 1), i & 0xFF);
+}
+
+// Reads whatever there is, up to `max` records at a time.
+function readAll(channel, max = kCapacity) {
+  const out = new Uint8Array(max * kSlotSize);
+  const lengths = new Uint32Array(max);
+  const records = [];
+  let count;
+  while ((count = channel.read(out, lengths)) > 0) {
+    for (let i = 0; i < count; i++) {
+      const start = i * kSlotSize;
+      records.push(Buffer.from(out.subarray(start, start + lengths[i])));
+    }
+  }
+  return records;
+}
+
+function checkClosed(channel) {
+  assert.throws(() => channel.write(record(1)), kClosed);
+  assert.throws(() => readAll(channel), kClosed);
+  assert.throws(() => channel.wait(0), kClosed);
+  assert.throws(() => channel.waitForSpace(0), kClosed);
+  assert.throws(() => channel.start(), kClosed);
+}
+
+if (!isMainThread) {
+  const { mode, channel } = workerData;
+  if (mode === 'write') {
+    // The main thread has started reading, so this clone cannot.
+    assert.throws(() => readAll(channel), kClosed);
+    for (let i = 0; i < kRecords; i++) {
+      while (!channel.write(record(i)))
+        assert.strictEqual(channel.waitForSpace(-1), true);
+    }
+    // Closing the writing end leaves the records for the reader.
+    channel.close();
+    checkClosed(channel);
+  } else if (mode === 'take-over') {
+    // Once the reader on the main thread has closed its end, this clone can
+    // read what it left behind.
+    parentPort.once('message', common.mustCall(() => {
+      assert.deepStrictEqual(readAll(channel), [record(1), record(2)]);
+      assert.strictEqual(channel.wait(0), false);
+      assert.strictEqual(channel.write(record(3)), true);
+      assert.strictEqual(channel.wait(-1), true);
+      assert.deepStrictEqual(readAll(channel), [record(3)]);
+      channel.close();
+    }));
+  } else if (mode === 'wait') {
+    parentPort.postMessage('blocking');
+    channel.wait(-1);
+  } else if (mode === 'wait-for-space') {
+    assert.strictEqual(channel.write(record(1)), true);
+    assert.strictEqual(channel.write(record(2)), false);
+    parentPort.postMessage('blocking');
+    channel.waitForSpace(-1);
+  }
+  return;
+}
+
+// Sizes that are out of range are rejected before any memory is allocated.
+for (const [capacity, slotSize] of [[0, 1], [1, 0], [2 ** 24 + 1, 1],
+                                    [1, 2 ** 20 + 1], [2 ** 12, 2 ** 20]]) {
+  assert.throws(() => new RingChannel(capacity, slotSize), kOutOfRange);
+}
+
+// Records that do not fit in a slot, reads that have no room for a record,
+// and a full ring.
+{
+  const channel = new RingChannel(3, kSlotSize);
+  assert.throws(() => channel.write(Buffer.alloc(kSlotSize + 1)), kOutOfRange);
+  assert.throws(() => channel.write(new Uint8Array(1024)), kOutOfRange);
+  // The capacity is rounded up to a power of two.
+  for (let i = 0; i < 4; i++)
+    assert.strictEqual(channel.write(record(kSlotSize - i)), true);
+  assert.strictEqual(channel.write(record(0)), false);
+  assert.strictEqual(channel.waitForSpace(0), false);
+  assert.strictEqual(channel.waitForSpace(10), false);
+
+  assert.throws(() => channel.read(new Uint8Array(kSlotSize - 1),
+                                   new Uint32Array(4)), kOutOfRange);
+  assert.throws(() => channel.read(new Uint8Array(kSlotSize),
+                                   new Uint32Array(0)), kOutOfRange);
+  assert.deepStrictEqual(readAll(channel, 1),
+                         [16, 15, 14, 13].map((i) => record(i)));
+  assert.strictEqual(channel.wait(0), false);
+  assert.strictEqual(channel.wait(10), false);
+  assert.strictEqual(channel.waitForSpace(-1), true);
+  channel.close();
+  checkClosed(channel);
+}
+
+// A worker writes more records than fit in the ring, waiting for space when
+// it is full, while the main thread reads them whenever onreadable is called.
+{
+  const channel = new RingChannel(kCapacity, kSlotSize);
+  const received = [];
+  channel.onreadable = common.mustCallAtLeast(function() {
+    assert.strictEqual(this, channel);
+    received.push(...readAll(channel));
+    if (received.length === kRecords) {
+      assert.deepStrictEqual(received,
+                             Array.from({ length: kRecords }, (_, i) =>
+                               record(i)));
+      channel.close();
+    }
+  });
+  // Becoming the reader keeps the event loop alive until the channel is
+  // closed.
+  channel.start();
+  const worker = new Worker(__filename, {
+    workerData: { mode: 'write', channel },
+  });
+  worker.on('exit', common.mustCall((code) => assert.strictEqual(code, 0)));
+}
+
+// The reader closes its end while there are records left.
+{
+  const channel = new RingChannel(kCapacity, kSlotSize);
+  for (let i = 0; i < 3; i++)
+    assert.strictEqual(channel.write(record(i)), true);
+  assert.strictEqual(channel.read(new Uint8Array(kSlotSize),
+                                  new Uint32Array(1)), 1);
+  const worker = new Worker(__filename, {
+    workerData: { mode: 'take-over', channel },
+  });
+  channel.close();
+  checkClosed(channel);
+  // A closed channel cannot be passed on.
+  const { port1 } = new MessageChannel();
+  assert.throws(() => port1.postMessage(channel), { name: 'DataCloneError' });
+  port1.close();
+  worker.postMessage('closed');
+  worker.on('exit', common.mustCall((code) => assert.strictEqual(code, 0)));
+}
+
+// Workers that are blocked in wait(-1) or waitForSpace(-1) can still be
+// terminated, and do not keep the process from exiting.
+for (const mode of ['wait', 'wait-for-space']) {
+  {
+    const channel = new RingChannel(1, kSlotSize);
+    const worker = new Worker(__filename, { workerData: { mode, channel } });
+    worker.once('message', common.mustCall(() => {
+      setTimeout(common.mustCall(() => {
+        worker.terminate().then(common.mustCall());
+      }), 100);
+    }));
+    worker.on('exit', common.mustCall((code) => assert.strictEqual(code, 1)));
+  }
+  {
+    const channel = new RingChannel(1, kSlotSize);
+    const worker = new Worker(__filename, { workerData: { mode, channel } });
+    worker.once('message', common.mustCall(() => worker.unref()));
+  }
+}